@@ -1,6 +1,10 @@
 #include <cstdlib>
+#include <iterator>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
+#include <ocl_blas.h>
 #include <ocl_buffer.h>
 #include <ocl_context.h>
 #include <ocl_device.h>
@@ -14,16 +18,25 @@
 #include <utl_matrix.h>
 #include <utl_profile_pass.h>
 #include <utl_profile_pass_manager.h>
+#include <utl_random.h>
+#include <utl_timer.h>
 
 
 typedef float Type;
 
 
 
+/**
+ * Runs one of the buffer kernels of gemm.cl, which share the same arguments.
+ * 
+ * All kernels are invoked with 16x16 work-groups, each work-item computes
+ * a block of workPerItem x workPerItem elements of the result.
+ */
 class BufferPass : public utl::ProfilePass< Type >
 {
 public :
-  BufferPass( std::istream& source, utl::Dim const& start, utl::Dim const& step, utl::Dim const& end, std::size_t iter = 10 );
+  BufferPass( std::string const& source, std::string const& kernelName, std::size_t workPerItem,
+              utl::Dim const& start, utl::Dim const& step, utl::Dim const& end, std::size_t iter = 10 );
     
   double prof( utl::Dim const& ) override;
   
@@ -33,7 +46,12 @@ private :
   typedef utl::Matrix< ValueType, utl::column_major_tag > Matrix; // Volkov uses column-major layout only.
   typedef utl::Zeros< ValueType, utl::column_major_tag > Zeros;
   
-  bool          testing_;
+  static std::size_t constexpr workGroupSize = 16;
+  
+  ocl::Kernel& kernel() const;
+  
+  std::string   kernelName_;
+  std::size_t   workPerItem_;
   ocl::Platform platform_;
   ocl::Device   device_;
   ocl::Context  context_;
@@ -43,15 +61,20 @@ private :
 
 
 
-BufferPass::BufferPass( std::istream& source, utl::Dim const& start, utl::Dim const& step, utl::Dim const& end, std::size_t iter ):
-  ProfilePass< ValueType >( "BufferPass", start, step, end, iter ),
-  testing_( true ),
+BufferPass::BufferPass( std::string const& source, std::string const& kernelName, std::size_t workPerItem,
+                        utl::Dim const& start, utl::Dim const& step, utl::Dim const& end, std::size_t iter ):
+  ProfilePass< ValueType >( kernelName, start, step, end, iter ),
+  kernelName_( kernelName ),
+  workPerItem_( workPerItem ),
   platform_( ocl::device_type::CPU ),
   device_( platform_.device( ocl::device_type::CPU ) ),
   context_( device_ ),
   queue_( (platform_.insert( context_ ), platform_.setActiveContext( context_ ), context_), device_, CL_QUEUE_PROFILING_ENABLE ),
   program_( (context_.setActiveQueue( queue_ ), context_), utl::type::Single )
 {
+  this->setDevice( device_ );
+  this->setMetadata( "preferred_vector_width", std::to_string( device_.preferredVectorWidthFloat() ) );
+  
   program_ << source;
   
   std::ostringstream oss;
@@ -70,7 +93,7 @@ BufferPass::BufferPass( std::istream& source, utl::Dim const& start, utl::Dim co
   {
     context_.setActiveProgram( program_ );
     
-    ocl::Kernel& kernel( program_.kernel( "gemm_simple", utl::type::Single ) );
+    ocl::Kernel& kernel( this->kernel() );
     
     if ( !kernel.created() )
     {
@@ -87,6 +110,8 @@ BufferPass::BufferPass( std::istream& source, utl::Dim const& start, utl::Dim co
 
 double BufferPass::prof( utl::Dim const& dim )
 {
+  utl::ScopedTimer const region( "BufferPass" );
+  
   std::size_t const N = dim[0];
   std::size_t const M = dim[1];
   std::size_t const L = dim[2];
@@ -96,15 +121,19 @@ double BufferPass::prof( utl::Dim const& dim )
   Matrix lhs( N, L );
   Matrix rhs( L, M );
   
-  // for ( size_t i = 0; i < N * L; ++i ) lhs[i] = i + 1; for ( size_t i = 0; i < L * M; ++i ) rhs[i] = i + 1;
-  for ( size_t i = 0; i < N * L; ++i ) lhs[i] = i % L;
-  for ( size_t i = 0; i < L * M; ++i ) rhs[i] = i / L;
+  // Uniform operands in [-1,1), so the error is not hidden by exact integer products.
+  utl::Philox const random( 42 );
+  random.uniform( lhs.data(), lhs.size(), Type( -1 ), Type( 1 ) );
+  random.uniform( rhs.data(), rhs.size(), Type( -1 ), Type( 1 ), lhs.size() );
   
-  std::chrono::nanoseconds totalRuntime{ 0 };
+  double median = 0.0;
   
-  ocl::Kernel& kernel( program_.kernel( "gemm_simple", utl::type::Single ) );
-      
-  kernel.setWorkSize( 1, 1, M, N );
+  ocl::Kernel& kernel( this->kernel() );
+  
+  // Round up to whole work-groups, the kernels skip elements outside of the result.
+  std::size_t const tile = workGroupSize * workPerItem_;
+  
+  kernel.setWorkSize( workGroupSize, workGroupSize, ( M + tile - 1 ) / tile * workGroupSize, ( N + tile - 1 ) / tile * workGroupSize );
   
   size_t constexpr typeSize = sizeof (Type);
   size_t const numResultBytes = typeSize * result.size();
@@ -115,8 +144,10 @@ double BufferPass::prof( utl::Dim const& dim )
               bufLhs( context_, numLhsBytes, ocl::Buffer::ReadOnly ),
               bufRhs( context_, numRhsBytes, ocl::Buffer::ReadOnly );
 
-  for ( std::size_t i = 0; i < this->_iter; ++i )
+  median = this->measure( [&]() -> double
   {
+    utl::ScopedTimer const iteration( "iteration" );
+    
     // Copy data from host to device.
     ocl::Event const lhsWritten = bufLhs.writeAsync( queue_, 0u, lhs.data(), numLhsBytes );
     ocl::Event const rhsWritten = bufRhs.writeAsync( queue_, 0u, rhs.data(), numRhsBytes );
@@ -126,8 +157,8 @@ double BufferPass::prof( utl::Dim const& dim )
     
     unsigned int lhsOffset = 0, rhsOffset = 0, resOffset = 0;
     
-    // Matrix is column major
-    unsigned int lhsStrideX = L, rhsStrideX = M, resStrideX = M;
+    // Matrix is column major, so the stride between columns is the number of rows.
+    unsigned int lhsStrideX = N, rhsStrideX = L, resStrideX = N;
     unsigned int lhsStrideY = 1, rhsStrideY = 1, resStrideY = 1;
     
     // Execute kernel when both operands have been loaded.
@@ -144,41 +175,53 @@ double BufferPass::prof( utl::Dim const& dim )
                                             resStrideX,
                                             lhsStrideY,
                                             rhsStrideY,
-                                            resStrideY
+                                            resStrideY,
+                                            static_cast< unsigned int >( N ),
+                                            static_cast< unsigned int >( M )
                                           );
     
     // Copy result from device to host.
     ocl::Event const resultRead = bufResult.readAsync( queue_, 0u, result.data(), numResultBytes, ocl::EventList( multiplyDone ) );
     
     // Wait for all commands being executed.
-    queue_.finish();
+    {
+      utl::ScopedTimer const wait( "finish" );
+      queue_.finish();
+    }
     
     size_t const kernelRuntime_ns = multiplyDone.finishTime() - multiplyDone.startTime();
 
-    totalRuntime += std::chrono::nanoseconds( kernelRuntime_ns );
-  }
+    return kernelRuntime_ns * 1e-9;
+  } );
   
-   if( testing_ )
   {
-    auto const ref = lhs * rhs;
-    auto const diff = result - ref;
-    auto const iMax = std::max_element( diff.begin(), diff.end(), []( Type a, Type b ){
-      return std::fabs( a ) < std::fabs( b );
-    } );
+    utl::ScopedTimer const verify( "verify" );
     
-    std::cout /*<< lhs << '*' << rhs << " = " */ << "ref = " << ref << std::endl;
-    std::cout << "result = " << result << std::endl;
-    std::cout << "Maximal error: " << *iMax << std::endl;
+    Matrix const ref = lhs * rhs;
     
-    if ( *iMax != 0 )
+    Type maxError = 0;
+    for ( size_t i = 0; i < result.size(); ++i ) maxError = std::max( maxError, Type( std::fabs( result[i] - ref[i] ) ) );
+    
+    // Each element sums L products of magnitude below one, the reference rounds as well.
+    Type const bound = 2 * L * std::numeric_limits< Type >::epsilon() * L;
+    std::cout << kernelName_ << " maximal error: " << maxError << " (bound " << bound << ")" << std::endl;
+    
+    if ( maxError > bound )
     {
-      size_t const index = iMax - diff.begin();
-      std::cout << "ref[" << index << "] = " << ref[index] << " != result[" << index << "] = " << result[index] << std::endl;
+      throw std::runtime_error( kernelName_ + ": result exceeds the error bound" );
     }
   }
   
-  // Return average time.
-  return std::chrono::duration_cast< std::chrono::microseconds >( totalRuntime / this->_iter ).count();
+  // Return median time in seconds.
+  return median;
+}
+
+
+
+// The vector kernels are written for float only and are not templated.
+ocl::Kernel& BufferPass::kernel() const
+{
+  return program_.exists( kernelName_ ) ? program_.kernel( kernelName_ ) : program_.kernel( kernelName_, utl::type::Single );
 }
 
 
@@ -191,10 +234,17 @@ double BufferPass::ops( utl::Dim const& dim )
 
 
 
+/**
+ * Runs one of the image kernels of gemm.cl, which share the same arguments.
+ * 
+ * The kernels are invoked with workGroupSize x workGroupSize work-groups, each
+ * work-item computes a block of workPerItem x workPerItem elements of the result.
+ */
 class ImagePass : public utl::ProfilePass< Type >
 {
 public :
-  ImagePass( std::istream& source, utl::Dim const& start, utl::Dim const& step, utl::Dim const& end, std::size_t iter = 10 );
+  ImagePass( std::string const& source, std::string const& kernelName, std::size_t workGroupSize, std::size_t workPerItem,
+             utl::Dim const& start, utl::Dim const& step, utl::Dim const& end, std::size_t iter = 10 );
     
   double prof( utl::Dim const& ) override;
   
@@ -204,7 +254,9 @@ private :
   typedef utl::Matrix< ValueType, utl::column_major_tag > Matrix; // Volkov uses column-major layout only.
   typedef utl::Zeros< ValueType, utl::column_major_tag > Zeros;
   
-  bool          testing_;
+  std::string   kernelName_;
+  std::size_t   workGroupSize_;
+  std::size_t   workPerItem_;
   ocl::Platform platform_;
   ocl::Device   device_;
   ocl::Context  context_;
@@ -214,15 +266,20 @@ private :
 
 
 
-ImagePass::ImagePass( std::istream& source, utl::Dim const& start, utl::Dim const& step, utl::Dim const& end, std::size_t iter ):
-  ProfilePass< ValueType >( "ImagePass", start, step, end, iter ),
-  testing_( true ),
+ImagePass::ImagePass( std::string const& source, std::string const& kernelName, std::size_t workGroupSize, std::size_t workPerItem,
+                      utl::Dim const& start, utl::Dim const& step, utl::Dim const& end, std::size_t iter ):
+  ProfilePass< ValueType >( kernelName, start, step, end, iter ),
+  kernelName_( kernelName ),
+  workGroupSize_( workGroupSize ),
+  workPerItem_( workPerItem ),
   platform_( ocl::device_type::CPU ),
   device_( platform_.device( ocl::device_type::CPU ) ),
   context_( device_ ),
   queue_( (platform_.insert( context_ ), platform_.setActiveContext( context_ ), context_), device_, CL_QUEUE_PROFILING_ENABLE ),
   program_( (context_.setActiveQueue( queue_ ), context_), utl::type::Single )
 {
+  this->setDevice( device_ );
+  
   program_ << source;
   
   std::ostringstream oss;
@@ -241,7 +298,7 @@ ImagePass::ImagePass( std::istream& source, utl::Dim const& start, utl::Dim cons
   {
     context_.setActiveProgram( program_ );
     
-    ocl::Kernel& kernel( program_.kernel( "gemm_img" ) );
+    ocl::Kernel& kernel( program_.kernel( kernelName_ ) );
     
     if ( !kernel.created() )
     {
@@ -258,6 +315,8 @@ ImagePass::ImagePass( std::istream& source, utl::Dim const& start, utl::Dim cons
 
 double ImagePass::prof( utl::Dim const& dim )
 {
+  utl::ScopedTimer const region( "ImagePass" );
+  
   if ( !device_.imageSupport() )
     return 0.0;
   
@@ -270,24 +329,28 @@ double ImagePass::prof( utl::Dim const& dim )
   Matrix lhs( N, L );
   Matrix rhs( L, M );
   
-  // for ( size_t i = 0; i < N * L; ++i ) lhs[i] = i + 1; for ( size_t i = 0; i < L * M; ++i ) rhs[i] = i + 1;
-  for ( size_t i = 0; i < N * L; ++i ) lhs[i] = i % L;
-  for ( size_t i = 0; i < L * M; ++i ) rhs[i] = i / L;
+  // Uniform operands in [-1,1), so the error is not hidden by exact integer products.
+  utl::Philox const random( 43 );
+  random.uniform( lhs.data(), lhs.size(), Type( -1 ), Type( 1 ) );
+  random.uniform( rhs.data(), rhs.size(), Type( -1 ), Type( 1 ), lhs.size() );
   
-  std::chrono::nanoseconds totalRuntime{ 0 };
+  double median = 0.0;
   
-  ocl::Kernel& kernel( program_.kernel( "gemm_img" ) );
-      
-  kernel.setWorkSize( 1, 1, M, N );
+  ocl::Kernel& kernel( program_.kernel( kernelName_ ) );
+  
+  std::size_t const tile = workGroupSize_ * workPerItem_;
+  
+  kernel.setWorkSize( workGroupSize_, workGroupSize_, ( M + tile - 1 ) / tile * workGroupSize_, ( N + tile - 1 ) / tile * workGroupSize_ );
   
 //   size_t constexpr typeSize = sizeof (Type);
 //   size_t const numResultBytes = typeSize * result.size();
 //   size_t const numLhsBytes = typeSize * lhs.size();
 //   size_t const numRhsBytes = typeSize * rhs.size();
   
-  ocl::Image imgResult( context_, M, N, ocl::Image::Float, ocl::Image::A, ocl::Image::WriteOnly ),
-             imgLhs( context_, L, N, ocl::Image::Float, ocl::Image::A, ocl::Image::ReadOnly ),
-             imgRhs( context_, M, L, ocl::Image::Float, ocl::Image::A, ocl::Image::ReadOnly );
+  // The images hold the column-major matrices, i.e. x is the row and y the column.
+  ocl::Image imgResult( context_, N, M, ocl::Image::Float, ocl::Image::A, ocl::Image::WriteOnly ),
+             imgLhs( context_, N, L, ocl::Image::Float, ocl::Image::A, ocl::Image::ReadOnly ),
+             imgRhs( context_, L, M, ocl::Image::Float, ocl::Image::A, ocl::Image::ReadOnly );
              
   /*std::unique_ptr< float[] > lhsData( new float[L * N * 4] ), rhsData( new float[M * L * 4] );
   
@@ -312,12 +375,14 @@ double ImagePass::prof( utl::Dim const& dim )
     rhsData[i * 4 + 3] = rhs[i];
   }*/
 
-  for ( std::size_t i = 0; i < this->_iter; ++i )
+  median = this->measure( [&]() -> double
   {
+    utl::ScopedTimer const iteration( "iteration" );
+    
     // Copy data from host to device.
     size_t           origin[] = { 0u, 0u, 0u };
-    size_t const     lhsRegion[] = { L, N, 1u };
-    size_t const     rhsRegion[] = { M, L, 1u };
+    size_t const     lhsRegion[] = { N, L, 1u };
+    size_t const     rhsRegion[] = { L, M, 1u };
     
     ocl::Event const lhsWritten = imgLhs.writeAsync( queue_, origin, lhs.data(), lhsRegion );
     ocl::Event const rhsWritten = imgRhs.writeAsync( queue_, origin, rhs.data(), rhsRegion );
@@ -357,41 +422,43 @@ double ImagePass::prof( utl::Dim const& dim )
     
     // Copy result from device to host.
 //     std::unique_ptr< float[] > resultData( new float[N * M * 4] );
-    size_t const resRegion[] = { M, N, 1u };
+    size_t const resRegion[] = { N, M, 1u };
     ocl::Event const resultRead = imgResult.readAsync( queue_, origin, result.data(), resRegion, ocl::EventList( multiplyDone ) );
     
     // Wait for all commands being executed.
-    queue_.finish();
+    {
+      utl::ScopedTimer const wait( "finish" );
+      queue_.finish();
+    }
     
 /*    for ( size_t i = 0; i < N * M; ++i )
       result[i] = resultData[i * 4 + 3];*/
     
     size_t const kernelRuntime_ns = multiplyDone.finishTime() - multiplyDone.startTime();
 
-    totalRuntime += std::chrono::nanoseconds( kernelRuntime_ns );
-  }
+    return kernelRuntime_ns * 1e-9;
+  } );
   
-   if( testing_ )
   {
-    auto const ref = lhs * rhs;
-    auto const diff = result - ref;
-    auto const iMax = std::max_element( diff.begin(), diff.end(), []( Type a, Type b ){
-      return std::fabs( a ) < std::fabs( b );
-    } );
+    utl::ScopedTimer const verify( "verify" );
+    
+    Matrix const ref = lhs * rhs;
     
-    std::cout /*<< lhs << '*' << rhs << " = " */ << "ref = " << ref << std::endl;
-    std::cout << "result = " << result << std::endl;
-    std::cout << "Maximal error: " << *iMax << std::endl;
+    Type maxError = 0;
+    for ( size_t i = 0; i < result.size(); ++i ) maxError = std::max( maxError, Type( std::fabs( result[i] - ref[i] ) ) );
     
-    if ( *iMax != 0 )
+    // Each element sums L products of magnitude below one, the reference rounds as well.
+    Type const bound = 2 * L * std::numeric_limits< Type >::epsilon() * L;
+    std::cout << kernelName_ << " maximal error: " << maxError << " (bound " << bound << ")" << std::endl;
+    
+    if ( maxError > bound )
     {
-      size_t const index = iMax - diff.begin();
-      std::cout << "ref[" << index << "] = " << ref[index] << " != result[" << index << "] = " << result[index] << std::endl;
+      throw std::runtime_error( kernelName_ + ": result exceeds the error bound" );
     }
   }
   
-  // Return average time.
-  return std::chrono::duration_cast< std::chrono::microseconds >( totalRuntime / this->_iter ).count();
+  // Return median time in seconds.
+  return median;
 }
 
 
@@ -404,24 +471,683 @@ double ImagePass::ops( utl::Dim const& dim )
 
 
 
+/**
+ * Runs ocl::blas::gemm, which chooses the kernel of gemm.cl from the tuning table of the device.
+ */
+class BlasPass : public utl::ProfilePass< Type >
+{
+public :
+  BlasPass( utl::Dim const& start, utl::Dim const& step, utl::Dim const& end, std::size_t iter = 10 );
+    
+  double prof( utl::Dim const& ) override;
+  
+  double ops( utl::Dim const& dim ) override;
+  
+private :
+  typedef utl::Matrix< ValueType, utl::column_major_tag > Matrix;
+  typedef utl::Zeros< ValueType, utl::column_major_tag > Zeros;
+  
+  ocl::Platform platform_;
+  ocl::Device   device_;
+  ocl::Context  context_;
+  ocl::Queue    queue_;
+};
+
+
+
+BlasPass::BlasPass( utl::Dim const& start, utl::Dim const& step, utl::Dim const& end, std::size_t iter ):
+  ProfilePass< ValueType >( "BlasPass", start, step, end, iter ),
+  platform_( ocl::device_type::CPU ),
+  device_( platform_.device( ocl::device_type::CPU ) ),
+  context_( device_ ),
+  queue_( (platform_.insert( context_ ), platform_.setActiveContext( context_ ), context_), device_, CL_QUEUE_PROFILING_ENABLE )
+{
+  context_.setActiveQueue( queue_ );
+  
+  this->setDevice( device_ );
+  
+  ocl::blas::GemmConfig const config = ocl::blas::gemmConfig( device_ );
+  char const* const kernels[] = { "naive", "blocked", "vector", "image" };
+  
+  this->setMetadata( "gemm_kernel", kernels[config.kernel] );
+}
+
+
+
+double BlasPass::prof( utl::Dim const& dim )
+{
+  utl::ScopedTimer const region( "BlasPass" );
+  
+  std::size_t const N = dim[0];
+  std::size_t const M = dim[1];
+  std::size_t const L = dim[2];
+  
+  Zeros result( N, M );
+  
+  Matrix lhs( N, L );
+  Matrix rhs( L, M );
+  
+  // Uniform operands in [-1,1), so the error is not hidden by exact integer products.
+  utl::Philox const random( 44 );
+  random.uniform( lhs.data(), lhs.size(), Type( -1 ), Type( 1 ) );
+  random.uniform( rhs.data(), rhs.size(), Type( -1 ), Type( 1 ), lhs.size() );
+  
+  size_t const numResultBytes = sizeof (Type) * result.size();
+  size_t const numLhsBytes = sizeof (Type) * lhs.size();
+  size_t const numRhsBytes = sizeof (Type) * rhs.size();
+  
+  ocl::Buffer bufResult( context_, numResultBytes, ocl::Buffer::WriteOnly ),
+              bufLhs( context_, numLhsBytes, ocl::Buffer::ReadOnly ),
+              bufRhs( context_, numRhsBytes, ocl::Buffer::ReadOnly );
+  
+  double const median = this->measure( [&]() -> double
+  {
+    utl::ScopedTimer const iteration( "iteration" );
+    
+    ocl::EventList operandsWritten;
+    operandsWritten << bufLhs.writeAsync( queue_, 0u, lhs.data(), numLhsBytes ) << bufRhs.writeAsync( queue_, 0u, rhs.data(), numRhsBytes );
+    
+    // The first call builds the kernels, which the warmup iterations hide.
+    ocl::Event const multiplyDone = ocl::blas::gemm< Type >( ocl::blas::NoTrans, ocl::blas::NoTrans, N, M, L,
+                                                             1, bufLhs, N, bufRhs, L, 0, bufResult, N, operandsWritten );
+    
+    bufResult.readAsync( queue_, 0u, result.data(), numResultBytes, ocl::EventList( multiplyDone ) );
+    
+    {
+      utl::ScopedTimer const wait( "finish" );
+      queue_.finish();
+    }
+    
+    return ( multiplyDone.finishTime() - multiplyDone.startTime() ) * 1e-9;
+  } );
+  
+  Matrix const ref = lhs * rhs;
+  
+  Type maxError = 0;
+  for ( size_t i = 0; i < result.size(); ++i ) maxError = std::max( maxError, Type( std::fabs( result[i] - ref[i] ) ) );
+  
+  // Each element sums L products of magnitude below one, the reference rounds as well.
+  Type const bound = 2 * L * std::numeric_limits< Type >::epsilon() * L;
+  std::cout << "Maximal error: " << maxError << " (bound " << bound << ")" << std::endl;
+  
+  if ( maxError > bound )
+  {
+    throw std::runtime_error( "BlasPass: result exceeds the error bound" );
+  }
+  
+  return median;
+}
+
+
+
+double BlasPass::ops( utl::Dim const& dim )
+{
+  // N * M * (L + (L - 1))
+  return dim[0] * dim[1] * (2.0 * dim[2] - 1.0);
+}
+
+
+/**
+ * Runs ocl::blas::gemmStrassen with the given crossover and compares it with ocl::blas::gemm.
+ * 
+ * Both are timed on the host, since gemmStrassen consists of many kernels. The speedup over
+ * gemm and the difference to its result are printed next to the error bound of the recursion.
+ */
+class StrassenPass : public utl::ProfilePass< Type >
+{
+public :
+  StrassenPass( std::size_t crossover, utl::Dim const& start, utl::Dim const& step, utl::Dim const& end, std::size_t iter = 10 );
+    
+  double prof( utl::Dim const& ) override;
+  
+  double ops( utl::Dim const& dim ) override;
+  
+private :
+  typedef utl::Matrix< ValueType, utl::column_major_tag > Matrix;
+  typedef utl::Zeros< ValueType, utl::column_major_tag > Zeros;
+  
+  std::size_t   crossover_;
+  ocl::Platform platform_;
+  ocl::Device   device_;
+  ocl::Context  context_;
+  ocl::Queue    queue_;
+};
+
+
+
+StrassenPass::StrassenPass( std::size_t crossover, utl::Dim const& start, utl::Dim const& step, utl::Dim const& end, std::size_t iter ):
+  ProfilePass< ValueType >( "StrassenPass", start, step, end, iter ),
+  crossover_( crossover ),
+  platform_( ocl::device_type::CPU ),
+  device_( platform_.device( ocl::device_type::CPU ) ),
+  context_( device_ ),
+  queue_( (platform_.insert( context_ ), platform_.setActiveContext( context_ ), context_), device_, CL_QUEUE_PROFILING_ENABLE )
+{
+  context_.setActiveQueue( queue_ );
+  
+  this->setDevice( device_ );
+  
+  ocl::blas::GemmConfig config = ocl::blas::gemmConfig( device_ );
+  config.crossover = crossover_;
+  ocl::blas::setGemmConfig( device_, config );
+  
+  this->setMetadata( "strassen_crossover", std::to_string( crossover_ ) );
+}
+
+
+
+double StrassenPass::prof( utl::Dim const& dim )
+{
+  utl::ScopedTimer const region( "StrassenPass" );
+  
+  std::size_t const N = dim[0];
+  std::size_t const M = dim[1];
+  std::size_t const L = dim[2];
+  
+  Zeros result( N, M ), classic( N, M );
+  
+  Matrix lhs( N, L );
+  Matrix rhs( L, M );
+  
+  // Uniform operands in [-1,1), so the error is not hidden by exact integer products.
+  utl::Philox const random( 45 );
+  random.uniform( lhs.data(), lhs.size(), Type( -1 ), Type( 1 ) );
+  random.uniform( rhs.data(), rhs.size(), Type( -1 ), Type( 1 ), lhs.size() );
+  
+  size_t const numResultBytes = sizeof (Type) * result.size();
+  size_t const numLhsBytes = sizeof (Type) * lhs.size();
+  size_t const numRhsBytes = sizeof (Type) * rhs.size();
+  
+  ocl::Buffer bufResult( context_, numResultBytes ),
+              bufLhs( context_, numLhsBytes, ocl::Buffer::ReadOnly ),
+              bufRhs( context_, numRhsBytes, ocl::Buffer::ReadOnly );
+  
+  bufLhs.write( queue_, lhs.data(), numLhsBytes );
+  bufRhs.write( queue_, rhs.data(), numRhsBytes );
+  
+  auto const timed = [&]( bool strassen ) -> double
+  {
+    auto const start = std::chrono::steady_clock::now();
+    
+    if ( strassen ) ocl::blas::gemmStrassen< Type >( N, M, L, 1, bufLhs, N, bufRhs, L, 0, bufResult, N );
+    else            ocl::blas::gemm< Type >( ocl::blas::NoTrans, ocl::blas::NoTrans, N, M, L, 1, bufLhs, N, bufRhs, L, 0, bufResult, N );
+    queue_.finish();
+    
+    return std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+  };
+  
+  // The classic product is the reference of the speedup and of the error, the first call builds the kernels.
+  timed( false );
+  std::vector< double > classicTimes;
+  for ( std::size_t i = 0; i < 3; ++i ) classicTimes.push_back( timed( false ) );
+  bufResult.read( queue_, classic.data(), numResultBytes );
+  
+  double const median = this->measure( [&]() -> double
+  {
+    utl::ScopedTimer const iteration( "iteration" );
+    return timed( true );
+  } );
+  bufResult.read( queue_, result.data(), numResultBytes );
+  
+  Type maxError = 0, maxLhs = 0, maxRhs = 0;
+  for ( size_t i = 0; i < result.size(); ++i ) maxError = std::max( maxError, Type( std::fabs( result[i] - classic[i] ) ) );
+  for ( size_t i = 0; i < lhs.size(); ++i ) maxLhs = std::max( maxLhs, Type( std::fabs( lhs[i] ) ) );
+  for ( size_t i = 0; i < rhs.size(); ++i ) maxRhs = std::max( maxRhs, Type( std::fabs( rhs[i] ) ) );
+  
+  // The bound holds for square matrices, the largest dimension gives the weakest one.
+  std::size_t const n = std::max( N, std::max( M, L ) );
+  double const bound = ocl::blas::strassenErrorBound< Type >( n, crossover_ ) * maxLhs * maxRhs;
+  double const classicBound = n * double( n ) * std::numeric_limits< Type >::epsilon() / 2 * maxLhs * maxRhs;
+  
+  std::sort( classicTimes.begin(), classicTimes.end() );
+  std::cout << "Speedup over gemm: " << classicTimes[1] / median << std::endl;
+  std::cout << "Maximal difference to gemm: " << maxError << " (Strassen bound " << bound << ", gemm bound " << classicBound << ")" << std::endl;
+  
+  // The difference includes the error of gemm, which stays below its own bound.
+  if ( maxError > bound + classicBound )
+  {
+    throw std::runtime_error( "StrassenPass: result exceeds the error bound" );
+  }
+  
+  return median;
+}
+
+
+
+double StrassenPass::ops( utl::Dim const& dim )
+{
+  // The operations of the classic product, so the performance is comparable with the other passes.
+  return dim[0] * dim[1] * (2.0 * dim[2] - 1.0);
+}
+
+
+
+/**
+ * Runs count products of size x size x size matrices with ocl::Blas::gemmBatched and compares
+ * it with one ocl::Blas::gemm per product, which is the case batching was added for.
+ * 
+ * The strided batch is measured, the Batch with one entry per product and the
+ * per-product gemm are timed on the host as well. All three are checked against
+ * a product on the host.
+ */
+class BatchedPass : public utl::ProfilePass< Type >
+{
+public :
+  BatchedPass( utl::Dim const& start, utl::Dim const& step, utl::Dim const& end, std::size_t iter = 10 );
+    
+  double prof( utl::Dim const& ) override;
+  
+  double ops( utl::Dim const& dim ) override;
+  
+private :
+  ocl::Platform platform_;
+  ocl::Device   device_;
+  ocl::Context  context_;
+  ocl::Queue    queue_;
+};
+
+
+
+BatchedPass::BatchedPass( utl::Dim const& start, utl::Dim const& step, utl::Dim const& end, std::size_t iter ):
+  ProfilePass< ValueType >( "BatchedPass", start, step, end, iter ),
+  platform_( ocl::device_type::CPU ),
+  device_( platform_.device( ocl::device_type::CPU ) ),
+  context_( device_ ),
+  queue_( (platform_.insert( context_ ), platform_.setActiveContext( context_ ), context_), device_, CL_QUEUE_PROFILING_ENABLE )
+{
+  context_.setActiveQueue( queue_ );
+  
+  this->setDevice( device_ );
+}
+
+
+
+double BatchedPass::prof( utl::Dim const& dim )
+{
+  utl::ScopedTimer const region( "BatchedPass" );
+  
+  // dim = ( size, count )
+  std::size_t const size = dim[0];
+  std::size_t const count = dim[1];
+  std::size_t const elements = size * size;
+  
+  std::vector< Type > lhs( count * elements ), rhs( count * elements ), result( count * elements ), ref( count * elements, 0 );
+  
+  utl::Philox const random( 46 );
+  random.uniform( lhs.data(), lhs.size(), Type( -1 ), Type( 1 ) );
+  random.uniform( rhs.data(), rhs.size(), Type( -1 ), Type( 1 ), lhs.size() );
+  
+  for ( std::size_t p = 0; p < count; ++p )
+    for ( std::size_t j = 0; j < size; ++j )
+      for ( std::size_t l = 0; l < size; ++l )
+        for ( std::size_t i = 0; i < size; ++i )
+          ref[p * elements + i + j * size] += lhs[p * elements + i + l * size] * rhs[p * elements + l + j * size];
+  
+  size_t const numBytes = sizeof (Type) * lhs.size();
+  
+  ocl::Buffer bufResult( context_, numBytes ),
+              bufLhs( context_, numBytes, ocl::Buffer::ReadOnly ),
+              bufRhs( context_, numBytes, ocl::Buffer::ReadOnly );
+  
+  bufLhs.write( queue_, lhs.data(), numBytes );
+  bufRhs.write( queue_, rhs.data(), numBytes );
+  
+  std::vector< ocl::Blas::BatchEntry > entries( count );
+  for ( std::size_t p = 0; p < count; ++p )
+  {
+    unsigned int const n = static_cast< unsigned int >( size ), offset = static_cast< unsigned int >( p * elements );
+    entries[p] = ocl::Blas::BatchEntry{ n, n, n, offset, n, offset, n, offset, n };
+  }
+  
+  ocl::Blas& blas = ocl::blas::library( context_ );
+  ocl::Blas::Batch const batch( context_, queue_, entries );
+  
+  enum Mode { PerProduct, Strided, Described };
+  
+  auto const timed = [&]( Mode mode ) -> double
+  {
+    auto const start = std::chrono::steady_clock::now();
+    
+    if ( mode == Strided )
+      blas.gemmBatched< Type >( queue_, ocl::blas::NoTrans, ocl::blas::NoTrans, size, size, size,
+                                1, bufLhs, size, elements, bufRhs, size, elements, 0, bufResult, size, elements, count );
+    else if ( mode == Described )
+      blas.gemmBatched< Type >( queue_, ocl::blas::NoTrans, ocl::blas::NoTrans, 1, bufLhs, bufRhs, 0, bufResult, batch );
+    else
+      for ( std::size_t p = 0; p < count; ++p )
+        blas.gemm< Type >( queue_, ocl::blas::NoTrans, ocl::blas::NoTrans, size, size, size,
+                           1, bufLhs, p * elements, size, bufRhs, p * elements, size, 0, bufResult, p * elements, size );
+    queue_.finish();
+    
+    return std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+  };
+  
+  // Largest difference of the result Buffer to the host product.
+  auto const maxError = [&]() -> Type
+  {
+    bufResult.read( queue_, result.data(), numBytes );
+    
+    Type error = 0;
+    for ( std::size_t i = 0; i < result.size(); ++i ) error = std::max( error, Type( std::fabs( result[i] - ref[i] ) ) );
+    return error;
+  };
+  
+  // The first calls build the kernels.
+  timed( PerProduct );
+  double const perProduct = timed( PerProduct );
+  Type const perProductError = maxError();
+  
+  timed( Described );
+  double const described = timed( Described );
+  Type const describedError = maxError();
+  
+  timed( Strided );
+  double const median = this->measure( [&]() -> double
+  {
+    utl::ScopedTimer const iteration( "iteration" );
+    return timed( Strided );
+  } );
+  Type const stridedError = maxError();
+  
+  std::cout << count << " products of " << size << "x" << size << ": strided " << median << " s, batch " << described
+            << " s, one gemm per product " << perProduct << " s (speedup " << perProduct / median << ")" << std::endl;
+  std::cout << "Maximal error: " << stridedError << " strided, " << describedError << " batch, " << perProductError << " gemm" << std::endl;
+  
+  Type const bound = 2 * size * std::numeric_limits< Type >::epsilon() * size;
+  if ( std::max( stridedError, std::max( describedError, perProductError ) ) > bound )
+  {
+    throw std::runtime_error( "BatchedPass: result exceeds the error bound" );
+  }
+  
+  return median;
+}
+
+
+
+double BatchedPass::ops( utl::Dim const& dim )
+{
+  // count * size * size * (size + (size - 1))
+  return dim[1] * dim[0] * dim[0] * (2.0 * dim[0] - 1.0);
+}
+
+
+
+/**
+ * Computes C = alpha * A * B + beta * C in host memory with ocl::Blas::gemmStreamed
+ * and a device budget of an eighth of the operands, so the product is split into tiles.
+ * 
+ * Sizes which are no multiple of the tiles and a C with padded columns exercise the
+ * edges of the tiles, beta != 0 the upload of C. The result is checked against
+ * a product on the host.
+ */
+class StreamedPass : public utl::ProfilePass< Type >
+{
+public :
+  StreamedPass( utl::Dim const& start, utl::Dim const& step, utl::Dim const& end, std::size_t iter = 10 );
+    
+  double prof( utl::Dim const& ) override;
+  
+  double ops( utl::Dim const& dim ) override;
+  
+private :
+  ocl::Platform platform_;
+  ocl::Device   device_;
+  ocl::Context  context_;
+  ocl::Queue    queue_;
+};
+
+
+
+StreamedPass::StreamedPass( utl::Dim const& start, utl::Dim const& step, utl::Dim const& end, std::size_t iter ):
+  ProfilePass< ValueType >( "StreamedPass", start, step, end, iter ),
+  platform_( ocl::device_type::CPU ),
+  device_( platform_.device( ocl::device_type::CPU ) ),
+  context_( device_ ),
+  queue_( (platform_.insert( context_ ), platform_.setActiveContext( context_ ), context_), device_, CL_QUEUE_PROFILING_ENABLE )
+{
+  context_.setActiveQueue( queue_ );
+  
+  this->setDevice( device_ );
+}
+
+
+
+double StreamedPass::prof( utl::Dim const& dim )
+{
+  utl::ScopedTimer const region( "StreamedPass" );
+  
+  std::size_t const N = dim[0];
+  std::size_t const M = dim[1];
+  std::size_t const L = dim[2];
+  
+  // The columns of C are padded, so a tile of C is not contiguous in host memory.
+  std::size_t const ldc = N + 3;
+  
+  Type const alpha = Type( 0.5 ), beta = Type( -2 );
+  
+  std::vector< Type > lhs( N * L ), rhs( L * M ), initial( ldc * M ), result( ldc * M );
+  
+  utl::Philox const random( 47 );
+  random.uniform( lhs.data(), lhs.size(), Type( -1 ), Type( 1 ) );
+  random.uniform( rhs.data(), rhs.size(), Type( -1 ), Type( 1 ), lhs.size() );
+  random.uniform( initial.data(), initial.size(), Type( -1 ), Type( 1 ), lhs.size() + rhs.size() );
+  
+  // The padding of C keeps its initial values.
+  std::vector< Type > ref( initial );
+  for ( std::size_t j = 0; j < M; ++j )
+  {
+    for ( std::size_t i = 0; i < N; ++i )
+    {
+      Type c = 0;
+      for ( std::size_t l = 0; l < L; ++l ) c += lhs[i + l * N] * rhs[l + j * L];
+      ref[i + j * ldc] = alpha * c + beta * initial[i + j * ldc];
+    }
+  }
+  
+  // An eighth of the operands, so every operand is split into several tiles.
+  std::size_t const deviceBytes = (N * L + L * M + N * M) * sizeof (Type) / 8;
+  
+  ocl::Blas& blas = ocl::blas::library( context_ );
+  
+  auto const timed = [&]() -> double
+  {
+    result = initial;
+    
+    auto const start = std::chrono::steady_clock::now();
+    
+    blas.gemmStreamed< Type >( queue_, ocl::blas::NoTrans, ocl::blas::NoTrans, N, M, L,
+                               alpha, lhs.data(), N, rhs.data(), L, beta, result.data(), ldc, deviceBytes );
+    
+    return std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+  };
+  
+  // The first call builds the kernels.
+  timed();
+  double const median = this->measure( [&]() -> double
+  {
+    utl::ScopedTimer const iteration( "iteration" );
+    return timed();
+  } );
+  
+  Type maxError = 0;
+  for ( std::size_t i = 0; i < result.size(); ++i ) maxError = std::max( maxError, Type( std::fabs( result[i] - ref[i] ) ) );
+  
+  Type const bound = 2 * L * std::numeric_limits< Type >::epsilon() * (std::fabs( alpha ) * L + std::fabs( beta ));
+  std::cout << "Streamed through " << deviceBytes << " bytes, maximal error: " << maxError << " (bound " << bound << ")" << std::endl;
+  
+  if ( maxError > bound )
+  {
+    throw std::runtime_error( "StreamedPass: result exceeds the error bound" );
+  }
+  
+  return median;
+}
+
+
+
+double StreamedPass::ops( utl::Dim const& dim )
+{
+  // N * M * (L + (L - 1))
+  return dim[0] * dim[1] * (2.0 * dim[2] - 1.0);
+}
+
+
+
+class HostPass : public utl::ProfilePass< Type >
+{
+public :
+  HostPass( utl::Dim const& start, utl::Dim const& step, utl::Dim const& end, std::size_t iter = 10 );
+    
+  double prof( utl::Dim const& ) override;
+  
+  double ops( utl::Dim const& dim ) override;
+  
+private :
+  typedef utl::Matrix< ValueType, utl::column_major_tag > Matrix;
+};
+
+
+
+HostPass::HostPass( utl::Dim const& start, utl::Dim const& step, utl::Dim const& end, std::size_t iter ):
+  ProfilePass< ValueType >( "HostPass", start, step, end, iter )
+{
+}
+
+
+
+double HostPass::prof( utl::Dim const& dim )
+{
+  utl::ScopedTimer const region( "HostPass" );
+  
+  std::size_t const N = dim[0];
+  std::size_t const M = dim[1];
+  std::size_t const L = dim[2];
+  
+  Matrix lhs( N, L );
+  Matrix rhs( L, M );
+  
+  for ( size_t i = 0; i < N * L; ++i ) lhs[i] = i % L;
+  for ( size_t i = 0; i < L * M; ++i ) rhs[i] = i / L;
+  
+  double median = 0.0;
+  
+  median = this->measure( [&]() -> double
+  {
+    utl::ScopedTimer const iteration( "iteration" );
+    
+    auto const start = std::chrono::steady_clock::now();
+    
+    Matrix const result = lhs * rhs;
+    
+    return std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+  } );
+  
+  // Return median time in seconds.
+  return median;
+}
+
+
+
+double HostPass::ops( utl::Dim const& dim )
+{
+  // N * M * (L + (L - 1))
+  return dim[0] * dim[1] * (2.0 * dim[2] - 1.0);
+}
+
+
+
 int main( int argc, char** argv )
 {
   utl::Args args( argc, argv );
   
-  if ( args.size() == 2 )
+  if ( args.size() >= 2 && args.size() <= 4 )
   {
     std::string const filename( args.toString( 1 ) );
     std::ifstream file( filename );
     
     if ( file.is_open() )
     {
+      // Every pass builds its own program from the source.
+      std::string const source( ( std::istreambuf_iterator< char >( file ) ), std::istreambuf_iterator< char >() );
+      
+      // ocl::blas::gemm dispatches to the kernels of the same source.
+      ocl::blas::setKernelSource( source );
+      
       utl::ProfilePassManager< Type > mgr;
   
-//       mgr << std::make_shared<BufferPass>( file, utl::Dim( 256, 256, 256 ), utl::Dim( 16, 16, 16 ), utl::Dim( 256, 256, 256 ) );
-      mgr << std::make_shared<ImagePass>( file, utl::Dim( 255, 255, 255 ), utl::Dim( 16, 16, 16 ), utl::Dim( 256, 256, 256 ) );
+      mgr << std::make_shared<BufferPass>( source, "gemm", 1, utl::Dim( 255, 255, 255 ), utl::Dim( 16, 16, 16 ), utl::Dim( 256, 256, 256 ) );
+      
+      // Double buffering and pipelining pay off once K is large, so the blocked kernels are also run with long panels.
+      std::vector< utl::Dim > const blockedSizes = { utl::Dim( 255, 255, 255 ), utl::Dim( 256, 256, 1024 ), utl::Dim( 256, 256, 4096 ) };
+      
+      for ( std::string const name : { "gemm_basic_algorithm", "gemm_double_buffering", "gemm_pipelining" } )
+      {
+        auto const pass = std::make_shared<BufferPass>( source, name, 4, blockedSizes.front(), utl::Dim( 16, 16, 16 ), blockedSizes.back() );
+        pass->setSweep( blockedSizes );
+        mgr << pass;
+      }
+      
+      // One pass per vector width, the report records which width the device prefers.
+      for ( std::size_t const width : { 4u, 8u } )
+      {
+        auto const pass = std::make_shared<BufferPass>( source, "gemm_vec" + std::to_string( width ), width,
+                                                        blockedSizes.front(), utl::Dim( 16, 16, 16 ), blockedSizes.back() );
+        pass->setSweep( blockedSizes );
+        mgr << pass;
+      }
+      
+      mgr << std::make_shared<ImagePass>( source, "gemm_img", 1, 1, utl::Dim( 255, 255, 255 ), utl::Dim( 16, 16, 16 ), utl::Dim( 256, 256, 256 ) );
+      
+      // The blocked image kernels run over the same sizes as the blocked buffer kernels.
+      for ( std::string const name : { "gemm_img_basic_algorithm", "gemm_img_double_buffering", "gemm_img_pipelining" } )
+      {
+        auto const pass = std::make_shared<ImagePass>( source, name, 16, 4, blockedSizes.front(), utl::Dim( 16, 16, 16 ), blockedSizes.back() );
+        pass->setSweep( blockedSizes );
+        mgr << pass;
+      }
+      
+      // The library front end over the same sizes, with the kernel the tuning table selects.
+      {
+        auto const pass = std::make_shared<BlasPass>( blockedSizes.front(), utl::Dim( 16, 16, 16 ), blockedSizes.back() );
+        pass->setSweep( blockedSizes );
+        mgr << pass;
+      }
+      
+      // Strassen only pays off for large products, so the crossover is lowered to recurse once or twice.
+      {
+        std::vector< utl::Dim > const strassenSizes = { utl::Dim( 1024, 1024, 1024 ), utl::Dim( 2048, 2048, 2048 ) };
+        auto const pass = std::make_shared<StrassenPass>( 512, strassenSizes.front(), utl::Dim( 16, 16, 16 ), strassenSizes.back(), 3 );
+        pass->setSweep( strassenSizes );
+        mgr << pass;
+      }
+      
+      // Many small products, where a launch per product leaves most of the device idle.
+      {
+        std::vector< utl::Dim > const batchedSizes = { utl::Dim( 8, 16384 ), utl::Dim( 16, 4096 ) };
+        auto const pass = std::make_shared<BatchedPass>( batchedSizes.front(), utl::Dim( 8, 1 ), batchedSizes.back(), 5 );
+        pass->setSweep( batchedSizes );
+        mgr << pass;
+      }
+      
+      // A product which does not fit into the device budget, with sizes which are no multiple of the tiles.
+      mgr << std::make_shared<StreamedPass>( utl::Dim( 500, 700, 900 ), utl::Dim( 16, 16, 16 ), utl::Dim( 500, 700, 900 ), 3 );
+      
+      // The counters sum up all threads of this process, which for the device passes
+      // include the threads of the OpenCL runtime, so only the host pass reads them.
+      {
+        auto const pass = std::make_shared<HostPass>( utl::Dim( 255, 255, 255 ), utl::Dim( 16, 16, 16 ), utl::Dim( 256, 256, 256 ) );
+        pass->setCounters( true );
+        mgr << pass;
+      }
   
       mgr.run();
       mgr.write( std::cout );
+      
+      // Host side breakdown of the passes.
+      utl::ScopedTimer::report( std::clog );
+      
+      if ( args.size() > 2 ) mgr.write( args.toString( 2 ) );
+      if ( args.size() > 3 && mgr.compare( args.toString( 3 ), std::cout ) > 0 ) return EXIT_FAILURE;
     }
     else
     {
@@ -430,7 +1156,7 @@ int main( int argc, char** argv )
   }
   else
   {
-    std::cout << "Usage: " << args.at( 0 ) << " <kernel.cl>" << std::endl;
+    std::cout << "Usage: " << args.at( 0 ) << " <kernel.cl> [<results.json|results.csv> [<baseline.csv>]]" << std::endl;
   }
   
   return EXIT_SUCCESS;
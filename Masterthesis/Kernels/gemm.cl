@@ -18,6 +18,11 @@
  * @param lhsStrideY Distance between consecutive @c lhs values in vertical direction.
  * @param rhsStrideY The same for @c rhs.
  * @param resStrideY The same for @c res.
+ * @param resRows Number of rows of the @c res (sub-) matrix.
+ * @param resCols Number of columns of the @c res (sub-) matrix.
+ * 
+ * The index space may be larger than @c res, so it can be
+ * rounded up to a multiple of the work-group size.
  * 
  * @tparam T Datatype of the matrix operands.
  */
@@ -35,13 +40,18 @@ __kernel void gemm(
   uint const        resStrideX,
   uint const        lhsStrideY,
   uint const        rhsStrideY,
-  uint const        resStrideY
+  uint const        resStrideY,
+  uint const        resRows,
+  uint const        resCols
 )
 {
   size_t const gx  = get_global_id( 0u );
   size_t const gy  = get_global_id( 1u );
   T            tmp = (T) 0;
   
+  if ( gx >= resCols || gy >= resRows )
+    return;
+  
   for ( size_t k = 0u; k < innerDim; ++k )
     tmp += lhs[lhsOffset + gy * lhsStrideY + k * lhsStrideX] *
            rhs[rhsOffset + gx * rhsStrideX + k * rhsStrideY];
@@ -52,7 +62,21 @@ __kernel void gemm(
 
 
 /**
- * @see gemm().
+ * Blocked matrix-matrix multiplication, @see gemm().
+ * 
+ * Each work-group computes a 64x64 tile of @c res. The tiles of
+ * @c lhs and @c rhs are staged in local memory in steps of 16
+ * along the inner dimension, so every value loaded from global
+ * memory is used 64 times. Each work-item accumulates a 4x4
+ * micro-tile in registers, which needs 8 local memory loads per
+ * 16 multiply-adds. The rows of the micro-tile are 16 apart, so
+ * that consecutive work-items in x direction access consecutive
+ * rows, which are coalesced for column-major matrices and free of
+ * local memory bank conflicts. Values outside of @c res and beyond
+ * @c K are read as zero and not written, so any size is allowed.
+ * 
+ * Invoke the kernel with a local size of 16x16 and a global size
+ * of ceil(resCols/64)*16 x ceil(resRows/64)*16.
  */
 template<class T>
 __kernel void gemm_basic_algorithm(
@@ -68,15 +92,94 @@ __kernel void gemm_basic_algorithm(
   uint const        resStrideX,
   uint const        lhsStrideY,
   uint const        rhsStrideY,
-  uint const        resStrideY
+  uint const        resStrideY,
+  uint const        resRows,
+  uint const        resCols
 )
 {
+  enum { WG = 16, WPI = 4, TILE = WG * WPI, TILE_K = 16 };
+  
+  __local T lhsTile[TILE_K][TILE];
+  __local T rhsTile[TILE_K][TILE + 1]; // Padded, as consecutive work-items store consecutive k.
+  
+  uint const lx   = get_local_id( 0u );
+  uint const ly   = get_local_id( 1u );
+  uint const tid  = ly * WG + lx;
+  uint const row0 = get_group_id( 1u ) * TILE;
+  uint const col0 = get_group_id( 0u ) * TILE;
+  
+  T acc[WPI][WPI];
+  
+  for ( uint i = 0u; i < WPI; ++i )
+    for ( uint j = 0u; j < WPI; ++j )
+      acc[i][j] = (T) 0;
+  
+  for ( uint k0 = 0u; k0 < K; k0 += TILE_K )
+  {
+    for ( uint l = 0u; l < TILE * TILE_K / ( WG * WG ); ++l )
+    {
+      uint const e = tid + l * WG * WG;
+      
+      uint const m  = e % TILE, mk = k0 + e / TILE;
+      uint const n  = e / TILE_K, nk = k0 + e % TILE_K;
+      
+      lhsTile[e / TILE][m] = ( row0 + m < resRows && mk < K ) ?
+        lhs[lhsOffset + ( row0 + m ) * lhsStrideY + mk * lhsStrideX] : (T) 0;
+      rhsTile[e % TILE_K][n] = ( col0 + n < resCols && nk < K ) ?
+        rhs[rhsOffset + ( col0 + n ) * rhsStrideX + nk * rhsStrideY] : (T) 0;
+    }
+    
+    barrier( CLK_LOCAL_MEM_FENCE );
+    
+    for ( uint k = 0u; k < TILE_K; ++k )
+    {
+      T a[WPI], b[WPI];
+      
+      for ( uint i = 0u; i < WPI; ++i ) a[i] = lhsTile[k][lx + i * WG];
+      for ( uint j = 0u; j < WPI; ++j ) b[j] = rhsTile[k][ly + j * WG];
+      
+      for ( uint i = 0u; i < WPI; ++i )
+        for ( uint j = 0u; j < WPI; ++j )
+          acc[i][j] = mad( a[i], b[j], acc[i][j] );
+    }
+    
+    barrier( CLK_LOCAL_MEM_FENCE );
+  }
+  
+  for ( uint j = 0u; j < WPI; ++j )
+  {
+    uint const col = col0 + ly + j * WG;
+    
+    for ( uint i = 0u; i < WPI; ++i )
+    {
+      uint const row = row0 + lx + i * WG;
+      
+      if ( row < resRows && col < resCols )
+        res[resOffset + row * resStrideY + col * resStrideX] = acc[i][j];
+    }
+  }
 }
 
 
 
 /**
- * @see gemm().
+ * Blocked matrix-matrix multiplication with double buffering,
+ * @see gemm_basic_algorithm().
+ * 
+ * The work-group and micro-tile sizes are the same as for
+ * gemm_basic_algorithm(), but there are two local buffers for each
+ * operand, like Alm0/Alm1 and Blm0/Blm1 in DoubleBufferingTemplate.
+ * While the current K-panel is multiplied out of one buffer, the
+ * next panel is loaded into the other one, so the latency of the
+ * global loads is hidden behind the multiply-adds. Since the buffer
+ * which is written has been read in the previous iteration, a single
+ * barrier per panel suffices.
+ * 
+ * The panel is 16 deep for float and 8 deep for double, so that
+ * the four buffers fit into 32 KB of local memory.
+ * 
+ * Invoke the kernel with a local size of 16x16 and a global size
+ * of ceil(resCols/64)*16 x ceil(resRows/64)*16.
  */
 template<class T>
 __kernel void gemm_double_buffering(
@@ -92,15 +195,103 @@ __kernel void gemm_double_buffering(
   uint const        resStrideX,
   uint const        lhsStrideY,
   uint const        rhsStrideY,
-  uint const        resStrideY
+  uint const        resStrideY,
+  uint const        resRows,
+  uint const        resCols
 )
 {
+  enum { WG = 16, WPI = 4, TILE = WG * WPI, TILE_K = 64 / sizeof(T), LOADS = TILE * TILE_K / ( WG * WG ) };
+  
+  __local T lhsTile[2][TILE_K][TILE];
+  __local T rhsTile[2][TILE_K][TILE + 1];
+  
+  uint const lx   = get_local_id( 0u );
+  uint const ly   = get_local_id( 1u );
+  uint const tid  = ly * WG + lx;
+  uint const row0 = get_group_id( 1u ) * TILE;
+  uint const col0 = get_group_id( 0u ) * TILE;
+  
+  T acc[WPI][WPI];
+  
+  for ( uint i = 0u; i < WPI; ++i )
+    for ( uint j = 0u; j < WPI; ++j )
+      acc[i][j] = (T) 0;
+  
+  uint const panels = ( K + TILE_K - 1u ) / TILE_K;
+  
+  for ( uint p = 0u; p <= panels; ++p )
+  {
+    uint const loaded = p & 1u, used = loaded ^ 1u;
+    
+    // Load the next panel, it is read after the barrier below.
+    if ( p < panels )
+    {
+      uint const k0 = p * TILE_K;
+      
+      for ( uint l = 0u; l < LOADS; ++l )
+      {
+        uint const e = tid + l * WG * WG;
+        
+        uint const m  = e % TILE, mk = k0 + e / TILE;
+        uint const n  = e / TILE_K, nk = k0 + e % TILE_K;
+        
+        lhsTile[loaded][e / TILE][m] = ( row0 + m < resRows && mk < K ) ?
+          lhs[lhsOffset + ( row0 + m ) * lhsStrideY + mk * lhsStrideX] : (T) 0;
+        rhsTile[loaded][e % TILE_K][n] = ( col0 + n < resCols && nk < K ) ?
+          rhs[rhsOffset + ( col0 + n ) * rhsStrideX + nk * rhsStrideY] : (T) 0;
+      }
+    }
+    
+    // Multiply the panel which has been loaded in the previous iteration.
+    if ( p > 0u )
+    {
+      for ( uint k = 0u; k < TILE_K; ++k )
+      {
+        T a[WPI], b[WPI];
+        
+        for ( uint i = 0u; i < WPI; ++i ) a[i] = lhsTile[used][k][lx + i * WG];
+        for ( uint j = 0u; j < WPI; ++j ) b[j] = rhsTile[used][k][ly + j * WG];
+        
+        for ( uint i = 0u; i < WPI; ++i )
+          for ( uint j = 0u; j < WPI; ++j )
+            acc[i][j] = mad( a[i], b[j], acc[i][j] );
+      }
+    }
+    
+    barrier( CLK_LOCAL_MEM_FENCE );
+  }
+  
+  for ( uint j = 0u; j < WPI; ++j )
+  {
+    uint const col = col0 + ly + j * WG;
+    
+    for ( uint i = 0u; i < WPI; ++i )
+    {
+      uint const row = row0 + lx + i * WG;
+      
+      if ( row < resRows && col < resCols )
+        res[resOffset + row * resStrideY + col * resStrideX] = acc[i][j];
+    }
+  }
 }
 
 
 
 /**
- * @see gemm().
+ * Blocked matrix-matrix multiplication with software pipelining,
+ * @see gemm_basic_algorithm().
+ * 
+ * The work-group and micro-tile sizes are the same as for
+ * gemm_basic_algorithm() and there is a single local buffer per
+ * operand. The next K-slice of @c lhs and @c rhs is prefetched
+ * into private registers while the current slice is multiplied out
+ * of local memory, then the registers are stored to local memory.
+ * The global loads are thus in flight during the multiply-adds,
+ * at the cost of 8 registers per work-item instead of a second
+ * local buffer.
+ * 
+ * Invoke the kernel with a local size of 16x16 and a global size
+ * of ceil(resCols/64)*16 x ceil(resRows/64)*16.
  */
 template<class T>
 __kernel void gemm_pipelining(
@@ -116,9 +307,297 @@ __kernel void gemm_pipelining(
   uint const        resStrideX,
   uint const        lhsStrideY,
   uint const        rhsStrideY,
-  uint const        resStrideY
+  uint const        resStrideY,
+  uint const        resRows,
+  uint const        resCols
+)
+{
+  enum { WG = 16, WPI = 4, TILE = WG * WPI, TILE_K = 16, LOADS = TILE * TILE_K / ( WG * WG ) };
+  
+  __local T lhsTile[TILE_K][TILE];
+  __local T rhsTile[TILE_K][TILE + 1];
+  
+  uint const lx   = get_local_id( 0u );
+  uint const ly   = get_local_id( 1u );
+  uint const tid  = ly * WG + lx;
+  uint const row0 = get_group_id( 1u ) * TILE;
+  uint const col0 = get_group_id( 0u ) * TILE;
+  
+  T acc[WPI][WPI];
+  T lhsNext[LOADS], rhsNext[LOADS];
+  
+  for ( uint i = 0u; i < WPI; ++i )
+    for ( uint j = 0u; j < WPI; ++j )
+      acc[i][j] = (T) 0;
+  
+  uint const panels = ( K + TILE_K - 1u ) / TILE_K;
+  
+  for ( uint p = 0u; p <= panels; ++p )
+  {
+    // Store the slice which has been prefetched in the previous iteration.
+    if ( p > 0u )
+    {
+      for ( uint l = 0u; l < LOADS; ++l )
+      {
+        uint const e = tid + l * WG * WG;
+        
+        lhsTile[e / TILE][e % TILE]     = lhsNext[l];
+        rhsTile[e % TILE_K][e / TILE_K] = rhsNext[l];
+      }
+      
+      barrier( CLK_LOCAL_MEM_FENCE );
+    }
+    
+    if ( p < panels )
+    {
+      uint const k0 = p * TILE_K;
+      
+      for ( uint l = 0u; l < LOADS; ++l )
+      {
+        uint const e = tid + l * WG * WG;
+        
+        uint const m  = e % TILE, mk = k0 + e / TILE;
+        uint const n  = e / TILE_K, nk = k0 + e % TILE_K;
+        
+        lhsNext[l] = ( row0 + m < resRows && mk < K ) ?
+          lhs[lhsOffset + ( row0 + m ) * lhsStrideY + mk * lhsStrideX] : (T) 0;
+        rhsNext[l] = ( col0 + n < resCols && nk < K ) ?
+          rhs[rhsOffset + ( col0 + n ) * rhsStrideX + nk * rhsStrideY] : (T) 0;
+      }
+    }
+    
+    if ( p > 0u )
+    {
+      for ( uint k = 0u; k < TILE_K; ++k )
+      {
+        T a[WPI], b[WPI];
+        
+        for ( uint i = 0u; i < WPI; ++i ) a[i] = lhsTile[k][lx + i * WG];
+        for ( uint j = 0u; j < WPI; ++j ) b[j] = rhsTile[k][ly + j * WG];
+        
+        for ( uint i = 0u; i < WPI; ++i )
+          for ( uint j = 0u; j < WPI; ++j )
+            acc[i][j] = mad( a[i], b[j], acc[i][j] );
+      }
+      
+      barrier( CLK_LOCAL_MEM_FENCE );
+    }
+  }
+  
+  for ( uint j = 0u; j < WPI; ++j )
+  {
+    uint const col = col0 + ly + j * WG;
+    
+    for ( uint i = 0u; i < WPI; ++i )
+    {
+      uint const row = row0 + lx + i * WG;
+      
+      if ( row < resRows && col < resCols )
+        res[resOffset + row * resStrideY + col * resStrideX] = acc[i][j];
+    }
+  }
+}
+
+
+
+/**
+ * Explicitly vectorized matrix-matrix multiplication for CPU devices
+ * using float4, @see gemm().
+ * 
+ * Each work-item computes a 4x4 block of @c res. The block is held
+ * in 4 float4 accumulators along the contiguous dimension of @c res,
+ * i.e. along the rows for column-major and along the columns for
+ * row-major matrices. For every k, one vload4 of the operand which is
+ * contiguous in the same dimension is multiplied with 4 broadcast
+ * values of the other operand using fma. The row-major case is computed
+ * as the transposed product, so both layouts take the same path.
+ * Blocks at the edges of @c res and operands with other strides are
+ * computed with scalar fma.
+ * 
+ * Use this kernel if the device prefers vectors of 4 floats,
+ * see CL_DEVICE_PREFERRED_VECTOR_WIDTH_FLOAT, and gemm_vec8() otherwise.
+ * Invoke the kernel with a global size of at least
+ * ceil(resCols/4) x ceil(resRows/4), the work-group size is arbitrary.
+ */
+__kernel void gemm_vec4(
+  __global float const* restrict lhs,
+  __global float const* restrict rhs,
+  __global float* const restrict res,
+  uint const        K,
+  uint const        lhsOffset,
+  uint const        rhsOffset,
+  uint const        resOffset,
+  uint const        lhsStrideX,
+  uint const        rhsStrideX,
+  uint const        resStrideX,
+  uint const        lhsStrideY,
+  uint const        rhsStrideY,
+  uint const        resStrideY,
+  uint const        resRows,
+  uint const        resCols
+)
+{
+  enum { W = 4 };
+  
+  // Compute the transposed product if res is contiguous along its columns.
+  bool const trans = resStrideY != 1u && resStrideX == 1u;
+  
+  // res(i,j) = sum_k a(i,k) * b(k,j) with a rows and res rows along the contiguous dimension.
+  __global float const* const a = trans ? rhs + rhsOffset : lhs + lhsOffset;
+  __global float const* const b = trans ? lhs + lhsOffset : rhs + rhsOffset;
+  __global float* const       c = res + resOffset;
+  
+  uint const aRow = trans ? rhsStrideX : lhsStrideY, aK   = trans ? rhsStrideY : lhsStrideX;
+  uint const bK   = trans ? lhsStrideX : rhsStrideY, bCol = trans ? lhsStrideY : rhsStrideX;
+  uint const cRow = trans ? resStrideX : resStrideY, cCol = trans ? resStrideY : resStrideX;
+  uint const rows = trans ? resCols : resRows,       cols = trans ? resRows : resCols;
+  
+  uint const i0 = W * (uint) get_global_id( trans ? 0u : 1u );
+  uint const j0 = W * (uint) get_global_id( trans ? 1u : 0u );
+  
+  if ( i0 >= rows || j0 >= cols )
+    return;
+  
+  uint const nc = min( (uint) W, cols - j0 );
+  
+  if ( aRow == 1u && cRow == 1u && i0 + W <= rows )
+  {
+    // Columns beyond the edge repeat the last column and are not stored.
+    uint bj[W];
+    
+    for ( uint j = 0u; j < W; ++j ) bj[j] = min( j0 + j, cols - 1u ) * bCol;
+    
+    float4 acc[W];
+    
+    for ( uint j = 0u; j < W; ++j ) acc[j] = (float4)( 0.0f );
+    
+    for ( uint k = 0u; k < K; ++k )
+    {
+      float4 const v = vload4( 0u, a + i0 + k * aK );
+      
+      for ( uint j = 0u; j < W; ++j )
+        acc[j] = fma( v, (float4)( b[k * bK + bj[j]] ), acc[j] );
+    }
+    
+    for ( uint j = 0u; j < nc; ++j )
+      vstore4( acc[j], 0u, c + i0 + ( j0 + j ) * cCol );
+  }
+  else
+  {
+    uint const nr = min( (uint) W, rows - i0 );
+    
+    for ( uint j = 0u; j < nc; ++j )
+      for ( uint i = 0u; i < nr; ++i )
+      {
+        float tmp = 0.0f;
+        
+        for ( uint k = 0u; k < K; ++k )
+          tmp = fma( a[( i0 + i ) * aRow + k * aK], b[k * bK + ( j0 + j ) * bCol], tmp );
+        
+        c[( i0 + i ) * cRow + ( j0 + j ) * cCol] = tmp;
+      }
+  }
+}
+
+
+
+/**
+ * Explicitly vectorized matrix-matrix multiplication for CPU devices
+ * using float8, @see gemm().
+ * 
+ * Each work-item computes a 8x8 block of @c res. The block is held
+ * in 8 float8 accumulators along the contiguous dimension of @c res,
+ * i.e. along the rows for column-major and along the columns for
+ * row-major matrices. For every k, one vload8 of the operand which is
+ * contiguous in the same dimension is multiplied with 8 broadcast
+ * values of the other operand using fma. The row-major case is computed
+ * as the transposed product, so both layouts take the same path.
+ * Blocks at the edges of @c res and operands with other strides are
+ * computed with scalar fma.
+ * 
+ * Use this kernel if the device prefers vectors of 8 floats,
+ * see CL_DEVICE_PREFERRED_VECTOR_WIDTH_FLOAT, and gemm_vec4() otherwise.
+ * Invoke the kernel with a global size of at least
+ * ceil(resCols/8) x ceil(resRows/8), the work-group size is arbitrary.
+ */
+__kernel void gemm_vec8(
+  __global float const* restrict lhs,
+  __global float const* restrict rhs,
+  __global float* const restrict res,
+  uint const        K,
+  uint const        lhsOffset,
+  uint const        rhsOffset,
+  uint const        resOffset,
+  uint const        lhsStrideX,
+  uint const        rhsStrideX,
+  uint const        resStrideX,
+  uint const        lhsStrideY,
+  uint const        rhsStrideY,
+  uint const        resStrideY,
+  uint const        resRows,
+  uint const        resCols
 )
 {
+  enum { W = 8 };
+  
+  // Compute the transposed product if res is contiguous along its columns.
+  bool const trans = resStrideY != 1u && resStrideX == 1u;
+  
+  // res(i,j) = sum_k a(i,k) * b(k,j) with a rows and res rows along the contiguous dimension.
+  __global float const* const a = trans ? rhs + rhsOffset : lhs + lhsOffset;
+  __global float const* const b = trans ? lhs + lhsOffset : rhs + rhsOffset;
+  __global float* const       c = res + resOffset;
+  
+  uint const aRow = trans ? rhsStrideX : lhsStrideY, aK   = trans ? rhsStrideY : lhsStrideX;
+  uint const bK   = trans ? lhsStrideX : rhsStrideY, bCol = trans ? lhsStrideY : rhsStrideX;
+  uint const cRow = trans ? resStrideX : resStrideY, cCol = trans ? resStrideY : resStrideX;
+  uint const rows = trans ? resCols : resRows,       cols = trans ? resRows : resCols;
+  
+  uint const i0 = W * (uint) get_global_id( trans ? 0u : 1u );
+  uint const j0 = W * (uint) get_global_id( trans ? 1u : 0u );
+  
+  if ( i0 >= rows || j0 >= cols )
+    return;
+  
+  uint const nc = min( (uint) W, cols - j0 );
+  
+  if ( aRow == 1u && cRow == 1u && i0 + W <= rows )
+  {
+    // Columns beyond the edge repeat the last column and are not stored.
+    uint bj[W];
+    
+    for ( uint j = 0u; j < W; ++j ) bj[j] = min( j0 + j, cols - 1u ) * bCol;
+    
+    float8 acc[W];
+    
+    for ( uint j = 0u; j < W; ++j ) acc[j] = (float8)( 0.0f );
+    
+    for ( uint k = 0u; k < K; ++k )
+    {
+      float8 const v = vload8( 0u, a + i0 + k * aK );
+      
+      for ( uint j = 0u; j < W; ++j )
+        acc[j] = fma( v, (float8)( b[k * bK + bj[j]] ), acc[j] );
+    }
+    
+    for ( uint j = 0u; j < nc; ++j )
+      vstore8( acc[j], 0u, c + i0 + ( j0 + j ) * cCol );
+  }
+  else
+  {
+    uint const nr = min( (uint) W, rows - i0 );
+    
+    for ( uint j = 0u; j < nc; ++j )
+      for ( uint i = 0u; i < nr; ++i )
+      {
+        float tmp = 0.0f;
+        
+        for ( uint k = 0u; k < K; ++k )
+          tmp = fma( a[( i0 + i ) * aRow + k * aK], b[k * bK + ( j0 + j ) * bCol], tmp );
+        
+        c[( i0 + i ) * cRow + ( j0 + j ) * cCol] = tmp;
+      }
+  }
 }
 
 
@@ -143,9 +622,14 @@ __kernel void gemm_pipelining(
  * @param lhsOffsetY First texel of the @c lhs (sub-) matrix in y direction.
  * @param rhsOffsetY The same for @c rhs.
  * @param resOffsetY The same for @c res.
- * @param lhsTranspose Indicates whether the @c lhs matrix is transposed.
+ * @param lhsTranspose Indicates whether the @c lhs matrix is transposed, i.e.
+ *        texel (x, y) holds the element in column x and row y. Otherwise
+ *        x is the row, which is the layout of column-major matrices.
  * @param rhsTranspose The same for @c rhs.
  * @param resTranspose The same for @c res.
+ * 
+ * The flags are turned into coordinate steps before the loop,
+ * so the texel coordinates are not selected per iteration.
  */
 __kernel void gemm_img(
   read_only image2d_t  lhs,
@@ -165,34 +649,51 @@ __kernel void gemm_img(
 {
   sampler_t const sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_NONE | CLK_FILTER_NEAREST;
   
-  size_t const gx  = get_global_id( 0u );
-  size_t const gy  = get_global_id( 1u );
-  float4       tmp = (float4)(0.0f,0.0f,0.0f,0.0f);
+  int const gx  = (int) get_global_id( 0u );
+  int const gy  = (int) get_global_id( 1u );
+  float4    tmp = (float4)(0.0f,0.0f,0.0f,0.0f);
   
-  int2 const lhsOffset = (int2)( lhsOffsetX, lhsOffsetY );
-  int2 const rhsOffset = (int2)( rhsOffsetX, rhsOffsetY );
+  // Texel coordinates of an element are offset + row * rowStep + col * colStep.
+  int2 const lhsRowStep = lhsTranspose ? (int2)( 0, 1 ) : (int2)( 1, 0 );
+  int2 const rhsRowStep = rhsTranspose ? (int2)( 0, 1 ) : (int2)( 1, 0 );
+  int2 const resRowStep = resTranspose ? (int2)( 0, 1 ) : (int2)( 1, 0 );
   
-  for ( int k = 0; k < innerDim; ++k )
+  int2       lIdx = (int2)( lhsOffsetX, lhsOffsetY ) + gy * lhsRowStep;
+  int2       rIdx = (int2)( rhsOffsetX, rhsOffsetY ) + gx * rhsRowStep.yx;
+  int2 const lStep = lhsRowStep.yx;
+  int2 const rStep = rhsRowStep;
+  
+  for ( int k = 0; k < innerDim; ++k, lIdx += lStep, rIdx += rStep )
   {
-    int2 const lIdx = (int2)( k, gy );
-    int2 const rIdx = (int2)( gx, k );
-    
-    float4 l = read_imagef( lhs, sampler, lhsOffset + select( lIdx.yx, lIdx, (int2)( lhsTranspose, lhsTranspose ) ) );
-    float4 r = read_imagef( rhs, sampler, rhsOffset + select( rIdx.yx, rIdx, (int2)( rhsTranspose, rhsTranspose ) ) );
+    float4 l = read_imagef( lhs, sampler, lIdx );
+    float4 r = read_imagef( rhs, sampler, rIdx );
     
     tmp.w += l.w * r.w;
   }
   
-  int2 const resOffset = (int2)( resOffsetX, resOffsetY );
-  int2 const resIdx    = (int2)( gx, gy );
+  int2 const resIdx = (int2)( resOffsetX, resOffsetY ) + gy * resRowStep + gx * resRowStep.yx;
   
-  write_imagef( res, resOffset + select( resIdx, resIdx.yx, (int2)( resTranspose, resTranspose ) ), tmp );
+  write_imagef( res, resIdx, tmp );
 }
 
 
 
 /**
+ * Register-blocked matrix-matrix multiplication of image objects,
  * @see gemm_img().
+ * 
+ * Each work-item computes a 4x4 micro-tile of @c res, whose rows and
+ * columns are 16 apart like in gemm_basic_algorithm(). For every k it
+ * fetches a block of 4 texels of @c lhs and 4 texels of @c rhs into
+ * registers and performs 16 multiply-adds. There is no local memory:
+ * the texels of the 64x64 tile of a work-group are shared through the
+ * texture cache, which keeps 2D neighbourhoods. The transpose flags
+ * are turned into coordinate steps once, @see gemm_img_pipelining().
+ * Texels outside of the images are read as zero by the clamping
+ * sampler and the result ends at the border of the @c res image.
+ * 
+ * Invoke the kernel with a local size of 16x16 and a global size
+ * of ceil(resCols/64)*16 x ceil(resRows/64)*16.
  */
 __kernel void gemm_img_basic_algorithm(
   read_only image2d_t  lhs,
@@ -210,12 +711,72 @@ __kernel void gemm_img_basic_algorithm(
   int const            resTranspose
 )
 {
+  enum { WG = 16, WPI = 4, TILE = WG * WPI };
+  
+  sampler_t const sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP | CLK_FILTER_NEAREST;
+  
+  int2 const lhsRowStep = lhsTranspose ? (int2)( 0, 1 ) : (int2)( 1, 0 );
+  int2 const rhsRowStep = rhsTranspose ? (int2)( 0, 1 ) : (int2)( 1, 0 );
+  int2 const resRowStep = resTranspose ? (int2)( 0, 1 ) : (int2)( 1, 0 );
+  int2 const lhsColStep = lhsRowStep.yx;
+  int2 const rhsColStep = rhsRowStep.yx;
+  int2 const resColStep = resRowStep.yx;
+  
+  int const resRows = resTranspose ? get_image_height( res ) - resOffsetY : get_image_width( res ) - resOffsetX;
+  int const resCols = resTranspose ? get_image_width( res ) - resOffsetX : get_image_height( res ) - resOffsetY;
+  
+  int const row0 = (int) get_group_id( 1u ) * TILE + (int) get_local_id( 0u );
+  int const col0 = (int) get_group_id( 0u ) * TILE + (int) get_local_id( 1u );
+  
+  // Coordinates of the micro-tile's rows of lhs and columns of rhs at k = 0.
+  int2 lhsIdx[WPI], rhsIdx[WPI];
+  
+  for ( int i = 0; i < WPI; ++i ) lhsIdx[i] = (int2)( lhsOffsetX, lhsOffsetY ) + ( row0 + i * WG ) * lhsRowStep;
+  for ( int j = 0; j < WPI; ++j ) rhsIdx[j] = (int2)( rhsOffsetX, rhsOffsetY ) + ( col0 + j * WG ) * rhsColStep;
+  
+  float acc[WPI][WPI];
+  
+  for ( int i = 0; i < WPI; ++i )
+    for ( int j = 0; j < WPI; ++j )
+      acc[i][j] = 0.0f;
+  
+  for ( int k = 0; k < innerDim; ++k )
+  {
+    float a[WPI], b[WPI];
+    
+    for ( int i = 0; i < WPI; ++i ) a[i] = read_imagef( lhs, sampler, lhsIdx[i] + k * lhsColStep ).w;
+    for ( int j = 0; j < WPI; ++j ) b[j] = read_imagef( rhs, sampler, rhsIdx[j] + k * rhsRowStep ).w;
+    
+    for ( int i = 0; i < WPI; ++i )
+      for ( int j = 0; j < WPI; ++j )
+        acc[i][j] = mad( a[i], b[j], acc[i][j] );
+  }
+  
+  for ( int j = 0; j < WPI; ++j )
+  {
+    int const col = col0 + j * WG;
+    
+    for ( int i = 0; i < WPI; ++i )
+    {
+      int const row = row0 + i * WG;
+      
+      if ( row < resRows && col < resCols )
+        write_imagef( res, (int2)( resOffsetX, resOffsetY ) + row * resRowStep + col * resColStep, (float4)( 0.0f, 0.0f, 0.0f, acc[i][j] ) );
+    }
+  }
 }
 
 
 
 /**
- * @see gemm_img().
+ * Blocked matrix-matrix multiplication of image objects with
+ * double buffering, @see gemm_double_buffering().
+ * 
+ * The K-panels of @c lhs and @c rhs are read through the texture
+ * cache into two local buffers per operand. While one panel is
+ * multiplied out, the next one is loaded into the other buffer.
+ * The transpose flags, the bounds and the index space are the same
+ * as for gemm_img_pipelining().
  */
 __kernel void gemm_img_double_buffering(
   read_only image2d_t  lhs,
@@ -233,12 +794,112 @@ __kernel void gemm_img_double_buffering(
   int const            resTranspose
 )
 {
+  enum { WG = 16, WPI = 4, TILE = WG * WPI, TILE_K = 16, LOADS = TILE * TILE_K / ( WG * WG ) };
+  
+  sampler_t const sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP | CLK_FILTER_NEAREST;
+  
+  __local float lhsTile[2][TILE_K][TILE];
+  __local float rhsTile[2][TILE_K][TILE + 1];
+  
+  int2 const lhsRowStep = lhsTranspose ? (int2)( 0, 1 ) : (int2)( 1, 0 );
+  int2 const rhsRowStep = rhsTranspose ? (int2)( 0, 1 ) : (int2)( 1, 0 );
+  int2 const resRowStep = resTranspose ? (int2)( 0, 1 ) : (int2)( 1, 0 );
+  int2 const lhsColStep = lhsRowStep.yx;
+  int2 const rhsColStep = rhsRowStep.yx;
+  int2 const resColStep = resRowStep.yx;
+  
+  int2 const lhsOrigin = (int2)( lhsOffsetX, lhsOffsetY );
+  int2 const rhsOrigin = (int2)( rhsOffsetX, rhsOffsetY );
+  int2 const resOrigin = (int2)( resOffsetX, resOffsetY );
+  
+  int const resRows = resTranspose ? get_image_height( res ) - resOffsetY : get_image_width( res ) - resOffsetX;
+  int const resCols = resTranspose ? get_image_width( res ) - resOffsetX : get_image_height( res ) - resOffsetY;
+  
+  int const lx   = (int) get_local_id( 0u );
+  int const ly   = (int) get_local_id( 1u );
+  int const tid  = ly * WG + lx;
+  int const row0 = (int) get_group_id( 1u ) * TILE;
+  int const col0 = (int) get_group_id( 0u ) * TILE;
+  
+  float acc[WPI][WPI];
+  
+  for ( int i = 0; i < WPI; ++i )
+    for ( int j = 0; j < WPI; ++j )
+      acc[i][j] = 0.0f;
+  
+  int const panels = ( innerDim + TILE_K - 1 ) / TILE_K;
+  
+  for ( int p = 0; p <= panels; ++p )
+  {
+    int const loaded = p & 1, used = loaded ^ 1;
+    
+    if ( p < panels )
+    {
+      int const k0 = p * TILE_K;
+      
+      for ( int l = 0; l < LOADS; ++l )
+      {
+        int const e = tid + l * WG * WG;
+        
+        int const m  = row0 + e % TILE, mk = k0 + e / TILE;
+        int const n  = col0 + e / TILE_K, nk = k0 + e % TILE_K;
+        
+        lhsTile[loaded][e / TILE][e % TILE] = ( m < resRows && mk < innerDim ) ?
+          read_imagef( lhs, sampler, lhsOrigin + m * lhsRowStep + mk * lhsColStep ).w : 0.0f;
+        rhsTile[loaded][e % TILE_K][e / TILE_K] = ( n < resCols && nk < innerDim ) ?
+          read_imagef( rhs, sampler, rhsOrigin + nk * rhsRowStep + n * rhsColStep ).w : 0.0f;
+      }
+    }
+    
+    if ( p > 0 )
+    {
+      for ( int k = 0; k < TILE_K; ++k )
+      {
+        float a[WPI], b[WPI];
+        
+        for ( int i = 0; i < WPI; ++i ) a[i] = lhsTile[used][k][lx + i * WG];
+        for ( int j = 0; j < WPI; ++j ) b[j] = rhsTile[used][k][ly + j * WG];
+        
+        for ( int i = 0; i < WPI; ++i )
+          for ( int j = 0; j < WPI; ++j )
+            acc[i][j] = mad( a[i], b[j], acc[i][j] );
+      }
+    }
+    
+    barrier( CLK_LOCAL_MEM_FENCE );
+  }
+  
+  for ( int j = 0; j < WPI; ++j )
+  {
+    int const col = col0 + ly + j * WG;
+    
+    for ( int i = 0; i < WPI; ++i )
+    {
+      int const row = row0 + lx + i * WG;
+      
+      if ( row < resRows && col < resCols )
+        write_imagef( res, resOrigin + row * resRowStep + col * resColStep, (float4)( 0.0f, 0.0f, 0.0f, acc[i][j] ) );
+    }
+  }
 }
 
 
 
 /**
- * @see gemm_img().
+ * Blocked matrix-matrix multiplication of image objects with
+ * software pipelining, @see gemm_pipelining().
+ * 
+ * The slices of @c lhs and @c rhs are read through the texture
+ * cache into private registers and staged in local memory like in
+ * gemm_pipelining(). A transpose flag of zero means that texel
+ * (x, y) holds the element in row x and column y, i.e. the matrix
+ * is stored column-major, otherwise x is the column. The flags are
+ * turned into coordinate steps once, so the loop does not select.
+ * The result ends at the border of the @c res image, values outside
+ * of it and beyond @c innerDim are read as zero.
+ * 
+ * Invoke the kernel with a local size of 16x16 and a global size
+ * of ceil(resCols/64)*16 x ceil(resRows/64)*16.
  */
 __kernel void gemm_img_pipelining(
   read_only image2d_t  lhs,
@@ -256,4 +917,104 @@ __kernel void gemm_img_pipelining(
   int const            resTranspose
 )
 {
+  enum { WG = 16, WPI = 4, TILE = WG * WPI, TILE_K = 16, LOADS = TILE * TILE_K / ( WG * WG ) };
+  
+  sampler_t const sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP | CLK_FILTER_NEAREST;
+  
+  __local float lhsTile[TILE_K][TILE];
+  __local float rhsTile[TILE_K][TILE + 1];
+  
+  // Texel coordinates of an element are offset + row * rowStep + col * colStep.
+  int2 const lhsRowStep = lhsTranspose ? (int2)( 0, 1 ) : (int2)( 1, 0 );
+  int2 const rhsRowStep = rhsTranspose ? (int2)( 0, 1 ) : (int2)( 1, 0 );
+  int2 const resRowStep = resTranspose ? (int2)( 0, 1 ) : (int2)( 1, 0 );
+  int2 const lhsColStep = lhsRowStep.yx;
+  int2 const rhsColStep = rhsRowStep.yx;
+  int2 const resColStep = resRowStep.yx;
+  
+  int2 const lhsOrigin = (int2)( lhsOffsetX, lhsOffsetY );
+  int2 const rhsOrigin = (int2)( rhsOffsetX, rhsOffsetY );
+  int2 const resOrigin = (int2)( resOffsetX, resOffsetY );
+  
+  int const resRows = resTranspose ? get_image_height( res ) - resOffsetY : get_image_width( res ) - resOffsetX;
+  int const resCols = resTranspose ? get_image_width( res ) - resOffsetX : get_image_height( res ) - resOffsetY;
+  
+  int const lx   = (int) get_local_id( 0u );
+  int const ly   = (int) get_local_id( 1u );
+  int const tid  = ly * WG + lx;
+  int const row0 = (int) get_group_id( 1u ) * TILE;
+  int const col0 = (int) get_group_id( 0u ) * TILE;
+  
+  float acc[WPI][WPI];
+  float lhsNext[LOADS], rhsNext[LOADS];
+  
+  for ( int i = 0; i < WPI; ++i )
+    for ( int j = 0; j < WPI; ++j )
+      acc[i][j] = 0.0f;
+  
+  int const panels = ( innerDim + TILE_K - 1 ) / TILE_K;
+  
+  for ( int p = 0; p <= panels; ++p )
+  {
+    if ( p > 0 )
+    {
+      for ( int l = 0; l < LOADS; ++l )
+      {
+        int const e = tid + l * WG * WG;
+        
+        lhsTile[e / TILE][e % TILE]     = lhsNext[l];
+        rhsTile[e % TILE_K][e / TILE_K] = rhsNext[l];
+      }
+      
+      barrier( CLK_LOCAL_MEM_FENCE );
+    }
+    
+    if ( p < panels )
+    {
+      int const k0 = p * TILE_K;
+      
+      for ( int l = 0; l < LOADS; ++l )
+      {
+        int const e = tid + l * WG * WG;
+        
+        int const m  = row0 + e % TILE, mk = k0 + e / TILE;
+        int const n  = col0 + e / TILE_K, nk = k0 + e % TILE_K;
+        
+        lhsNext[l] = ( m < resRows && mk < innerDim ) ?
+          read_imagef( lhs, sampler, lhsOrigin + m * lhsRowStep + mk * lhsColStep ).w : 0.0f;
+        rhsNext[l] = ( n < resCols && nk < innerDim ) ?
+          read_imagef( rhs, sampler, rhsOrigin + nk * rhsRowStep + n * rhsColStep ).w : 0.0f;
+      }
+    }
+    
+    if ( p > 0 )
+    {
+      for ( int k = 0; k < TILE_K; ++k )
+      {
+        float a[WPI], b[WPI];
+        
+        for ( int i = 0; i < WPI; ++i ) a[i] = lhsTile[k][lx + i * WG];
+        for ( int j = 0; j < WPI; ++j ) b[j] = rhsTile[k][ly + j * WG];
+        
+        for ( int i = 0; i < WPI; ++i )
+          for ( int j = 0; j < WPI; ++j )
+            acc[i][j] = mad( a[i], b[j], acc[i][j] );
+      }
+      
+      barrier( CLK_LOCAL_MEM_FENCE );
+    }
+  }
+  
+  for ( int j = 0; j < WPI; ++j )
+  {
+    int const col = col0 + ly + j * WG;
+    
+    for ( int i = 0; i < WPI; ++i )
+    {
+      int const row = row0 + lx + i * WG;
+      
+      if ( row < resRows && col < resCols )
+        write_imagef( res, resOrigin + row * resRowStep + col * resColStep, (float4)( 0.0f, 0.0f, 0.0f, acc[i][j] ) );
+    }
+  }
 }
@@ -21,6 +21,7 @@
 #include <ocl_query.h>
 #include <ocl_queue.h>
 
+#include <utl_args.h>
 #include <utl_profile_pass.h>
 #include <utl_profile_pass_manager.h>
 #include <utl_type.h>
@@ -115,6 +116,95 @@ __kernel void dot_fma_vec4( __global const float* restrict u, __global const flo
   
   w[get_global_id(0)] = tmp.x + tmp.y + tmp.z + tmp.w;
 }
+
+__kernel void dot_partial_vec4( __global const float* restrict u, __global const float* restrict v, uint N, __local float* scratch, __global float* const partial )
+{
+  uint const lid = get_local_id(0);
+  uint const gid = get_global_id(0);
+  uint const numWorkers = get_global_size(0);
+  
+  float4 tmp = 0.0f;
+  
+  for ( uint i = gid; i < N/4; i += numWorkers )
+    tmp = fma( vload4( i, u ), vload4( i, v ), tmp );
+  
+  for ( uint i = N/4*4 + gid; i < N; i += numWorkers )
+    tmp.x = fma( u[i], v[i], tmp.x );
+  
+  scratch[lid] = tmp.x + tmp.y + tmp.z + tmp.w;
+  barrier( CLK_LOCAL_MEM_FENCE );
+  
+  for ( uint s = get_local_size(0)/2; s > 0; s /= 2 )
+  {
+    if ( lid < s )
+      scratch[lid] += scratch[lid + s];
+    barrier( CLK_LOCAL_MEM_FENCE );
+  }
+  
+  if ( lid == 0 )
+    partial[get_group_id(0)] = scratch[0];
+}
+
+__kernel void dot_final( __global const float* restrict partial, uint count, __local float* scratch, __global float* const w )
+{
+  uint const lid = get_local_id(0);
+  
+  float tmp = 0.0f;
+  
+  for ( uint i = lid; i < count; i += get_local_size(0) )
+    tmp += partial[i];
+  
+  scratch[lid] = tmp;
+  barrier( CLK_LOCAL_MEM_FENCE );
+  
+  for ( uint s = get_local_size(0)/2; s > 0; s /= 2 )
+  {
+    if ( lid < s )
+      scratch[lid] += scratch[lid + s];
+    barrier( CLK_LOCAL_MEM_FENCE );
+  }
+  
+  if ( lid == 0 )
+    w[0] = scratch[0];
+}
+
+__kernel void dot_atomic_vec4( __global const float* restrict u, __global const float* restrict v, uint N, __local float* scratch, __global float* const w )
+{
+  uint const lid = get_local_id(0);
+  uint const gid = get_global_id(0);
+  uint const numWorkers = get_global_size(0);
+  
+  float4 tmp = 0.0f;
+  
+  for ( uint i = gid; i < N/4; i += numWorkers )
+    tmp = fma( vload4( i, u ), vload4( i, v ), tmp );
+  
+  for ( uint i = N/4*4 + gid; i < N; i += numWorkers )
+    tmp.x = fma( u[i], v[i], tmp.x );
+  
+  scratch[lid] = tmp.x + tmp.y + tmp.z + tmp.w;
+  barrier( CLK_LOCAL_MEM_FENCE );
+  
+  for ( uint s = get_local_size(0)/2; s > 0; s /= 2 )
+  {
+    if ( lid < s )
+      scratch[lid] += scratch[lid + s];
+    barrier( CLK_LOCAL_MEM_FENCE );
+  }
+  
+  if ( lid == 0 )
+  {
+    volatile __global uint* const sum = (volatile __global uint*) w;
+    uint old = *sum, assumed;
+    
+    do
+    {
+      assumed = old;
+      old = atomic_cmpxchg( sum, assumed, as_uint( as_float( assumed ) + scratch[0] ) );
+    }
+    while ( old != assumed );
+  }
+}
   )";
 
 
@@ -133,6 +223,8 @@ public :
     kernelName_( kernelName ),
     isTemplatized_( isTemplatized )
   {
+    this->setDevice( device_ );
+    
     context_.setActiveQueue( queue_ );
   }
   
@@ -170,9 +262,6 @@ public :
         size_t numWorkers = device_.maxWorkItemSizes()[0];
         kernel.setWorkSize( 1, numWorkers );
         
-        std::vector< ocl::Event > evts( this->_iter );
-        ocl::EventList allKernelsExecuted;
-        
         size_t const numBytes = dimension * sizeof (ValueType);
         auto const   numResBytes = sizeof (ValueType) * numWorkers;
         
@@ -186,42 +275,26 @@ public :
           lhs.begin(), lhs.end(), rhs.begin(), static_cast< ValueType >( 0 )
         );
         
-        for ( auto i = 0u; i < this->_iter; ++i )
-        {                   
+        // Return median time in seconds.
+        return this->measure( [&]() -> double
+        {
           ocl::Event const lhsWritten = u.writeAsync( queue_, 0u, lhs.data(), numBytes );
           ocl::Event const rhsWritten = v.writeAsync( queue_, 0u, rhs.data(), numBytes );
     
           ocl::EventList operandsWritten;
           operandsWritten << lhsWritten << rhsWritten;
     
-          evts[i] = kernel( queue_, operandsWritten, u.id(), v.id(), dimension, w.id() );
+          ocl::Event const kernelExecuted = kernel( queue_, operandsWritten, u.id(), v.id(), dimension, w.id() );
           
-          ocl::Event const resultRead = w.readAsync( queue_, 0u, res.data(), numResBytes, ocl::EventList( evts[i] ) );
+          ocl::Event const resultRead = w.readAsync( queue_, 0u, res.data(), numResBytes, ocl::EventList( kernelExecuted ) );
           
-          allKernelsExecuted << evts[i];
-        }
-        
-        // Wait for all kernels to finish.
-        queue_.barrier( allKernelsExecuted );
-        
-        assert( std::count( res.begin(), res.end(), result ) == res.size() );
-        
-        // Calculate the total execution time.
-        double totalRuntime_ns( 0 );
-
-        //for ( auto const& evt : allKernelsExecuted.events() )
-        for ( size_t i = 0; i < allKernelsExecuted.size(); ++i )
-        {
-          auto const start = allKernelsExecuted.at(i).startTime();
-          auto const end   = allKernelsExecuted.at(i).finishTime();
-          auto const kernelRuntime_ns = end - start;
-
-          totalRuntime_ns += kernelRuntime_ns;
-        }
-                
-        // Return average time in seconds.
-        return (static_cast< double >( totalRuntime_ns ) / this->_iter) / 1000000000.0;
-        //return std::chrono::duration_cast< std::chrono::microseconds >( totalRuntime /* this->_iter */).count();
+          // Wait for the kernel to finish.
+          queue_.finish();
+          
+          assert( std::count( res.begin(), res.end(), result ) == static_cast< std::ptrdiff_t >( res.size() ) );
+          
+          return (kernelExecuted.finishTime() - kernelExecuted.startTime()) / 1000000000.0;
+        } );
       }
       else
       {
@@ -250,8 +323,140 @@ private :
 
 
 
-int main()
+/**
+ * Runs the dot product partitioned across all work-items.
+ * 
+ * Every work-item accumulates a strided part of the float4 elements, so neighbouring
+ * work-items read neighbouring elements. The work-groups reduce their partial sums
+ * in local memory with a tree, whose power-of-two local size is chosen here. The sums
+ * of the work-groups are then either added by dot_final in a second launch of a single
+ * work-group or added to the result with a compare-and-swap loop, since OpenCL 1.1 has
+ * no atomic float addition.
+ */
+template< typename T >
+class DotReductionProfiler : public utl::ProfilePass< T >
+{
+public :
+  using typename utl::ProfilePass< T >::ValueType;
+  
+  DotReductionProfiler( std::string const& kernelName, bool isTwoPass, utl::Dim const& start, utl::Dim const& step, utl::Dim const& end, size_t numIterations = NumIterations ):
+    utl::ProfilePass< T >( "DotProduct_" + kernelName, start, step, end, numIterations ),
+    platform_( ocl::device_type::CPU ),
+    device_( platform_.device( ocl::device_type::CPU ) ),
+    context_( device_ ),
+    queue_( (platform_.insert( context_ ), platform_.setActiveContext( context_ ), context_), device_, CL_QUEUE_PROFILING_ENABLE ),
+    kernelName_( kernelName ),
+    isTwoPass_( isTwoPass )
+  {
+    this->setDevice( device_ );
+    this->setMetadata( "reduction", isTwoPass_ ? "two_pass" : "atomic" );
+    
+    context_.setActiveQueue( queue_ );
+  }
+  
+  double prof( utl::Dim const& dim ) override
+  {
+    assert( dim.size() >= 1u );
+    
+    ocl::Program program( context_, utl::getType< ValueType >() );
+    
+    int const dimension = dim[0] - 1;
+    
+    program << kernels;
+    
+    ocl::CompileOption const opts( "-cl-std=CL1.1 -w -Werror" );
+    
+    program.setCompileOption( ocl::compile_option::FAST_MATH | ocl::compile_option::NO_SIGNED_ZERO | opts );
+    program.build();
+    
+    if ( !program.isBuilt() ) throw std::runtime_error( "program not built" );
+    
+    context_.setActiveProgram( program );
+    
+    ocl::Kernel& kernel = program.kernel( kernelName_ );
+    ocl::Kernel& finalKernel = program.kernel( "dot_final" );
+    
+    if ( !kernel.created() || !finalKernel.created() ) throw std::runtime_error( "kernel not created" );
+    
+    // Largest power of two which the device allows, at most 256 work-items.
+    size_t localSize = 1;
+    while ( localSize * 2 <= std::min< size_t >( 256, device_.maxWorkGroupSize() ) ) localSize *= 2;
+    
+    // A few work-groups per compute unit, as many as needed for one float4 per work-item on small vectors.
+    size_t const numVectors = std::max< size_t >( dimension / 4, 1 );
+    size_t const numGroups  = std::min( ( numVectors + localSize - 1 ) / localSize, 4 * device_.maxComputeUnits() );
+    
+    kernel.setWorkSize( localSize, numGroups * localSize );
+    finalKernel.setWorkSize( localSize, localSize );
+    
+    size_t const numBytes = std::max( dimension, 1 ) * sizeof (ValueType);
+    size_t const numPartialBytes = numGroups * sizeof (ValueType);
+    size_t const numScratchBytes = localSize * sizeof (ValueType);
+    
+    ocl::Buffer u( context_, numBytes, ocl::Buffer::ReadOnly ), 
+                v( context_, numBytes, ocl::Buffer::ReadOnly ),
+                partial( context_, numPartialBytes ),
+                w( context_, sizeof (ValueType) );
+                
+    std::vector< ValueType > lhs( dimension, 1 ), rhs( dimension, 1 );
+    ValueType res = 0;
+    
+    auto result = std::inner_product(
+      lhs.begin(), lhs.end(), rhs.begin(), static_cast< ValueType >( 0 )
+    );
+    
+    // Return median time in seconds.
+    return this->measure( [&]() -> double
+    {
+      ocl::EventList operandsWritten;
+      operandsWritten << u.writeAsync( queue_, 0u, lhs.data(), dimension * sizeof (ValueType) )
+                      << v.writeAsync( queue_, 0u, rhs.data(), dimension * sizeof (ValueType) );
+      
+      ocl::Event first, last;
+      if ( isTwoPass_ )
+      {
+        first = kernel( queue_, operandsWritten, u.id(), v.id(), dimension, numScratchBytes, partial.id() );
+        last  = finalKernel( queue_, ocl::EventList( first ), partial.id(), (unsigned int)( numGroups ), numScratchBytes, w.id() );
+      }
+      else
+      {
+        // The work-groups add to the result, so it is cleared first.
+        ValueType const zero = 0;
+        operandsWritten << w.writeAsync( queue_, 0u, &zero, sizeof (ValueType) );
+        first = last = kernel( queue_, operandsWritten, u.id(), v.id(), dimension, numScratchBytes, w.id() );
+      }
+      
+      w.readAsync( queue_, 0u, &res, sizeof (ValueType), ocl::EventList( last ) );
+      
+      // Wait for the kernels to finish.
+      queue_.finish();
+      
+      assert( res == result );
+      
+      return (last.finishTime() - first.startTime()) / 1000000000.0;
+    } );
+  }
+  
+  double ops( utl::Dim const& dim ) override
+  {
+    return 2 * dim[0] - 1;
+  }
+  
+private :  
+  ocl::Platform                               platform_;
+  ocl::Device                                 device_;
+  ocl::Context                                context_;
+  ocl::Queue                                  queue_;
+  std::string                                 kernelName_;
+  bool isTwoPass_;
+};
+
+
+
+int main( int argc, char** argv )
 {
+  utl::Args args( argc, argv );
+  
   try
   {
     utl::ProfilePassManager< float > mgr;
@@ -267,8 +472,18 @@ int main()
     mgr << std::make_shared< DotProductProfiler< float > >( "dot_fma_vec2", false, start, step, end );
     mgr << std::make_shared< DotProductProfiler< float > >( "dot_fma_vec4", false, start, step, end );
     
+    // The kernels above compute the whole dot product in every work-item, these partition it.
+    mgr << std::make_shared< DotReductionProfiler< float > >( "dot_partial_vec4", true, start, step, end );
+    mgr << std::make_shared< DotReductionProfiler< float > >( "dot_atomic_vec4", false, start, step, end );
+    
+    // Powers of two refined around the sizes where the performance changes, e.g. at cache sizes.
+    mgr.setAdaptiveSweep( 0.1, 64 );
+    
     mgr.run();
     mgr.write( std::cout );
+    
+    if ( args.size() > 1 ) mgr.write( args.toString( 1 ) );
+    if ( args.size() > 2 && mgr.compare( args.toString( 2 ), std::cout ) > 0 ) return EXIT_FAILURE;
   }
   catch ( std::exception& e )
   {
@@ -19,6 +19,7 @@
 #include <ocl_query.h>
 #include <ocl_queue.h>
 
+#include <utl_args.h>
 #include <utl_profile_pass.h>
 #include <utl_profile_pass_manager.h>
 #include <utl_type.h>
@@ -37,6 +38,8 @@ public :
     context_( device_ ),
     queue_( (platform_.insert( context_ ), platform_.setActiveContext( context_ ), context_), device_, CL_QUEUE_PROFILING_ENABLE )
   {
+    this->setDevice( device_ );
+    
     context_.setActiveQueue( queue_ );
   }
   
@@ -67,42 +70,23 @@ public :
         // Don't care about wavefront/warp sizes here.
         kernel.setWorkSize( 1, 1 );
         
-        std::vector< ocl::Event > evts( this->_iter );
-        ocl::EventList allKernelsExecuted;
-        
         std::vector< int > parameters( numArgs, 42 );
         
-        for ( auto i = 0u; i < this->_iter; ++i )
-        {          
+        // Return median time in seconds.
+        return this->measure( [&]() -> double
+        {
           for ( auto j = 0; j < numArgs; ++j )
           {
             kernel.setArg( j, parameters[j] );
           }
           
-          evts[i] = kernel( queue_ );
+          ocl::Event const kernelExecuted = kernel( queue_ );
           
-          allKernelsExecuted << evts[i];
-        }
-        
-        // Wait for all kernels to finish.
-        queue_.barrier( allKernelsExecuted );
-        
-        // Calculate the total execution time.
-        double totalRuntime_ns( 0 );
-
-        //for ( auto const& evt : allKernelsExecuted.events() )
-        for ( size_t i = 0; i < allKernelsExecuted.size(); ++i )
-        {
-          auto const start = allKernelsExecuted.at(i).startTime();
-          auto const end   = allKernelsExecuted.at(i).finishTime();
-          auto const kernelRuntime_ns = end - start;
-
-          totalRuntime_ns += kernelRuntime_ns;
-        }
-                
-        // Return average time in seconds.
-        return (static_cast< double >( totalRuntime_ns ) / this->_iter) / 1000000000.0;
-        //return std::chrono::duration_cast< std::chrono::microseconds >( totalRuntime /* this->_iter */).count();
+          // Wait for the kernel to finish.
+          queue_.finish();
+          
+          return (kernelExecuted.finishTime() - kernelExecuted.startTime()) / 1000000000.0;
+        } );
       }
       else
       {
@@ -150,8 +134,10 @@ private :
 
 
 
-int main()
+int main( int argc, char** argv )
 {
+  utl::Args args( argc, argv );
+  
   try
   {
     utl::ProfilePassManager< float > mgr;
@@ -163,6 +149,9 @@ int main()
     
     mgr.run();
     mgr.write( std::cout );
+    
+    if ( args.size() > 1 ) mgr.write( args.toString( 1 ) );
+    if ( args.size() > 2 && mgr.compare( args.toString( 2 ), std::cout ) > 0 ) return EXIT_FAILURE;
   }
   catch ( std::exception& e )
   {
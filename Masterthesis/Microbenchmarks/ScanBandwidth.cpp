@@ -0,0 +1,152 @@
+/**
+ * This microbenchmark measures the bandwidth of the exclusive and inclusive
+ * scans of ocl::Reduction and compares it with a plain copy of the same Buffer.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <ocl_buffer.h>
+#include <ocl_context.h>
+#include <ocl_device.h>
+#include <ocl_device_type.h>
+#include <ocl_event_list.h>
+#include <ocl_platform.h>
+#include <ocl_queue.h>
+#include <ocl_reduce.h>
+
+#include <utl_args.h>
+#include <utl_profile_pass.h>
+#include <utl_profile_pass_manager.h>
+
+constexpr size_t NumIterations = 100u;
+
+
+
+/**
+ * Scans a Buffer of ones, so the prefixes are the indices, and copies it.
+ *
+ * Both read and write every element once, so their bandwidth is given by
+ * twice the bytes of the Buffer over the device time of the profiling events.
+ * The scan additionally reads and writes the totals of its work-groups.
+ */
+template< typename T >
+class ScanProfiler : public utl::ProfilePass< float >
+{
+public :
+  ScanProfiler( std::string const& typeName, bool isInclusive, utl::Dim const& start, utl::Dim const& step, utl::Dim const& end, size_t numIterations = NumIterations ):
+    utl::ProfilePass< float >( std::string( isInclusive ? "InclusiveScan_" : "ExclusiveScan_" ) + typeName, start, step, end, numIterations ),
+    platform_( ocl::device_type::CPU ),
+    device_( platform_.device( ocl::device_type::CPU ) ),
+    context_( device_ ),
+    queue_( (platform_.insert( context_ ), platform_.setActiveContext( context_ ), context_), device_, CL_QUEUE_PROFILING_ENABLE ),
+    isInclusive_( isInclusive )
+  {
+    this->setDevice( device_ );
+    this->setMetadata( "element_type", typeName );
+
+    context_.setActiveQueue( queue_ );
+  }
+
+  double prof( utl::Dim const& dim ) override
+  {
+    assert( dim.size() >= 1u );
+
+    size_t const n = dim[0];
+    size_t const numBytes = n * sizeof (T);
+
+    ocl::Buffer input( context_, numBytes, ocl::Buffer::ReadOnly ),
+                output( context_, numBytes );
+
+    std::vector< T > host( n, T( 1 ) );
+
+    ocl::Reduction& reduction = ocl::reduction( context_ );
+
+    // A scan runs several kernels and returns the event of the last one, so it is
+    // timed from the end of the preceding write of its input, which the queue orders before it.
+    auto const timed = [&]( bool scan ) -> double
+    {
+      ocl::Event const written = input.writeAsync( queue_, 0u, host.data(), numBytes );
+      ocl::EventList const after( written );
+
+      ocl::Event const done = !scan        ? input.copyToAsync( queue_, 0, numBytes, output, 0, after )
+                            : isInclusive_ ? reduction.inclusiveScan< T >( queue_, input, output, n, ocl::ReduceOp::Sum, 0, 0, after )
+                                           : reduction.exclusiveScan< T >( queue_, input, output, n, ocl::ReduceOp::Sum, 0, 0, after );
+      queue_.finish();
+
+      return ( done.finishTime() - ( scan ? written.finishTime() : done.startTime() ) ) * 1e-9;
+    };
+
+    // The first scan builds the kernels, the first copy touches the output.
+    timed( true );
+    timed( false );
+    std::vector< double > copyTimes;
+    for ( size_t i = 0; i < 5; ++i ) copyTimes.push_back( timed( false ) );
+    std::sort( copyTimes.begin(), copyTimes.end() );
+
+    double const median = this->measure( [&]() -> double { return timed( true ); } );
+
+    output.read( queue_, host.data(), numBytes );
+    for ( size_t i = 0; i < n; i += std::max< size_t >( n / 64, 1 ) )
+      if ( host[i] != T( isInclusive_ ? i + 1 : i ) ) throw std::runtime_error( "wrong prefix at " + std::to_string( i ) );
+
+    double const scanRate = 2.0 * numBytes / median * 1e-9, copyRate = 2.0 * numBytes / copyTimes[2] * 1e-9;
+    std::cout << this->name() << " " << n << ": " << scanRate << " GB/s, copy " << copyRate << " GB/s ("
+              << 100.0 * scanRate / copyRate << "%)" << std::endl;
+
+    return median;
+  }
+
+  double ops( utl::Dim const& dim ) override
+  {
+    // Bytes read and written, so the performance is the bandwidth.
+    return 2.0 * dim[0] * sizeof (T);
+  }
+
+private :
+  ocl::Platform platform_;
+  ocl::Device   device_;
+  ocl::Context  context_;
+  ocl::Queue    queue_;
+  bool isInclusive_;
+};
+
+
+
+int main( int argc, char** argv )
+{
+  utl::Args args( argc, argv );
+
+  try
+  {
+    utl::ProfilePassManager< float > mgr;
+
+    // Number of elements, float prefixes of ones are exact up to 2^24.
+    utl::Dim start( 1 << 10 ), step( 1 << 10 ), end( 1 << 24 );
+
+    mgr << std::make_shared< ScanProfiler< int > >( "int", false, start, step, end );
+    mgr << std::make_shared< ScanProfiler< int > >( "int", true, start, step, end );
+    mgr << std::make_shared< ScanProfiler< unsigned int > >( "uint", false, start, step, end );
+    mgr << std::make_shared< ScanProfiler< float > >( "float", false, start, step, end );
+
+    mgr.setGeometricSweep( 4.0 );
+
+    mgr.run();
+    mgr.write( std::cout );
+
+    if ( args.size() > 1 ) mgr.write( args.toString( 1 ) );
+    if ( args.size() > 2 && mgr.compare( args.toString( 2 ), std::cout ) > 0 ) return EXIT_FAILURE;
+  }
+  catch ( std::exception& e )
+  {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
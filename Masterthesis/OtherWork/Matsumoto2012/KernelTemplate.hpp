@@ -228,8 +228,8 @@ constexpr char const KernelTemplate< Matrix >::GLOBAL[];
  * 
  * @pre The inner blocks of the must all have the same size i.e. no blocks are allowed to have less elements especially at the matrix' borders.
  */
-template< typename T >
-std::string index( std::string const& x, std::string const& y, utl::Matrix2< T, utl::column_major_tag, utl::row_major_tag > const& m )
+template< typename T, typename Alloc >
+std::string index( std::string const& x, std::string const& y, utl::Matrix2< T, utl::column_major_tag, utl::row_major_tag, Alloc > const& m )
 {
   assert( m.rows() % m.innerRows() == 0 );
   assert( m.cols() % m.innerCols() == 0 );
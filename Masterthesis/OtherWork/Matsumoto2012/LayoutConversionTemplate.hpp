@@ -0,0 +1,184 @@
+#ifndef LAYOUT_CONVERSION_TEMPLATE_HPP
+#define LAYOUT_CONVERSION_TEMPLATE_HPP
+
+#include <cassert>
+#include <iosfwd>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+#include <ocl_kernel.h>
+#include <utl_type.h>
+#include "utl_matrix2.hpp"
+
+/**
+ * Generates kernels that convert between column- or row-major matrices and the block layout
+ * of a Matrix2 on the device. This allows to feed the generated multiplication kernels with
+ * operands in a standard layout without converting them on the host.
+ *
+ * Each work group converts a square tile of the matrix. The tile is read along the contiguous
+ * dimension of the source into local memory and written along the contiguous dimension of the
+ * destination, so both the loads and the stores are coalesced. The tile is padded by one column
+ * to avoid bank conflicts when it is read transposed.
+ *
+ * The kernels have the interface
+ * \code
+ * __kernel void <name>_to_blocked( __global T const* src, uint const rowStride, uint const colStride, __global T* dst );
+ * __kernel void <name>_from_blocked( __global T const* src, __global T* dst, uint const rowStride, uint const colStride );
+ * \endcode
+ * where rowStride and colStride are the distances between two rows and columns of the strided
+ * matrix, e.g. 1 and the number of rows for a column-major matrix.
+ *
+ * @tparam Matrix Specialisation of Matrix2 that determines the block layout.
+ */
+template< typename Matrix >
+class LayoutConversionTemplate
+{
+public :
+  /**
+   * @param tile Number of rows and columns of the tile converted by a work group.
+   */
+  explicit LayoutConversionTemplate( size_t tile = 16 ):
+    tile_( tile )
+  {
+    assert( tile > 0 );
+  }
+
+  /**
+   * Generate both conversion kernels for the size and blocking of a matrix.
+   *
+   * @param os Stream to write the kernels to.
+   * @param m Matrix whose size and block layout are baked into the kernels.
+   * @param name Prefix of the kernel names. Use different prefixes for matrices of different size.
+   *
+   * @par Exception Guarantee
+   * strong
+   */
+  void generate( std::ostream& os, Matrix const& m, std::string const& name ) const
+  {
+    std::ostringstream oss;
+
+    auto const dataType = utl::getType< typename Matrix::value_type >().name();
+
+    oss << KERNEL << " void " << toBlockedName( name ) << "( " <<
+      GLOBAL << ' ' << dataType << " const* src, uint const rowStride, uint const colStride, " <<
+      GLOBAL << ' ' << dataType << "* dst )\n{\n";
+    header( oss, dataType );
+    oss << "  // Read along the contiguous dimension of the source.\n" <<
+           "  row = rowStride == 1 ? r0 + lx : r0 + ly;\n" <<
+           "  col = rowStride == 1 ? c0 + ly : c0 + lx;\n" <<
+           "  if ( row < " << m.rows() << " && col < " << m.cols() << " )\n" <<
+           "    tile[col - c0][row - r0] = src[row * rowStride + col * colStride];\n\n" <<
+           "  barrier( CLK_LOCAL_MEM_FENCE );\n\n";
+    blockedCoordinates( oss );
+    oss << "  if ( row < " << m.rows() << " && col < " << m.cols() << " )\n  {\n";
+    blockedIndex( oss, m );
+    oss << "    dst[index] = tile[col - c0][row - r0];\n  }\n}\n\n";
+
+    oss << KERNEL << " void " << fromBlockedName( name ) << "( " <<
+      GLOBAL << ' ' << dataType << " const* src, " <<
+      GLOBAL << ' ' << dataType << "* dst, uint const rowStride, uint const colStride )\n{\n";
+    header( oss, dataType );
+    blockedCoordinates( oss );
+    oss << "  if ( row < " << m.rows() << " && col < " << m.cols() << " )\n  {\n";
+    blockedIndex( oss, m );
+    oss << "    tile[col - c0][row - r0] = src[index];\n  }\n\n" <<
+           "  barrier( CLK_LOCAL_MEM_FENCE );\n\n" <<
+           "  // Write along the contiguous dimension of the destination.\n" <<
+           "  row = rowStride == 1 ? r0 + lx : r0 + ly;\n" <<
+           "  col = rowStride == 1 ? c0 + ly : c0 + lx;\n" <<
+           "  if ( row < " << m.rows() << " && col < " << m.cols() << " )\n" <<
+           "    dst[row * rowStride + col * colStride] = tile[col - c0][row - r0];\n}\n\n";
+
+    os << oss.str();
+  }
+
+  std::string toBlockedName( std::string const& name ) const { return name + "_to_blocked"; }
+
+  std::string fromBlockedName( std::string const& name ) const { return name + "_from_blocked"; }
+
+  size_t tile() const { return tile_; }
+
+  /**
+   * Set the work sizes of a conversion kernel generated for m.
+   */
+  void setWorkSize( ocl::Kernel& kernel, Matrix const& m ) const
+  {
+    kernel.setWorkSize( tile(), tile(), roundUp( m.rows() ), roundUp( m.cols() ) );
+  }
+
+private :
+  static constexpr char const KERNEL[] = "__kernel";
+  static constexpr char const GLOBAL[] = "__global";
+
+  size_t roundUp( size_t n ) const { return (n + tile() - 1u) / tile() * tile(); }
+
+  void header( std::ostream& os, std::string const& dataType ) const
+  {
+    os << "  local " << dataType << " tile[" << tile() << "][" << tile() + 1u << "];\n\n" <<
+          "  uint const lx = get_local_id( 0 ), ly = get_local_id( 1 );\n" <<
+          "  uint const r0 = get_group_id( 0 ) * " << tile() << ", c0 = get_group_id( 1 ) * " << tile() << ";\n" <<
+          "  uint row, col;\n\n";
+  }
+
+  /**
+   * Let the first local dimension run along the contiguous dimension of the blocks.
+   */
+  void blockedCoordinates( std::ostream& os ) const
+  {
+    if ( std::is_same< InnerLayout, utl::column_major_tag >::value )
+      os << "  row = r0 + lx;\n  col = c0 + ly;\n";
+    else
+      os << "  row = r0 + ly;\n  col = c0 + lx;\n";
+  }
+
+  /**
+   * Compute the index of the element (row, col) in the block layout. This is the same as Matrix2::computeIndex()
+   * including the smaller blocks at the borders of the matrix.
+   */
+  void blockedIndex( std::ostream& os, Matrix const& m ) const
+  {
+    auto const rows = std::to_string( m.rows() ), cols = std::to_string( m.cols() );
+    auto const innerRows = std::to_string( m.innerRows() ), innerCols = std::to_string( m.innerCols() );
+
+    os << "    uint const blockRow = row / " << innerRows << " * " << innerRows << ", blockCol = col / " << innerCols << " * " << innerCols << ";\n" <<
+          "    uint const rowsOfBlock = min( " << innerRows << "u, " << rows << "u - blockRow );\n" <<
+          "    uint const colsOfBlock = min( " << innerCols << "u, " << cols << "u - blockCol );\n";
+
+    if ( std::is_same< OuterLayout, utl::column_major_tag >::value )
+      os << "    uint index = blockCol * " << rows << " + blockRow * colsOfBlock;\n";
+    else
+      os << "    uint index = blockRow * " << cols << " + blockCol * rowsOfBlock;\n";
+
+    if ( std::is_same< InnerLayout, utl::column_major_tag >::value )
+      os << "    index += (col - blockCol) * rowsOfBlock + (row - blockRow);\n";
+    else
+      os << "    index += (row - blockRow) * colsOfBlock + (col - blockCol);\n";
+  }
+
+  template< typename M > struct Layouts;
+
+  template< typename T, typename O, typename I, typename A >
+  struct Layouts< utl::Matrix2< T, O, I, A > >
+  {
+    typedef O Outer;
+    typedef I Inner;
+  };
+
+  typedef typename Layouts< Matrix >::Outer OuterLayout;
+  typedef typename Layouts< Matrix >::Inner InnerLayout;
+
+  size_t tile_;
+};
+
+
+
+template< typename Matrix >
+constexpr char const LayoutConversionTemplate< Matrix >::KERNEL[];
+
+
+
+template< typename Matrix >
+constexpr char const LayoutConversionTemplate< Matrix >::GLOBAL[];
+
+#endif
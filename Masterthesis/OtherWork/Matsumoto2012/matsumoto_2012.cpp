@@ -17,24 +17,35 @@
 
 #include "BasicTemplate.hpp"
 #include "DoubleBufferingTemplate.hpp"
+#include "LayoutConversionTemplate.hpp"
 #include "PipeliningTemplate.hpp"
 
 typedef float Type;
 
 
+/**
+ * Measures a kernel generated by a KernelTemplate.
+ * 
+ * If the operands are given in column-major order, they are converted into the block layout
+ * of Matrix by kernels of a LayoutConversionTemplate before the multiplication and the result
+ * is converted back afterwards. The runtime of the conversions is included then.
+ */
 template< typename Matrix >
 class Matsumoto2012Pass : public utl::ProfilePass< typename Matrix::value_type >
 {
 public :
-  Matsumoto2012Pass( std::unique_ptr< KernelTemplate< Matrix > >&& kernelTemplate, bool testing, utl::Dim const& start, utl::Dim const& step, utl::Dim const& end, std::size_t iter = 10 ):
-    utl::ProfilePass< typename Matrix::value_type >( "Matsumoto2012", start, step, end, iter ),
+  Matsumoto2012Pass( std::unique_ptr< KernelTemplate< Matrix > >&& kernelTemplate, bool testing, utl::Dim const& start, utl::Dim const& step, utl::Dim const& end, std::size_t iter = 10, bool columnMajor = false ):
+    utl::ProfilePass< typename Matrix::value_type >( columnMajor ? "Matsumoto2012_ColMajor" : "Matsumoto2012", start, step, end, iter ),
     kernelTemplate_( std::move( kernelTemplate ) ),
     testing_( testing ),
+    columnMajor_( columnMajor ),
     platform_( ocl::device_type::CPU ),
     device_( platform_.device( ocl::device_type::CPU ) ),
     context_( device_ ),
     queue_( (platform_.insert( context_ ), platform_.setActiveContext( context_ ), context_), device_, CL_QUEUE_PROFILING_ENABLE )
   {
+    this->setDevice( device_ );
+    
     context_.setActiveQueue( queue_ );
   }
   
@@ -52,6 +63,13 @@ public :
     std::ostringstream oss;
     kernelTemplate_->generate( oss, lhs, rhs, result );
     
+    if ( columnMajor_ )
+    {
+      conversion_.generate( oss, lhs, "lhs" );
+      conversion_.generate( oss, rhs, "rhs" );
+      conversion_.generate( oss, result, "result" );
+    }
+    
     ocl::Program program( context_, utl::getType< typename Matrix::value_type >() );
         
     std::string const srcFilename = "/home/fpatschkowski/Projekte/kernel.cl";
@@ -101,7 +119,7 @@ public :
         
         auto const resCopy = result;
         
-        std::chrono::nanoseconds totalRuntime{ 0 };
+        double median = 0.0;
         
         auto const localX = kernelTemplate_->NdimC(), localY = kernelTemplate_->MdimC(), globalX = N / kernelTemplate_->Nwg() * kernelTemplate_->NdimC(), globalY = M / kernelTemplate_->Mwg() * kernelTemplate_->MdimC();
       
@@ -112,13 +130,63 @@ public :
         size_t const     numLhsBytes    = typeSize * lhs.size();
         size_t const     numRhsBytes    = typeSize * rhs.size();
         
-        ocl::Buffer bufResult( context_, numResultBytes, ocl::Buffer::WriteOnly ),
-                    bufLhs( context_, numLhsBytes, ocl::Buffer::ReadOnly ),
-                    bufRhs( context_, numRhsBytes, ocl::Buffer::ReadOnly );
+        // The blocked operands are written by the conversion kernels if the operands are column-major.
+        ocl::Buffer bufResult( context_, numResultBytes, columnMajor_ ? ocl::Buffer::ReadWrite : ocl::Buffer::WriteOnly ),
+                    bufLhs( context_, numLhsBytes, columnMajor_ ? ocl::Buffer::ReadWrite : ocl::Buffer::ReadOnly ),
+                    bufRhs( context_, numRhsBytes, columnMajor_ ? ocl::Buffer::ReadWrite : ocl::Buffer::ReadOnly );
                     
         Type const alpha = 1, beta = 0;
-
-        for ( std::size_t i = 0; i < this->_iter; ++i )
+        
+        if ( columnMajor_ )
+        {
+          utl::Matrix< Type, utl::column_major_tag > lhsCm, rhsCm, resultCm( M, N );
+          utl::convert( lhs, lhsCm );
+          utl::convert( rhs, rhsCm );
+          
+          ocl::Buffer bufLhsCm( context_, numLhsBytes, ocl::Buffer::ReadOnly ),
+                      bufRhsCm( context_, numRhsBytes, ocl::Buffer::ReadOnly ),
+                      bufResultCm( context_, numResultBytes, ocl::Buffer::WriteOnly );
+          
+          ocl::Kernel& lhsToBlocked( program.kernel( conversion_.toBlockedName( "lhs" ) ) );
+          ocl::Kernel& rhsToBlocked( program.kernel( conversion_.toBlockedName( "rhs" ) ) );
+          ocl::Kernel& resultFromBlocked( program.kernel( conversion_.fromBlockedName( "result" ) ) );
+          
+          conversion_.setWorkSize( lhsToBlocked, lhs );
+          conversion_.setWorkSize( rhsToBlocked, rhs );
+          conversion_.setWorkSize( resultFromBlocked, result );
+          
+          median = this->measure( [&]() -> double
+          {
+            ocl::Event const lhsWritten = bufLhsCm.writeAsync( queue_, 0u, lhsCm.data(), numLhsBytes );
+            ocl::Event const rhsWritten = bufRhsCm.writeAsync( queue_, 0u, rhsCm.data(), numRhsBytes );
+            
+            // Convert the operands into the block layout on the device.
+            ocl::Event const lhsConverted = lhsToBlocked( queue_, ocl::EventList( lhsWritten ), bufLhsCm.id(), 1u, static_cast< unsigned int >( M ), bufLhs.id() );
+            ocl::Event const rhsConverted = rhsToBlocked( queue_, ocl::EventList( rhsWritten ), bufRhsCm.id(), 1u, static_cast< unsigned int >( L ), bufRhs.id() );
+            
+            ocl::EventList operandsConverted;
+            operandsConverted << lhsConverted << rhsConverted;
+            
+            ocl::Event const multiplyDone = kernel( queue_, operandsConverted, alpha, bufLhs.id(), bufRhs.id(), beta, bufResult.id() );
+            
+            ocl::Event const resultConverted = resultFromBlocked( queue_, ocl::EventList( multiplyDone ), bufResult.id(), bufResultCm.id(), 1u, static_cast< unsigned int >( M ) );
+            
+            ocl::Event const resultRead = bufResultCm.readAsync( queue_, 0u, resultCm.data(), numResultBytes, ocl::EventList( resultConverted ) );
+            
+            queue_.finish();
+            
+            size_t const runtime_ns = (lhsConverted.finishTime() - lhsConverted.startTime()) +
+                                      (rhsConverted.finishTime() - rhsConverted.startTime()) +
+                                      (multiplyDone.finishTime() - multiplyDone.startTime()) +
+                                      (resultConverted.finishTime() - resultConverted.startTime());
+            
+            return runtime_ns * 1e-9;
+          } );
+          
+          utl::convert( resultCm, result );
+        }
+        
+        if ( !columnMajor_ ) median = this->measure( [&]() -> double
         {
           // Copy data from host to device.
           ocl::Event const lhsWritten = bufLhs.writeAsync( queue_, 0u, lhs.data(), numLhsBytes );
@@ -138,8 +206,8 @@ public :
           
           size_t const kernelRuntime_ns = multiplyDone.finishTime() - multiplyDone.startTime();
 
-          totalRuntime += std::chrono::nanoseconds( kernelRuntime_ns );
-        }
+          return kernelRuntime_ns * 1e-9;
+        } );
         
         if( testing_ )
         {
@@ -147,7 +215,7 @@ public :
           auto const t2 = t1 *rhs;
           auto const t3 = beta * resCopy;
           auto const t4 = t2 + t3;*/
-          auto const ref  = alpha * lhs * rhs + beta * resCopy;
+          Matrix const ref = alpha * lhs * rhs + beta * resCopy;
           auto const diff = result - ref;
           auto const iMax = std::max_element( diff.begin(), diff.end(), []( Type a, Type b ){
             return std::fabs( a ) < std::fabs( b );
@@ -164,8 +232,8 @@ public :
           }
         }
         
-        // Return average time.
-        return std::chrono::duration_cast< std::chrono::microseconds >( totalRuntime / this->_iter ).count();
+        // Return median time in seconds.
+        return median;
       }
       else
       {
@@ -187,6 +255,8 @@ public :
 private :
   std::unique_ptr< KernelTemplate< Matrix > > kernelTemplate_;
   bool                                        testing_;
+  bool                                        columnMajor_;
+  LayoutConversionTemplate< Matrix >          conversion_;
   ocl::Platform                               platform_;
   ocl::Device                                 device_;
   ocl::Context                                context_;
@@ -203,7 +273,7 @@ int main( int argc, char** argv )
   std::cerr.sync_with_stdio();
   std::clog.sync_with_stdio();
   
-  if ( args.size() == 2 )
+  if ( args.size() >= 2 && args.size() <= 4 )
   {
     try
     {
@@ -230,8 +300,17 @@ int main( int argc, char** argv )
           start[1]
         ) ), args.toBool( 1 ), start, step, end );
       
+      // The same kernel fed with column-major operands which are converted on the device.
+      mgr << std::make_shared< Matsumoto2012Pass< utl::Matrix2< Type, utl::column_major_tag, utl::row_major_tag > > >(
+        std::unique_ptr< DoubleBufferingTemplate< utl::Matrix2< Type, utl::column_major_tag, utl::row_major_tag > > >( new DoubleBufferingTemplate< utl::Matrix2< Type, utl::column_major_tag, utl::row_major_tag > >(
+          start[1]
+        ) ), args.toBool( 1 ), start, step, end, 10, true );
+      
       mgr.run();
       mgr.write( std::cout );
+      
+      if ( args.size() > 2 ) mgr.write( args.toString( 2 ) );
+      if ( args.size() > 3 && mgr.compare( args.toString( 3 ), std::cout ) > 0 ) return EXIT_FAILURE;
     }
     catch ( std::exception& e )
     {
@@ -241,7 +320,7 @@ int main( int argc, char** argv )
   }
   else
   {
-    std::cout << "Usage: " << args.at( 0 ) << " <bool_testing>" << std::endl;
+    std::cout << "Usage: " << args.at( 0 ) << " <bool_testing> [<results.json|results.csv> [<baseline.csv>]]" << std::endl;
     return EXIT_FAILURE;
   }
   
@@ -5,6 +5,7 @@
 #include <iterator>
 
 #include <utl_matrix.h>
+#include <utl_transpose.h>
 
 namespace utl {
 
@@ -12,141 +13,15 @@ namespace utl {
 * @tparam T Type of value stored in the matrix.
 * @tparam OuterLayout Layout of the inner blocks stored in the matrix. Can be either row_major_tag or column_major_tag.
 * @tparam InnerLayout Layout of the elements in the inner blocks of the matrix. Can be one of row_major_tag or column_major_tag.
+* @tparam Alloc Allocator of the elements, e.g. one of utl_allocator.h.
 */
-template< typename T, typename OuterLayout, typename InnerLayout >
+template< typename T, typename OuterLayout, typename InnerLayout, typename Alloc = std::allocator< T > >
 class Matrix2 { ~Matrix2() = delete; };
 
 
 
-template< typename T, typename OuterLayout, typename InnerLayout >
-Matrix2< T, OuterLayout, InnerLayout > operator *(
-  Matrix2< T, OuterLayout, InnerLayout > const& m,
-  typename Matrix2< T, OuterLayout, InnerLayout >::const_reference value )
-{
-  auto res = m;
-
-  std::transform( m.begin(), m.end(), res.begin(), std::bind_front( std::multiplies< T >(), value ) );
-  
-  return res;
-}
-
-
-template< typename T, typename OuterLayout, typename InnerLayout >
-Matrix2< T, OuterLayout, InnerLayout > operator *(
-  typename Matrix2< T, OuterLayout, InnerLayout >::const_reference value,
-  Matrix2< T, OuterLayout, InnerLayout > const& m )
-{
-  return m * value;
-}
-
-
-
-template< typename T, typename OuterLayout, typename InnerLayout >
-Matrix2< T, OuterLayout, InnerLayout > operator /(
-  Matrix2< T, OuterLayout, InnerLayout > const& m,
-  typename Matrix2< T, OuterLayout, InnerLayout >::const_reference value )
-{
-  auto res = m;
-
-  std::transform( m.begin(), m.end(), res.begin(), std::bind_front( std::divides< T >(), value ) );
-  
-  return res;
-}
-
-
-
-template< typename T, typename OuterLayout, typename InnerLayout >
-Matrix2< T, OuterLayout, InnerLayout > operator +(
-  Matrix2< T, OuterLayout, InnerLayout > const& m,
-  typename Matrix2< T, OuterLayout, InnerLayout >::const_reference value )
-{
-  auto res = m;
-
-  std::transform( m.begin(), m.end(), res.begin(), std::bind_front( std::plus< T >(), value ) );
-  
-  return res;
-}
-
-
-
-template< typename T, typename OuterLayout, typename InnerLayout >
-Matrix2< T, OuterLayout, InnerLayout > operator +(
-  Matrix2< T, OuterLayout, InnerLayout > const& m1,
-  Matrix2< T, OuterLayout, InnerLayout > const& m2 )
-{
-  auto res = m1;
-
-  std::transform( m1.begin(), m1.end(), m2.begin(), res.begin(), std::plus< T >() );
-  
-  return res;
-}
-
-
-
-template< typename T, typename OuterLayout, typename InnerLayout >
-Matrix2< T, OuterLayout, InnerLayout > operator -(
-  Matrix2< T, OuterLayout, InnerLayout > const& m,
-  typename Matrix2< T, OuterLayout, InnerLayout >::const_reference value )
-{
-  auto res = m;
-
-  std::transform( m.begin(), m.end(), res.begin(), std::bind_front( std::minus< T >(), value ) );
-  
-  return res;
-}
-
-
-
-template< typename T, typename OuterLayout, typename InnerLayout >
-Matrix2< T, OuterLayout, InnerLayout > operator -(
-  Matrix2< T, OuterLayout, InnerLayout > const& m1,
-  Matrix2< T, OuterLayout, InnerLayout > const& m2 )
-{
-  return m1 + -m2;
-}
-
-template< typename T, typename OuterLayout, typename InnerLayout >
-Matrix2< T, OuterLayout, InnerLayout > operator -(
-  Matrix2< T, OuterLayout, InnerLayout > const& m )
-{
-  auto res = m;
-
-  std::transform( m.begin(), m.end(), res.begin(), std::negate<T>() );
-  
-  return res;
-}
-
-
-
-template< typename T, typename OuterLayout, typename InnerLayout >
-Matrix2< T, OuterLayout, InnerLayout > operator *(
-  Matrix2< T, OuterLayout, InnerLayout > const& lhs,
-  Matrix2< T, OuterLayout, InnerLayout > const& rhs )
-{
-  TRUE_ASSERT( lhs.cols() == rhs.rows(), "Inner dimension have to match for matrix multiplication." );
-  
-  Matrix2< T, OuterLayout, InnerLayout > result(
-    lhs.rows(), rhs.cols(), lhs.innerRows(), rhs.innerCols()
-  );
-  
-  for ( size_t n = 0; n < result.rows(); ++n )
-    for ( size_t m = 0; m < result.cols(); ++m )
-    {
-      typename Matrix2< T, OuterLayout, InnerLayout >::value_type element( 0 );
-      
-      for ( size_t l = 0; l < lhs.cols(); ++l )
-        element += lhs.at( n, l ) * rhs.at( l, m );
-      
-      result.at( n, m ) = element;
-    }
-  
-  return result;
-}
-
-
-
-template< typename T, typename OuterLayout, typename InnerLayout >
-std::ostream& operator <<( std::ostream& out, Matrix2< T, OuterLayout, InnerLayout > const& mat )
+template< typename T, typename OuterLayout, typename InnerLayout, typename Alloc >
+std::ostream& operator <<( std::ostream& out, Matrix2< T, OuterLayout, InnerLayout, Alloc > const& mat )
 {
   out << '[';
   
@@ -158,7 +33,7 @@ std::ostream& operator <<( std::ostream& out, Matrix2< T, OuterLayout, InnerLayo
   {
     char const* const delimiter = mat.rows() > mat.cols() ? "; " : ", ";
     
-    std::ostream_iterator< typename Matrix2< T, OuterLayout, InnerLayout >::value_type > it( out, delimiter );
+    std::ostream_iterator< typename Matrix2< T, OuterLayout, InnerLayout, Alloc >::value_type > it( out, delimiter );
     
     std::copy( std::begin( mat ), std::end( mat ), it );
   }
@@ -197,17 +72,19 @@ out << "| ";*/
   return out << "];\n";
 }
 
-template< typename T >
-class Matrix2< T, column_major_tag, column_major_tag > : public __MatrixBase< T >
+template< typename T, typename Alloc >
+class Matrix2< T, column_major_tag, column_major_tag, Alloc > : public __MatrixBase< T, Alloc >, public MatrixExpressionBase
 {
 public :
-  typedef typename __MatrixBase< T >::pointer pointer;
-  typedef typename __MatrixBase< T >::const_pointer const_pointer;
-  typedef typename __MatrixBase< T >::reference reference;
-  typedef typename __MatrixBase< T >::const_reference const_reference;
-  typedef typename __MatrixBase< T >::value_type value_type;
-  typedef typename __MatrixBase< T >::iterator iterator;
-  typedef typename __MatrixBase< T >::const_iterator const_iterator;
+  typedef typename __MatrixBase< T, Alloc >::pointer pointer;
+  typedef typename __MatrixBase< T, Alloc >::const_pointer const_pointer;
+  typedef typename __MatrixBase< T, Alloc >::reference reference;
+  typedef typename __MatrixBase< T, Alloc >::const_reference const_reference;
+  typedef typename __MatrixBase< T, Alloc >::value_type value_type;
+  typedef typename __MatrixBase< T, Alloc >::iterator iterator;
+  typedef typename __MatrixBase< T, Alloc >::const_iterator const_iterator;
+  typedef typename __MatrixBase< T, Alloc >::storage_type storage_type;
+  typedef Matrix2 terminal_type;
   
   reference at( size_t row, size_t col )
   {
@@ -217,14 +94,14 @@ public :
   }
   
   Matrix2( size_t rows, size_t cols, size_t innerRows, size_t innerCols, const_reference value ):
-    __MatrixBase< T >( rows, cols, value ), innerRows_( innerRows ), innerCols_( innerCols )
+    __MatrixBase< T, Alloc >( rows, cols, value ), innerRows_( innerRows ), innerCols_( innerCols )
   {
     TRUE_ASSERT( innerCols <= cols, "Inner blocks larger than matrix" );
     TRUE_ASSERT( innerRows <= rows, "Inner blocks larger than matrix" );
   }
   
   Matrix2( size_t rows, size_t cols, size_t innerRows, size_t innerCols ):
-    __MatrixBase< T >( rows, cols ), innerRows_( innerRows ), innerCols_( innerCols )
+    __MatrixBase< T, Alloc >( rows, cols ), innerRows_( innerRows ), innerCols_( innerCols )
   {
     TRUE_ASSERT( innerCols <= cols, "Inner blocks larger than matrix" );
     TRUE_ASSERT( innerRows <= rows, "Inner blocks larger than matrix" );
@@ -234,21 +111,52 @@ public :
   Matrix2( Matrix2&& ) = default;
   Matrix2() = default;
   
+  /**
+   * Refers to external elements, e.g. a mapped buffer, which are already stored in this blocked layout. Nothing is copied.
+   *
+   * @param data Elements of the matrix. They must outlive the matrix and are not released by it.
+   */
+  static Matrix2 wrap( pointer data, size_t rows, size_t cols, size_t innerRows, size_t innerCols )
+  {
+    return Matrix2( rows, cols, innerRows, innerCols, storage_type::wrap( data, rows * cols ) );
+  }
+  
+  Matrix2& operator =( Matrix2 const& ) = default;
+  Matrix2& operator =( Matrix2&& ) = default;
+  
+  /**
+   * Evaluates a matrix expression into a new matrix. The blocking is taken from the operands.
+   */
+  template< typename E, typename = typename std::enable_if< isMatrixExpressionNode< E >::value >::type >
+  Matrix2( E const& e ):
+    Matrix2( detail::evaluate( e ) )
+  { }
+  
+  template< typename E, typename = typename std::enable_if< isMatrixExpressionNode< E >::value >::type >
+  Matrix2& operator =( E const& e )
+  {
+    return *this = Matrix2( e );
+  }
+  
   const_reference at( size_t row, size_t col ) const
   {
-    return this->_vector.at( computeIndex( row, col ) );
+    return this->_storage.at( computeIndex( row, col ) );
   }
   
   size_t innerRows() const { return innerRows_; }
   size_t innerCols() const { return innerCols_; }
   
-  Matrix2( __MatrixBase< T >&& base ):
-    __MatrixBase< T >( std::move( base ) ), innerRows_( 0 ), innerCols_( 0 )
+  Matrix2( __MatrixBase< T, Alloc >&& base ):
+    __MatrixBase< T, Alloc >( std::move( base ) ), innerRows_( 0 ), innerCols_( 0 )
   { }
   
 private :
   size_t innerRows_, innerCols_;
   
+  Matrix2( size_t rows, size_t cols, size_t innerRows, size_t innerCols, storage_type&& storage ):
+    __MatrixBase< T, Alloc >( rows, cols, std::move( storage ) ), innerRows_( innerRows ), innerCols_( innerCols )
+  { }
+  
   size_t computeIndex( size_t row, size_t col ) const
   {
     // Indices of the inner blocks.
@@ -288,17 +196,19 @@ private :
 
 
 
-template< typename T >
-class Matrix2< T, column_major_tag, row_major_tag > : public __MatrixBase< T >
+template< typename T, typename Alloc >
+class Matrix2< T, column_major_tag, row_major_tag, Alloc > : public __MatrixBase< T, Alloc >, public MatrixExpressionBase
 {
 public :
-  typedef typename __MatrixBase< T >::pointer pointer;
-  typedef typename __MatrixBase< T >::const_pointer const_pointer;
-  typedef typename __MatrixBase< T >::reference reference;
-  typedef typename __MatrixBase< T >::const_reference const_reference;
-  typedef typename __MatrixBase< T >::value_type value_type;
-  typedef typename __MatrixBase< T >::iterator iterator;
-  typedef typename __MatrixBase< T >::const_iterator const_iterator;
+  typedef typename __MatrixBase< T, Alloc >::pointer pointer;
+  typedef typename __MatrixBase< T, Alloc >::const_pointer const_pointer;
+  typedef typename __MatrixBase< T, Alloc >::reference reference;
+  typedef typename __MatrixBase< T, Alloc >::const_reference const_reference;
+  typedef typename __MatrixBase< T, Alloc >::value_type value_type;
+  typedef typename __MatrixBase< T, Alloc >::iterator iterator;
+  typedef typename __MatrixBase< T, Alloc >::const_iterator const_iterator;
+  typedef typename __MatrixBase< T, Alloc >::storage_type storage_type;
+  typedef Matrix2 terminal_type;
   
   reference at( size_t row, size_t col )
   {
@@ -308,14 +218,14 @@ public :
   }
   
   Matrix2( size_t rows, size_t cols, size_t innerRows, size_t innerCols, const_reference value ):
-    __MatrixBase< T >( rows, cols, value ), innerRows_( innerRows ), innerCols_( innerCols )
+    __MatrixBase< T, Alloc >( rows, cols, value ), innerRows_( innerRows ), innerCols_( innerCols )
   {
     TRUE_ASSERT( innerCols <= cols, "Inner blocks larger than matrix" );
     TRUE_ASSERT( innerRows <= rows, "Inner blocks larger than matrix" );
   }
   
   Matrix2( size_t rows, size_t cols, size_t innerRows, size_t innerCols ):
-    __MatrixBase< T >( rows, cols ), innerRows_( innerRows ), innerCols_( innerCols )
+    __MatrixBase< T, Alloc >( rows, cols ), innerRows_( innerRows ), innerCols_( innerCols )
   {
     TRUE_ASSERT( innerCols <= cols, "Inner blocks larger than matrix" );
     TRUE_ASSERT( innerRows <= rows, "Inner blocks larger than matrix" );
@@ -325,20 +235,51 @@ public :
   Matrix2( Matrix2&& ) = default;
   Matrix2() = default;
   
+  /**
+   * Refers to external elements, e.g. a mapped buffer, which are already stored in this blocked layout. Nothing is copied.
+   *
+   * @param data Elements of the matrix. They must outlive the matrix and are not released by it.
+   */
+  static Matrix2 wrap( pointer data, size_t rows, size_t cols, size_t innerRows, size_t innerCols )
+  {
+    return Matrix2( rows, cols, innerRows, innerCols, storage_type::wrap( data, rows * cols ) );
+  }
+  
+  Matrix2& operator =( Matrix2 const& ) = default;
+  Matrix2& operator =( Matrix2&& ) = default;
+  
+  /**
+   * Evaluates a matrix expression into a new matrix. The blocking is taken from the operands.
+   */
+  template< typename E, typename = typename std::enable_if< isMatrixExpressionNode< E >::value >::type >
+  Matrix2( E const& e ):
+    Matrix2( detail::evaluate( e ) )
+  { }
+  
+  template< typename E, typename = typename std::enable_if< isMatrixExpressionNode< E >::value >::type >
+  Matrix2& operator =( E const& e )
+  {
+    return *this = Matrix2( e );
+  }
+  
   const_reference at( size_t row, size_t col ) const
   {
-    return this->_vector.at( computeIndex( row, col ) );
+    return this->_storage.at( computeIndex( row, col ) );
   }
   
   size_t innerRows() const { return innerRows_; }
   size_t innerCols() const { return innerCols_; }
   
-  Matrix2( __MatrixBase< T >&& base ): __MatrixBase< T >( std::move( base ) )
+  Matrix2( __MatrixBase< T, Alloc >&& base ): __MatrixBase< T, Alloc >( std::move( base ) )
   { }
   
 private :
   size_t innerRows_, innerCols_;
   
+  Matrix2( size_t rows, size_t cols, size_t innerRows, size_t innerCols, storage_type&& storage ):
+    __MatrixBase< T, Alloc >( rows, cols, std::move( storage ) ), innerRows_( innerRows ), innerCols_( innerCols )
+  { }
+  
   size_t computeIndex( size_t row, size_t col ) const
   {
     // Indices of the inner blocks.
@@ -378,17 +319,19 @@ this->rows() - (innerBlockRow * innerRows_) : innerRows_
 
 
 
-template< typename T >
-class Matrix2< T, row_major_tag, column_major_tag > : public __MatrixBase< T >
+template< typename T, typename Alloc >
+class Matrix2< T, row_major_tag, column_major_tag, Alloc > : public __MatrixBase< T, Alloc >, public MatrixExpressionBase
 {
 public :
-  typedef typename __MatrixBase< T >::pointer pointer;
-  typedef typename __MatrixBase< T >::const_pointer const_pointer;
-  typedef typename __MatrixBase< T >::reference reference;
-  typedef typename __MatrixBase< T >::const_reference const_reference;
-  typedef typename __MatrixBase< T >::value_type value_type;
-  typedef typename __MatrixBase< T >::iterator iterator;
-  typedef typename __MatrixBase< T >::const_iterator const_iterator;
+  typedef typename __MatrixBase< T, Alloc >::pointer pointer;
+  typedef typename __MatrixBase< T, Alloc >::const_pointer const_pointer;
+  typedef typename __MatrixBase< T, Alloc >::reference reference;
+  typedef typename __MatrixBase< T, Alloc >::const_reference const_reference;
+  typedef typename __MatrixBase< T, Alloc >::value_type value_type;
+  typedef typename __MatrixBase< T, Alloc >::iterator iterator;
+  typedef typename __MatrixBase< T, Alloc >::const_iterator const_iterator;
+  typedef typename __MatrixBase< T, Alloc >::storage_type storage_type;
+  typedef Matrix2 terminal_type;
   
   reference at( size_t row, size_t col )
   {
@@ -398,14 +341,14 @@ public :
   }
   
   Matrix2( size_t rows, size_t cols, size_t innerRows, size_t innerCols, const_reference value ):
-    __MatrixBase< T >( rows, cols, value ), innerRows_( innerRows ), innerCols_( innerCols )
+    __MatrixBase< T, Alloc >( rows, cols, value ), innerRows_( innerRows ), innerCols_( innerCols )
   {
     TRUE_ASSERT( innerCols <= cols, "Inner blocks larger than matrix" );
     TRUE_ASSERT( innerRows <= rows, "Inner blocks larger than matrix" );
   }
   
   Matrix2( size_t rows, size_t cols, size_t innerRows, size_t innerCols ):
-    __MatrixBase< T >( rows, cols ), innerRows_( innerRows ), innerCols_( innerCols )
+    __MatrixBase< T, Alloc >( rows, cols ), innerRows_( innerRows ), innerCols_( innerCols )
   {
     TRUE_ASSERT( innerCols <= cols, "Inner blocks larger than matrix" );
     TRUE_ASSERT( innerRows <= rows, "Inner blocks larger than matrix" );
@@ -415,20 +358,51 @@ public :
   Matrix2( Matrix2&& ) = default;
   Matrix2() = default;
   
+  /**
+   * Refers to external elements, e.g. a mapped buffer, which are already stored in this blocked layout. Nothing is copied.
+   *
+   * @param data Elements of the matrix. They must outlive the matrix and are not released by it.
+   */
+  static Matrix2 wrap( pointer data, size_t rows, size_t cols, size_t innerRows, size_t innerCols )
+  {
+    return Matrix2( rows, cols, innerRows, innerCols, storage_type::wrap( data, rows * cols ) );
+  }
+  
+  Matrix2& operator =( Matrix2 const& ) = default;
+  Matrix2& operator =( Matrix2&& ) = default;
+  
+  /**
+   * Evaluates a matrix expression into a new matrix. The blocking is taken from the operands.
+   */
+  template< typename E, typename = typename std::enable_if< isMatrixExpressionNode< E >::value >::type >
+  Matrix2( E const& e ):
+    Matrix2( detail::evaluate( e ) )
+  { }
+  
+  template< typename E, typename = typename std::enable_if< isMatrixExpressionNode< E >::value >::type >
+  Matrix2& operator =( E const& e )
+  {
+    return *this = Matrix2( e );
+  }
+  
   const_reference at( size_t row, size_t col ) const
   {
-    return this->_vector.at( computeIndex( row, col ) );
+    return this->_storage.at( computeIndex( row, col ) );
   }
   
   size_t innerRows() const { return innerRows_; }
   size_t innerCols() const { return innerCols_; }
   
-  Matrix2( __MatrixBase< T >&& base ): __MatrixBase< T >( std::move( base ) )
+  Matrix2( __MatrixBase< T, Alloc >&& base ): __MatrixBase< T, Alloc >( std::move( base ) )
   { }
   
 private :
   size_t innerRows_, innerCols_;
   
+  Matrix2( size_t rows, size_t cols, size_t innerRows, size_t innerCols, storage_type&& storage ):
+    __MatrixBase< T, Alloc >( rows, cols, std::move( storage ) ), innerRows_( innerRows ), innerCols_( innerCols )
+  { }
+  
   size_t computeIndex( size_t row, size_t col ) const
   {
     // Indices of the inner blocks.
@@ -467,17 +441,19 @@ this->cols() - (innerBlockCol * innerCols_) : innerCols_
 
 
 
-template< typename T >
-class Matrix2< T, row_major_tag, row_major_tag > : public __MatrixBase< T >
+template< typename T, typename Alloc >
+class Matrix2< T, row_major_tag, row_major_tag, Alloc > : public __MatrixBase< T, Alloc >, public MatrixExpressionBase
 {
 public :
-  typedef typename __MatrixBase< T >::pointer pointer;
-  typedef typename __MatrixBase< T >::const_pointer const_pointer;
-  typedef typename __MatrixBase< T >::reference reference;
-  typedef typename __MatrixBase< T >::const_reference const_reference;
-  typedef typename __MatrixBase< T >::value_type value_type;
-  typedef typename __MatrixBase< T >::iterator iterator;
-  typedef typename __MatrixBase< T >::const_iterator const_iterator;
+  typedef typename __MatrixBase< T, Alloc >::pointer pointer;
+  typedef typename __MatrixBase< T, Alloc >::const_pointer const_pointer;
+  typedef typename __MatrixBase< T, Alloc >::reference reference;
+  typedef typename __MatrixBase< T, Alloc >::const_reference const_reference;
+  typedef typename __MatrixBase< T, Alloc >::value_type value_type;
+  typedef typename __MatrixBase< T, Alloc >::iterator iterator;
+  typedef typename __MatrixBase< T, Alloc >::const_iterator const_iterator;
+  typedef typename __MatrixBase< T, Alloc >::storage_type storage_type;
+  typedef Matrix2 terminal_type;
   
   reference at( size_t row, size_t col )
   {
@@ -487,14 +463,14 @@ public :
   }
   
   Matrix2( size_t rows, size_t cols, size_t innerRows, size_t innerCols, const_reference value ):
-    __MatrixBase< T >( rows, cols, value ), innerRows_( innerRows ), innerCols_( innerCols )
+    __MatrixBase< T, Alloc >( rows, cols, value ), innerRows_( innerRows ), innerCols_( innerCols )
   {
     TRUE_ASSERT( innerCols <= cols, "Inner blocks larger than matrix" );
     TRUE_ASSERT( innerRows <= rows, "Inner blocks larger than matrix" );
   }
   
   Matrix2( size_t rows, size_t cols, size_t innerRows, size_t innerCols ):
-    __MatrixBase< T >( rows, cols ), innerRows_( innerRows ), innerCols_( innerCols )
+    __MatrixBase< T, Alloc >( rows, cols ), innerRows_( innerRows ), innerCols_( innerCols )
   {
     TRUE_ASSERT( innerCols <= cols, "Inner blocks larger than matrix" );
     TRUE_ASSERT( innerRows <= rows, "Inner blocks larger than matrix" );
@@ -504,20 +480,51 @@ public :
   Matrix2( Matrix2&& ) = default;
   Matrix2() = default;
   
+  /**
+   * Refers to external elements, e.g. a mapped buffer, which are already stored in this blocked layout. Nothing is copied.
+   *
+   * @param data Elements of the matrix. They must outlive the matrix and are not released by it.
+   */
+  static Matrix2 wrap( pointer data, size_t rows, size_t cols, size_t innerRows, size_t innerCols )
+  {
+    return Matrix2( rows, cols, innerRows, innerCols, storage_type::wrap( data, rows * cols ) );
+  }
+  
+  Matrix2& operator =( Matrix2 const& ) = default;
+  Matrix2& operator =( Matrix2&& ) = default;
+  
+  /**
+   * Evaluates a matrix expression into a new matrix. The blocking is taken from the operands.
+   */
+  template< typename E, typename = typename std::enable_if< isMatrixExpressionNode< E >::value >::type >
+  Matrix2( E const& e ):
+    Matrix2( detail::evaluate( e ) )
+  { }
+  
+  template< typename E, typename = typename std::enable_if< isMatrixExpressionNode< E >::value >::type >
+  Matrix2& operator =( E const& e )
+  {
+    return *this = Matrix2( e );
+  }
+  
   const_reference at( size_t row, size_t col ) const
   {
-    return this->_vector.at( computeIndex( row, col ) );
+    return this->_storage.at( computeIndex( row, col ) );
   }
   
   size_t innerRows() const { return innerRows_; }
   size_t innerCols() const { return innerCols_; }
   
-  Matrix2( __MatrixBase< T >&& base ): __MatrixBase< T >( std::move( base ) )
+  Matrix2( __MatrixBase< T, Alloc >&& base ): __MatrixBase< T, Alloc >( std::move( base ) )
   { }
   
 private :
   size_t innerRows_, innerCols_;
   
+  Matrix2( size_t rows, size_t cols, size_t innerRows, size_t innerCols, storage_type&& storage ):
+    __MatrixBase< T, Alloc >( rows, cols, std::move( storage ) ), innerRows_( innerRows ), innerCols_( innerCols )
+  { }
+  
   size_t computeIndex( size_t row, size_t col ) const
   {
     // Indices of the inner blocks.
@@ -554,6 +561,152 @@ private :
   }
 };
 
+namespace detail {
+
+/**
+ * Calls f for each inner block of a blocked matrix. The blocks are distributed among the OpenMP threads.
+ * 
+ * @param f Called with the row and column of the first element of the block, its number of rows and columns,
+ *          its offset into the elements of the matrix and the distance between two of its rows and columns.
+ */
+template< typename T, typename OuterLayout, typename InnerLayout, typename Alloc, typename F >
+void forEachBlock( Matrix2< T, OuterLayout, InnerLayout, Alloc > const& m, F const& f )
+{
+  constexpr bool outerColumnMajor = std::is_same< OuterLayout, column_major_tag >::value;
+  constexpr bool innerColumnMajor = std::is_same< InnerLayout, column_major_tag >::value;
+  
+  size_t const blockRows = (m.rows() + m.innerRows() - 1u) / m.innerRows();
+  size_t const blockCols = (m.cols() + m.innerCols() - 1u) / m.innerCols();
+  std::ptrdiff_t const blocks = std::ptrdiff_t( blockRows * blockCols );
+  
+#pragma omp parallel for schedule( static ) if( blocks > 1 && m.size() > (1u << 15) )
+  for ( std::ptrdiff_t b = 0; b < blocks; ++b )
+  {
+    // Visit the blocks in the order they are stored.
+    size_t const blockRow = outerColumnMajor ? size_t( b ) % blockRows : size_t( b ) / blockCols;
+    size_t const blockCol = outerColumnMajor ? size_t( b ) / blockRows : size_t( b ) % blockCols;
+    
+    size_t const row = blockRow * m.innerRows();
+    size_t const col = blockCol * m.innerCols();
+    
+    // Blocks at the borders may be smaller.
+    size_t const rowsOfBlock = std::min( m.innerRows(), m.rows() - row );
+    size_t const colsOfBlock = std::min( m.innerCols(), m.cols() - col );
+    
+    size_t const offset = outerColumnMajor ? col * m.rows() + row * colsOfBlock : row * m.cols() + col * rowsOfBlock;
+    
+    f( row, col, rowsOfBlock, colsOfBlock, offset,
+       std::ptrdiff_t( innerColumnMajor ? 1u : colsOfBlock ), std::ptrdiff_t( innerColumnMajor ? rowsOfBlock : 1u ) );
+  }
+}
+
+}
+
+/**
+ * Copies a matrix given by its elements and the distance between two of its rows and columns into a blocked matrix.
+ * Each block is copied, and if necessary transposed, by a cache-oblivious SIMD routine.
+ * 
+ * @param src Elements of a matrix with the same number of rows and columns as @c dst.
+ * @param rowStride Distance between two rows of @c src, e.g. 1 for a column-major matrix.
+ * @param colStride Distance between two columns of @c src, e.g. the number of rows for a column-major matrix.
+ * @param dst Blocked matrix.
+ */
+template< typename T, typename OuterLayout, typename InnerLayout, typename Alloc >
+void fromStrided( T const* src, std::ptrdiff_t rowStride, std::ptrdiff_t colStride, Matrix2< T, OuterLayout, InnerLayout, Alloc >& dst )
+{
+  if ( dst.innerRows() >= dst.rows() && dst.innerCols() >= dst.cols() )
+  {
+    copyStrided( dst.rows(), dst.cols(), src, rowStride, colStride, dst.data(),
+                 std::is_same< InnerLayout, column_major_tag >::value ? 1 : std::ptrdiff_t( dst.cols() ),
+                 std::is_same< InnerLayout, column_major_tag >::value ? std::ptrdiff_t( dst.rows() ) : 1 );
+    return;
+  }
+  
+  T* const data = dst.data();
+  detail::forEachBlock( dst, [=]( size_t row, size_t col, size_t rows, size_t cols, size_t offset, std::ptrdiff_t rs, std::ptrdiff_t cs ) {
+    detail::copyRecursive( rows, cols, src + std::ptrdiff_t( row ) * rowStride + std::ptrdiff_t( col ) * colStride, rowStride, colStride, data + offset, rs, cs );
+  } );
+}
+
+/**
+ * Copies a blocked matrix into a matrix given by its elements and the distance between two of its rows and columns.
+ * 
+ * @see fromStrided()
+ */
+template< typename T, typename OuterLayout, typename InnerLayout, typename Alloc >
+void toStrided( Matrix2< T, OuterLayout, InnerLayout, Alloc > const& src, T* dst, std::ptrdiff_t rowStride, std::ptrdiff_t colStride )
+{
+  if ( src.innerRows() >= src.rows() && src.innerCols() >= src.cols() )
+  {
+    copyStrided( src.rows(), src.cols(), src.data(),
+                 std::is_same< InnerLayout, column_major_tag >::value ? 1 : std::ptrdiff_t( src.cols() ),
+                 std::is_same< InnerLayout, column_major_tag >::value ? std::ptrdiff_t( src.rows() ) : 1,
+                 dst, rowStride, colStride );
+    return;
+  }
+  
+  T const* const data = src.data();
+  detail::forEachBlock( src, [=]( size_t row, size_t col, size_t rows, size_t cols, size_t offset, std::ptrdiff_t rs, std::ptrdiff_t cs ) {
+    detail::copyRecursive( rows, cols, data + offset, rs, cs, dst + std::ptrdiff_t( row ) * rowStride + std::ptrdiff_t( col ) * colStride, rowStride, colStride );
+  } );
+}
+
+/**
+ * Converts a column- or row-major matrix into the block layout of @c dst.
+ * 
+ * @pre @c src and @c dst have the same number of rows and columns.
+ */
+template< typename T, typename OuterLayout, typename InnerLayout, typename Alloc, typename Format, typename MatrixAlloc >
+void convert( Matrix< T, Format, MatrixAlloc > const& src, Matrix2< T, OuterLayout, InnerLayout, Alloc >& dst )
+{
+  typedef MatrixTraits< Matrix< T, Format, MatrixAlloc > > Traits;
+  
+  TRUE_ASSERT( src.rows() == dst.rows() && src.cols() == dst.cols(), "Matrices differ in size" );
+  
+  fromStrided( src.data(), Traits::rowStride( src ), Traits::colStride( src ), dst );
+}
+
+/**
+ * Converts a blocked matrix into the column- or row-major matrix @c dst, which is resized if necessary.
+ */
+template< typename T, typename OuterLayout, typename InnerLayout, typename Alloc, typename Format, typename MatrixAlloc >
+void convert( Matrix2< T, OuterLayout, InnerLayout, Alloc > const& src, Matrix< T, Format, MatrixAlloc >& dst )
+{
+  typedef MatrixTraits< Matrix< T, Format, MatrixAlloc > > Traits;
+  
+  dst.resize( src.rows(), src.cols() );
+  
+  toStrided( src, dst.data(), Traits::rowStride( dst ), Traits::colStride( dst ) );
+}
+
+/**
+ * Matrix2 takes part in the expression templates of utl_matrix_expression.h. Products are
+ * computed by converting the blocked operands into column-major order.
+ */
+template< typename T, typename OuterLayout, typename InnerLayout, typename Alloc >
+struct MatrixTraits< Matrix2< T, OuterLayout, InnerLayout, Alloc > >
+{
+  typedef Matrix2< T, OuterLayout, InnerLayout, Alloc > matrix_type;
+  
+  static constexpr bool strided = false;
+  
+  template< typename R, typename C >
+  static matrix_type create( R const& rowPrototype, C const& colPrototype )
+  {
+    return matrix_type( rowPrototype.rows(), colPrototype.cols(), rowPrototype.innerRows(), colPrototype.innerCols() );
+  }
+  
+  static void toColumnMajor( matrix_type const& m, T* dst )
+  {
+    toStrided( m, dst, 1, std::ptrdiff_t( m.rows() ) );
+  }
+  
+  static void fromColumnMajor( T const* src, matrix_type& m )
+  {
+    fromStrided( src, 1, std::ptrdiff_t( m.rows() ), m );
+  }
+};
+
 }
 
 #endif
\ No newline at end of file
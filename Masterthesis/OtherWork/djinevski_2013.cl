@@ -1,38 +1,42 @@
-__kernel void gemm( size_t const N, size_t const L2CacheSize,
+__kernel void gemm( uint const N, uint const rowsPerBlock, uint const colsPerBlock, uint const depth,
   __global float const* A, __global float const* B,
   __global float* C )
 {
-  size_t const bx = get_global_id( 0 );
-  size_t const m  = L2CacheSize / (N * sizeof (float));
-  
-  int jj = 0;
-  
-  while ( jj < (N + m - 1) / m )
+  /* Matrices are stored in column major layout.
+   *
+   * Each work-item computes blocks of rowsPerBlock x colsPerBlock elements of C.
+   * The product of a block is accumulated over blocks of depth columns of A
+   * and depth rows of B, which are sized by the host such that the blocks
+   * of A, B and C stay in the global memory cache of a compute unit. */
+
+  uint const rowBlocks = (N + rowsPerBlock - 1) / rowsPerBlock;
+  uint const numBlocks = rowBlocks * ((N + colsPerBlock - 1) / colsPerBlock);
+
+  // Consecutive work-items compute blocks in the same columns of C, so they share the block of B.
+  for ( uint block = get_global_id( 0 ); block < numBlocks; block += get_global_size( 0 ) )
   {
-    int i = 0;
-    
-    int l = (bx + i * get_local_size( 0 )) * m;
-  
-    while ( l < N )
+    uint const i0 = (block % rowBlocks) * rowsPerBlock;
+    uint const j0 = (block / rowBlocks) * colsPerBlock;
+    uint const i1 = min( i0 + rowsPerBlock, N );
+    uint const j1 = min( j0 + colsPerBlock, N );
+
+    for ( uint k0 = 0; k0 < N; k0 += depth )
     {
-      for ( int k1 = 0; k1 < min( m, N - jj * m ); ++k1 )
+      uint const k1 = min( k0 + depth, N );
+
+      for ( uint j = j0; j < j1; ++j )
       {
-        for ( int k2 = 0; k2 < min( m, N - jj * m ); ++k2 )
+        for ( uint i = i0; i < i1; ++i )
         {
-          float c = 0.0f;
-          
-          for ( int n = 0; n < N; ++n )
-            c += A[l + k1 + N * n] * B[k2 * N + jj * m * N + n];
-          
-          C[l + k1 + k2 * N + jj * m * N] = c;
+          // C is read and written once per block of depth, not once per product.
+          float c = k0 == 0 ? 0.0f : C[i + j * N];
+
+          for ( uint k = k0; k < k1; ++k )
+            c += A[i + k * N] * B[k + j * N];
+
+          C[i + j * N] = c;
         }
       }
-    
-      ++i;
-      
-      l = (bx + i * get_local_size( 0 )) * m;
     }
-    
-    ++jj;
   }
 }
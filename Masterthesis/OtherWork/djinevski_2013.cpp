@@ -8,8 +8,16 @@
  * @date April 2014
  */
 
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <sstream>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 #include <ocl_buffer.h>
 #include <ocl_context.h>
@@ -29,38 +37,99 @@ typedef float Type;
 
 
 
+/**
+ * Blocks of the kernel in elements.
+ */
+struct Djinevski2013Blocking
+{
+  std::size_t rows;  // Rows of a block of C and A.
+  std::size_t cols;  // Columns of a block of C and B.
+  std::size_t depth; // Columns of a block of A and rows of a block of B.
+};
+
+
+
 class Djinevski2013Pass : public utl::ProfilePass< Type >
 {
 public :
-  Djinevski2013Pass( std::istream& source, utl::Dim const& start, utl::Dim const& step, utl::Dim const& end, std::size_t iter = 10 );
+  Djinevski2013Pass( std::string const& source, bool tileDepth, std::size_t iter = 10 );
     
   double prof( utl::Dim const& ) override;
   
   double ops( utl::Dim const& dim ) override;
   
+  Djinevski2013Blocking blocking( std::size_t N ) const;
+  
 private :
   typedef utl::Matrix< Type, utl::column_major_tag > Matrix;
-  typedef utl::Zeros< Type, utl::column_major_tag > Zeros;
+  typedef utl::Rand< Type, utl::column_major_tag, utl::uniform_dist_tag > Rand;
   
   bool          testing_;
+  bool          tileDepth_;
+  bool          skipped_;
   ocl::Platform platform_;
   ocl::Device   device_;
   ocl::Context  context_;
   ocl::Queue    queue_;
   ocl::Program  program_;
+  std::size_t   cacheSize_;
+  std::size_t   cachelineSize_;
+  cl_device_mem_cache_type cacheType_;
 };
 
 
 
-Djinevski2013Pass::Djinevski2013Pass( std::istream& source, utl::Dim const& start, utl::Dim const& step, utl::Dim const& end, std::size_t iter ):
-  ProfilePass< Type >( "Djinevski2013", start, step, end, iter ),
-  testing_( true ),
+/*
+ * The sizes are swept around the size whose three matrices just fill the cache,
+ * which is not known before the device has been queried.
+ */
+Djinevski2013Pass::Djinevski2013Pass( std::string const& source, bool tileDepth, std::size_t iter ):
+  ProfilePass< Type >( tileDepth ? "Djinevski2013_TiledDepth" : "Djinevski2013", utl::Dim( 1 ), utl::Dim( 1 ), utl::Dim( 1 ), iter ),
+  testing_( false ),
+  tileDepth_( tileDepth ),
+  skipped_( false ),
   platform_( ocl::device_type::CPU ),
   device_( platform_.device( ocl::device_type::CPU ) ),
   context_( device_ ),
   queue_( (platform_.insert( context_ ), platform_.setActiveContext( context_ ), context_), device_, CL_QUEUE_PROFILING_ENABLE ),
-  program_( (context_.setActiveQueue( queue_ ), context_), utl::type::Single )
+  program_( (context_.setActiveQueue( queue_ ), context_), utl::type::Single ),
+  cacheSize_( device_.globalMemCacheSize() ),
+  cachelineSize_( device_.globalMemCachelineSize() ),
+  cacheType_( device_.globalMemCacheType() )
 {
+  // The kernel keeps its blocks in the global memory cache and stages nothing in local memory,
+  // so without a cache the depth-tiled blocking has nothing to fit and the pass is skipped.
+  // The sizes are then swept around the local memory, where the untiled pass shows no transition.
+  if ( cacheType_ == CL_NONE || cacheSize_ == 0 )
+  {
+    skipped_ = tileDepth_;
+    cacheSize_ = device_.localMemSize();
+  }
+  
+  cachelineSize_ = std::max( cachelineSize_, sizeof (Type) );
+  
+  this->setDevice( device_ );
+  this->setMetadata( "cache_size", std::to_string( cacheSize_ ) );
+  this->setMetadata( "cacheline_size", std::to_string( cachelineSize_ ) );
+  this->setMetadata( "cache_type", cacheType_ == CL_READ_WRITE_CACHE ? "read_write" : cacheType_ == CL_READ_ONLY_CACHE ? "read_only" : "none" );
+  
+  if ( skipped_ )
+  {
+    this->setMetadata( "skipped", "no global memory cache to block for" );
+  }
+  
+  std::vector< utl::Dim > sizes;
+  
+  // The three matrices fill from 1/16 up to 16 times the cache.
+  double const transition = std::sqrt( cacheSize_ / (3.0 * sizeof (Type)) );
+  
+  for ( int e = -4; e <= 4; ++e )
+  {
+    sizes.push_back( utl::Dim( std::max< std::size_t >( 16, std::size_t( transition * std::pow( 2.0, 0.5 * e ) ) ) ) );
+  }
+  
+  this->setSweep( sizes );
+  
   program_ << source;
   
   std::ostringstream oss;
@@ -90,20 +159,52 @@ Djinevski2013Pass::Djinevski2013Pass( std::istream& source, utl::Dim const& star
 
 
 
+/*
+ * Without tiling of the depth, the blocks of C span m = cache size / (N * sizeof (Type)) 
+ * rows and columns as in the paper, so that m full columns of B fill the cache.
+ * 
+ * With tiling, the blocks of A and B, and unless the cache is read-only the block of C,
+ * fill half of the cache, the other half is left for conflicting lines.
+ * The rows of a block of A and C and the depth of a block of B are
+ * multiples of a cacheline, so that no line is shared by two blocks.
+ */
+Djinevski2013Blocking Djinevski2013Pass::blocking( std::size_t N ) const
+{
+  if ( !tileDepth_ )
+  {
+    std::size_t const m = std::min( N, std::max< std::size_t >( 1, cacheSize_ / (N * sizeof (Type)) ) );
+    
+    return Djinevski2013Blocking{ m, m, N };
+  }
+  
+  std::size_t const lineElements = cachelineSize_ / sizeof (Type);
+  std::size_t const numBlocks = cacheType_ == CL_READ_ONLY_CACHE ? 2 : 3;
+  
+  std::size_t block = std::size_t( std::sqrt( cacheSize_ / (2.0 * numBlocks * sizeof (Type)) ) );
+  block = std::max( lineElements, block / lineElements * lineElements );
+  
+  // Blocks larger than the matrices do not save any loads.
+  std::size_t const padded = (N + lineElements - 1) / lineElements * lineElements;
+  block = std::min( block, padded );
+  
+  return Djinevski2013Blocking{ block, block, block };
+}
+
+
+
 double Djinevski2013Pass::prof( utl::Dim const& dim )
 {
-  std::size_t const N = dim[0];
+  if ( skipped_ )
+    return 0.0;
   
-  Zeros result( N, N );
+  std::size_t const N = dim[0];
   
-  Matrix lhs( N, N );
-  Matrix rhs( N, N );
+  Matrix result( N, N );
   
-  // for ( size_t i = 0; i < N * L; ++i ) lhs[i] = i + 1; for ( size_t i = 0; i < L * M; ++i ) rhs[i] = i + 1;
-  for ( size_t i = 0; i < N * N; ++i ) lhs[i] = i % N;
-  for ( size_t i = 0; i < N * N; ++i ) rhs[i] = i / N;
+  Rand const lhs( N, N, Type( -1 ), Type( 1 ), 1 );
+  Rand const rhs( N, N, Type( -1 ), Type( 1 ), 2 );
   
-  std::chrono::nanoseconds totalRuntime{ 0 };
+  double median = 0.0;
   
   ocl::Kernel& kernel( program_.kernel( "gemm" ) );
   
@@ -115,16 +216,22 @@ double Djinevski2013Pass::prof( utl::Dim const& dim )
    */
   kernel.setWorkSize( 1, numProcessingElements );
   
+  Djinevski2013Blocking const b = blocking( N );
+  
+  std::cout << this->name() << " " << N << ": blocks of " << b.rows << "x" << b.cols << "x" << b.depth
+            << ", matrices fill " << 3.0 * N * N * sizeof (Type) / cacheSize_ << " caches" << std::endl;
+  
   size_t constexpr typeSize = sizeof (Type);
   size_t const numResultBytes = typeSize * result.size();
   size_t const numLhsBytes = typeSize * lhs.size();
   size_t const numRhsBytes = typeSize * rhs.size();
   
-  ocl::Buffer bufResult( context_, numResultBytes, ocl::Buffer::WriteOnly ),
+  // C is read back by the kernel for all but the first block of depth.
+  ocl::Buffer bufResult( context_, numResultBytes ),
               bufLhs( context_, numLhsBytes, ocl::Buffer::ReadOnly ),
               bufRhs( context_, numRhsBytes, ocl::Buffer::ReadOnly );
 
-  for ( std::size_t i = 0; i < this->_iter; ++i )
+  median = this->measure( [&]() -> double
   {
     // Copy data from host to device.
     ocl::Event const lhsWritten = bufLhs.writeAsync( queue_, 0u, lhs.data(), numLhsBytes );
@@ -134,8 +241,9 @@ double Djinevski2013Pass::prof( utl::Dim const& dim )
     operandsWritten << lhsWritten << rhsWritten;
     
     // Execute kernel when both operands have been loaded.
-    size_t const L2CacheSize = 1024 * 768;
-    ocl::Event const multiplyDone = kernel( queue_, operandsWritten, N, L2CacheSize, bufLhs.id(), bufRhs.id(), bufResult.id() );
+    ocl::Event const multiplyDone = kernel( queue_, operandsWritten,
+      static_cast< unsigned int >( N ), static_cast< unsigned int >( b.rows ), static_cast< unsigned int >( b.cols ), static_cast< unsigned int >( b.depth ),
+      bufLhs.id(), bufRhs.id(), bufResult.id() );
     
     // Copy result from device to host.
     ocl::Event const resultRead = bufResult.readAsync( queue_, 0u, result.data(), numResultBytes, ocl::EventList( multiplyDone ) );
@@ -145,30 +253,41 @@ double Djinevski2013Pass::prof( utl::Dim const& dim )
     
     size_t const kernelRuntime_ns = multiplyDone.finishTime() - multiplyDone.startTime();
 
-    totalRuntime += std::chrono::nanoseconds( kernelRuntime_ns );
-  }
+    return kernelRuntime_ns * 1e-9;
+  } );
   
-   if( testing_ )
+  if( testing_ )
   {
-    auto const ref = lhs * rhs;
-    auto const diff = result - ref;
-    auto const iMax = std::max_element( diff.begin(), diff.end(), []( Type a, Type b ){
-      return std::fabs( a ) < std::fabs( b );
-    } );
+    Matrix const ref = lhs * rhs;
     
     std::cout /*<< lhs << '*' << rhs << " = " */ << "ref = " << ref << std::endl;
     std::cout << "result = " << result << std::endl;
-    std::cout << "Maximal error: " << *iMax << std::endl;
-    
-    if ( *iMax != 0 )
+  }
+  
+  // The full product is too expensive on the host for the larger sizes, so a diagonal band of C is checked.
+  double maxError = 0.0;
+  
+  for ( size_t j = 0; j < N; ++j )
+  {
+    for ( size_t i = j % 7; i < N; i += 97 )
     {
-      size_t const index = iMax - diff.begin();
-      std::cout << "ref[" << index << "] = " << ref[index] << " != result[" << index << "] = " << result[index] << std::endl;
+      double ref = 0.0;
+      for ( size_t k = 0; k < N; ++k ) ref += double( lhs.at( i, k ) ) * rhs.at( k, j );
+      
+      maxError = std::max( maxError, std::fabs( ref - result.at( i, j ) ) );
     }
   }
   
-  // Return average time.
-  return std::chrono::duration_cast< std::chrono::microseconds >( totalRuntime / this->_iter ).count();
+  std::cout << "Maximal error: " << maxError << std::endl;
+  
+  // The elements are in [-1,1], so each element of C is a sum of N products with a rounding error below N * N * eps.
+  if ( maxError > 2.0 * N * N * std::numeric_limits< Type >::epsilon() )
+  {
+    throw std::runtime_error( this->name() + ": result exceeds the error bound" );
+  }
+  
+  // Return median time in seconds.
+  return median;
 }
 
 
@@ -185,19 +304,26 @@ int main( int argc, char** argv )
 {
   utl::Args args( argc, argv );
   
-  if ( args.size() == 2 )
+  if ( args.size() >= 2 && args.size() <= 4 )
   {
     std::string const filename( args.toString( 1 ) );
     std::ifstream file( filename );
     
     if ( file.is_open() )
     {
+      std::string const source( ( std::istreambuf_iterator< char >( file ) ), std::istreambuf_iterator< char >() );
+      
       utl::ProfilePassManager< Type > mgr;
-  
-      mgr << std::make_shared<Djinevski2013Pass>( file, utl::Dim( 256 ), utl::Dim( 16 ), utl::Dim( 256 ) );
+      
+      // Blocking of the paper, which streams over full columns, and blocking which tiles the depth as well.
+      mgr << std::make_shared<Djinevski2013Pass>( source, false );
+      mgr << std::make_shared<Djinevski2013Pass>( source, true );
   
       mgr.run();
       mgr.write( std::cout );
+      
+      if ( args.size() > 2 ) mgr.write( args.toString( 2 ) );
+      if ( args.size() > 3 && mgr.compare( args.toString( 3 ), std::cout ) > 0 ) return EXIT_FAILURE;
     }
     else
     {
@@ -206,7 +332,7 @@ int main( int argc, char** argv )
   }
   else
   {
-    std::cout << "Usage: " << args.at( 0 ) << " <kernel.cl>" << std::endl;
+    std::cout << "Usage: " << args.at( 0 ) << " <kernel.cl> [<results.json|results.csv> [<baseline.csv>]]" << std::endl;
   }
   
   return EXIT_SUCCESS;
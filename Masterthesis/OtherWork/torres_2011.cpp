@@ -61,6 +61,8 @@ Torres2011Pass::Torres2011Pass( std::istream& source, utl::Dim const& start, utl
   queue_( (platform_.insert( context_ ), platform_.setActiveContext( context_ ), context_), device_, CL_QUEUE_PROFILING_ENABLE ),
   program_( (context_.setActiveQueue( queue_ ), context_), utl::type::Single )
 {
+  this->setDevice( device_ );
+  
   program_ << source;
   
   std::ostringstream oss;
@@ -105,7 +107,7 @@ double Torres2011Pass::prof( utl::Dim const& dim )
   for ( size_t i = 0; i < N * L; ++i ) lhs[i] = i % L;
   for ( size_t i = 0; i < L * M; ++i ) rhs[i] = i / L;
   
-  std::chrono::nanoseconds totalRuntime{ 0 };
+  double median = 0.0;
   
   ocl::Kernel& kernel( program_.kernel( "gemm" ) );
       
@@ -120,7 +122,7 @@ double Torres2011Pass::prof( utl::Dim const& dim )
               bufLhs( context_, numLhsBytes, ocl::Buffer::ReadOnly ),
               bufRhs( context_, numRhsBytes, ocl::Buffer::ReadOnly );
 
-  for ( std::size_t i = 0; i < this->_iter; ++i )
+  median = this->measure( [&]() -> double
   {
     // Copy data from host to device.
     ocl::Event const lhsWritten = bufLhs.writeAsync( queue_, 0u, lhs.data(), numLhsBytes );
@@ -140,12 +142,12 @@ double Torres2011Pass::prof( utl::Dim const& dim )
     
     size_t const kernelRuntime_ns = multiplyDone.finishTime() - multiplyDone.startTime();
 
-    totalRuntime += std::chrono::nanoseconds( kernelRuntime_ns );
-  }
+    return kernelRuntime_ns * 1e-9;
+  } );
   
    if( testing_ )
   {
-    auto const ref = lhs * rhs;
+    Matrix const ref = lhs * rhs;
     auto const diff = result - ref;
     auto const iMax = std::max_element( diff.begin(), diff.end(), []( Type a, Type b ){
       return std::fabs( a ) < std::fabs( b );
@@ -162,8 +164,8 @@ double Torres2011Pass::prof( utl::Dim const& dim )
     }
   }
   
-  // Return average time.
-  return std::chrono::duration_cast< std::chrono::microseconds >( totalRuntime / this->_iter ).count();
+  // Return median time in seconds.
+  return median;
 }
 
 
@@ -180,7 +182,7 @@ int main( int argc, char** argv )
 {
   utl::Args args( argc, argv );
   
-  if ( args.size() == 2 )
+  if ( args.size() >= 2 && args.size() <= 4 )
   {
     std::string const filename( args.toString( 1 ) );
     std::ifstream file( filename );
@@ -193,6 +195,9 @@ int main( int argc, char** argv )
   
       mgr.run();
       mgr.write( std::cout );
+      
+      if ( args.size() > 2 ) mgr.write( args.toString( 2 ) );
+      if ( args.size() > 3 && mgr.compare( args.toString( 3 ), std::cout ) > 0 ) return EXIT_FAILURE;
     }
     else
     {
@@ -201,7 +206,7 @@ int main( int argc, char** argv )
   }
   else
   {
-    std::cout << "Usage: " << args.at( 0 ) << " <kernel.cl>" << std::endl;
+    std::cout << "Usage: " << args.at( 0 ) << " <kernel.cl> [<results.json|results.csv> [<baseline.csv>]]" << std::endl;
   }
   
   return EXIT_SUCCESS;
@@ -1,84 +1,119 @@
 template<class T>
-__kernel void gemm( size_t const N, size_t const L,
-  __global T const* A, __global T const* B, __global T* C )
+__kernel void gemm( uint const N, uint const M, uint const L, T const alpha,
+  __global T const* A, uint const rowStrideA, uint const colStrideA,
+  __global T const* B, uint const rowStrideB, uint const colStrideB,
+  T const beta, __global T* C, uint const rowStrideC, uint const colStrideC )
 {
+  /* C = alpha * A * B + beta * C with A of size N x L, B of size L x M and C of size N x M.
+   * Element (i,j) of a matrix X is X[i * rowStrideX + j * colStrideX], so
+   * column-major operands have a row stride of 1 and row-major operands
+   * a column stride of 1. */
+
+  /* Specialization parameters, which are set with -D on the command line:
+   * BLOCKSIZE     is the number of columns of C computed by a work-item and the depth of a block in B,
+   * ROWS_PER_ITEM is the number of rows of C computed by a work-item and
+   * UNROLL        is the number of steps of the inner loop which are unrolled.
+   * Every type specialises this template in the same source, so the macros stay defined
+   * for the following specialisations, which thereby see the same values. */
+#ifndef BLOCKSIZE
 #define BLOCKSIZE 16
-  
-  // This is part of a row of C.
-  private T c[BLOCKSIZE] = { 0.0f }; 
-  
-  // This is a block in B.
-  local   T b[BLOCKSIZE][BLOCKSIZE]; 
-  
-  /* Matrices are stored in column major layout. */
-  
-  A += get_global_id( 1 );
-  B += L * BLOCKSIZE * get_group_id( 0 );
-  C += N * BLOCKSIZE * get_group_id( 0 ) + get_global_id( 1 );
-  
-  global T const* end = B + L;
-  
-  do
+#endif
+#ifndef ROWS_PER_ITEM
+#define ROWS_PER_ITEM 1
+#endif
+#ifndef UNROLL
+#define UNROLL BLOCKSIZE
+#endif
+
+  // These are parts of rows of C.
+  private T c[ROWS_PER_ITEM][BLOCKSIZE];
+
+  // This is a block in B, the padding avoids bank conflicts when it is stored.
+  local   T b[BLOCKSIZE][BLOCKSIZE + 1];
+
+  uint const lid  = get_local_id( 1 );
+  uint const size = get_local_size( 1 );
+  uint const col  = BLOCKSIZE * get_group_id( 0 );
+
+  // Consecutive work-items compute consecutive rows, so loads of column-major A are coalesced.
+  uint row[ROWS_PER_ITEM];
+  __global T const* a[ROWS_PER_ITEM];
+
+  #pragma unroll
+  for ( uint r = 0; r < ROWS_PER_ITEM; ++r )
   {
+    row[r] = ROWS_PER_ITEM * size * get_group_id( 1 ) + r * size + lid;
+
+    // Rows beyond N read the last row of A and are not stored, so the inner loop is not predicated.
+    a[r] = A + min( row[r], N - 1 ) * rowStrideA;
+
+    #pragma unroll
+    for ( uint j = 0; j < BLOCKSIZE; ++j ) c[r][j] = 0;
+  }
+
+  for ( uint k = 0; k < L; k += BLOCKSIZE )
+  {
+    // Elements of B beyond L or M are zero, so they do not contribute to C.
+    for ( uint e = lid; e < BLOCKSIZE * BLOCKSIZE; e += size )
     {
-      int       x = get_local_id( 1 ) / BLOCKSIZE;
-      int const y = get_local_id( 1 ) % BLOCKSIZE;
-      
-      b[y][x] = B[x * L + y]; x += 4;
-      b[y][x] = B[x * L + y]; x += 4;
-      b[y][x] = B[x * L + y]; x += 4;
-      b[y][x] = B[x * L + y];
+      uint const x = e / BLOCKSIZE;
+      uint const y = e % BLOCKSIZE;
+
+      b[y][x] = k + y < L && col + x < M ? B[(k + y) * rowStrideB + (col + x) * colStrideB] : 0;
     }
-    
+
     barrier( CLK_LOCAL_MEM_FENCE );
-    
-    #pragma unroll 16
-    for ( int i = 0; i < BLOCKSIZE; ++i )
+
+    uint const depth = min( (uint) BLOCKSIZE, L - k );
+    uint i = 0;
+
+    for ( ; i + UNROLL <= depth; i += UNROLL )
+    {
+      #pragma unroll
+      for ( uint u = 0; u < UNROLL; ++u )
+      {
+        #pragma unroll
+        for ( uint r = 0; r < ROWS_PER_ITEM; ++r )
+        {
+          private T const s = a[r][(k + i + u) * colStrideA];
+
+          #pragma unroll
+          for ( uint j = 0; j < BLOCKSIZE; ++j ) c[r][j] += s * b[i + u][j];
+        }
+      }
+    }
+
+    // Remaining steps of the last block of L or of a BLOCKSIZE which is no multiple of UNROLL.
+    for ( ; i < depth; ++i )
     {
-      private T const a = *A;
-      
-      A += N;
-      
-      c[0]  += a * b[i][0];
-      c[1]  += a * b[i][1];
-      c[2]  += a * b[i][2];
-      c[3]  += a * b[i][3];
-      c[4]  += a * b[i][4];
-      c[5]  += a * b[i][5];
-      c[6]  += a * b[i][6];
-      c[7]  += a * b[i][7];
-      c[8]  += a * b[i][8];
-      c[9]  += a * b[i][9];
-      c[10] += a * b[i][10];
-      c[11] += a * b[i][11];
-      c[12] += a * b[i][12];
-      c[13] += a * b[i][13];
-      c[14] += a * b[i][14];
-      c[15] += a * b[i][15];
+      #pragma unroll
+      for ( uint r = 0; r < ROWS_PER_ITEM; ++r )
+      {
+        private T const s = a[r][(k + i) * colStrideA];
+
+        #pragma unroll
+        for ( uint j = 0; j < BLOCKSIZE; ++j ) c[r][j] += s * b[i][j];
+      }
     }
-    
+
     barrier( CLK_LOCAL_MEM_FENCE );
-    
-    B += BLOCKSIZE;
   }
-  while ( B < end );
-  
-  C[0 * N] = c[0];
-  C[1 * N] = c[1];
-  C[2 * N] = c[2];
-  C[3 * N] = c[3];
-  C[4 * N] = c[4];
-  C[5 * N] = c[5];
-  C[6 * N] = c[6];
-  C[7 * N] = c[7];
-  C[8 * N] = c[8];
-  C[9 * N] = c[9];
-  C[10 * N] = c[10];
-  C[11 * N] = c[11];
-  C[12 * N] = c[12];
-  C[13 * N] = c[13];
-  C[14 * N] = c[14];
-  C[15 * N] = c[15];
-  
-#undef BLOCKSIZE
+
+  #pragma unroll
+  for ( uint r = 0; r < ROWS_PER_ITEM; ++r )
+  {
+    if ( row[r] >= N ) break;
+
+    __global T* const z = C + row[r] * rowStrideC;
+
+    #pragma unroll
+    for ( uint j = 0; j < BLOCKSIZE; ++j )
+    {
+      if ( col + j < M )
+      {
+        // C is not read for beta == 0, so it may be uninitialized.
+        z[(col + j) * colStrideC] = beta == 0 ? alpha * c[r][j] : alpha * c[r][j] + beta * z[(col + j) * colStrideC];
+      }
+    }
+  }
 }
@@ -8,8 +8,15 @@
  * @date April 2014
  */
 
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <sstream>
 #include <stdexcept>
+#include <string>
 
 #include <ocl_buffer.h>
 #include <ocl_context.h>
@@ -29,42 +36,98 @@ typedef float Type;
 
 
 
+/**
+ * Compile-time specialization of the kernel.
+ */
+struct Volkov2008Config
+{
+  std::size_t blockSize;   // Columns of C per work-item and depth of the blocks of B.
+  std::size_t rowsPerItem; // Rows of C per work-item.
+  std::size_t unroll;      // Unrolled steps of the inner loop.
+  std::size_t groupSize;   // Work-items per work-group.
+};
+
+
+
+/**
+ * C = alpha * A * B + beta * C for operands of any size in column-major
+ * or row-major layout, which is given by Layout.
+ */
+template< typename Layout >
 class Volkov2008Pass : public utl::ProfilePass< Type >
 {
 public :
-  Volkov2008Pass( std::istream& source, utl::Dim const& start, utl::Dim const& step, utl::Dim const& end, std::size_t iter = 10 );
+  Volkov2008Pass( std::string const& source, Volkov2008Config const& config, Type alpha, Type beta,
+                  utl::Dim const& start, utl::Dim const& step, utl::Dim const& end, std::size_t iter = 10 );
     
   double prof( utl::Dim const& ) override;
   
   double ops( utl::Dim const& dim ) override;
   
 private :
-  typedef utl::Matrix< Type, utl::column_major_tag > Matrix; // Volkov uses column-major layout only.
-  typedef utl::Zeros< Type, utl::column_major_tag > Zeros;
-  
-  bool          testing_;
-  ocl::Platform platform_;
-  ocl::Device   device_;
-  ocl::Context  context_;
-  ocl::Queue    queue_;
-  ocl::Program  program_;
+  typedef utl::Matrix< Type, Layout > Matrix;
+  typedef utl::Rand< Type, Layout, utl::uniform_dist_tag > Rand;
+  typedef utl::MatrixTraits< Matrix > Traits;
+  
+  static std::string passName( Volkov2008Config const& config, Type beta );
+  
+  bool             testing_;
+  Volkov2008Config config_;
+  Type             alpha_, beta_;
+  ocl::Platform    platform_;
+  ocl::Device      device_;
+  ocl::Context     context_;
+  ocl::Queue       queue_;
+  ocl::Program     program_;
 };
 
 
 
-Volkov2008Pass::Volkov2008Pass( std::istream& source, utl::Dim const& start, utl::Dim const& step, utl::Dim const& end, std::size_t iter ):
-  ProfilePass< Type >( "Volkov2008", start, step, end, iter ),
+template< typename Layout >
+std::string Volkov2008Pass< Layout >::passName( Volkov2008Config const& config, Type beta )
+{
+  std::ostringstream oss;
+  oss << "Volkov2008_" << ( utl::isRowMajor< Matrix >::value ? "RowMajor" : "ColMajor" )
+      << "_B" << config.blockSize << "_R" << config.rowsPerItem << "_U" << config.unroll << ( beta != 0 ? "_Beta" : "" );
+  
+  return oss.str();
+}
+
+
+
+template< typename Layout >
+Volkov2008Pass< Layout >::Volkov2008Pass( std::string const& source, Volkov2008Config const& config, Type alpha, Type beta,
+                                          utl::Dim const& start, utl::Dim const& step, utl::Dim const& end, std::size_t iter ):
+  ProfilePass< Type >( passName( config, beta ), start, step, end, iter ),
   testing_( false ),
+  config_( config ),
+  alpha_( alpha ),
+  beta_( beta ),
   platform_( ocl::device_type::CPU ),
   device_( platform_.device( ocl::device_type::CPU ) ),
   context_( device_ ),
   queue_( (platform_.insert( context_ ), platform_.setActiveContext( context_ ), context_), device_, CL_QUEUE_PROFILING_ENABLE ),
   program_( (context_.setActiveQueue( queue_ ), context_), utl::type::Single )
 {
+  if ( config_.blockSize == 0 || config_.rowsPerItem == 0 || config_.unroll == 0 || config_.groupSize == 0 )
+  {
+    throw std::invalid_argument( "specialization parameters must not be zero" );
+  }
+  
+  this->setDevice( device_ );
+  this->setMetadata( "block_size", std::to_string( config_.blockSize ) );
+  this->setMetadata( "rows_per_item", std::to_string( config_.rowsPerItem ) );
+  this->setMetadata( "unroll", std::to_string( config_.unroll ) );
+  this->setMetadata( "group_size", std::to_string( config_.groupSize ) );
+  this->setMetadata( "layout", utl::isRowMajor< Matrix >::value ? "row_major" : "column_major" );
+  
   program_ << source;
   
   std::ostringstream oss;
-  oss << "-cl-std=CL1.2 -w -Werror";
+  oss << "-cl-std=CL1.2 -w -Werror"
+      << " -DBLOCKSIZE=" << config_.blockSize
+      << " -DROWS_PER_ITEM=" << config_.rowsPerItem
+      << " -DUNROLL=" << config_.unroll;
   
   ocl::CompileOption const opts( oss.str() );
   
@@ -90,47 +153,57 @@ Volkov2008Pass::Volkov2008Pass( std::istream& source, utl::Dim const& start, utl
 
 
 
-double Volkov2008Pass::prof( utl::Dim const& dim )
+template< typename Layout >
+double Volkov2008Pass< Layout >::prof( utl::Dim const& dim )
 {
   std::size_t const N = dim[0];
   std::size_t const M = dim[1];
   std::size_t const L = dim[2];
   
-  Zeros result( N, M );
+  Matrix result = Rand( N, M, Type( -1 ), Type( 1 ), 3 );
+  Matrix const initial = result;
   
-  Matrix lhs( N, L );
-  Matrix rhs( L, M );
+  Rand const lhs( N, L, Type( -1 ), Type( 1 ), 1 );
+  Rand const rhs( L, M, Type( -1 ), Type( 1 ), 2 );
   
-  // for ( size_t i = 0; i < N * L; ++i ) lhs[i] = i + 1; for ( size_t i = 0; i < L * M; ++i ) rhs[i] = i + 1;
-  for ( size_t i = 0; i < N * L; ++i ) lhs[i] = i % L;
-  for ( size_t i = 0; i < L * M; ++i ) rhs[i] = i / L;
-  
-  std::chrono::nanoseconds totalRuntime{ 0 };
+  double median = 0.0;
   
   ocl::Kernel& kernel( program_.kernel( "gemm" ) );
-      
-  kernel.setWorkSize( 1, 64, M / 16, N );
+  
+  // Partial blocks of columns and rows are padded, the kernel predicates their loads and stores.
+  std::size_t const rowsPerGroup = config_.groupSize * config_.rowsPerItem;
+  
+  kernel.setWorkSize( 1, config_.groupSize,
+                      ( M + config_.blockSize - 1 ) / config_.blockSize,
+                      ( N + rowsPerGroup - 1 ) / rowsPerGroup * config_.groupSize );
   
   size_t constexpr typeSize = sizeof (Type);
   size_t const numResultBytes = typeSize * result.size();
   size_t const numLhsBytes = typeSize * lhs.size();
   size_t const numRhsBytes = typeSize * rhs.size();
   
-  ocl::Buffer bufResult( context_, numResultBytes, ocl::Buffer::WriteOnly ),
+  ocl::Buffer bufResult( context_, numResultBytes ),
               bufLhs( context_, numLhsBytes, ocl::Buffer::ReadOnly ),
               bufRhs( context_, numRhsBytes, ocl::Buffer::ReadOnly );
+  
+  auto const stride = []( std::ptrdiff_t s ) { return static_cast< unsigned int >( s ); };
 
-  for ( std::size_t i = 0; i < this->_iter; ++i )
+  median = this->measure( [&]() -> double
   {
-    // Copy data from host to device.
+    // Copy data from host to device, C is an operand for beta != 0.
     ocl::Event const lhsWritten = bufLhs.writeAsync( queue_, 0u, lhs.data(), numLhsBytes );
     ocl::Event const rhsWritten = bufRhs.writeAsync( queue_, 0u, rhs.data(), numRhsBytes );
+    ocl::Event const resultWritten = bufResult.writeAsync( queue_, 0u, initial.data(), numResultBytes );
     
     ocl::EventList operandsWritten;
-    operandsWritten << lhsWritten << rhsWritten;
+    operandsWritten << lhsWritten << rhsWritten << resultWritten;
     
-    // Execute kernel when both operands have been loaded.
-    ocl::Event const multiplyDone = kernel( queue_, operandsWritten, N, L, bufLhs.id(), bufRhs.id(), bufResult.id() );
+    // Execute kernel when all operands have been loaded.
+    ocl::Event const multiplyDone = kernel( queue_, operandsWritten,
+      static_cast< unsigned int >( N ), static_cast< unsigned int >( M ), static_cast< unsigned int >( L ), alpha_,
+      bufLhs.id(), stride( Traits::rowStride( lhs ) ), stride( Traits::colStride( lhs ) ),
+      bufRhs.id(), stride( Traits::rowStride( rhs ) ), stride( Traits::colStride( rhs ) ),
+      beta_, bufResult.id(), stride( Traits::rowStride( result ) ), stride( Traits::colStride( result ) ) );
     
     // Copy result from device to host.
     ocl::Event const resultRead = bufResult.readAsync( queue_, 0u, result.data(), numResultBytes, ocl::EventList( multiplyDone ) );
@@ -140,35 +213,42 @@ double Volkov2008Pass::prof( utl::Dim const& dim )
     
     size_t const kernelRuntime_ns = multiplyDone.finishTime() - multiplyDone.startTime();
 
-    totalRuntime += std::chrono::nanoseconds( kernelRuntime_ns );
-  }
+    return kernelRuntime_ns * 1e-9;
+  } );
   
-   if( testing_ )
+  Matrix const ref = alpha_ * lhs * rhs + beta_ * initial;
+  auto const diff = result - ref;
+  auto const iMax = std::max_element( diff.begin(), diff.end(), []( Type a, Type b ){
+    return std::fabs( a ) < std::fabs( b );
+  } );
+  
+  if( testing_ )
   {
-    auto const ref = lhs * rhs;
-    auto const diff = result - ref;
-    auto const iMax = std::max_element( diff.begin(), diff.end(), []( Type a, Type b ){
-      return std::fabs( a ) < std::fabs( b );
-    } );
-    
     std::cout /*<< lhs << '*' << rhs << " = " */ << "ref = " << ref << std::endl;
     std::cout << "result = " << result << std::endl;
-    std::cout << "Maximal error: " << *iMax << std::endl;
+  }
+  
+  std::cout << this->name() << " " << N << "x" << M << "x" << L << " maximal error: " << *iMax << std::endl;
+  
+  // The elements are in [-1,1], so each element of A * B is a sum of L products with a rounding error below L * L * eps.
+  double const tolerance = 2.0 * std::numeric_limits< Type >::epsilon() * ( std::fabs( alpha_ ) * L * L + std::fabs( beta_ ) + 1.0 );
+  
+  if ( std::fabs( *iMax ) > tolerance )
+  {
+    size_t const index = iMax - diff.begin();
+    std::cout << "ref[" << index << "] = " << ref[index] << " != result[" << index << "] = " << result[index] << std::endl;
     
-    if ( *iMax != 0 )
-    {
-      size_t const index = iMax - diff.begin();
-      std::cout << "ref[" << index << "] = " << ref[index] << " != result[" << index << "] = " << result[index] << std::endl;
-    }
+    throw std::runtime_error( this->name() + ": result exceeds the error bound" );
   }
   
-  // Return average time.
-  return std::chrono::duration_cast< std::chrono::microseconds >( totalRuntime / this->_iter ).count();
+  // Return median time in seconds.
+  return median;
 }
 
 
 
-double Volkov2008Pass::ops( utl::Dim const& dim )
+template< typename Layout >
+double Volkov2008Pass< Layout >::ops( utl::Dim const& dim )
 {
   // N * M * (L + (L - 1))
   return dim[0] * dim[1] * (2.0 * dim[2] - 1.0);
@@ -180,19 +260,40 @@ int main( int argc, char** argv )
 {
   utl::Args args( argc, argv );
   
-  if ( args.size() == 2 )
+  if ( args.size() >= 2 && args.size() <= 4 )
   {
     std::string const filename( args.toString( 1 ) );
     std::ifstream file( filename );
     
     if ( file.is_open() )
     {
+      std::string const source( ( std::istreambuf_iterator< char >( file ) ), std::istreambuf_iterator< char >() );
+      
       utl::ProfilePassManager< Type > mgr;
-  
-      mgr << std::make_shared<Volkov2008Pass>( file, utl::Dim( 256, 256, 256 ), utl::Dim( 16, 16, 16 ), utl::Dim( 256, 256, 256 ) );
+      
+      // The configuration of Volkov and Demmel and two which compute more elements of C per work-item.
+      Volkov2008Config const volkov = { 16, 1, 16, 64 };
+      Volkov2008Config const rows   = { 16, 4, 16, 64 };
+      Volkov2008Config const wide   = { 32, 2,  8, 64 };
+      
+      // Aligned sizes as in the paper and sizes which are no multiple of any block.
+      utl::Dim const alignedStart( 256, 256, 256 ), alignedStep( 256, 256, 256 ), alignedEnd( 1024, 1024, 1024 );
+      utl::Dim const oddStart( 100, 130, 70 ), oddStep( 300, 300, 300 ), oddEnd( 1000, 1030, 970 );
+      
+      mgr << std::make_shared< Volkov2008Pass< utl::column_major_tag > >( source, volkov, Type( 1 ), Type( 0 ), alignedStart, alignedStep, alignedEnd );
+      mgr << std::make_shared< Volkov2008Pass< utl::column_major_tag > >( source, rows, Type( 1 ), Type( 0 ), alignedStart, alignedStep, alignedEnd );
+      mgr << std::make_shared< Volkov2008Pass< utl::column_major_tag > >( source, wide, Type( 1 ), Type( 0 ), alignedStart, alignedStep, alignedEnd );
+      mgr << std::make_shared< Volkov2008Pass< utl::row_major_tag > >( source, rows, Type( 1 ), Type( 0 ), alignedStart, alignedStep, alignedEnd );
+      
+      // Non-aligned sizes with alpha and beta.
+      mgr << std::make_shared< Volkov2008Pass< utl::column_major_tag > >( source, rows, Type( 0.5 ), Type( -2 ), oddStart, oddStep, oddEnd );
+      mgr << std::make_shared< Volkov2008Pass< utl::row_major_tag > >( source, wide, Type( 0.5 ), Type( -2 ), oddStart, oddStep, oddEnd );
   
       mgr.run();
       mgr.write( std::cout );
+      
+      if ( args.size() > 2 ) mgr.write( args.toString( 2 ) );
+      if ( args.size() > 3 && mgr.compare( args.toString( 3 ), std::cout ) > 0 ) return EXIT_FAILURE;
     }
     else
     {
@@ -201,7 +302,7 @@ int main( int argc, char** argv )
   }
   else
   {
-    std::cout << "Usage: " << args.at( 0 ) << " <kernel.cl>" << std::endl;
+    std::cout << "Usage: " << args.at( 0 ) << " <kernel.cl> [<results.json|results.csv> [<baseline.csv>]]" << std::endl;
   }
   
   return EXIT_SUCCESS;
@@ -0,0 +1,217 @@
+//Copyright (C) 2013 Cem Bassoy.
+//
+//This file is part of the OpenCL Utility Toolkit.
+//
+//OpenCL Utility Toolkit is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+//
+//OpenCL Utility Toolkit is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License
+//along with OpenCL Utility Toolkit.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef OCL_BLAS_H
+#define OCL_BLAS_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <ocl_program.h>
+#include <ocl_buffer.h>
+#include <ocl_event.h>
+#include <ocl_event_list.h>
+
+namespace ocl{
+
+class Context;
+class Queue;
+class Device;
+
+/*! \namespace blas
+  * \brief BLAS-style entry points on column-major matrices stored in Buffer objects.
+  */
+namespace blas{
+
+/*! \brief Operation op(X) applied to an input matrix. */
+enum Transpose { NoTrans = 0, /*!< op(X) = X */
+                 Trans   = 1  /*!< op(X) = X^T */
+               };
+
+/*! \brief Kernels among which gemm chooses, all but Naive from gemm.cl. */
+enum GemmKernel { Naive,   /*!< one element of C per work-item */
+                  Blocked, /*!< gemm_basic_algorithm, tiles of A and B in local memory, register blocking of C */
+                  Vector,  /*!< gemm_vec4 or gemm_vec8, vectors of rows of C per work-item, for CPU devices, float only */
+                  Image    /*!< gemm_img_basic_algorithm, register blocking with A and B read from images, float only */
+                };
+
+/*! \class GemmConfig ocl_blas.h "inc/ocl_blas.h"
+  * \brief Kernel of gemm for one device and the sizes at which it switches to others.
+  *
+  * The blocking of Blocked and Image is fixed by gemm.cl to 16x16 work-items,
+  * each computing 4x4 elements of C.
+  */
+struct GemmConfig
+{
+    GemmKernel kernel;
+    unsigned int vectorWidth; /*!< Rows and columns of C per work-item of Vector, 4 or 8, 0 for the preferred width of the device */
+    double naiveBelow;        /*!< Products with less multiply-adds M*N*K run Naive */
+    size_t crossover;         /*!< Smallest dimension from which gemmStrassen recurses */
+};
+
+GemmConfig gemmConfig(const Device&);
+void setGemmConfig(const Device&, const GemmConfig&);
+
+void setKernelSource(const std::string&);
+const std::string& kernelSource();
+
+}
+
+
+/*! \class Blas ocl_blas.h "inc/ocl_blas.h"
+  * \brief BLAS routines on column-major matrices stored in a Buffer.
+  *
+  * gemm computes C = alpha*op(A)*op(B) + beta*C with the kernel which
+  * blas::gemmConfig returns for the device of the Queue. Except for Naive,
+  * these are the kernels of gemm.cl, whose source the Blas object is given. All kernels
+  * handle partial tiles at the borders of C and any leading dimensions, so
+  * the matrices can be submatrices of larger ones. C is not read if beta is zero.
+  *
+  * gemmStrassen computes the same with the Strassen-Winograd recursion,
+  * which multiplies classically with gemm once a dimension is below the
+  * crossover of the GemmConfig.
+  *
+  * gemmStreamed computes the product of matrices in host memory, which may be
+  * larger than the device memory, by streaming tiles of A, B and C through the device.
+  *
+  * gemmBatched computes the same for a whole batch of small matrices with a
+  * single kernel launch. The matrices of a batch are either evenly strided
+  * within three Buffers or described by a Batch, which holds the sizes, offsets
+  * and leading dimensions of every product. Depending on the size of the
+  * products, one work-group computes one or several matrices, so that products
+  * of 8x8 matrices do not leave most of the work-items idle.
+  *
+  * The kernels are built for the given Types, which must be float or double.
+  * The kernels except those of gemm.cl can also be added to another Program with source().
+  */
+class Blas
+{
+public:
+    /*! \brief Sizes, offsets in elements and leading dimensions of one product of a Batch. */
+    struct BatchEntry
+    {
+        unsigned int m, n, k;
+        unsigned int offsetA, lda;
+        unsigned int offsetB, ldb;
+        unsigned int offsetC, ldc;
+    };
+
+    /*! \class Batch ocl_blas.h "inc/ocl_blas.h"
+      * \brief Products of a batch with arbitrary sizes, uploaded once to the device.
+      */
+    class Batch
+    {
+    public:
+        Batch(Context&, const Queue&, const std::vector<BatchEntry>&);
+
+        size_t size() const { return _entries.size(); }
+        unsigned int maxElements() const { return _maxElements; }
+        const Buffer& buffer() const { return _buffer; }
+        const std::vector<BatchEntry>& entries() const { return _entries; }
+
+        void check(blas::Transpose transA, blas::Transpose transB, const Buffer& A, const Buffer& B, const Buffer& C, size_t elementSize) const;
+
+    private:
+        Buffer _buffer;
+        std::vector<BatchEntry> _entries; /*!< Host copy of the entries for the checks */
+        unsigned int _maxElements; /*!< Largest m*n of all products */
+    };
+
+    explicit Blas(Context&, const utl::Types& types = utl::Types(utl::type::Single), const std::string& gemmSource = std::string());
+
+    Blas(const Blas&) = delete;
+    Blas& operator=(const Blas&) = delete;
+
+    template<class T>
+    Event gemm(const Queue&, blas::Transpose transA, blas::Transpose transB, size_t m, size_t n, size_t k,
+               T alpha, const Buffer& A, size_t offsetA, size_t lda,
+                        const Buffer& B, size_t offsetB, size_t ldb,
+               T beta,  const Buffer& C, size_t offsetC, size_t ldc, const EventList& list = EventList());
+
+    template<class T>
+    Event gemmStrassen(const Queue&, size_t m, size_t n, size_t k,
+                       T alpha, const Buffer& A, size_t offsetA, size_t lda,
+                                const Buffer& B, size_t offsetB, size_t ldb,
+                       T beta,  const Buffer& C, size_t offsetC, size_t ldc, const EventList& list = EventList());
+
+    template<class T>
+    void gemmStreamed(const Queue&, blas::Transpose transA, blas::Transpose transB, size_t m, size_t n, size_t k,
+                      T alpha, const T *A, size_t lda, const T *B, size_t ldb, T beta, T *C, size_t ldc, size_t deviceBytes = 0);
+
+    template<class T>
+    Event gemmBatched(const Queue&, blas::Transpose transA, blas::Transpose transB, size_t m, size_t n, size_t k,
+                      T alpha, const Buffer& A, size_t lda, size_t strideA,
+                               const Buffer& B, size_t ldb, size_t strideB,
+                      T beta,  const Buffer& C, size_t ldc, size_t strideC,
+                      size_t count, const EventList& list = EventList());
+
+    template<class T>
+    Event gemmBatched(const Queue&, blas::Transpose transA, blas::Transpose transB, T alpha, const Buffer& A, const Buffer& B,
+                      T beta, const Buffer& C, const Batch& batch, const EventList& list = EventList());
+
+    Program& program() { return _program; }
+
+    static const std::string& source();
+
+private:
+    const Buffer& workspace(size_t index, size_t bytes);
+
+    template<class T>
+    Event strassen(const Queue&, size_t m, size_t n, size_t k, T alpha, const Buffer& A, size_t offsetA, size_t lda,
+                   const Buffer& B, size_t offsetB, size_t ldb, T beta, const Buffer& C, size_t offsetC, size_t ldc,
+                   size_t crossover, size_t level, const EventList&);
+
+    Program _program;
+    std::unique_ptr<Program> _gemm; /*!< Kernels of gemm.cl, null without its source */
+    std::vector<std::unique_ptr<Buffer> > _workspace; /*!< Operands and products of the Strassen levels */
+    bool _images; /*!< All devices of the Context support images */
+};
+
+
+namespace blas{
+
+Blas& library(Context&);
+
+/*! \brief Computes C = alpha*op(A)*op(B) + beta*C on the active Queue of the Context of C.
+  *
+  * op(A) is M x K, op(B) is K x N and C is M x N, all stored column-major
+  * from the first element of their Buffer on.
+  */
+template<class T>
+Event gemm(Transpose transA, Transpose transB, size_t M, size_t N, size_t K,
+           T alpha, const Buffer& A, size_t lda, const Buffer& B, size_t ldb,
+           T beta, const Buffer& C, size_t ldc, const EventList& list = EventList());
+
+
+template<class T>
+Event gemmStrassen(size_t M, size_t N, size_t K, T alpha, const Buffer& A, size_t lda, const Buffer& B, size_t ldb,
+                   T beta, const Buffer& C, size_t ldc, const EventList& list = EventList());
+
+template<class T>
+double strassenErrorBound(size_t n, size_t crossover);
+
+template<class T>
+void gemmStreamed(Context&, Transpose transA, Transpose transB, size_t M, size_t N, size_t K,
+                  T alpha, const T *A, size_t lda, const T *B, size_t ldb, T beta, T *C, size_t ldc);
+
+}
+
+}
+#endif
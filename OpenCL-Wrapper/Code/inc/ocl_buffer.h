@@ -78,6 +78,7 @@ public:
                    };
 	explicit Buffer();
 	Buffer (Context&, size_t size_bytes, Access access = ReadWrite);
+	Buffer (Context&, void *host_ptr, size_t size_bytes, Access access = ReadWrite);
 	#ifdef __OPENGL__
 	Buffer (Context &, GLuint vbo_desc);
 	#endif
@@ -87,6 +88,7 @@ public:
 	Buffer ( Buffer && other);
 
 	void create(size_t size_bytes, Access access = ReadWrite);
+	void create(void *host_ptr, size_t size_bytes, Access access = ReadWrite);
 	#ifdef __OPENGL__
 	void create(GLuint vbo_desc);
 	#endif
@@ -75,11 +75,17 @@ public:
 	size_t maxMemAllocSize() const;
 	size_t maxConstantBufferSize() const;
 	size_t globalMemSize() const;
+	size_t globalMemCacheSize() const;
+	size_t globalMemCachelineSize() const;
+	cl_device_mem_cache_type globalMemCacheType() const;
 	size_t localMemSize() const;
+	size_t preferredVectorWidthFloat() const;
+	size_t preferredVectorWidthDouble() const;
 	size_t maxWorkGroupSize() const;
 
 	cl_platform_id platform() const;
 	std::string version()    const;
+	std::string driverVersion() const;
 	std::string name()       const;
 	std::string vendor()     const;
 	std::string extensions() const;
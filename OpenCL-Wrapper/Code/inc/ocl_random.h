@@ -0,0 +1,72 @@
+//Copyright (C) 2013 Cem Bassoy.
+//
+//This file is part of the OpenCL Utility Toolkit.
+//
+//OpenCL Utility Toolkit is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+//
+//OpenCL Utility Toolkit is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License
+//along with OpenCL Utility Toolkit.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef OCL_RANDOM_H
+#define OCL_RANDOM_H
+
+#include <cstdint>
+#include <string>
+
+#include <ocl_program.h>
+#include <ocl_event.h>
+#include <ocl_event_list.h>
+
+namespace ocl{
+
+class Context;
+class Queue;
+class Buffer;
+
+/*! \class Random ocl_random.h "inc/ocl_random.h"
+  * \brief Generates random numbers directly into a Buffer.
+  *
+  * The kernels implement the same Philox4x32-10 generator as utl::Philox,
+  * so a Buffer filled with a seed holds the same numbers as a host array
+  * filled with utl::Philox(seed) for the uniform stream or
+  * utl::Philox(seed, utl::Philox::Normal) for the normal stream.
+  * Each work-item generates one block of four numbers.
+  *
+  * The kernels are built for the given Types, which must be float or double.
+  * They can also be added to another Program with source().
+  */
+class Random
+{
+public:
+    explicit Random(Context&, const utl::Types& types = utl::Types(utl::type::Single));
+
+    Random(const Random&) = delete;
+    Random& operator=(const Random&) = delete;
+
+    template<class T>
+    Event uniform(const Queue&, const Buffer&, size_t n, T min, T max, std::uint64_t seed, size_t offset = 0, const EventList& list = EventList());
+
+    template<class T>
+    Event normal(const Queue&, const Buffer&, size_t n, T mean, T dev, std::uint64_t seed, size_t offset = 0, const EventList& list = EventList());
+
+    Program& program() { return _program; }
+
+    static const std::string& source();
+
+private:
+    template<class T>
+    Event launch(const std::string& name, const Queue&, const Buffer&, size_t n, T a, T b, std::uint64_t seed, size_t offset, const EventList&);
+
+    Program _program;
+};
+
+}
+#endif
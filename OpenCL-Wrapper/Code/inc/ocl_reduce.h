@@ -0,0 +1,155 @@
+//Copyright (C) 2013 Cem Bassoy.
+//
+//This file is part of the OpenCL Utility Toolkit.
+//
+//OpenCL Utility Toolkit is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+//
+//OpenCL Utility Toolkit is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License
+//along with OpenCL Utility Toolkit.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef OCL_REDUCE_H
+#define OCL_REDUCE_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <ocl_program.h>
+#include <ocl_buffer.h>
+#include <ocl_event.h>
+#include <ocl_event_list.h>
+
+namespace ocl{
+
+class Context;
+class Queue;
+
+/*! \class ReduceOp ocl_reduce.h "inc/ocl_reduce.h"
+  * \brief Associative and commutative operator of a Reduction.
+  *
+  * An operator is an OpenCL expression which combines the two operands a and b
+  * of the element type, e.g. "a + b", together with its neutral element.
+  * The operator is compiled into the kernels as a macro, its name identifies them.
+  */
+class ReduceOp
+{
+public:
+    /*! \brief Built-in operators, whose neutral elements depend on the element type. */
+    enum Kind { Sum, Min, Max };
+
+    ReduceOp(Kind);
+    ReduceOp(const std::string& name, const std::string& expression, double identity);
+
+    const std::string& name() const { return _name; }
+    const std::string& expression() const { return _expression; }
+
+    template<class T>
+    T identity() const;
+
+private:
+    std::string _name, _expression;
+    double _identity; /*!< neutral element of sums and custom operators, min and max depend on the type */
+};
+
+
+/*! \class Reduction ocl_reduce.h "inc/ocl_reduce.h"
+  * \brief Reduces the elements of a Buffer to a scalar or to their prefixes.
+  *
+  * Every work-item combines a strided share of the elements, read as vectors
+  * of four, and the work-groups combine the values of their work-items with
+  * a tree in local memory, which works for any local size. The values of the
+  * work-groups are reduced again until a single value is left. The local size
+  * is the largest the kernel supports, at most 256, and the number of
+  * work-groups is bounded by the compute units of the device.
+  *
+  * The scans are work-efficient and run on several levels. A work-group
+  * scans four elements per work-item and its total is written to a Buffer
+  * of the call, the totals are scanned on the next level and combined with
+  * the elements of the following work-groups. The local size is a power
+  * of two for the scans. Since the scans share no memory, they can run
+  * concurrently on several queues, while reduce, argmin and argmax share
+  * the workspace and return only after reading their result.
+  *
+  * argmin and argmax return the index of the smallest or largest element
+  * relative to the offset, the first one if several are equal, and read
+  * the elements and their indices as vectors of four as well.
+  *
+  * The kernels are templates, a Program per operator specialises them for
+  * float, int, unsigned int and, if all devices of the Context support the
+  * cl_khr_fp64 extension, double. It is built on the first use of the operator.
+  */
+class Reduction
+{
+public:
+    explicit Reduction(Context&);
+
+    Reduction(const Reduction&) = delete;
+    Reduction& operator=(const Reduction&) = delete;
+
+    template<class T>
+    T reduce(const Queue&, const Buffer&, const ReduceOp&, size_t n, size_t offset = 0, const EventList& list = EventList());
+
+    template<class T>
+    Event exclusiveScan(const Queue&, const Buffer& input, const Buffer& output, size_t n, const ReduceOp& op = ReduceOp::Sum,
+                        size_t inputOffset = 0, size_t outputOffset = 0, const EventList& list = EventList());
+
+    template<class T>
+    Event inclusiveScan(const Queue&, const Buffer& input, const Buffer& output, size_t n, const ReduceOp& op = ReduceOp::Sum,
+                        size_t inputOffset = 0, size_t outputOffset = 0, const EventList& list = EventList());
+
+    template<class T>
+    size_t argmin(const Queue&, const Buffer&, size_t n, size_t offset = 0, const EventList& list = EventList());
+
+    template<class T>
+    size_t argmax(const Queue&, const Buffer&, size_t n, size_t offset = 0, const EventList& list = EventList());
+
+    Context& context() { return _ctxt; }
+    bool isBuilt() const;
+
+private:
+    Program& program(const std::string& key, const std::string& source, const CompileOption& options);
+    const Buffer& workspace(size_t index, size_t bytes);
+
+    template<class T>
+    Event scan(const Queue&, const Buffer& input, size_t inputOffset, const Buffer& output, size_t outputOffset,
+               size_t n, const ReduceOp&, bool inclusive, const EventList&);
+
+    template<class T>
+    size_t argreduce(bool largest, const Queue&, const Buffer&, size_t n, size_t offset, const EventList&);
+
+    Context& _ctxt;
+    std::map<std::string, std::unique_ptr<Program> > _programs; /*!< Programs of the operators and of argmin and argmax */
+    std::vector<std::unique_ptr<Buffer> > _workspace; /*!< Values and indices of the work-groups of reduce and argreduce twice */
+};
+
+Reduction& reduction(Context&);
+
+/*! \brief Reduces all elements of the Buffer with the Queue, e.g. reduce<float>(queue, buffer, ReduceOp::Max). */
+template<class T>
+T reduce(const Queue&, const Buffer&, const ReduceOp& op = ReduceOp::Sum);
+
+/*! \brief Writes the prefix sums, or the prefixes of the operator, of all elements of input to output. */
+template<class T>
+Event exclusiveScan(const Queue&, const Buffer& input, const Buffer& output, const ReduceOp& op = ReduceOp::Sum);
+
+template<class T>
+Event inclusiveScan(const Queue&, const Buffer& input, const Buffer& output, const ReduceOp& op = ReduceOp::Sum);
+
+template<class T>
+size_t argmin(const Queue&, const Buffer&);
+
+template<class T>
+size_t argmax(const Queue&, const Buffer&);
+
+}
+#endif
@@ -42,5 +42,8 @@
 #include <ocl_queue.h>
 #include <ocl_image.h>
 #include <ocl_sampler.h>
+#include <ocl_random.h>
+#include <ocl_blas.h>
+#include <ocl_reduce.h>
 
 #endif
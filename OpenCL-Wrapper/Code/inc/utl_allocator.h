@@ -0,0 +1,166 @@
+//Copyright (C) 2013 Cem Bassoy.
+//
+//This file is part of the OpenCL Utility Toolkit.
+//
+//OpenCL Utility Toolkit is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+//
+//OpenCL Utility Toolkit is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License
+//along with OpenCL Utility Toolkit.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef UTL_ALLOCATOR_H
+#define UTL_ALLOCATOR_H
+
+#include <cstddef>
+#include <memory>
+
+namespace utl{
+
+size_t pageSize();
+size_t hugePageSize();
+
+void* alignedAllocate(size_t size_bytes, size_t alignment);
+void  alignedDeallocate(void *ptr, size_t alignment);
+
+void adviseHugePages(void *ptr, size_t size_bytes);
+void touchPages(void *ptr, size_t size_bytes);
+
+
+/*! \class AlignedAllocator utl_allocator.h "inc/utl_allocator.h"
+  * \brief Allocator which aligns the memory to Alignment bytes.
+  *
+  * The default of 64 bytes corresponds to a cache line and allows aligned SIMD loads
+  * for all vector widths up to AVX-512.
+  */
+template<class T, size_t Alignment = 64>
+class AlignedAllocator
+{
+public:
+    typedef T value_type;
+
+    template<class U> struct rebind { typedef AlignedAllocator<U,Alignment> other; };
+
+    AlignedAllocator() noexcept = default;
+    template<class U> AlignedAllocator(const AlignedAllocator<U,Alignment>&) noexcept {}
+
+    static size_t alignment() { return Alignment; }
+
+    T* allocate(size_t n) { return static_cast<T*>(alignedAllocate(n*sizeof(T), alignment())); }
+    void deallocate(T *ptr, size_t) noexcept { alignedDeallocate(ptr, alignment()); }
+};
+
+template<class T, class U, size_t A>
+bool operator==(const AlignedAllocator<T,A>&, const AlignedAllocator<U,A>&) { return true; }
+
+template<class T, class U, size_t A>
+bool operator!=(const AlignedAllocator<T,A>&, const AlignedAllocator<U,A>&) { return false; }
+
+
+/*! \class PageAlignedAllocator utl_allocator.h "inc/utl_allocator.h"
+  * \brief Allocator which aligns the memory to the page size of the system.
+  *
+  * Page aligned host memory can be used by ocl::Buffer with UseHost without copying (zero-copy).
+  */
+template<class T>
+class PageAlignedAllocator
+{
+public:
+    typedef T value_type;
+
+    template<class U> struct rebind { typedef PageAlignedAllocator<U> other; };
+
+    PageAlignedAllocator() noexcept = default;
+    template<class U> PageAlignedAllocator(const PageAlignedAllocator<U>&) noexcept {}
+
+    static size_t alignment() { return pageSize(); }
+
+    T* allocate(size_t n) { return static_cast<T*>(alignedAllocate(n*sizeof(T), alignment())); }
+    void deallocate(T *ptr, size_t) noexcept { alignedDeallocate(ptr, alignment()); }
+};
+
+template<class T, class U>
+bool operator==(const PageAlignedAllocator<T>&, const PageAlignedAllocator<U>&) { return true; }
+
+template<class T, class U>
+bool operator!=(const PageAlignedAllocator<T>&, const PageAlignedAllocator<U>&) { return false; }
+
+
+/*! \class HugePageAllocator utl_allocator.h "inc/utl_allocator.h"
+  * \brief Allocator which requests transparent huge pages for the memory.
+  *
+  * The memory is aligned to and padded to a multiple of the huge page size and advised
+  * with madvise(MADV_HUGEPAGE) on Linux. This reduces dTLB misses for large matrices.
+  * On other systems the memory is only aligned.
+  */
+template<class T>
+class HugePageAllocator
+{
+public:
+    typedef T value_type;
+
+    template<class U> struct rebind { typedef HugePageAllocator<U> other; };
+
+    HugePageAllocator() noexcept = default;
+    template<class U> HugePageAllocator(const HugePageAllocator<U>&) noexcept {}
+
+    static size_t alignment() { return hugePageSize(); }
+
+    T* allocate(size_t n)
+    {
+        const size_t size_bytes = (n*sizeof(T) + alignment() - 1) / alignment() * alignment();
+        void *ptr = alignedAllocate(size_bytes, alignment());
+        adviseHugePages(ptr, size_bytes);
+        return static_cast<T*>(ptr);
+    }
+    void deallocate(T *ptr, size_t) noexcept { alignedDeallocate(ptr, alignment()); }
+};
+
+template<class T, class U>
+bool operator==(const HugePageAllocator<T>&, const HugePageAllocator<U>&) { return true; }
+
+template<class T, class U>
+bool operator!=(const HugePageAllocator<T>&, const HugePageAllocator<U>&) { return false; }
+
+
+/*! \class FirstTouchAllocator utl_allocator.h "inc/utl_allocator.h"
+  * \brief Allocator which places the pages on the NUMA nodes of the threads using them.
+  *
+  * Linux maps a page to the NUMA node of the thread which touches it first. The pages
+  * are therefore touched by the OpenMP threads with a static schedule right after the
+  * allocation, which matches the distribution of the element-wise operations and the
+  * host GEMM. The memory itself is allocated by Base.
+  */
+template<class T, class Base = PageAlignedAllocator<T> >
+class FirstTouchAllocator : public Base
+{
+public:
+    typedef T value_type;
+
+    template<class U> struct rebind { typedef FirstTouchAllocator<U, typename std::allocator_traits<Base>::template rebind_alloc<U> > other; };
+
+    FirstTouchAllocator() noexcept = default;
+    template<class U, class B> FirstTouchAllocator(const FirstTouchAllocator<U,B>& other) noexcept : Base(other) {}
+
+    T* allocate(size_t n)
+    {
+        T *ptr = Base::allocate(n);
+        touchPages(ptr, n*sizeof(T));
+        return ptr;
+    }
+};
+
+template<class T, class U, class B, class C>
+bool operator==(const FirstTouchAllocator<T,B>& a, const FirstTouchAllocator<U,C>& b) { return static_cast<const B&>(a) == static_cast<const C&>(b); }
+
+template<class T, class U, class B, class C>
+bool operator!=(const FirstTouchAllocator<T,B>& a, const FirstTouchAllocator<U,C>& b) { return !(a == b); }
+
+}
+#endif
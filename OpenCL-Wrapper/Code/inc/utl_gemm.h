@@ -0,0 +1,211 @@
+//Copyright (C) 2013 Cem Bassoy.
+//
+//This file is part of the OpenCL Utility Toolkit.
+//
+//OpenCL Utility Toolkit is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+//
+//OpenCL Utility Toolkit is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License
+//along with OpenCL Utility Toolkit.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef UTL_GEMM_H
+#define UTL_GEMM_H
+
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace utl{
+
+/*! \class GemmBlocking utl_gemm.h "inc/utl_gemm.h"
+  * \brief Blocking parameters of the host GEMM for the value type T.
+  *
+  * MR x NR is the register tile computed by the micro kernel. MR spans one cache line
+  * of T so that the inner loop maps onto full SIMD registers. A block of MC x KC elements
+  * of the left operand is packed per thread and stays in L2, a panel of KC x NC elements
+  * of the right operand is packed once and shared by all threads in L3.
+  */
+template<class T>
+struct GemmBlocking
+{
+    static constexpr size_t MR = 64/sizeof(T) < 4 ? 4 : (64/sizeof(T) > 16 ? 16 : 64/sizeof(T));
+    static constexpr size_t NR = 6;
+    static constexpr size_t MC = 8*MR;
+    static constexpr size_t KC = 256;
+    static constexpr size_t NC = 512*NR;
+};
+
+namespace detail {
+
+/*! \brief Packs mc x kc elements of a into column panels of MR rows. Missing rows are padded with zeros. */
+template<class T, size_t MR>
+void gemmPackLhs(size_t mc, size_t kc, const T* a, std::ptrdiff_t rsA, std::ptrdiff_t csA, T* packed)
+{
+    for(size_t i = 0; i < mc; i += MR)
+    {
+        const size_t mr = std::min(MR, mc - i);
+        const T* panel = a + std::ptrdiff_t(i)*rsA;
+        for(size_t p = 0; p < kc; ++p, packed += MR)
+        {
+            const T* col = panel + std::ptrdiff_t(p)*csA;
+            size_t ii = 0;
+            if(rsA == 1) for(; ii < mr; ++ii) packed[ii] = col[ii];
+            else         for(; ii < mr; ++ii) packed[ii] = col[std::ptrdiff_t(ii)*rsA];
+            for(; ii < MR; ++ii) packed[ii] = T(0);
+        }
+    }
+}
+
+/*! \brief Packs the NR columns of b starting at column j into a row panel of length kc. Missing columns are padded with zeros. */
+template<class T, size_t NR>
+void gemmPackRhs(size_t nr, size_t kc, const T* b, std::ptrdiff_t rsB, std::ptrdiff_t csB, T* packed)
+{
+    for(size_t p = 0; p < kc; ++p, packed += NR)
+    {
+        const T* row = b + std::ptrdiff_t(p)*rsB;
+        size_t jj = 0;
+        if(csB == 1) for(; jj < nr; ++jj) packed[jj] = row[jj];
+        else         for(; jj < nr; ++jj) packed[jj] = row[std::ptrdiff_t(jj)*csB];
+        for(; jj < NR; ++jj) packed[jj] = T(0);
+    }
+}
+
+/*! \brief Computes the MR x NR tile c = alpha * a * b + beta * c from packed panels. Only the mr x nr upper left part is stored. */
+template<class T, size_t MR, size_t NR>
+void gemmMicroKernel(size_t kc, const T* a, const T* b, T alpha, T beta, T* c, std::ptrdiff_t rsC, std::ptrdiff_t csC, size_t mr, size_t nr)
+{
+    T acc[NR][MR] = {};
+
+    for(size_t p = 0; p < kc; ++p, a += MR, b += NR)
+    {
+        for(size_t j = 0; j < NR; ++j)
+        {
+            const T bj = b[j];
+#pragma omp simd
+            for(size_t i = 0; i < MR; ++i)
+                acc[j][i] += a[i] * bj;
+        }
+    }
+
+    for(size_t j = 0; j < nr; ++j)
+    {
+        T* col = c + std::ptrdiff_t(j)*csC;
+        if(beta == T(0)) for(size_t i = 0; i < mr; ++i) col[std::ptrdiff_t(i)*rsC] = alpha*acc[j][i];
+        else             for(size_t i = 0; i < mr; ++i) col[std::ptrdiff_t(i)*rsC] = alpha*acc[j][i] + beta*col[std::ptrdiff_t(i)*rsC];
+    }
+}
+
+}
+
+/*! \brief Computes C = alpha * A * B + beta * C on the host.
+  *
+  * A is m x k, B is k x n and C is m x n. Each operand is described by a pointer and
+  * the distance between two consecutive rows (rs) and columns (cs), so column-major
+  * (rs = 1, cs = ld), row-major (rs = ld, cs = 1) and transposed operands are handled
+  * by the same routine. The operands are packed into cache sized blocks, multiplied
+  * by a register blocked micro kernel and the blocks of C are distributed among the
+  * OpenMP threads. If beta is zero, C is not read.
+  */
+template<class T>
+void gemm(size_t m, size_t n, size_t k, T alpha,
+          const T* a, std::ptrdiff_t rsA, std::ptrdiff_t csA,
+          const T* b, std::ptrdiff_t rsB, std::ptrdiff_t csB,
+          T beta, T* c, std::ptrdiff_t rsC, std::ptrdiff_t csC)
+{
+    typedef GemmBlocking<T> Blocking;
+    constexpr size_t MR = Blocking::MR, NR = Blocking::NR;
+    constexpr size_t MC = Blocking::MC, KC = Blocking::KC, NC = Blocking::NC;
+
+    if(m == 0 || n == 0) return;
+
+    if(k == 0 || alpha == T(0))
+    {
+        for(size_t j = 0; j < n; ++j)
+            for(size_t i = 0; i < m; ++i){
+                T& r = c[std::ptrdiff_t(i)*rsC + std::ptrdiff_t(j)*csC];
+                r = beta == T(0) ? T(0) : beta*r;
+            }
+        return;
+    }
+
+    const size_t lhsBlocks = (m + MC - 1)/MC;
+    std::vector<T> packedRhs(std::min(KC, k) * ((std::min(NC, n) + NR - 1)/NR) * NR);
+
+#pragma omp parallel
+    {
+        std::vector<T> packedLhs(MC*std::min(KC, k));
+
+#ifdef _OPENMP
+        const size_t threads = size_t(omp_get_num_threads());
+#else
+        const size_t threads = 1;
+#endif
+        for(size_t jc = 0; jc < n; jc += NC)
+        {
+            const size_t nc = std::min(NC, n - jc);
+            const std::ptrdiff_t rhsPanels = std::ptrdiff_t((nc + NR - 1)/NR);
+
+            // if there are less blocks of A than threads, the column panels of C are split as well.
+            const size_t groups = std::min(size_t(rhsPanels), std::max<size_t>(1, (threads + lhsBlocks - 1)/lhsBlocks));
+            const size_t panelsPerGroup = (size_t(rhsPanels) + groups - 1)/groups;
+            const std::ptrdiff_t tasks = std::ptrdiff_t(lhsBlocks*groups);
+
+            for(size_t pc = 0; pc < k; pc += KC)
+            {
+                const size_t kc = std::min(KC, k - pc);
+                const T betaBlock = pc == 0 ? beta : T(1);
+
+#pragma omp for schedule(static)
+                for(std::ptrdiff_t jp = 0; jp < rhsPanels; ++jp)
+                {
+                    const size_t jr = size_t(jp)*NR;
+                    detail::gemmPackRhs<T,NR>(std::min(NR, nc - jr), kc,
+                                              b + std::ptrdiff_t(pc)*rsB + std::ptrdiff_t(jc + jr)*csB, rsB, csB,
+                                              packedRhs.data() + jr*kc);
+                }
+
+                size_t packedBlock = lhsBlocks;
+#pragma omp for schedule(static)
+                for(std::ptrdiff_t task = 0; task < tasks; ++task)
+                {
+                    const size_t block = size_t(task)/groups, group = size_t(task)%groups;
+                    const size_t ic = block*MC, mc = std::min(MC, m - ic);
+
+                    // consecutive tasks of a thread usually share the same block of A.
+                    if(packedBlock != block){
+                        detail::gemmPackLhs<T,MR>(mc, kc, a + std::ptrdiff_t(ic)*rsA + std::ptrdiff_t(pc)*csA, rsA, csA, packedLhs.data());
+                        packedBlock = block;
+                    }
+
+                    const size_t jrBegin = group*panelsPerGroup*NR;
+                    const size_t jrEnd   = std::min(nc, jrBegin + panelsPerGroup*NR);
+                    for(size_t jr = jrBegin; jr < jrEnd; jr += NR)
+                    {
+                        const size_t nr = std::min(NR, nc - jr);
+                        for(size_t ir = 0; ir < mc; ir += MR)
+                        {
+                            const size_t mr = std::min(MR, mc - ir);
+                            T* tile = c + std::ptrdiff_t(ic + ir)*rsC + std::ptrdiff_t(jc + jr)*csC;
+                            detail::gemmMicroKernel<T,MR,NR>(kc, packedLhs.data() + ir*kc, packedRhs.data() + jr*kc,
+                                                             alpha, betaBlock, tile, rsC, csC, mr, nr);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+}
+#endif
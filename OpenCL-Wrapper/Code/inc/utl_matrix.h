@@ -27,6 +27,9 @@
 #include <algorithm>
 
 #include <utl_assert.h>
+#include <utl_gemm.h>
+#include <utl_matrix_storage.h>
+#include <utl_matrix_expression.h>
 
 
 namespace utl{
@@ -41,24 +44,27 @@ namespace utl{
   * to other data types.
   */
 
-template<class T>
+template<class T, class Alloc = std::allocator<T> >
 class __MatrixBase
 {
 public:
 
-    typedef typename std::vector<T>::pointer           pointer;
-    typedef typename std::vector<T>::const_pointer     const_pointer;
-    typedef typename std::vector<T>::reference         reference;
-    typedef typename std::vector<T>::const_reference   const_reference;
-    typedef typename std::vector<T>::value_type        value_type;
+    typedef MatrixStorage<T,Alloc>                     storage_type;
+    typedef Alloc                                      allocator_type;
 
-    typedef typename std::vector<T>::iterator          iterator;
-    typedef typename std::vector<T>::const_iterator    const_iterator;
+    typedef typename storage_type::pointer             pointer;
+    typedef typename storage_type::const_pointer       const_pointer;
+    typedef typename storage_type::reference           reference;
+    typedef typename storage_type::const_reference     const_reference;
+    typedef typename storage_type::value_type          value_type;
+
+    typedef typename storage_type::iterator            iterator;
+    typedef typename storage_type::const_iterator      const_iterator;
 
 
     __MatrixBase& operator = (value_type value) { std::fill(this->begin(), this->end(), value); return *this; }
-    __MatrixBase& operator = (const __MatrixBase& m) { _vector = m._vector; _rows = m._rows; _cols = m._cols; return *this;}
-    __MatrixBase& operator = (__MatrixBase&& m) { _vector = std::move(m._vector); _rows = m._rows; _cols = m._cols; return *this; }
+    __MatrixBase& operator = (const __MatrixBase& m) { _storage = m._storage; _rows = m._rows; _cols = m._cols; return *this;}
+    __MatrixBase& operator = (__MatrixBase&& m) { _storage = std::move(m._storage); _rows = m._rows; _cols = m._cols; return *this; }
 
 
     bool operator==(const_reference value) {
@@ -76,77 +82,35 @@ public:
         return std::equal(this->begin(), this->end(), m.begin());
     }
 
-    __MatrixBase operator*(const_reference value) const
-    {
-        __MatrixBase res = *this;
-        std::for_each(res.begin(), res.end(), [value]( reference r){ r *= value; });
-        return res;
-    }
-
-    __MatrixBase operator+(const_reference value) const
-    {
-        __MatrixBase res = *this;
-        std::for_each(res.begin(), res.end(), [value]( reference r){ r += value; });
-        return res;
-    }
-
-    __MatrixBase operator+(const __MatrixBase& rhs) const
-    {
-        const __MatrixBase& lhs = *this;
-        TRUE_ASSERT(lhs.dim() == rhs.dim(), "Dimensions must be equal");
-        __MatrixBase res(lhs.rows(), lhs.cols());
-        std::transform(lhs.begin(), lhs.end(), rhs.begin(), res.begin(), std::plus<T>());
-        return res;
-    }
-
-    __MatrixBase operator-(const_reference value) const
-    {
-        __MatrixBase res = *this;
-        std::for_each(res.begin(), res.end(), [value]( reference r){ r -= value; });
-        return res;
-    }
-
-    __MatrixBase operator-(const __MatrixBase& rhs) const
-    {
-        const __MatrixBase& lhs = *this;
-        TRUE_ASSERT(lhs.dim() == rhs.dim(), "Dimensions must be equal");
-        __MatrixBase res(lhs.rows(), lhs.cols());
-        std::transform(lhs.begin(), lhs.end(), rhs.begin(), res.begin(), std::minus<T>());
-        return res;
-    }
-
-    __MatrixBase operator/(const_reference value) const
-    {
-        return this->operator *(value_type(1)/value);
-    }
-
-
-    void resize(size_t rows, size_t cols, value_type value = value_type()) { _rows = rows; _cols = cols; this->_vector.resize(rows*cols, value);}
-    size_t size() const { return this->vector().size(); }
+    void resize(size_t rows, size_t cols, value_type value = value_type()) { this->_storage.resize(rows*cols, value); _rows = rows; _cols = cols; }
+    size_t size() const { return this->storage().size(); }
 
-    pointer data() { return this->_vector.data(); }
-    const_pointer data() const { return this->vector().data(); }
+    pointer data() { return this->_storage.data(); }
+    const_pointer data() const { return this->storage().data(); }
 
     size_t rows() const { return this->_rows; }
     size_t cols() const { return this->_cols; }
 
     std::pair<size_t,size_t> dim() const { return std::make_pair(_rows,_cols); }
 
-    const std::vector<T>& vector() const { return this->_vector; }
+    const storage_type& storage() const { return this->_storage; }
 
-    const_iterator begin() const { return this->_vector.begin(); }
-    const_iterator end() const { return this->_vector.end(); }
-    iterator begin() { return this->_vector.begin(); }
-    iterator end()   { return this->_vector.end(); }
+    /*! \brief Returns true if the elements are owned by the matrix and not wrapped external memory. */
+    bool owner() const { return this->_storage.owner(); }
 
+    const_iterator begin() const { return this->_storage.begin(); }
+    const_iterator end() const { return this->_storage.end(); }
+    iterator begin() { return this->_storage.begin(); }
+    iterator end()   { return this->_storage.end(); }
 
-    reference operator[](size_t index) { return _vector[index]; }
-    const_reference operator[](size_t index) const { return _vector[index]; }
 
-    reference front() { return this->_vector.front(); }
-    const_reference front() const { return this->_vector.front(); }
-    reference back() { return this->_vector.back(); }
-    const_reference back() const { return this->_vector.back(); }
+    reference operator[](size_t index) { return _storage[index]; }
+    const_reference operator[](size_t index) const { return _storage[index]; }
+
+    reference front() { return this->_storage.front(); }
+    const_reference front() const { return this->_storage.front(); }
+    reference back() { return this->_storage.back(); }
+    const_reference back() const { return this->_storage.back(); }
 
     bool is_scalar() const { return _rows == 1 && _cols == 1; }
     bool is_vector() const { return !is_scalar() && (_rows == 1 || _cols == 1); }
@@ -156,16 +120,17 @@ public:
 
 protected:
 
-    __MatrixBase(size_t rows, size_t cols, const_reference value) :  _vector(rows*cols, value), _rows(rows), _cols(cols) {}
-    __MatrixBase(size_t rows, size_t cols) :  _vector(rows*cols), _rows(rows), _cols(cols) {}
-    __MatrixBase(const __MatrixBase& m) : _vector(m._vector), _rows(m._rows), _cols(m._cols) {}
-    __MatrixBase(__MatrixBase&& m) : _vector(std::move(m._vector)), _rows(m._rows), _cols(m._cols) {}
-    __MatrixBase() = default;
+    __MatrixBase(size_t rows, size_t cols, const_reference value) :  _storage(rows*cols, value), _rows(rows), _cols(cols) {}
+    __MatrixBase(size_t rows, size_t cols) :  _storage(rows*cols), _rows(rows), _cols(cols) {}
+    __MatrixBase(size_t rows, size_t cols, storage_type&& storage) :  _storage(std::move(storage)), _rows(rows), _cols(cols) {}
+    __MatrixBase(const __MatrixBase& m) : _storage(m._storage), _rows(m._rows), _cols(m._cols) {}
+    __MatrixBase(__MatrixBase&& m) : _storage(std::move(m._storage)), _rows(m._rows), _cols(m._cols) {}
+    __MatrixBase() : _rows(0), _cols(0) {}
 
 
 
 
-    std::vector<T> _vector;
+    storage_type _storage;
 
     size_t _rows;
     size_t _cols;
@@ -178,8 +143,8 @@ struct column_major_tag { };
 struct row_major_tag  { };
 
 
-template <class T, class F>
-class Matrix : private __MatrixBase<T>
+template <class T, class F, class Alloc = std::allocator<T> >
+class Matrix : private __MatrixBase<T,Alloc>
 {
     Matrix() = delete;
 };
@@ -194,13 +159,13 @@ struct isRowMajorImpl
 
 template< typename T > constexpr bool const isRowMajorImpl< T >::value;
 
-template< typename T >
-struct isRowMajorImpl< Matrix< T, row_major_tag > >
+template< typename T, typename Alloc >
+struct isRowMajorImpl< Matrix< T, row_major_tag, Alloc > >
 {
   constexpr static bool const value = true;
 };
 
-template< typename T > constexpr bool const isRowMajorImpl< Matrix< T, row_major_tag > >::value;
+template< typename T, typename Alloc > constexpr bool const isRowMajorImpl< Matrix< T, row_major_tag, Alloc > >::value;
   
 }
 
@@ -214,10 +179,10 @@ struct isRowMajor
 template< typename Matrix > constexpr bool const isRowMajor< Matrix >::value;
 
 
-template <class T>
-class Matrix<T, column_major_tag> : public __MatrixBase<T>
+template <class T, class Alloc>
+class Matrix<T, column_major_tag, Alloc> : public __MatrixBase<T,Alloc>, public MatrixExpressionBase
 {
-    using Base = __MatrixBase<T>;
+    using Base = __MatrixBase<T,Alloc>;
 
 public :
 
@@ -230,56 +195,53 @@ public :
     typedef typename Base::iterator          iterator;
     typedef typename Base::const_iterator    const_iterator;
 
+    typedef typename Base::storage_type      storage_type;
+    typedef typename Base::allocator_type    allocator_type;
+
+    typedef Matrix                           terminal_type;
+
     Matrix(size_t rows, size_t cols, const_reference value) :  Base(rows,cols, value) {}
     Matrix(size_t rows, size_t cols) :  Base(rows,cols) {}
     Matrix(const Matrix& m) : Base(m) {}
     Matrix(Matrix&& m) : Base(std::move(m)) {}
+
+    /*! \brief Copies a matrix whose elements are stored with another allocator. */
+    template<class A, class = typename std::enable_if<!std::is_same<A, Alloc>::value>::type>
+    explicit Matrix(const Matrix<T, column_major_tag, A>& m) : Base(m.rows(), m.cols()) { std::copy(m.begin(), m.end(), this->begin()); }
+
     Matrix() = default;
     ~Matrix() = default;
 
+    /*! \brief Returns a matrix which refers to the rows x cols elements at data, e.g. a mapped ocl::Buffer, without copying them.
+      *
+      * The memory must outlive the matrix and is not released by it. Copies of the matrix own their elements.
+      */
+    static Matrix wrap(pointer data, size_t rows, size_t cols) { return Matrix(rows, cols, storage_type::wrap(data, rows*cols)); }
+
+    /*! \brief Evaluates a matrix expression, e.g. alpha * lhs * rhs + beta * c, into a new matrix. */
+    template<class E, class = typename std::enable_if<isMatrixExpressionNode<E>::value>::type>
+    Matrix(const E& e) : Matrix(detail::evaluate(e)) {}
+
     Matrix& operator = (value_type value) { Base::operator=( value ); return *this; }
     Matrix& operator = (const Matrix& m) { Base::operator=( m ); return *this; }
     Matrix& operator = (Matrix&& m) { Base::operator=( std::move(m) ) ;  return *this; }
 
-
-    Matrix operator*(const_reference value) const { return Base::operator*(value);  }
-    Matrix operator+(const_reference value) const { return Base::operator+(value);  }
-    Matrix operator+(const Matrix& rhs) const     { return Base::operator+(rhs);   }
-    Matrix operator-(const_reference value) const { return Base::operator-(value); }
-    Matrix operator-(const Matrix& rhs) const     { return Base::operator-(rhs);   }
-    Matrix operator/(const_reference value) const { return Base::operator/(value); }
-
-    Matrix operator*(const Matrix& rhs) const
+    /*! \brief Evaluates a matrix expression. Element-wise expressions of the same size are evaluated in place. */
+    template<class E, class = typename std::enable_if<isMatrixExpressionNode<E>::value>::type>
+    Matrix& operator = (const E& e)
     {
-        const Matrix& lhs = *this;
-        TRUE_ASSERT(lhs.cols() == rhs.rows(), "LhsMatrix.cols() != RhsMatrix.rows()");
-        Matrix res(lhs.rows(), rhs.cols());
-
-
-        auto itRhsCol = rhs.begin(), itRhsColEnd = rhs.begin() + rhs.cols() * rhs.rows();
-        auto itResCol = res.begin();
-        auto itLhsRowEnd = lhs.begin() + lhs.rows();
-
-        for(; itRhsCol != itRhsColEnd; itRhsCol += rhs.rows(), itResCol += res.rows())
-        {
-            auto itLhsRow = lhs.begin();
-            auto itResRow = itResCol;
-            for(; itLhsRow != itLhsRowEnd; ++itLhsRow, ++itResRow)
-            {
-                auto itLhsCol = itLhsRow;
-                auto itRhsRow = itRhsCol;
-                auto itRhsRowEnd = itRhsRow + rhs.rows();
-                for(; itRhsRow != itRhsRowEnd; itLhsCol += lhs.rows(), ++itRhsRow){
-                    *itResRow += *itLhsCol * *itRhsRow;
-                }
+        if constexpr (isElementwiseExpression<E>::value){
+            if(this->rows() == e.rows() && this->cols() == e.cols()){
+                detail::assignElementwise(*this, e);
+                return *this;
             }
         }
-        return res;
+        return *this = Matrix(e);
     }
 
 
-    reference at(size_t row, size_t col) { return this->_vector.at(row + col * this->_rows); }
-    const_reference at(size_t row, size_t col) const { return this->_vector.at(row + col * this->_rows); }
+    reference at(size_t row, size_t col) { return this->_storage.at(row + col * this->_rows); }
+    const_reference at(size_t row, size_t col) const { return this->_storage.at(row + col * this->_rows); }
 
     friend std::ostream& operator<< (std::ostream & out, const Matrix & m)
     {
@@ -312,18 +274,29 @@ public :
     }
 
 private:
-    Matrix(Base &&base) :
-        Base(base)
-    {
-    }
+    Matrix(size_t rows, size_t cols, storage_type&& storage) : Base(rows, cols, std::move(storage)) {}
+};
+
+template <class T, class Alloc>
+struct MatrixTraits< Matrix<T, column_major_tag, Alloc> >
+{
+    typedef Matrix<T, column_major_tag, Alloc> matrix_type;
+
+    static constexpr bool strided = true;
+
+    template<class R, class C>
+    static matrix_type create(const R& rowPrototype, const C& colPrototype) { return matrix_type(rowPrototype.rows(), colPrototype.cols()); }
+
+    static std::ptrdiff_t rowStride(const matrix_type&) { return 1; }
+    static std::ptrdiff_t colStride(const matrix_type& m) { return std::ptrdiff_t(m.rows()); }
 };
 }
 
 namespace utl{
-template <class T>
-class Matrix<T, row_major_tag> : public __MatrixBase<T>
+template <class T, class Alloc>
+class Matrix<T, row_major_tag, Alloc> : public __MatrixBase<T,Alloc>, public MatrixExpressionBase
 {
-    using Base = __MatrixBase<T>;
+    using Base = __MatrixBase<T,Alloc>;
 public :
 
     typedef typename Base::pointer           pointer;
@@ -335,58 +308,55 @@ public :
     typedef typename Base::iterator          iterator;
     typedef typename Base::const_iterator    const_iterator;
 
+    typedef typename Base::storage_type      storage_type;
+    typedef typename Base::allocator_type    allocator_type;
+
+    typedef Matrix                           terminal_type;
+
     Matrix(size_t rows, size_t cols, const_reference value) :  Base(rows,cols, value) {}
     Matrix(size_t rows, size_t cols) :  Base(rows,cols) {}
     Matrix(const Matrix& m) : Base(m) {}
     Matrix(Matrix&& m) : Base(std::move(m)) {}
+
+    /*! \brief Copies a matrix whose elements are stored with another allocator. */
+    template<class A, class = typename std::enable_if<!std::is_same<A, Alloc>::value>::type>
+    explicit Matrix(const Matrix<T, row_major_tag, A>& m) : Base(m.rows(), m.cols()) { std::copy(m.begin(), m.end(), this->begin()); }
+
     Matrix() = default;
     ~Matrix() = default;
 
+    /*! \brief Returns a matrix which refers to the rows x cols elements at data, e.g. a mapped ocl::Buffer, without copying them.
+      *
+      * The memory must outlive the matrix and is not released by it. Copies of the matrix own their elements.
+      */
+    static Matrix wrap(pointer data, size_t rows, size_t cols) { return Matrix(rows, cols, storage_type::wrap(data, rows*cols)); }
+
+    /*! \brief Evaluates a matrix expression, e.g. alpha * lhs * rhs + beta * c, into a new matrix. */
+    template<class E, class = typename std::enable_if<isMatrixExpressionNode<E>::value>::type>
+    Matrix(const E& e) : Matrix(detail::evaluate(e)) {}
+
 
     Matrix& operator = (value_type value) { Base::operator=( value ); return *this; }
     Matrix& operator = (const Matrix& m) { Base::operator=( m ); return *this; }
     Matrix& operator = (Matrix&& m) { Base::operator=( std::move(m) ) ;  return *this; }
 
-
-    Matrix operator*(const_reference value) const { return Base::operator*(value); }
-    Matrix operator+(const_reference value) const { return Base::operator+(value); }
-    Matrix operator+(const Matrix& rhs) const     { return Base::operator+(rhs); }
-    Matrix operator-(const_reference value) const { return Base::operator-(value); }
-    Matrix operator-(const Matrix& rhs) const     { return Base::operator-(rhs); }
-    Matrix operator/(const_reference value) const { return Base::operator/(value); }
-
-    Matrix operator*(const Matrix& rhs) const
+    /*! \brief Evaluates a matrix expression. Element-wise expressions of the same size are evaluated in place. */
+    template<class E, class = typename std::enable_if<isMatrixExpressionNode<E>::value>::type>
+    Matrix& operator = (const E& e)
     {
-        const Matrix& lhs = *this;
-        TRUE_ASSERT(lhs.cols() == rhs.rows(), "LhsMatrix.cols() != RhsMatrix.rows()");
-        Matrix res(lhs.rows(), rhs.cols());
-
-
-        auto itRhsCol = rhs.begin(), itRhsColEnd = rhs.begin() + rhs.cols();
-        auto itResCol = res.begin();
-        auto itLhsRowEnd = lhs.begin() + lhs.cols() * lhs.rows();
-
-        for(; itRhsCol != itRhsColEnd; ++itRhsCol, ++itResCol)
-        {
-            auto itLhsRow = lhs.begin();
-            auto itResRow = itResCol;
-            for(; itLhsRow != itLhsRowEnd; itLhsRow += lhs.cols(), itResRow += res.cols())
-            {
-                auto itLhsCol = itLhsRow;
-                auto itRhsRow = itRhsCol;
-                auto itRhsRowEnd = itRhsRow + rhs.cols() * rhs.rows();
-                for(; itRhsRow != itRhsRowEnd; ++itLhsCol, itRhsRow += rhs.cols()){
-                    *itResRow += *itLhsCol * *itRhsRow;
-                }
+        if constexpr (isElementwiseExpression<E>::value){
+            if(this->rows() == e.rows() && this->cols() == e.cols()){
+                detail::assignElementwise(*this, e);
+                return *this;
             }
         }
-        return res;
+        return *this = Matrix(e);
     }
 
 
 
-    reference at(size_t row, size_t col) { return this->_vector.at(row*this->_cols + col); }
-    const_reference at(size_t row, size_t col) const { return this->_vector.at(row*this->_cols + col); }
+    reference at(size_t row, size_t col) { return this->_storage.at(row*this->_cols + col); }
+    const_reference at(size_t row, size_t col) const { return this->_storage.at(row*this->_cols + col); }
 
 
 
@@ -419,15 +389,25 @@ public :
         return out;
     }
 private:
+    Matrix(size_t rows, size_t cols, storage_type&& storage) : Base(rows, cols, std::move(storage)) {}
+};
 
-    Matrix(Base &&base) :
-        Base(base)
-    {
-    }
+template <class T, class Alloc>
+struct MatrixTraits< Matrix<T, row_major_tag, Alloc> >
+{
+    typedef Matrix<T, row_major_tag, Alloc> matrix_type;
+
+    static constexpr bool strided = true;
+
+    template<class R, class C>
+    static matrix_type create(const R& rowPrototype, const C& colPrototype) { return matrix_type(rowPrototype.rows(), colPrototype.cols()); }
+
+    static std::ptrdiff_t rowStride(const matrix_type& m) { return std::ptrdiff_t(m.cols()); }
+    static std::ptrdiff_t colStride(const matrix_type&) { return 1; }
 };
 }
 
-#include <random>
+#include <utl_random.h>
 #include <limits>
 
 namespace utl{
@@ -438,141 +418,67 @@ struct uniform_dist_tag { };
 ///  Marking row_major matrices.
 struct normal_dist_tag  { };
 
-template <class T, class F, class D>
-class Rand : public Matrix<T,F>
+template <class T, class F, class D, class Alloc = std::allocator<T> >
+class Rand : public Matrix<T,F,Alloc>
 {
     Rand() = delete;
 };
 
-template<class Engine, class Vector, bool>
-struct uniform_int_distribution
-{
-    typedef typename Vector::value_type Type;
-    static void run(Engine, Vector&, Type, Type){}
-};
-
-template<class Engine, class Vector>
-struct uniform_int_distribution<Engine, Vector, true>
-{
-    typedef typename Vector::value_type Type;
-    static void run(Engine engine, Vector& vector, Type min, Type max)
-    {
-        std::uniform_int_distribution<Type> dist(min, max);
-        for(auto &v : vector)
-            v = dist(engine);
-    }
-};
-
-template<class Engine, class Vector, bool>
-struct uniform_real_distribution
-{
-    typedef typename Vector::value_type Type;
-    static void run(Engine, Vector&, Type, Type){}
-};
-
-template<class Engine, class Vector>
-struct uniform_real_distribution<Engine, Vector, true>
-{
-    typedef typename Vector::value_type Type;
-    static void run(Engine engine, Vector& vector, Type min, Type max)
-    {
-        std::uniform_real_distribution<Type> dist(min, max);
-        for(auto &v : vector)
-            v = dist(engine);
-    }
-};
-
 
-template <class T, class F>
-class Rand<T,F,uniform_dist_tag> : public Matrix<T,F>
+/*! \brief Matrix with uniform random elements in [min, max), or [min, max] for integral types.
+  *
+  * The elements are generated in parallel with Philox. Matrices with the same seed, size
+  * and format are equal, independent of the number of threads, and equal to a Buffer filled
+  * by ocl::Random::uniform with the same seed.
+  */
+template <class T, class F, class Alloc>
+class Rand<T,F,uniform_dist_tag,Alloc> : public Matrix<T,F,Alloc>
 {
 public :
-    typedef typename Matrix<T,F>::value_type        value_type;
+    typedef typename Matrix<T,F,Alloc>::value_type        value_type;
 
-    Rand(size_t rows, size_t cols, value_type min = value_type(0), value_type max = value_type(1)) :
-        utl::Matrix<T,F>(rows, cols)
+    Rand(size_t rows, size_t cols, value_type min = value_type(0), value_type max = value_type(1), std::uint64_t seed = Philox::randomSeed()) :
+        utl::Matrix<T,F,Alloc>(rows, cols)
     {
-        typedef std::mt19937 Engine;
-        typedef std::vector<T> Vector;
-        // Seed with a real random value, if available
-        std::random_device device;
-
-        Engine engine(device());
-
-        constexpr bool is_integral = std::is_integral<T>::value;
-        constexpr bool is_floating_point = std::is_floating_point<T>::value;
-
-        uniform_int_distribution<Engine, Vector, is_integral>::run(engine, this->_vector , min, max);
-        uniform_real_distribution<Engine, Vector, is_floating_point>::run(engine, this->_vector, min, max);
+        Philox(seed, Philox::Uniform).uniform(this->data(), rows*cols, min, max);
     }
 };
 
 
-template<class Engine, class Vector, bool isFloat>
-struct normal_distribution
-{
-    static void run(Engine engine, Vector& vector, double mean, double dev)
-    {
-        std::normal_distribution<> dist(mean, dev);
-        for(auto &v : vector)
-            v = std::round(dist(engine));
-    }
-};
-
-template<class Engine, class Vector>
-struct normal_distribution<Engine, Vector, true>
-{
-    static void run(Engine engine, Vector& vector, double mean, double dev)
-    {
-        std::normal_distribution<> dist(mean, dev);
-        for(auto &v : vector)
-            v = dist(engine);
-    }
-};
-
-
-
-template <class T, class F>
-class Rand<T,F,normal_dist_tag> : public Matrix<T,F>
+/*! \brief Matrix with normal random elements, which are rounded for integral types.
+  *
+  * See the uniform Rand for the generation.
+  */
+template <class T, class F, class Alloc>
+class Rand<T,F,normal_dist_tag,Alloc> : public Matrix<T,F,Alloc>
 {
 public :
 
-    Rand(size_t rows, size_t cols, double mean = 0.0, double dev = 1.0) :
-        utl::Matrix<T,F>(rows, cols)
+    Rand(size_t rows, size_t cols, double mean = 0.0, double dev = 1.0, std::uint64_t seed = Philox::randomSeed()) :
+        utl::Matrix<T,F,Alloc>(rows, cols)
     {
-        typedef std::mt19937 Engine;
-        typedef std::vector<T> Vector;
-
-        // Seed with a real random value, if available
-        std::random_device device;
-
-        Engine engine(device());
-
-        constexpr bool is_floating_point = std::is_floating_point<T>::value;
-
-        normal_distribution<Engine, Vector, is_floating_point>::run(engine, this->_vector , mean, dev);
-
+        Philox(seed, Philox::Normal).normal(this->data(), rows*cols, mean, dev);
     }
 };
 
 
-template <class T, class F>
-class Ones : public Matrix<T,F>
+template <class T, class F, class Alloc = std::allocator<T> >
+class Ones : public Matrix<T,F,Alloc>
 {
 public :
-    typedef typename Matrix<T,F>::value_type        value_type;
+    typedef typename Matrix<T,F,Alloc>::value_type        value_type;
     Ones(size_t rows, size_t cols) :
-        utl::Matrix<T,F>(rows, cols, value_type(1))
+        utl::Matrix<T,F,Alloc>(rows, cols, value_type(1))
     {}
 };
 
-template <class T, class F>
-class Zeros : public Matrix<T,F>
+template <class T, class F, class Alloc = std::allocator<T> >
+class Zeros : public Matrix<T,F,Alloc>
 {
 public :
-    typedef typename Matrix<T,F>::value_type        value_type;
+    typedef typename Matrix<T,F,Alloc>::value_type        value_type;
     Zeros(size_t rows, size_t cols) :
-        utl::Matrix<T,F>(rows, cols, value_type(0))
+        utl::Matrix<T,F,Alloc>(rows, cols, value_type(0))
     {}
 };
 
@@ -0,0 +1,640 @@
+//Copyright (C) 2013 Cem Bassoy.
+//
+//This file is part of the OpenCL Utility Toolkit.
+//
+//OpenCL Utility Toolkit is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+//
+//OpenCL Utility Toolkit is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License
+//along with OpenCL Utility Toolkit.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef UTL_MATRIX_EXPRESSION_H
+#define UTL_MATRIX_EXPRESSION_H
+
+#include <cstddef>
+#include <iterator>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <utl_assert.h>
+#include <utl_gemm.h>
+
+namespace utl{
+
+/*! \brief Marks matrices and matrix expressions which take part in the lazy arithmetic below. */
+struct MatrixExpressionBase { };
+
+/*! \brief Marks the nodes of an expression tree, i.e. everything which is not a stored matrix. */
+struct MatrixExpressionNode : MatrixExpressionBase { };
+
+/*! \brief Marks (scaled) matrix products and GEMM expressions which cannot be evaluated element by element. */
+struct MatrixProductNode : MatrixExpressionNode { };
+
+/*! \brief Describes how a stored matrix type is created and accessed by the expression templates.
+  *
+  * Specializations provide create(rowPrototype, colPrototype) which returns a matrix with the rows of
+  * the first and the columns of the second prototype. Strided matrices set strided to true and provide
+  * rowStride() and colStride(), all others provide toColumnMajor() and fromColumnMajor() instead.
+  */
+template<class M>
+struct MatrixTraits;
+
+template<class E>
+struct isMatrixExpression : std::is_base_of<MatrixExpressionBase, typename std::decay<E>::type> { };
+
+template<class E>
+struct isMatrixExpressionNode : std::is_base_of<MatrixExpressionNode, typename std::decay<E>::type> { };
+
+template<class E>
+struct isMatrixProduct : std::is_base_of<MatrixProductNode, typename std::decay<E>::type> { };
+
+template<class E>
+struct isElementwiseExpression : std::integral_constant<bool, isMatrixExpression<E>::value && !isMatrixProduct<E>::value> { };
+
+
+namespace detail {
+
+/// lvalues are referenced by expression nodes, temporaries are moved into them.
+template<class E>
+using Forwarded = typename std::conditional<std::is_lvalue_reference<E>::value,
+                                            const typename std::decay<E>::type&,
+                                            typename std::decay<E>::type>::type;
+
+template<class E, bool = isMatrixExpressionNode<E>::value>
+struct Prototype
+{
+    static const E& rows(const E& e) { return e; }
+    static const E& cols(const E& e) { return e; }
+};
+
+template<class E>
+struct Prototype<E, true>
+{
+    static decltype(auto) rows(const E& e) { return e.rowPrototype(); }
+    static decltype(auto) cols(const E& e) { return e.colPrototype(); }
+};
+
+/// Stored matrix which determines the row count (and row blocking) of an expression.
+template<class E>
+decltype(auto) rowPrototype(const E& e) { return Prototype<E>::rows(e); }
+
+/// Stored matrix which determines the column count (and column blocking) of an expression.
+template<class E>
+decltype(auto) colPrototype(const E& e) { return Prototype<E>::cols(e); }
+
+template<class E>
+using ResultOf = typename std::decay<decltype(rowPrototype(std::declval<const E&>()))>::type::terminal_type;
+
+/// Products are evaluated once when they are used inside an element-wise expression.
+template<class E>
+using Operand = typename std::conditional<isMatrixProduct<E>::value, ResultOf<E>, Forwarded<E> >::type;
+
+template<class E>
+bool refersTo(const E& e, const void* p);
+
+/// Element-wise expressions smaller than this are not worth waking up the OpenMP threads.
+constexpr std::ptrdiff_t elementwiseParallelThreshold = 1 << 15;
+
+template<class D, class E>
+void assignElementwise(D& dest, const E& e)
+{
+    TRUE_ASSERT(dest.rows() == e.rows() && dest.cols() == e.cols(), "Dimensions must be equal");
+    typename D::pointer d = dest.data();
+    const std::ptrdiff_t size = std::ptrdiff_t(e.size());
+#pragma omp parallel for schedule(static) if(size > elementwiseParallelThreshold)
+    for(std::ptrdiff_t i = 0; i < size; ++i)
+        d[i] = e[i];
+}
+
+template<class T>
+struct MatrixOperand
+{
+    const T* data;
+    std::ptrdiff_t rowStride, colStride;
+    std::vector<T> buffer;
+};
+
+/// Returns a strided view of m, gathering non-strided layouts into a column-major copy.
+template<class M>
+MatrixOperand<typename M::value_type> stridedOperand(const M& m)
+{
+    typedef typename M::terminal_type Terminal;
+    typedef MatrixTraits<Terminal> Traits;
+    MatrixOperand<typename M::value_type> op;
+    if constexpr (Traits::strided){
+        op.data = m.data();
+        op.rowStride = Traits::rowStride(m);
+        op.colStride = Traits::colStride(m);
+    }
+    else{
+        op.buffer.resize(m.rows()*m.cols());
+        Traits::toColumnMajor(m, op.buffer.data());
+        op.data = op.buffer.data();
+        op.rowStride = 1;
+        op.colStride = std::ptrdiff_t(m.rows());
+    }
+    return op;
+}
+
+template<class E>
+ResultOf<E> evaluate(const E& e);
+
+template<class E>
+MatrixOperand<typename E::value_type> operand(const E& e)
+{
+    if constexpr (isMatrixExpressionNode<E>::value){
+        const ResultOf<E> m = evaluate(e);
+        MatrixOperand<typename E::value_type> op = stridedOperand(m);
+        if(op.buffer.empty()){
+            op.buffer.assign(m.begin(), m.end());
+            op.data = op.buffer.data();
+        }
+        return op;
+    }
+    else
+        return stridedOperand(e);
+}
+
+/*! \brief Computes dest = alpha * lhs * rhs + beta * c with a single call of utl::gemm. c may be null if beta is zero. */
+template<class D, class L, class R, class C>
+void gemmAssign(D& dest, typename D::value_type alpha, const L& lhs, const R& rhs, typename D::value_type beta, const C* c)
+{
+    typedef typename D::value_type T;
+    typedef MatrixTraits<typename D::terminal_type> Traits;
+
+    const MatrixOperand<T> a = operand(lhs);
+    const MatrixOperand<T> b = operand(rhs);
+
+    if(beta == T(0)) c = nullptr;
+
+    if constexpr (Traits::strided){
+        if(c != nullptr && !refersTo(*c, &dest)) assignElementwise(dest, *c);
+        utl::gemm(lhs.rows(), rhs.cols(), lhs.cols(), alpha,
+                  a.data, a.rowStride, a.colStride,
+                  b.data, b.rowStride, b.colStride,
+                  beta, dest.data(), Traits::rowStride(dest), Traits::colStride(dest));
+    }
+    else{
+        std::vector<T> result(dest.rows()*dest.cols());
+        if(c != nullptr){
+            const MatrixOperand<T> acc = operand(*c);
+            for(size_t j = 0; j < dest.cols(); ++j)
+                for(size_t i = 0; i < dest.rows(); ++i)
+                    result[i + j*dest.rows()] = acc.data[std::ptrdiff_t(i)*acc.rowStride + std::ptrdiff_t(j)*acc.colStride];
+        }
+        utl::gemm(lhs.rows(), rhs.cols(), lhs.cols(), alpha,
+                  a.data, a.rowStride, a.colStride,
+                  b.data, b.rowStride, b.colStride,
+                  beta, result.data(), 1, std::ptrdiff_t(dest.rows()));
+        Traits::fromColumnMajor(result.data(), dest);
+    }
+}
+
+}
+
+
+/*! \class MatrixExpressionIterator utl_matrix_expression.h "inc/utl_matrix_expression.h"
+  * \brief Random access iterator which evaluates an element-wise expression on dereferencing.
+  */
+template<class E>
+class MatrixExpressionIterator
+{
+public:
+    typedef std::random_access_iterator_tag   iterator_category;
+    typedef typename E::value_type            value_type;
+    typedef std::ptrdiff_t                    difference_type;
+    typedef const value_type*                 pointer;
+    typedef value_type                        reference;
+
+    MatrixExpressionIterator() : _expression(nullptr), _index(0) {}
+    MatrixExpressionIterator(const E* expression, difference_type index) : _expression(expression), _index(index) {}
+
+    value_type operator*() const { return (*_expression)[size_t(_index)]; }
+    value_type operator[](difference_type n) const { return (*_expression)[size_t(_index + n)]; }
+
+    MatrixExpressionIterator& operator++() { ++_index; return *this; }
+    MatrixExpressionIterator& operator--() { --_index; return *this; }
+    MatrixExpressionIterator operator++(int) { MatrixExpressionIterator it = *this; ++_index; return it; }
+    MatrixExpressionIterator operator--(int) { MatrixExpressionIterator it = *this; --_index; return it; }
+    MatrixExpressionIterator& operator+=(difference_type n) { _index += n; return *this; }
+    MatrixExpressionIterator& operator-=(difference_type n) { _index -= n; return *this; }
+    MatrixExpressionIterator operator+(difference_type n) const { return MatrixExpressionIterator(_expression, _index + n); }
+    MatrixExpressionIterator operator-(difference_type n) const { return MatrixExpressionIterator(_expression, _index - n); }
+    friend MatrixExpressionIterator operator+(difference_type n, const MatrixExpressionIterator& it) { return it + n; }
+    difference_type operator-(const MatrixExpressionIterator& it) const { return _index - it._index; }
+
+    bool operator==(const MatrixExpressionIterator& it) const { return _index == it._index; }
+    bool operator!=(const MatrixExpressionIterator& it) const { return _index != it._index; }
+    bool operator< (const MatrixExpressionIterator& it) const { return _index <  it._index; }
+    bool operator> (const MatrixExpressionIterator& it) const { return _index >  it._index; }
+    bool operator<=(const MatrixExpressionIterator& it) const { return _index <= it._index; }
+    bool operator>=(const MatrixExpressionIterator& it) const { return _index >= it._index; }
+
+private:
+    const E* _expression;
+    difference_type _index;
+};
+
+
+/*! \class MatrixElementwiseExpression utl_matrix_expression.h "inc/utl_matrix_expression.h"
+  * \brief Common interface of the element-wise expression nodes.
+  *
+  * Element-wise expressions are evaluated lazily. An element is computed when it is accessed,
+  * so a chain of operations is traversed once when it is assigned to a matrix.
+  */
+template<class Derived>
+class MatrixElementwiseExpression : public MatrixExpressionNode
+{
+public:
+    size_t rows() const { return derived().rowPrototype().rows(); }
+    size_t cols() const { return derived().rowPrototype().cols(); }
+    size_t size() const { return rows()*cols(); }
+    std::pair<size_t,size_t> dim() const { return std::make_pair(rows(),cols()); }
+
+    MatrixExpressionIterator<Derived> begin() const { return MatrixExpressionIterator<Derived>(&derived(), 0); }
+    MatrixExpressionIterator<Derived> end() const { return MatrixExpressionIterator<Derived>(&derived(), std::ptrdiff_t(size())); }
+
+private:
+    const Derived& derived() const { return static_cast<const Derived&>(*this); }
+};
+
+
+/*! \brief Element-wise combination op(lhs, rhs) of two matrix expressions of the same layout. */
+template<class Op, class L, class R>
+class MatrixBinaryExpression : public MatrixElementwiseExpression<MatrixBinaryExpression<Op,L,R> >
+{
+public:
+    typedef typename std::decay<L>::type::value_type value_type;
+
+    MatrixBinaryExpression(L&& lhs, R&& rhs, Op op = Op()) : _lhs(std::forward<L>(lhs)), _rhs(std::forward<R>(rhs)), _op(op)
+    {
+        static_assert(std::is_same<detail::ResultOf<L>, detail::ResultOf<R> >::value, "Element-wise operations require matrices of the same type and layout");
+        TRUE_ASSERT(_lhs.rows() == _rhs.rows() && _lhs.cols() == _rhs.cols(), "Dimensions must be equal");
+    }
+
+    value_type operator[](size_t index) const { return _op(_lhs[index], _rhs[index]); }
+
+    decltype(auto) rowPrototype() const { return detail::rowPrototype(_lhs); }
+    decltype(auto) colPrototype() const { return detail::colPrototype(_lhs); }
+
+    bool refersTo(const void* p) const { return detail::refersTo(_lhs, p) || detail::refersTo(_rhs, p); }
+
+private:
+    L _lhs;
+    R _rhs;
+    Op _op;
+};
+
+
+/*! \brief Element-wise application of a unary function object f(e). */
+template<class F, class E>
+class MatrixUnaryExpression : public MatrixElementwiseExpression<MatrixUnaryExpression<F,E> >
+{
+public:
+    typedef typename std::decay<E>::type::value_type value_type;
+
+    MatrixUnaryExpression(E&& e, F f) : _expression(std::forward<E>(e)), _f(f) {}
+
+    value_type operator[](size_t index) const { return _f(_expression[index]); }
+
+    decltype(auto) rowPrototype() const { return detail::rowPrototype(_expression); }
+    decltype(auto) colPrototype() const { return detail::colPrototype(_expression); }
+
+    bool refersTo(const void* p) const { return detail::refersTo(_expression, p); }
+
+private:
+    E _expression;
+    F _f;
+};
+
+
+/*! \brief Expression scalar * e which is kept separately so that it can be folded into a GEMM. */
+template<class E>
+class MatrixScaledExpression : public MatrixElementwiseExpression<MatrixScaledExpression<E> >
+{
+public:
+    typedef typename std::decay<E>::type::value_type value_type;
+    typedef E expression_type;
+
+    MatrixScaledExpression(value_type scalar, E&& e) : _scalar(scalar), _expression(std::forward<E>(e)) {}
+
+    value_type operator[](size_t index) const { return _scalar * _expression[index]; }
+
+    value_type scalar() const { return _scalar; }
+    const typename std::decay<E>::type& expression() const { return _expression; }
+    E&& release() { return std::forward<E>(_expression); }
+
+    decltype(auto) rowPrototype() const { return detail::rowPrototype(_expression); }
+    decltype(auto) colPrototype() const { return detail::colPrototype(_expression); }
+
+    bool refersTo(const void* p) const { return detail::refersTo(_expression, p); }
+
+private:
+    value_type _scalar;
+    E _expression;
+};
+
+
+/*! \brief Lazy product alpha * lhs * rhs. It is evaluated by a single utl::gemm call when assigned. */
+template<class L, class R>
+class MatrixProductExpression : public MatrixProductNode
+{
+public:
+    typedef typename std::decay<L>::type::value_type value_type;
+
+    MatrixProductExpression(value_type alpha, L&& lhs, R&& rhs) : _alpha(alpha), _lhs(std::forward<L>(lhs)), _rhs(std::forward<R>(rhs))
+    {
+        TRUE_ASSERT(_lhs.cols() == _rhs.rows(), "LhsMatrix.cols() != RhsMatrix.rows()");
+    }
+
+    size_t rows() const { return _lhs.rows(); }
+    size_t cols() const { return _rhs.cols(); }
+
+    value_type alpha() const { return _alpha; }
+    void scale(value_type s) { _alpha *= s; }
+
+    decltype(auto) rowPrototype() const { return detail::rowPrototype(_lhs); }
+    decltype(auto) colPrototype() const { return detail::colPrototype(_rhs); }
+
+    bool refersTo(const void* p) const { return detail::refersTo(_lhs, p) || detail::refersTo(_rhs, p); }
+
+    template<class D, class C>
+    void evaluateTo(D& dest, value_type beta, const C* c) const { detail::gemmAssign(dest, _alpha, _lhs, _rhs, beta, c); }
+
+    template<class D>
+    void evaluateTo(D& dest) const { evaluateTo(dest, value_type(0), static_cast<const D*>(nullptr)); }
+
+private:
+    value_type _alpha;
+    L _lhs;
+    R _rhs;
+};
+
+
+/*! \brief Lazy GEMM product + beta * c, e.g. alpha * lhs * rhs + beta * c. The shape is taken from c. */
+template<class P, class C>
+class MatrixGemmExpression : public MatrixProductNode
+{
+public:
+    typedef typename std::decay<P>::type::value_type value_type;
+
+    MatrixGemmExpression(P&& product, value_type beta, C&& c) : _product(std::forward<P>(product)), _beta(beta), _c(std::forward<C>(c))
+    {
+        TRUE_ASSERT(_product.rows() == _c.rows() && _product.cols() == _c.cols(), "Dimensions must be equal");
+    }
+
+    size_t rows() const { return _c.rows(); }
+    size_t cols() const { return _c.cols(); }
+
+    decltype(auto) rowPrototype() const { return detail::rowPrototype(_c); }
+    decltype(auto) colPrototype() const { return detail::colPrototype(_c); }
+
+    bool refersTo(const void* p) const { return _product.refersTo(p) || detail::refersTo(_c, p); }
+
+    template<class D>
+    void evaluateTo(D& dest) const { _product.evaluateTo(dest, _beta, &_c); }
+
+private:
+    P _product;
+    value_type _beta;
+    C _c;
+};
+
+
+namespace detail {
+
+template<class E>
+bool refersTo(const E& e, const void* p)
+{
+    if constexpr (isMatrixExpressionNode<E>::value) return e.refersTo(p);
+    else return static_cast<const void*>(&e) == p;
+}
+
+template<class E>
+ResultOf<E> evaluate(const E& e)
+{
+    typedef ResultOf<E> Result;
+    Result result = MatrixTraits<Result>::create(rowPrototype(e), colPrototype(e));
+    if constexpr (isMatrixProduct<E>::value) e.evaluateTo(result);
+    else assignElementwise(result, e);
+    return result;
+}
+
+/// Functor op(x, value) for operations with a scalar on the right hand side.
+template<class T, class Op>
+struct BindScalarRight
+{
+    T value; Op op;
+    T operator()(const T& x) const { return op(x, value); }
+};
+
+/// Functor op(value, x) for operations with a scalar on the left hand side.
+template<class T, class Op>
+struct BindScalarLeft
+{
+    T value; Op op;
+    T operator()(const T& x) const { return op(value, x); }
+};
+
+template<class E>
+struct isScaled : std::false_type { };
+
+template<class E>
+struct isScaled<MatrixScaledExpression<E> > : std::true_type { };
+
+template<class E>
+struct isProduct : std::false_type { };
+
+template<class L, class R>
+struct isProduct<MatrixProductExpression<L,R> > : std::true_type { };
+
+template<bool Condition>
+using Requires = typename std::enable_if<Condition, int>::type;
+
+/// A product combined with an element-wise expression is folded into a GEMM.
+template<class P, class C>
+constexpr bool gemmPair() { return isProduct<typename std::decay<P>::type>::value && isElementwiseExpression<C>::value; }
+
+/// Everything else is combined element by element, products are evaluated beforehand.
+template<class L, class R>
+constexpr bool elementwisePair() { return isMatrixExpression<L>::value && isMatrixExpression<R>::value && !gemmPair<L,R>() && !gemmPair<R,L>(); }
+
+template<class E>
+constexpr bool elementwise() { return isElementwiseExpression<E>::value; }
+
+/// Splits a (possibly scaled) operand into its scalar factor and the unscaled expression.
+template<class E>
+auto unscaled(E&& e)
+{
+    typedef typename std::decay<E>::type Expression;
+    if constexpr (isScaled<Expression>::value){
+        typedef typename Expression::expression_type Inner;
+        typedef Forwarded<typename std::conditional<std::is_lvalue_reference<E>::value, const typename std::decay<Inner>::type&, Inner>::type> Result;
+        if constexpr (std::is_lvalue_reference<E>::value) return std::pair<typename Expression::value_type, Result>(e.scalar(), e.expression());
+        else return std::pair<typename Expression::value_type, Result>(e.scalar(), e.release());
+    }
+    else
+        return std::pair<typename Expression::value_type, Forwarded<E> >(typename Expression::value_type(1), std::forward<E>(e));
+}
+
+template<class P, class C>
+auto makeGemm(P&& product, typename std::decay<P>::type::value_type sign, C&& c)
+{
+    auto acc = unscaled(std::forward<C>(c));
+    typedef decltype(acc.second) Acc;
+    return MatrixGemmExpression<Forwarded<P>, Acc>(std::forward<P>(product), sign*acc.first, std::forward<Acc>(acc.second));
+}
+
+}
+
+
+/*! \brief Element-wise sum of two matrices or expressions. */
+template<class L, class R, detail::Requires<detail::elementwisePair<L,R>()> = 0>
+auto operator+(L&& lhs, R&& rhs)
+{
+    typedef typename std::decay<L>::type::value_type T;
+    return MatrixBinaryExpression<std::plus<T>, detail::Operand<L>, detail::Operand<R> >(std::forward<L>(lhs), std::forward<R>(rhs));
+}
+
+/*! \brief Element-wise difference of two matrices or expressions. */
+template<class L, class R, detail::Requires<detail::elementwisePair<L,R>()> = 0>
+auto operator-(L&& lhs, R&& rhs)
+{
+    typedef typename std::decay<L>::type::value_type T;
+    return MatrixBinaryExpression<std::minus<T>, detail::Operand<L>, detail::Operand<R> >(std::forward<L>(lhs), std::forward<R>(rhs));
+}
+
+/*! \brief alpha * lhs * rhs + beta * c maps to a single GEMM. */
+template<class P, class C, detail::Requires<detail::gemmPair<P,C>()> = 0>
+auto operator+(P&& product, C&& c) { return detail::makeGemm(std::forward<P>(product), 1, std::forward<C>(c)); }
+
+/*! \brief beta * c + alpha * lhs * rhs maps to a single GEMM. */
+template<class C, class P, detail::Requires<detail::gemmPair<P,C>()> = 0>
+auto operator+(C&& c, P&& product) { return detail::makeGemm(std::forward<P>(product), 1, std::forward<C>(c)); }
+
+/*! \brief alpha * lhs * rhs - beta * c maps to a single GEMM. */
+template<class P, class C, detail::Requires<detail::gemmPair<P,C>()> = 0>
+auto operator-(P&& product, C&& c) { return detail::makeGemm(std::forward<P>(product), -1, std::forward<C>(c)); }
+
+/*! \brief beta * c - alpha * lhs * rhs maps to a single GEMM. */
+template<class C, class P, detail::Requires<detail::gemmPair<P,C>()> = 0>
+auto operator-(C&& c, P&& product)
+{
+    typename std::decay<P>::type negated = std::forward<P>(product);
+    negated.scale(-1);
+    return detail::makeGemm(std::move(negated), 1, std::forward<C>(c));
+}
+
+/*! \brief Matrix product. Scalar factors of both operands are folded into alpha. */
+template<class L, class R, detail::Requires<isMatrixExpression<L>::value && isMatrixExpression<R>::value> = 0>
+auto operator*(L&& lhs, R&& rhs)
+{
+    auto l = detail::unscaled(std::forward<L>(lhs));
+    auto r = detail::unscaled(std::forward<R>(rhs));
+    typedef decltype(l.second) Lhs;
+    typedef decltype(r.second) Rhs;
+    typedef detail::Operand<Lhs> LhsOperand;
+    typedef detail::Operand<Rhs> RhsOperand;
+    return MatrixProductExpression<LhsOperand, RhsOperand>(l.first*r.first, std::forward<Lhs>(l.second), std::forward<Rhs>(r.second));
+}
+
+/*! \brief Multiplies every element of a matrix or an expression with value. */
+template<class E, detail::Requires<detail::elementwise<E>()> = 0>
+auto operator*(E&& e, typename std::decay<E>::type::value_type value)
+{
+    auto s = detail::unscaled(std::forward<E>(e));
+    typedef decltype(s.second) Inner;
+    return MatrixScaledExpression<Inner>(s.first*value, std::forward<Inner>(s.second));
+}
+
+/*! \brief Multiplies every element of a matrix or an expression with value. */
+template<class E, detail::Requires<detail::elementwise<E>()> = 0>
+auto operator*(typename std::decay<E>::type::value_type value, E&& e) { return std::forward<E>(e) * value; }
+
+/*! \brief Scales a lazy product, the factor is folded into alpha. */
+template<class P, detail::Requires<detail::isProduct<typename std::decay<P>::type>::value> = 0>
+auto operator*(P&& product, typename std::decay<P>::type::value_type value)
+{
+    typename std::decay<P>::type scaled = std::forward<P>(product);
+    scaled.scale(value);
+    return scaled;
+}
+
+/*! \brief Scales a lazy product, the factor is folded into alpha. */
+template<class P, detail::Requires<detail::isProduct<typename std::decay<P>::type>::value> = 0>
+auto operator*(typename std::decay<P>::type::value_type value, P&& product) { return std::forward<P>(product) * value; }
+
+/*! \brief Divides every element of a matrix or an expression by value. */
+template<class E, detail::Requires<detail::elementwise<E>()> = 0>
+auto operator/(E&& e, typename std::decay<E>::type::value_type value)
+{
+    typedef typename std::decay<E>::type::value_type T;
+    typedef detail::BindScalarRight<T, std::divides<T> > F;
+    return MatrixUnaryExpression<F, detail::Forwarded<E> >(std::forward<E>(e), F{value, std::divides<T>()});
+}
+
+/*! \brief Adds value to every element of a matrix or an expression. */
+template<class E, detail::Requires<detail::elementwise<E>()> = 0>
+auto operator+(E&& e, typename std::decay<E>::type::value_type value)
+{
+    typedef typename std::decay<E>::type::value_type T;
+    typedef detail::BindScalarRight<T, std::plus<T> > F;
+    return MatrixUnaryExpression<F, detail::Forwarded<E> >(std::forward<E>(e), F{value, std::plus<T>()});
+}
+
+/*! \brief Adds value to every element of a matrix or an expression. */
+template<class E, detail::Requires<detail::elementwise<E>()> = 0>
+auto operator+(typename std::decay<E>::type::value_type value, E&& e) { return std::forward<E>(e) + value; }
+
+/*! \brief Subtracts value from every element of a matrix or an expression. */
+template<class E, detail::Requires<detail::elementwise<E>()> = 0>
+auto operator-(E&& e, typename std::decay<E>::type::value_type value)
+{
+    typedef typename std::decay<E>::type::value_type T;
+    typedef detail::BindScalarRight<T, std::minus<T> > F;
+    return MatrixUnaryExpression<F, detail::Forwarded<E> >(std::forward<E>(e), F{value, std::minus<T>()});
+}
+
+/*! \brief Subtracts every element of a matrix or an expression from value. */
+template<class E, detail::Requires<detail::elementwise<E>()> = 0>
+auto operator-(typename std::decay<E>::type::value_type value, E&& e)
+{
+    typedef typename std::decay<E>::type::value_type T;
+    typedef detail::BindScalarLeft<T, std::minus<T> > F;
+    return MatrixUnaryExpression<F, detail::Forwarded<E> >(std::forward<E>(e), F{value, std::minus<T>()});
+}
+
+/*! \brief Negates every element of a matrix or an expression. */
+template<class E, detail::Requires<detail::elementwise<E>()> = 0>
+auto operator-(E&& e)
+{
+    typedef typename std::decay<E>::type::value_type T;
+    return MatrixUnaryExpression<std::negate<T>, detail::Forwarded<E> >(std::forward<E>(e), std::negate<T>());
+}
+
+/*! \brief Negates a lazy product, -1 is folded into alpha, so -(lhs * rhs) + c maps to a single GEMM. */
+template<class P, detail::Requires<detail::isProduct<typename std::decay<P>::type>::value> = 0>
+auto operator-(P&& product) { return std::forward<P>(product) * typename std::decay<P>::type::value_type(-1); }
+
+/*! \brief Compares an expression element by element with a matrix or another expression. */
+template<class L, class R, detail::Requires<detail::elementwise<L>() && detail::elementwise<R>() &&
+                                            (isMatrixExpressionNode<L>::value || isMatrixExpressionNode<R>::value)> = 0>
+bool operator==(const L& lhs, const R& rhs)
+{
+    if(lhs.rows() != rhs.rows() || lhs.cols() != rhs.cols()) return false;
+    for(size_t i = 0, size = lhs.size(); i < size; ++i)
+        if(!(lhs[i] == rhs[i])) return false;
+    return true;
+}
+
+}
+#endif
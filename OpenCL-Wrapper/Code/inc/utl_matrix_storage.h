@@ -0,0 +1,173 @@
+//Copyright (C) 2013 Cem Bassoy.
+//
+//This file is part of the OpenCL Utility Toolkit.
+//
+//OpenCL Utility Toolkit is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+//
+//OpenCL Utility Toolkit is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License
+//along with OpenCL Utility Toolkit.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef UTL_MATRIX_STORAGE_H
+#define UTL_MATRIX_STORAGE_H
+
+#include <cstddef>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+
+#include <utl_assert.h>
+#include <utl_allocator.h>
+
+namespace utl{
+
+/*! \class MatrixStorage utl_matrix_storage.h "inc/utl_matrix_storage.h"
+  * \brief Contiguous element storage of the matrices.
+  *
+  * The storage either owns its memory, which is then obtained from the allocator Alloc,
+  * or refers to external memory, e.g. a mapped ocl::Buffer or a memory mapped file, which
+  * is neither allocated nor released by the storage. External memory cannot be resized.
+  * Copying a storage always creates an owning deep copy, assigning a storage of the same
+  * size copies the elements into the existing memory. Assignments to external memory,
+  * including move assignments, always write into that memory.
+  */
+template<class T, class Alloc = std::allocator<T> >
+class MatrixStorage
+{
+    typedef std::allocator_traits<Alloc> Traits;
+
+public:
+    typedef T                 value_type;
+    typedef Alloc             allocator_type;
+    typedef T*                pointer;
+    typedef const T*          const_pointer;
+    typedef T&                reference;
+    typedef const T&          const_reference;
+    typedef T*                iterator;
+    typedef const T*          const_iterator;
+
+    MatrixStorage() noexcept : _data(nullptr), _size(0), _owner(true) {}
+
+    explicit MatrixStorage(size_t size, const Alloc& alloc = Alloc()) : MatrixStorage(size, value_type(), alloc) {}
+
+    MatrixStorage(size_t size, const_reference value, const Alloc& alloc = Alloc()) :
+        _alloc(alloc), _data(allocate(size)), _size(size), _owner(true)
+    {
+        std::uninitialized_fill_n(_data, _size, value);
+    }
+
+    MatrixStorage(const MatrixStorage& s) :
+        _alloc(Traits::select_on_container_copy_construction(s._alloc)), _data(allocate(s._size)), _size(s._size), _owner(true)
+    {
+        std::uninitialized_copy(s.begin(), s.end(), _data);
+    }
+
+    MatrixStorage(MatrixStorage&& s) noexcept :
+        _alloc(std::move(s._alloc)), _data(s._data), _size(s._size), _owner(s._owner)
+    {
+        s._data = nullptr; s._size = 0; s._owner = true;
+    }
+
+    ~MatrixStorage() { release(); }
+
+    MatrixStorage& operator = (const MatrixStorage& s)
+    {
+        if(this == &s) return *this;
+        if(_size == s._size){
+            std::copy(s.begin(), s.end(), _data);
+            return *this;
+        }
+        TRUE_ASSERT(_owner, "External memory of size " << _size << " cannot hold " << s._size << " elements");
+        MatrixStorage copy(s);
+        this->swap(copy);
+        return *this;
+    }
+
+    MatrixStorage& operator = (MatrixStorage&& s)
+    {
+        if(this == &s) return *this;
+        if(!_owner) return *this = static_cast<const MatrixStorage&>(s);
+        release();
+        _alloc = std::move(s._alloc); _data = s._data; _size = s._size; _owner = s._owner;
+        s._data = nullptr; s._size = 0; s._owner = true;
+        return *this;
+    }
+
+    /*! \brief Returns a storage which refers to size elements at data without taking ownership. */
+    static MatrixStorage wrap(pointer data, size_t size)
+    {
+        MatrixStorage s;
+        s._data = data; s._size = size; s._owner = false;
+        return s;
+    }
+
+    void swap(MatrixStorage& s) noexcept
+    {
+        using std::swap;
+        swap(_alloc, s._alloc); swap(_data, s._data); swap(_size, s._size); swap(_owner, s._owner);
+    }
+
+    void resize(size_t size, const_reference value = value_type())
+    {
+        if(size == _size) return;
+        TRUE_ASSERT(_owner, "External memory cannot be resized");
+        MatrixStorage s(size, value, _alloc);
+        std::copy_n(this->begin(), std::min(size, _size), s.begin());
+        this->swap(s);
+    }
+
+    bool owner() const { return _owner; }
+    allocator_type get_allocator() const { return _alloc; }
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    pointer data() { return _data; }
+    const_pointer data() const { return _data; }
+
+    iterator begin() { return _data; }
+    iterator end() { return _data + _size; }
+    const_iterator begin() const { return _data; }
+    const_iterator end() const { return _data + _size; }
+
+    reference operator[](size_t index) { return _data[index]; }
+    const_reference operator[](size_t index) const { return _data[index]; }
+
+    reference at(size_t index) { check(index); return _data[index]; }
+    const_reference at(size_t index) const { check(index); return _data[index]; }
+
+    reference front() { return _data[0]; }
+    const_reference front() const { return _data[0]; }
+    reference back() { return _data[_size-1]; }
+    const_reference back() const { return _data[_size-1]; }
+
+private:
+
+    pointer allocate(size_t size) { return size == 0 ? nullptr : Traits::allocate(_alloc, size); }
+
+    void release()
+    {
+        if(!_owner || _data == nullptr) return;
+        std::for_each(_data, _data + _size, [](reference v){ v.~value_type(); });
+        Traits::deallocate(_alloc, _data, _size);
+        _data = nullptr;
+        _size = 0;
+    }
+
+    void check(size_t index) const { if(index >= _size) throw std::out_of_range("utl::MatrixStorage::at"); }
+
+    Alloc _alloc;
+    pointer _data;
+    size_t _size;
+    bool _owner;
+};
+
+}
+#endif
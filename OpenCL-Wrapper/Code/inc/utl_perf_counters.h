@@ -0,0 +1,75 @@
+//Copyright (C) 2013 Cem Bassoy.
+//
+//This file is part of the OpenCL Utility Toolkit.
+//
+//OpenCL Utility Toolkit is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+//
+//OpenCL Utility Toolkit is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License
+//along with OpenCL Utility Toolkit.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef UTL_PERF_COUNTERS_H
+#define UTL_PERF_COUNTERS_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace utl{
+
+/*! \class PerfCounters utl_perf_counters.h "inc/utl_perf_counters.h"
+  * \brief Hardware performance counters of the whole process.
+  *
+  * The counters are opened with perf_event_open on Linux for every thread of the
+  * process, including the worker threads of a CPU OpenCL runtime. Threads which are
+  * created later are attached when the counters are read the next time, the events of
+  * threads which have exited are closed then and their final counts are kept. Only user
+  * space is counted, which is allowed with the default perf_event_paranoid level.
+  *
+  * The collected events are cycles, instructions, last level cache misses, data TLB
+  * misses and, on Intel CPUs, retired packed floating point instructions. Events which
+  * the CPU, the kernel or a virtual machine do not provide are left out. On other
+  * systems no counters are available.
+  *
+  * read returns the accumulated counts, so the counts of a region are the difference
+  * of two reads. Counts are scaled if the kernel multiplexes the counters.
+  */
+class PerfCounters
+{
+public:
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const { return !_events.empty(); }
+    const std::vector<std::string>& names() const { return _names; }
+
+    std::vector<double> read();
+
+private:
+    struct Event
+    {
+        std::uint32_t type;
+        std::uint64_t config;
+    };
+
+    void attach();
+
+    std::vector<Event> _events;
+    std::vector<std::string> _names;
+    std::map<int, std::vector<int> > _fds; /*!< File descriptors of the events per thread */
+    std::vector<double> _exited;           /*!< Counts of the threads which have exited */
+};
+
+}
+#endif
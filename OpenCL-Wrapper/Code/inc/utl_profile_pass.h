@@ -25,10 +25,23 @@
 #include <string>
 #include <vector>
 #include <chrono>
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <memory>
+#include <cmath>
+#include <map>
+#include <set>
+#include <random>
+#include <iterator>
 
 #include <utl_stream.h>
 #include <utl_dim.h>
 #include <utl_timer.h>
+#include <utl_statistics.h>
+#include <utl_profile_report.h>
+#include <utl_perf_counters.h>
+#include <utl_assert.h>
 
 
 
@@ -42,6 +55,22 @@ namespace utl{
   * Objects from inherited classes of ProfilePass can be stored in a
   * ProfilePassManager object which runs all ProfilePass functions.
   * Inhertied objects need to implement the prof and ops functions.
+  *
+  * prof returns the runtime in seconds. The runtime of one iteration should be taken with measure or call.
+  * They run warmup iterations first and then repeat the iteration at least _iter
+  * times until the confidence interval of the mean runtime is narrow enough or
+  * _maxIter samples are taken. The samples and their Statistics are stored for
+  * each problem size.
+  *
+  * The problem sizes lie on the grid start + k*step up to end. By default all of
+  * them are measured. A geometric sweep only measures sizes which grow by a
+  * constant factor, a random sweep draws log-uniformly distributed sizes and an
+  * adaptive sweep bisects between neighbouring sizes of a geometric sweep whose
+  * performance differs strongly, e.g. at cache size transitions. Alternatively
+  * an explicit list of sizes can be given.
+  *
+  * Optionally hardware performance counters are read around the measured iterations
+  * and reported per iteration next to the runtimes.
   */
 
 template <class T>
@@ -49,8 +78,12 @@ class ProfilePass
 {
 
 public:
+	enum Sweep { Linear, Geometric, Explicit, Random, Adaptive };
+
 	ProfilePass(const std::string& str, const Dim& start, const Dim& step, const Dim& end, size_t __iter = 10) :
-        _name(str), _start(start), _step(step), _end(end), _iter(__iter), _print_n(true), _print_t(true), _print_o(true), _print_p(true) , _countUp(true)
+        _name(str), _start(start), _step(step), _end(end), _iter(__iter), _warmup(1), _maxIter(10*__iter), _precision(0.05), _confidence(0.95),
+        _print_n(true), _print_t(true), _print_o(true), _print_p(true), _print_s(true), _countUp(true),
+        _sweep(Linear), _factor(2.0), _threshold(0.1), _count(0), _seed(0)
 	{}
 	
 	using ValueType = T;
@@ -60,16 +93,45 @@ public:
 	ProfilePass(ProfilePass&&) = default;
   virtual ~ProfilePass(){}
 
+	/*! \brief Measures an iteration repeatedly and returns the median runtime in seconds.
+	  *
+	  * \param __sample executes one iteration and returns its runtime in seconds, e.g. taken from profiling events.
+	  */
+	template<class F>
+	double measure(F&& __sample)
+	{
+		for (size_t j = 0; j < _warmup; j++)
+			__sample();
+
+		const std::vector<double> begin = _counters ? _counters->read() : std::vector<double>();
+
+		std::vector<double> samples;
+		samples.reserve(_iter);
+
+		// the confidence interval is only checked after every quarter of new samples.
+		size_t check = std::max<size_t>(_iter, 2);
+		while (samples.size() < std::max(_iter, _maxIter)){
+			samples.push_back(double(__sample()));
+			if(samples.size() < check) continue;
+			if(Statistics(samples, _confidence).ciRelativeWidth() <= _precision) break;
+			check = samples.size() + std::max<size_t>(1, samples.size()/4);
+		}
+
+		if(_samples.empty()) _samples.emplace_back();
+		_samples.back().insert(_samples.back().end(), samples.begin(), samples.end());
+		if(_counters) addCounts(begin, _counters->read());
+		return Statistics(samples, _confidence).median();
+	}
+
+	/*! \brief Measures a function repeatedly on the host and returns the median runtime in seconds. */
 	template<class F>
 	double call(F&& __func)
 	{
-        utl::Timer::tic();
-		for (size_t j = 0; j < _iter; j++){
+		return measure([&__func]() {
+			const Clock::ticks start = Clock::now();
 			__func();
-            //std::cout << "Iter=" << _iter << ", cIter = " << j << std::endl;
-		}
-        utl::Timer::toc();
-        return utl::Timer::elapsed(_iter);
+			return Clock::seconds(Clock::now() - start);
+		});
 	}
 
 
@@ -79,43 +141,88 @@ public:
 
 	void run()
     {
-        //size_t j = 0;
+        switch(_sweep){
+            case Linear:
+                for(Dim i = _start; inRange(i); _countUp ? i += _step : i -= _step)
+                    this->profile(i);
+                break;
+            case Explicit:
+                for(const Dim& i : _sizeList)
+                    this->profile(i);
+                break;
+            case Geometric:
+            case Random:
+                for(long k : _sweep == Random ? randomSteps() : geometricSteps())
+                    this->profile(gridPoint(k));
+                break;
+            case Adaptive:
+                this->refine(geometricSteps());
+                break;
+        }
+	}
 
-    std::function<bool(const Dim&, const Dim&)> compare;
-    std::function<void(Dim&, const Dim&)> advance;
+    const std::vector<double> & dims()    const { return _elems; }
+	const std::vector<double> & times()   const { return _times; }
+	const std::vector<double> & ops()     const { return _ops; }
+	const std::vector<double> & perf()    const { return _perf; }
+	const std::vector<Statistics> & statistics()        const { return _stats; }
+	const std::vector<std::vector<double> > & samples() const { return _samples; }
+	const std::vector<std::vector<double> > & counts()  const { return _counts; }
 
-    if (_countUp) {
-      compare = [](const Dim& lhs, const Dim& rhs) { return (lhs < 1) == 0 && lhs <= rhs; };
-      advance = [](Dim& lhs, const Dim& rhs) { lhs += rhs; };
-    }
-    else {
-      compare = [](const Dim& lhs, const Dim& rhs) { return (lhs < 1) == 0 && lhs >= rhs; };
-      advance = [](Dim& lhs, const Dim& rhs) { lhs -= rhs; };
-    }
+	/*! \brief Returns the names of the hardware counters or nothing if they are disabled. */
+	std::vector<std::string> counterNames() const { return _counters ? _counters->names() : std::vector<std::string>(); }
+	const std::string &name()             const { return _name; }
+	const Metadata &metadata()            const { return _metadata; }
 
-        //for(Dim i = _start; i <= _end; i += _step, ++j)
-        for(Dim i = _start; compare(i, _end); advance(i,_step))
-        {
-    //TRUE_COMMENT("start : " << this->_start.toString() << ", _end : " << this->_end.toString() << ", _step = " << this->_step.toString() << ", i " << i.toString() << ", comp = "  << compare(i,_end));
+	/*! \brief Returns the results of all problem sizes for a ProfileReport. */
+	std::vector<ProfileRecord> records() const
+	{
+		std::vector<ProfileRecord> records;
+		for(size_t i = 0; i < _stats.size(); ++i){
+			ProfileRecord r;
+			r.pass = _name;
+			for(auto it = _sizes.at(i).begin(); it != _sizes.at(i).end(); ++it)
+				r.dim += (it == _sizes.at(i).begin() ? "" : "x") + std::to_string(*it);
+			r.elements = _elems.at(i);
+			r.ops      = _ops.at(i);
+			r.min      = _stats[i].min();
+			r.median   = _stats[i].median();
+			r.p95      = _stats[i].p95();
+			r.mean     = _stats[i].mean();
+			r.stddev   = _stats[i].stddev();
+			r.ciLow    = _stats[i].ciLow();
+			r.ciHigh   = _stats[i].ciHigh();
+			r.samples  = _stats[i].samples();
+			r.outliers = _stats[i].outliers();
+			r.times    = _samples.at(i);
+			for(size_t c = 0; c < _counts.at(i).size() && _counters; ++c)
+				r.counters[_counters->names().at(c)] = _counts[i][c];
+			records.push_back(r);
+		}
+		return records;
+	}
 
-            double time = this->prof(i); // seconds
-            double op = this->ops(i);
-			double perf = double(op)  / time;
+    /*! \brief Measures all sizes from start to end. */
+    void setLinearSweep() { _sweep = Linear; }
 
-            this->_elems.push_back(i.prod());
-            this->_times.push_back(time) ;
-            this->_ops.push_back(op) ; // 2 * n^2 + n
-            this->_perf.push_back(perf);
-		}
+    /*! \brief Measures the sizes on the grid which grow by factor, always including the first and the last one. */
+    void setGeometricSweep(double factor = 2.0) { _sweep = Geometric; _factor = factor; }
 
-	}
+    /*! \brief Measures exactly the given sizes. */
+    void setSweep(const std::vector<Dim>& sizes) { _sweep = Explicit; _sizeList = sizes; }
 
+    /*! \brief Measures count sizes on the grid drawn log-uniformly with a fixed seed. */
+    void setRandomSweep(size_t count, unsigned seed = 0) { _sweep = Random; _count = count; _seed = seed; }
 
-    const std::vector<double> & dims()    const { return _elems; }
-	const std::vector<double> & times()   const { return _times; }
-	const std::vector<double> & ops()     const { return _ops; }
-	const std::vector<double> & perf()    const { return _perf; }
-	const std::string &name()             const { return _name; }
+    /*! \brief Refines a geometric sweep by bisection.
+      *
+      * Neighbouring sizes whose performance differs by more than threshold relative to
+      * the larger one are bisected on the grid until at most maxSizes sizes are measured.
+      */
+    void setAdaptiveSweep(double threshold = 0.1, size_t maxSizes = 64, double factor = 2.0)
+    {
+        _sweep = Adaptive; _threshold = threshold; _count = maxSizes; _factor = factor;
+    }
 
     void setCountUp()   { this->_countUp = true; }
     void setCountDown() { this->_countUp = false; }
@@ -128,8 +235,34 @@ public:
         _print_p = print_p;
     }
 
+    void setPrintStatistics(bool print_s) { _print_s = print_s; }
+
+    /*! \brief Enables or disables the hardware performance counters. */
+    void setCounters(bool enable)
+    {
+        _counters.reset(enable ? new PerfCounters() : nullptr);
+        TRUE_WARNING(!enable || _counters->available(), "No hardware performance counters available for " << _name);
+    }
+
+    void setMetadata(const std::string& key, const std::string& value) { _metadata[key] = value; }
+
+    /*! \brief Describes the device the pass runs on, e.g. an ocl::Device. */
+    template<class D>
+    void setDevice(const D& device)
+    {
+        setMetadata("device", device.name());
+        setMetadata("device_vendor", device.vendor());
+        setMetadata("device_version", device.version());
+        setMetadata("driver_version", device.driverVersion());
+    }
+
     void setName(const std::string& n)  { _name = n; }
     void setIter(size_t iter) { this->_iter = iter; }
+    void setMaxIter(size_t iter) { this->_maxIter = iter; }
+    void setWarmup(size_t warmup) { this->_warmup = warmup; }
+
+    /*! \brief Sets the width of the confidence interval relative to the mean at which the measurement stops. */
+    void setPrecision(double relativeWidth, double confidence = 0.95) { this->_precision = relativeWidth; this->_confidence = confidence; }
 
 	template<class E>
 	std::string toString(const std::vector<E> &v) const
@@ -150,6 +283,23 @@ public:
 	}
 
 
+	/*! \brief Returns one row [min,median,p95,mean,stddev,ciLow,ciHigh,samples,outliers] per problem size. */
+	std::string toString(const std::vector<Statistics> &v) const
+	{
+		std::ostringstream oss;
+		oss.precision( std::numeric_limits< double >::digits10 );
+		oss << std::scientific << '[';
+		for ( size_t i = 0; i < v.size(); ++i )
+		{
+			const Statistics &s = v.at(i);
+			oss << (i == 0 ? "" : ";") << s.min() << ',' << s.median() << ',' << s.p95() << ',' << s.mean() << ',' << s.stddev() << ','
+			    << s.ciLow() << ',' << s.ciHigh() << ',' << double(s.samples()) << ',' << double(s.outliers());
+		}
+		oss << "];";
+		return oss.str();
+	}
+
+
 	friend std::ostream& operator <<(std::ostream &out, const ProfilePass<T> *_p)
 	{
 		out.precision(std::numeric_limits< double >::digits10);
@@ -158,22 +308,214 @@ public:
         if(_p->_print_o) out << _p->name() << "_o = " << _p->toString<double>(_p->ops())   << std::endl;
 		if(_p->_print_t) out << _p->name() << "_t = " << _p->toString<double>(_p->times()) << std::endl;
         if(_p->_print_p) out << _p->name() << "_p = " << _p->toString<double>(_p->perf())  << std::endl;
+        if(_p->_print_s) out << _p->name() << "_s = " << _p->toString(_p->statistics()) << std::endl;
+        if(_p->_counters && _p->_counters->available()){
+            out << _p->name() << "_cn = {";
+            for(size_t c = 0; c < _p->_counters->names().size(); ++c) out << (c == 0 ? "'" : ",'") << _p->_counters->names()[c] << "'";
+            out << "};" << std::endl;
+            out << _p->name() << "_c = [";
+            for(size_t i = 0; i < _p->counts().size(); ++i)
+                for(size_t c = 0; c < _p->counts()[i].size(); ++c)
+                    out << (c == 0 ? (i == 0 ? "" : ";") : ",") << _p->counts()[i][c];
+            out << "];" << std::endl;
+        }
 		return out;
 	}
 
 protected:
+
+	/*! \brief Measures one problem size and stores its results. */
+	void profile(const Dim& i)
+	{
+        this->_samples.emplace_back();
+        this->_counts.emplace_back();
+
+        const std::vector<double> begin = _counters ? _counters->read() : std::vector<double>();
+        double time = this->prof(i); // seconds
+        double op = this->ops(i);
+
+        // prof did not use measure or call, so its result is the only sample.
+        if(this->_samples.back().empty()){
+            this->_samples.back().push_back(time);
+            if(_counters) addCounts(begin, _counters->read());
+        }
+
+        // counts per iteration
+        for(double& c : this->_counts.back()) c /= double(this->_samples.back().size());
+        this->_stats.emplace_back(this->_samples.back(), _confidence);
+        double perf = double(op)  / time;
+
+        this->_sizes.push_back(i);
+        this->_elems.push_back(i.prod());
+        this->_times.push_back(time) ;
+        this->_ops.push_back(op) ; // 2 * n^2 + n
+        this->_perf.push_back(perf);
+	}
+
+	bool inRange(const Dim& i) const
+	{
+        return _countUp ? (i < 1) == 0 && i <= _end : (i < 1) == 0 && i >= _end;
+	}
+
+	/*! \brief Returns the k-th size of the grid. */
+	Dim gridPoint(long k) const
+	{
+        Dim i(_start);
+        for(size_t c = 0; c < i.size() && c < _step.size(); ++c)
+            i[c] = int(_countUp ? _start[c] + k*_step[c] : _start[c] - k*_step[c]);
+        return i;
+	}
+
+	/*! \brief Returns the index of the last size of the grid or -1 if the grid is empty. */
+	long lastStep() const
+	{
+        if(!inRange(_start)) return -1;
+
+        long last = std::numeric_limits<long>::max();
+        for(size_t c = 0; c < _start.size() && c < _step.size() && c < _end.size(); ++c){
+            if(_step[c] <= 0) continue;
+            const long distance = _countUp ? long(_end[c]) - _start[c] : long(_start[c]) - std::max(_end[c], 1);
+            last = std::min(last, distance < 0 ? -1 : distance/_step[c]);
+        }
+        if(last == std::numeric_limits<long>::max()) return 0;
+
+        while(last > 0 && !inRange(gridPoint(last))) --last;
+        return last;
+	}
+
+	/*! \brief Returns the first dimension which changes along the grid. */
+	size_t leading() const
+	{
+        size_t c = 0;
+        while(c < _start.size() && c < _step.size() && _step[c] <= 0) ++c;
+        return c;
+	}
+
+	/*! \brief Returns the extent of the leading dimension at step k. */
+	double magnitude(long k) const
+	{
+        const size_t c = leading();
+        return c < _start.size() && c < _step.size() ? std::max(1.0, double(gridPoint(k)[c])) : 1.0;
+	}
+
+	std::vector<long> geometricSteps() const
+	{
+        const long last = lastStep();
+        if(last < 0) return std::vector<long>();
+
+        const size_t c = leading();
+        std::vector<long> steps(1, 0);
+        while(steps.back() < last){
+            const double target = _countUp ? magnitude(steps.back())*_factor : magnitude(steps.back())/_factor;
+            const double k = std::ceil((_countUp ? target - _start[c] : _start[c] - target)/_step[c]);
+            steps.push_back(std::min(last, std::max(steps.back() + 1, long(k))));
+        }
+        return steps;
+	}
+
+	std::vector<long> randomSteps() const
+	{
+        const long last = lastStep();
+        if(last < 0) return std::vector<long>();
+
+        const double lo = std::log(magnitude(0)), hi = std::log(magnitude(last));
+        const double first = magnitude(0), scale = last > 0 ? (magnitude(last) - first)/double(last) : 1.0;
+
+        std::mt19937 gen(_seed);
+        std::uniform_real_distribution<double> logSize(std::min(lo, hi), std::max(lo, hi));
+
+        std::set<long> steps;
+        const size_t count = std::min<size_t>(_count, size_t(last) + 1);
+        for(size_t n = 0; steps.size() < count && n < 100*count; ++n){
+            const long k = long(std::round((std::exp(logSize(gen)) - first)/scale));
+            steps.insert(std::max(0L, std::min(last, k)));
+        }
+        return std::vector<long>(steps.begin(), steps.end());
+	}
+
+	/*! \brief Measures the steps and bisects between neighbours whose performance differs by more than _threshold. */
+	void refine(const std::vector<long>& initial)
+	{
+        const size_t first = _perf.size();
+        std::map<long, size_t> measured; // step -> index of the results
+
+        for(long k : initial){
+            if(measured.size() >= _count) break;
+            measured[k] = _perf.size();
+            this->profile(gridPoint(k));
+        }
+
+        while(measured.size() < _count){
+            std::vector<long> bisect;
+            for(auto a = measured.begin(), b = std::next(a); b != measured.end(); ++a, ++b){
+                const double pa = _perf[a->second], pb = _perf[b->second];
+                if(b->first - a->first > 1 && std::fabs(pa - pb) > _threshold*std::max(std::fabs(pa), std::fabs(pb)))
+                    bisect.push_back((a->first + b->first)/2);
+            }
+            if(bisect.empty()) break;
+
+            for(size_t j = 0; j < bisect.size() && measured.size() < _count; ++j){
+                measured[bisect[j]] = _perf.size();
+                this->profile(gridPoint(bisect[j]));
+            }
+        }
+
+        // The results are ordered by size.
+        std::vector<size_t> order;
+        for(const auto& m : measured) order.push_back(m.second);
+        permute(_samples, first, order); permute(_stats, first, order);
+        permute(_sizes, first, order);   permute(_elems, first, order);
+        permute(_times, first, order);   permute(_ops, first, order);
+        permute(_perf, first, order);    permute(_counts, first, order);
+	}
+
+	void addCounts(const std::vector<double>& begin, const std::vector<double>& end)
+	{
+        if(_counts.empty()) _counts.emplace_back();
+        _counts.back().resize(end.size(), 0.0);
+        for(size_t c = 0; c < end.size() && c < begin.size(); ++c)
+            _counts.back()[c] += end[c] - begin[c];
+	}
+
+	template<class V>
+	static void permute(V& v, size_t first, const std::vector<size_t>& order)
+	{
+        V tail;
+        for(size_t i : order) tail.push_back(std::move(v[i]));
+        v.erase(v.begin() + first, v.end());
+        std::move(tail.begin(), tail.end(), std::back_inserter(v));
+	}
+
 	std::string _name;
     utl::Dim _start, _step, _end;
-	size_t _iter;
-    bool _print_n, _print_t, _print_o, _print_p;
+	size_t _iter;    /*!< Minimal number of measured iterations */
+	size_t _warmup;  /*!< Number of iterations which are not measured */
+	size_t _maxIter; /*!< Maximal number of measured iterations */
+	double _precision, _confidence;
+    bool _print_n, _print_t, _print_o, _print_p, _print_s;
+
+    Metadata _metadata;
 
+    std::vector<Dim> _sizes;    /*!< Problem sizes */
     std::vector<double> _elems;
 	std::vector<double> _ops;   /*!< Number of operations at each dimension [ ops ]*/
 	std::vector<double> _times; /*!< Time needed for the operation [ s ] */
 	std::vector<double> _perf;  /*!< Number of operations per Time [ Ops / s ]*/
 
+	std::vector<std::vector<double> > _samples; /*!< Runtimes of the measured iterations at each dimension */
+	std::vector<Statistics> _stats;             /*!< Statistics of the samples at each dimension */
+	std::vector<std::vector<double> > _counts;  /*!< Hardware counts per iteration at each dimension */
+
+	std::shared_ptr<PerfCounters> _counters;
+
     bool _countUp;
 
+    Sweep _sweep;
+    double _factor, _threshold;
+    size_t _count;
+    unsigned _seed;
+    std::vector<Dim> _sizeList;
+
 };
 
 }
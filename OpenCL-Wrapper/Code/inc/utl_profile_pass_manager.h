@@ -20,6 +20,7 @@
 
 #include <ostream>
 #include <iostream>
+#include <fstream>
 #include <string>
 #include <vector>
 #include <chrono>
@@ -27,6 +28,8 @@
 #include <memory>
 
 #include <utl_profile_pass.h>
+#include <utl_profile_report.h>
+#include <utl_assert.h>
 
 
 namespace utl {
@@ -35,7 +38,8 @@ namespace utl {
   * \brief Utility class to handle profile classes.
   *
   * ProfilePassManager objects are used to collect ProfilePass objects
-  * and to run them collectively.
+  * and to run them collectively. The results are written as Octave
+  * variables, JSON or CSV and can be compared with a baseline CSV file.
   */
 
 template<class ValueType_>
@@ -51,6 +55,8 @@ public:
     using reference      = typename std::vector<std::shared_ptr<PassType>>::reference;
         
 
+    enum Format { Octave, Json, Csv };
+
     ProfilePassManager() = default;
     ~ProfilePassManager() = default;
 
@@ -74,6 +80,27 @@ public:
         }
     }
 
+    void setGeometricSweep(double factor = 2.0)
+    {
+        for (auto it : _passes){
+            it->setGeometricSweep(factor);
+        }
+    }
+
+    void setAdaptiveSweep(double threshold = 0.1, size_t maxSizes = 64, double factor = 2.0)
+    {
+        for (auto it : _passes){
+            it->setAdaptiveSweep(threshold, maxSizes, factor);
+        }
+    }
+
+    void setCounters(bool enable = true)
+    {
+        for (auto it : _passes){
+            it->setCounters(enable);
+        }
+    }
+
     void setPrint(bool print_n, bool print_t, bool print_o, bool print_p)
     {
         for (auto it : _passes){
@@ -89,22 +116,66 @@ public:
 		}
 	}
 
-	void write(std::ostream& out) const
+    void setMetadata(const std::string& key, const std::string& value) { _metadata[key] = value; }
+
+	/*! \brief Returns the results and metadata of all passes. */
+	ProfileReport report() const
 	{
+		ProfileReport r;
+		for (const auto& m : _metadata)
+			r.setMetadata(m.first, m.second);
+		for (auto it : _passes)
+			r.add(it->name(), it->metadata(), it->records());
+		return r;
+	}
+
+	void write(std::ostream& out, Format format = Octave) const
+	{
+		if (format == Json) { report().writeJson(out); return; }
+		if (format == Csv)  { report().writeCsv(out);  return; }
+
 		for (auto it : _passes)
 			out << it;
 		out << std::endl;
 	}
 
+	/*! \brief Writes the results into a file whose extension .json or .csv selects the format, Octave otherwise. */
 	void write(const std::string &filename) const
 	{
 		std::ofstream out(filename.c_str());
-		_passes.write(out);
+		TRUE_ASSERT(out.is_open(), "Cannot open " << filename);
+
+		auto endsWith = [&filename](const std::string& ext) {
+			return filename.size() >= ext.size() && filename.compare(filename.size() - ext.size(), ext.size(), ext) == 0;
+		};
+		write(out, endsWith(".json") ? Json : endsWith(".csv") ? Csv : Octave);
+	}
+
+	/*! \brief Compares the results with a baseline CSV file and reports regressions and improvements.
+	  *
+	  * \param alpha significance level of the t-test.
+	  * \param threshold minimal relative change of the median runtime.
+	  * \return the number of regressions.
+	  */
+	size_t compare(const std::string &baseline, std::ostream& out, double alpha = 0.05, double threshold = 0.05) const
+	{
+		std::ifstream in(baseline.c_str());
+		TRUE_ASSERT(in.is_open(), "Cannot open " << baseline);
+
+		size_t regressions = 0;
+		for (const ProfileComparison& c : utl::compare(ProfileReport::readCsv(in), report().records(), alpha, threshold)){
+			if (!c.regression && !c.improvement) continue;
+			regressions += c.regression;
+			out << (c.regression ? "REGRESSION " : "IMPROVEMENT ") << c.pass << " " << c.dim << ": "
+			    << c.baseline << " s -> " << c.current << " s (" << std::showpos << 100*c.change << std::noshowpos << " %)" << std::endl;
+		}
+		return regressions;
 	}
 
 private:
 
     std::vector<std::shared_ptr<PassType>> _passes;
+    Metadata _metadata;
 
 };
 
@@ -0,0 +1,103 @@
+//Copyright (C) 2013 Cem Bassoy.
+//
+//This file is part of the OpenCL Utility Toolkit.
+//
+//OpenCL Utility Toolkit is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+//
+//OpenCL Utility Toolkit is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License
+//along with OpenCL Utility Toolkit.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef UTL_PROFILE_REPORT_H
+#define UTL_PROFILE_REPORT_H
+
+#include <cstddef>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace utl{
+
+typedef std::map<std::string, std::string> Metadata;
+
+/*! \class ProfileRecord utl_profile_report.h "inc/utl_profile_report.h"
+  * \brief Result of a ProfilePass at one problem size.
+  *
+  * All times are given in seconds, the performance in operations per second
+  * and the hardware counts per iteration.
+  * The statistics are computed without the outliers, samples counts them.
+  */
+struct ProfileRecord
+{
+    ProfileRecord();
+
+    double perf() const { return median > 0 ? ops/median : 0.0; }
+
+    std::string pass;
+    std::string dim;      /*!< Problem size, e.g. 256x256x256 */
+    double elements, ops;
+    double min, median, p95, mean, stddev, ciLow, ciHigh;
+    size_t samples, outliers;
+    std::vector<double> times; /*!< Runtimes of all measured iterations, empty for loaded records */
+    std::map<std::string, double> counters; /*!< Hardware counts per iteration */
+};
+
+/*! \class ProfileComparison utl_profile_report.h "inc/utl_profile_report.h"
+  * \brief Comparison of a ProfileRecord with the baseline of the same pass and problem size.
+  */
+struct ProfileComparison
+{
+    std::string pass, dim;
+    double baseline, current; /*!< Median runtimes [ s ] */
+    double change;            /*!< Relative change of the median runtime */
+    double t;                 /*!< Welch's t statistic of the mean runtimes */
+    bool regression, improvement;
+};
+
+/*! \class ProfileReport utl_profile_report.h "inc/utl_profile_report.h"
+  * \brief Machine-readable results of ProfilePass objects.
+  *
+  * A report holds the records of all passes together with metadata such as
+  * the git revision of the build, the date and the devices of the passes.
+  * It is written as JSON, which includes the runtimes of all iterations, or as
+  * CSV with one line per pass and problem size. CSV files can be read back
+  * as the baseline of a later comparison.
+  */
+class ProfileReport
+{
+public:
+    ProfileReport();
+
+    void setMetadata(const std::string& key, const std::string& value) { _metadata[key] = value; }
+    const Metadata& metadata() const { return _metadata; }
+
+    void add(const std::string& pass, const Metadata& metadata, const std::vector<ProfileRecord>& records);
+    const std::vector<ProfileRecord>& records() const { return _records; }
+
+    void writeJson(std::ostream&) const;
+    void writeCsv(std::ostream&) const;
+
+    static std::vector<ProfileRecord> readCsv(std::istream&);
+
+private:
+    Metadata _metadata;
+    std::vector<std::pair<std::string, Metadata> > _passes;
+    std::vector<ProfileRecord> _records;
+};
+
+/*! \brief Returns the git revision, the compiler and the date of the current run. */
+Metadata buildMetadata();
+
+std::vector<ProfileComparison> compare(const std::vector<ProfileRecord>& baseline, const std::vector<ProfileRecord>& current,
+                                       double alpha = 0.05, double threshold = 0.05);
+
+}
+#endif
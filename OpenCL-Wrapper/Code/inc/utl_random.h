@@ -0,0 +1,261 @@
+//Copyright (C) 2013 Cem Bassoy.
+//
+//This file is part of the OpenCL Utility Toolkit.
+//
+//OpenCL Utility Toolkit is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+//
+//OpenCL Utility Toolkit is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License
+//along with OpenCL Utility Toolkit.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef UTL_RANDOM_H
+#define UTL_RANDOM_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace utl{
+
+/*! \class Philox utl_random.h "inc/utl_random.h"
+  * \brief Counter-based Philox4x32-10 random number generator.
+  *
+  * The generator maps a 64 bit block number and the key, i.e. the seed,
+  * to four random 32 bit words without any state. Element i of a
+  * sequence is taken from word i%4 of block i/4, so every element is a
+  * pure function of the seed, the stream and its index. The sequences
+  * are therefore the same for any number of threads, for any subrange
+  * and on OpenCL devices which run ocl::Random with the same seed.
+  *
+  * Uniform floating point numbers have a resolution of 2^-24 for float
+  * and 2^-32 for double and are scaled with a fused multiply-add, so they
+  * are bitwise identical to the device. Normal numbers are computed with
+  * the Box-Muller transform from two words and agree with the device up
+  * to the accuracy of its log, sqrt, sin and cos functions.
+  */
+class Philox
+{
+public:
+    typedef std::array<std::uint32_t, 4> Block;
+
+    /*! \brief Stream of uniform and of normal numbers, so both are independent for the same seed. */
+    enum Stream { Uniform = 0, Normal = 1 };
+
+    explicit Philox(std::uint64_t seed = 0, std::uint32_t stream = Uniform) :
+        _key{{std::uint32_t(seed), std::uint32_t(seed >> 32)}}, _stream(stream)
+    {}
+
+    /*! \brief Returns the four random words of a block.
+      *
+      * \param draw fourth word of the counter, which is non-zero only for the additional
+      *        words of integral uniform numbers.
+      */
+    Block operator()(std::uint64_t block, std::uint32_t draw = 0) const
+    {
+        std::uint32_t c0 = std::uint32_t(block), c1 = std::uint32_t(block >> 32), c2 = _stream, c3 = draw;
+        rounds(c0, c1, c2, c3, _key[0], _key[1]);
+        return Block{{c0, c1, c2, c3}};
+    }
+
+    /*! \brief Fills data with uniform numbers in [min, max) or, for integral types, in [min, max].
+      *
+      * Integral numbers are unbiased. They are drawn with Lemire's multiply-shift from one
+      * word for ranges up to 2^32 and from two words for wider ranges, and a rejected
+      * element draws again from the same block with the next draw of the counter.
+      *
+      * \param offset index of the first element within the sequence.
+      */
+    template<class T>
+    void uniform(T *data, size_t n, T min, T max, size_t offset = 0) const
+    {
+        generate(data, n, offset, [this, min, max](const Block& w, std::uint64_t block) {
+            std::array<T, 4> v;
+            for(size_t l = 0; l < 4; ++l) v[l] = toUniform<T>(w[l], block, l, min, max);
+            return v;
+        });
+    }
+
+    /*! \brief Fills data with normal numbers, which are rounded for integral types.
+      *
+      * \param offset index of the first element within the sequence.
+      */
+    template<class T>
+    void normal(T *data, size_t n, double mean, double dev, size_t offset = 0) const
+    {
+        typedef typename std::conditional<std::is_floating_point<T>::value, T, double>::type R;
+        const R m = R(mean), d = R(dev);
+        generate(data, n, offset, [m, d](const Block& w, std::uint64_t) {
+            std::array<T, 4> v;
+            for(size_t l = 0; l < 4; l += 2){
+                R z0, z1;
+                boxMuller(w[l], w[l+1], z0, z1);
+                v[l]   = toValue<T>(m + d*z0);
+                v[l+1] = toValue<T>(m + d*z1);
+            }
+            return v;
+        });
+    }
+
+    /*! \brief Returns the float or double in [0,1) of a word, as the OpenCL kernels do. */
+    template<class R>
+    static R unit(std::uint32_t w)
+    {
+        const unsigned shift = sizeof(R) == 4 ? 8 : 0;
+        return R(w >> shift) / R(std::uint64_t(1) << (32 - shift));
+    }
+
+    static std::uint64_t randomSeed();
+
+private:
+    std::array<std::uint32_t, 2> _key;
+    std::uint32_t _stream;
+
+    static constexpr std::uint32_t W0 = 0x9E3779B9u, W1 = 0xBB67AE85u; /*!< Weyl sequence of the key */
+    static constexpr size_t Chunk = 256; /*!< Blocks generated at once by a thread */
+
+    static void round(std::uint32_t& c0, std::uint32_t& c1, std::uint32_t& c2, std::uint32_t& c3, std::uint32_t k0, std::uint32_t k1)
+    {
+        const std::uint64_t p0 = std::uint64_t(0xD2511F53u)*c0;
+        const std::uint64_t p1 = std::uint64_t(0xCD9E8D57u)*c2;
+        c0 = std::uint32_t(p1 >> 32) ^ c1 ^ k0;
+        c2 = std::uint32_t(p0 >> 32) ^ c3 ^ k1;
+        c1 = std::uint32_t(p1);
+        c3 = std::uint32_t(p0);
+    }
+
+    /*! \brief Transforms the counter c0..c3 with the key k0, k1 into four random words. */
+    static void rounds(std::uint32_t& c0, std::uint32_t& c1, std::uint32_t& c2, std::uint32_t& c3, std::uint32_t k0, std::uint32_t k1)
+    {
+        // The rounds are unrolled, so that the loops over blocks are vectorized.
+        round(c0, c1, c2, c3, k0, k1); round(c0, c1, c2, c3, k0 += W0, k1 += W1);
+        round(c0, c1, c2, c3, k0 += W0, k1 += W1); round(c0, c1, c2, c3, k0 += W0, k1 += W1);
+        round(c0, c1, c2, c3, k0 += W0, k1 += W1); round(c0, c1, c2, c3, k0 += W0, k1 += W1);
+        round(c0, c1, c2, c3, k0 += W0, k1 += W1); round(c0, c1, c2, c3, k0 += W0, k1 += W1);
+        round(c0, c1, c2, c3, k0 += W0, k1 += W1); round(c0, c1, c2, c3, k0 += W0, k1 += W1);
+    }
+
+
+    template<class T, class F>
+    void generate(T *data, size_t n, size_t offset, F convert) const;
+
+    template<class T>
+    typename std::enable_if<std::is_floating_point<T>::value, T>::type
+    toUniform(std::uint32_t w, std::uint64_t, size_t, T min, T max) const { return std::fma(unit<T>(w), max - min, min); }
+
+    /*! \brief Maps word w, which is word lane of the block, to [min, max] without bias.
+      *
+      * A range of r <= 2^32 takes the upper half of w*r, which is rejected while the lower
+      * half is below 2^32 mod r. Wider ranges combine two words into x and reject x at or
+      * above the largest multiple of r. Range 0 stands for all 2^64 values.
+      */
+    template<class T>
+    typename std::enable_if<std::is_integral<T>::value, T>::type
+    toUniform(std::uint32_t w, std::uint64_t block, size_t lane, T min, T max) const
+    {
+        const std::uint64_t range = std::uint64_t(max) - std::uint64_t(min) + 1;
+        std::uint32_t draw = 0;
+
+        if(range != 0 && range <= (std::uint64_t(1) << 32)){
+            std::uint64_t m = std::uint64_t(w)*range;
+            if(std::uint32_t(m) < range){
+                const std::uint32_t threshold = std::uint32_t((std::uint64_t(1) << 32) % range);
+                while(std::uint32_t(m) < threshold)
+                    m = std::uint64_t((*this)(block, ++draw)[lane])*range;
+            }
+            return T(std::uint64_t(min) + (m >> 32));
+        }
+
+        std::uint64_t x = std::uint64_t(w) << 32 | (*this)(block, ++draw)[lane];
+        if(range == 0) return T(std::uint64_t(min) + x);
+
+        const std::uint64_t limit = std::uint64_t(0) - (std::uint64_t(0) - range) % range; // multiple of range, 0 for 2^64
+        while(limit != 0 && x >= limit){
+            x = std::uint64_t((*this)(block, ++draw)[lane]) << 32;
+            x |= (*this)(block, ++draw)[lane];
+        }
+        return T(std::uint64_t(min) + x % range);
+    }
+
+    template<class R>
+    static void boxMuller(std::uint32_t w0, std::uint32_t w1, R& z0, R& z1)
+    {
+        const unsigned shift = sizeof(R) == 4 ? 8 : 0;
+        const R u1 = (R(w0 >> shift) + R(1)) / R(std::uint64_t(1) << (32 - shift)); // (0,1]
+        const R r  = std::sqrt(R(-2)*std::log(u1));
+        const R a  = R(6.283185307179586476925286766559)*unit<R>(w1);
+        z0 = r*std::cos(a);
+        z1 = r*std::sin(a);
+    }
+
+    template<class T, class R>
+    static typename std::enable_if<std::is_floating_point<T>::value, T>::type toValue(R x) { return T(x); }
+
+    template<class T, class R>
+    static typename std::enable_if<std::is_integral<T>::value, T>::type toValue(R x) { return T(std::round(x)); }
+};
+
+
+/*! \brief Writes the elements [offset, offset+n) of the sequence to data.
+  *
+  * The full blocks are generated in parallel, the partial blocks at both ends serially.
+  */
+template<class T, class F>
+void Philox::generate(T *data, size_t n, size_t offset, F convert) const
+{
+    if(n == 0) return;
+
+    const std::uint64_t begin = offset, end = std::uint64_t(offset) + n;
+    const std::uint64_t first = (begin + 3)/4, last = end/4; // full blocks
+
+    auto partial = [&](std::uint64_t block) {
+        const std::array<T, 4> v = convert((*this)(block), block);
+        for(std::uint64_t e = std::max(4*block, begin); e < std::min(4*block + 4, end); ++e)
+            data[e - begin] = v[e - 4*block];
+    };
+
+    if(first > last){ // inside a single block
+        partial(begin/4);
+        return;
+    }
+    if(begin < 4*first) partial(begin/4);
+
+    T *out = data + (4*first - begin);
+    const std::ptrdiff_t chunks = std::ptrdiff_t((last - first + Chunk - 1)/Chunk);
+    const std::uint32_t k0 = _key[0], k1 = _key[1], stream = _stream;
+
+#pragma omp parallel for schedule(static) if(chunks > 16)
+    for(std::ptrdiff_t c = 0; c < chunks; ++c){
+        const std::uint64_t b0 = first + std::uint64_t(c)*Chunk;
+        const size_t m = size_t(std::min<std::uint64_t>(Chunk, last - b0));
+
+        // The words are generated for a whole chunk first, so that the rounds are vectorized across blocks.
+        std::uint32_t w[4][Chunk];
+#pragma omp simd
+        for(size_t j = 0; j < m; ++j){
+            std::uint32_t c0 = std::uint32_t(b0 + j), c1 = std::uint32_t((b0 + j) >> 32), c2 = stream, c3 = 0;
+            rounds(c0, c1, c2, c3, k0, k1);
+            w[0][j] = c0; w[1][j] = c1; w[2][j] = c2; w[3][j] = c3;
+        }
+
+        T *o = out + 4*(b0 - first);
+        for(size_t j = 0; j < m; ++j){
+            const std::array<T, 4> v = convert(Block{{w[0][j], w[1][j], w[2][j], w[3][j]}}, b0 + j);
+            for(size_t l = 0; l < 4; ++l) o[4*j + l] = v[l];
+        }
+    }
+
+    if(4*last < end) partial(last);
+}
+
+}
+#endif
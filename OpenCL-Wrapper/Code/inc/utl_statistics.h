@@ -0,0 +1,69 @@
+//Copyright (C) 2013 Cem Bassoy.
+//
+//This file is part of the OpenCL Utility Toolkit.
+//
+//OpenCL Utility Toolkit is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+//
+//OpenCL Utility Toolkit is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License
+//along with OpenCL Utility Toolkit.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef UTL_STATISTICS_H
+#define UTL_STATISTICS_H
+
+#include <cstddef>
+#include <vector>
+
+namespace utl{
+
+/*! \class Statistics utl_statistics.h "inc/utl_statistics.h"
+  * \brief Summary statistics of repeated runtime measurements.
+  *
+  * Outliers are detected with Tukey's far-out fences, i.e. samples which lie more than
+  * three interquartile ranges below the first or above the third quartile. They are
+  * counted but excluded from all other statistics, so that a single preempted run
+  * on a shared node does not distort the result. The confidence interval of the mean
+  * uses the quantiles of Student's t-distribution.
+  */
+class Statistics
+{
+public:
+    Statistics();
+    explicit Statistics(const std::vector<double>& samples, double confidence = 0.95);
+
+    size_t samples()  const { return _samples; }
+    size_t outliers() const { return _outliers; }
+
+    double min()    const { return _min; }
+    double max()    const { return _max; }
+    double mean()   const { return _mean; }
+    double median() const { return _median; }
+    double p95()    const { return _p95; }
+    double stddev() const { return _stddev; }
+
+    double confidence() const { return _confidence; }
+    double ciLow()      const { return _ciLow; }
+    double ciHigh()     const { return _ciHigh; }
+
+    /*! \brief Returns the width of the confidence interval relative to the mean. */
+    double ciRelativeWidth() const;
+
+private:
+    size_t _samples, _outliers;
+    double _min, _max, _mean, _median, _p95, _stddev;
+    double _confidence, _ciLow, _ciHigh;
+};
+
+double quantile(const std::vector<double>& sorted, double p);
+double normalQuantile(double p);
+double studentQuantile(double p, double dof);
+
+}
+#endif
@@ -41,6 +41,136 @@ void write(const std::string &file_name, T *A, size_t size, std::ios::openmode m
 template<class T>
 void read(const std::string &file_name, T *A, size_t size, std::ios::openmode mode = std::ios::in);
 
+/*! \class MatrixHeader utl_stream.h "inc/utl_stream.h"
+  * \brief Beschreibung einer Matrixdatei.
+  *
+  * Eine Matrixdatei beginnt mit einem Kopf, der den Elementtyp, die Dimensionen, die
+  * Storage und optional die Blockung einer Matrix2 enthaelt. Die Elemente folgen ab
+  * dataOffset, sodass sie nach mmap seitenweise ausgerichtet sind.
+  *
+  * Eine geblockte Matrix besteht nur aus ganzen Bloecken: rows und cols sind Vielfache
+  * von innerRows und innerCols, Randbloecke werden nicht unterstuetzt. Die Bloecke liegen
+  * wie in Matrix2 ohne Luecken hintereinander, Matrizen mit anderen Dimensionen muessen
+  * vor dem Schreiben auf ganze Bloecke aufgefuellt werden.
+  */
+struct MatrixHeader
+{
+    MatrixHeader();
+
+    template<class T>
+    static MatrixHeader create(size_t rows, size_t cols, const Storage& storage = ColMajor,
+                               size_t innerRows = 0, size_t innerCols = 0, const Storage& innerStorage = ColMajor);
+
+    template<class T>
+    void check() const;
+
+    size_t elements() const { return rows*cols; }
+    size_t bytes() const { return rows*cols*elementSize; }
+    bool blocked() const { return innerRows > 0 && innerCols > 0; }
+
+    std::string type;          /*!< Name des Elementtyps, siehe typeToString */
+    size_t elementSize;
+    size_t rows, cols;
+    const Storage *storage;
+    size_t innerRows, innerCols; /*!< Bloecke einer Matrix2, 0 falls nicht geblockt, teilen rows und cols */
+    const Storage *innerStorage;
+
+    static const size_t dataOffset = 4096;
+};
+
+MatrixHeader readMatrixHeader(const std::string &file_name);
+
+template<class T>
+void writeMatrix(const std::string &file_name, const T *A, const MatrixHeader &header);
+
+template<class T>
+MatrixHeader readMatrix(const std::string &file_name, T *A, size_t size);
+
+/*! \class MatrixWriter utl_stream.h "inc/utl_stream.h"
+  * \brief Schreibt eine Matrixdatei abschnittsweise, z.B. fuer Matrizen groesser als der Hauptspeicher.
+  */
+class MatrixWriter
+{
+public:
+    MatrixWriter(const std::string &file_name, const MatrixHeader &header);
+    ~MatrixWriter();
+
+    template<class T>
+    void write(const T *A, size_t size);
+
+    void close();
+
+    const MatrixHeader& header() const { return _header; }
+    size_t written() const { return _written; }
+
+private:
+    std::string _name;
+    std::ofstream _os;
+    MatrixHeader _header;
+    size_t _written;
+};
+
+/*! \class MatrixReader utl_stream.h "inc/utl_stream.h"
+  * \brief Liest eine Matrixdatei abschnittsweise.
+  */
+class MatrixReader
+{
+public:
+    explicit MatrixReader(const std::string &file_name);
+
+    template<class T>
+    size_t read(T *A, size_t size);
+
+    void seek(size_t element);
+
+    const MatrixHeader& header() const { return _header; }
+    size_t position() const { return _position; }
+    size_t remaining() const { return _header.elements() - _position; }
+
+private:
+    std::string _name;
+    std::ifstream _is;
+    MatrixHeader _header;
+    size_t _position;
+};
+
+/*! \class MappedMatrix utl_stream.h "inc/utl_stream.h"
+  * \brief Bildet eine Matrixdatei mit mmap in den Speicher ab.
+  *
+  * Die Elemente koennen ohne Kopie von Matrix::wrap oder Matrix2::wrap verwendet werden:
+  * \code
+  * utl::MappedMatrix file("A.mat");
+  * auto A = utl::Matrix<float, utl::column_major_tag>::wrap(file.data<float>(), file.header().rows, file.header().cols);
+  * \endcode
+  * Ohne writable werden Aenderungen nicht in die Datei geschrieben (copy-on-write).
+  */
+class MappedMatrix
+{
+public:
+    explicit MappedMatrix(const std::string &file_name, bool writable = false);
+    MappedMatrix(MappedMatrix&&);
+    ~MappedMatrix();
+
+    MappedMatrix(const MappedMatrix&) = delete;
+    MappedMatrix& operator=(const MappedMatrix&) = delete;
+
+    static MappedMatrix create(const std::string &file_name, const MatrixHeader &header);
+
+    template<class T>
+    T* data() const;
+
+    const MatrixHeader& header() const { return _header; }
+
+    void sync();
+
+private:
+    MappedMatrix();
+
+    char *_base;
+    size_t _length;
+    MatrixHeader _header;
+};
+
 template<class T>
 void randn(T *data, size_t num, T maxData = (T)RAND_MAX);
 
@@ -19,20 +19,13 @@
 #define UTL_TIME_H
 
 #include <chrono>
+#include <cstdint>
+#include <cstddef>
 #include <ostream>
 
 namespace utl
 {
 
-/*! \class Timer
-  * \brief Utility class for timing functions.
-  *
-  * Timer class encapsulates the chono clock
-  * functions for an easier clock query.
-  * Use tic, toc methods (similar to Matlab) to
-  * query the runtime in seconds of a function.
-  */
-
 class MilliSeconds;
 class MicroSeconds;
 
@@ -95,31 +88,104 @@ MicroSeconds operator "" _us(long double d)
 }
 */
 
+/*! \class Clock
+  * \brief Low overhead clock for the timers.
+  *
+  * The clock either reads the time stamp counter of the CPU or std::chrono::steady_clock.
+  * The time stamp counter is used by default if the CPU reports an invariant counter,
+  * i.e. one which runs at a constant rate independent of frequency scaling and sleep states.
+  * Its rate is calibrated against the steady clock when the clock is used first.
+  */
+class Clock
+{
+public:
+    enum Source { Steady, Tsc };
+    typedef std::uint64_t ticks;
+
+    static ticks now();
+    static double seconds(ticks);
+
+    static Source source();
+    static void setSource(Source);
+    static bool tscAvailable();
+
+private:
+    Clock() = delete;
+};
+
+/*! \class Timer
+  * \brief Utility class for timing functions.
+  *
+  * Timer class encapsulates the chono clock
+  * functions for an easier clock query.
+  * Use tic, toc methods (similar to Matlab) to
+  * query the runtime in seconds of a function.
+  * Each Timer object measures independently, so timers can be nested
+  * and used by several threads.
+  */
 class Timer
 {
 public :
-		
-    typedef std::chrono::high_resolution_clock clock;
+
+    typedef std::chrono::steady_clock clock;
     typedef typename clock::duration duration;
     typedef typename clock::time_point point;
     typedef typename clock::period period;
     typedef std::chrono::microseconds resolution;
 
-    static void tic();
-    static void toc();
+    Timer();
 
-    static point start();
-    static point stop();
+    void tic();
+    void toc();
 
-    static MicroSeconds elapsed();
-    static MicroSeconds elapsed(size_t run);
+    point start() const;
+    point stop() const;
+
+    MicroSeconds elapsed() const;
+    MicroSeconds elapsed(size_t run) const;
 
 
 private:
-    explicit Timer(){}
+    point _start;
+    point _stop;
+};
 
-    static point _start;
-    static point _stop;
+namespace detail { struct TimerBuffer; }
+
+/*! \class ScopedTimer
+  * \brief Measures the runtime of a scope as a region of a hierarchical tree.
+  *
+  * A ScopedTimer which is created while another one is alive on the same thread
+  * becomes a child region of it, e.g. "setup", "transfer", "kernel" and "verify" inside
+  * of "prof". Regions with the same name and parent are accumulated. Each thread
+  * records into its own buffer without synchronization. The buffers are merged by the
+  * path of the regions when the report is written, which must not happen while a
+  * thread is still timing.
+  *
+  * \code
+  * {
+  *     utl::ScopedTimer t("kernel");
+  *     ...
+  * }
+  * utl::ScopedTimer::report(std::cout);
+  * \endcode
+  */
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(const char* name);
+    ~ScopedTimer();
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    static void report(std::ostream&);
+    static void reset();
+
+private:
+    detail::TimerBuffer* _buffer;
+    size_t _region;
+    Clock::ticks _start;
 };
 }
 #endif
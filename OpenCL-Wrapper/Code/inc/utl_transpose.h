@@ -0,0 +1,138 @@
+//Copyright (C) 2013 Cem Bassoy.
+//
+//This file is part of the OpenCL Utility Toolkit.
+//
+//OpenCL Utility Toolkit is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+//
+//OpenCL Utility Toolkit is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License
+//along with OpenCL Utility Toolkit.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef UTL_TRANSPOSE_H
+#define UTL_TRANSPOSE_H
+
+#include <cstddef>
+#include <algorithm>
+
+namespace utl{
+
+/*! \class CopyBlocking utl_transpose.h "inc/utl_transpose.h"
+  * \brief Blocking parameters of the strided copy for the value type T.
+  *
+  * Tile x Tile elements of the source and the destination fit into the L1 cache together.
+  * Panel x Panel elements are the unit of work distributed among the OpenMP threads.
+  */
+template<class T>
+struct CopyBlocking
+{
+    static constexpr size_t Tile  = 4096/sizeof(T) >= 32*32 ? 32 : 16;
+    static constexpr size_t Panel = 8*Tile;
+};
+
+namespace detail {
+
+/*! \brief Copies a tile which fits into the L1 cache. The inner loop runs along the contiguous dimension of the destination. */
+template<class T>
+void copyTile(size_t rows, size_t cols, const T* src, std::ptrdiff_t rsS, std::ptrdiff_t csS, T* dst, std::ptrdiff_t rsD, std::ptrdiff_t csD)
+{
+    if(rsD == 1){
+        for(size_t j = 0; j < cols; ++j){
+            const T* s = src + std::ptrdiff_t(j)*csS;
+            T* d = dst + std::ptrdiff_t(j)*csD;
+            if(rsS == 1){
+#pragma omp simd
+                for(size_t i = 0; i < rows; ++i) d[i] = s[i];
+            }
+            else{
+#pragma omp simd
+                for(size_t i = 0; i < rows; ++i) d[i] = s[std::ptrdiff_t(i)*rsS];
+            }
+        }
+    }
+    else if(csD == 1){
+        for(size_t i = 0; i < rows; ++i){
+            const T* s = src + std::ptrdiff_t(i)*rsS;
+            T* d = dst + std::ptrdiff_t(i)*rsD;
+            if(csS == 1){
+#pragma omp simd
+                for(size_t j = 0; j < cols; ++j) d[j] = s[j];
+            }
+            else{
+#pragma omp simd
+                for(size_t j = 0; j < cols; ++j) d[j] = s[std::ptrdiff_t(j)*csS];
+            }
+        }
+    }
+    else{
+        for(size_t j = 0; j < cols; ++j)
+            for(size_t i = 0; i < rows; ++i)
+                dst[std::ptrdiff_t(i)*rsD + std::ptrdiff_t(j)*csD] = src[std::ptrdiff_t(i)*rsS + std::ptrdiff_t(j)*csS];
+    }
+}
+
+/*! \brief Halves the larger dimension until a tile fits into the L1 cache, so each level of the memory hierarchy is used without knowing its size. */
+template<class T>
+void copyRecursive(size_t rows, size_t cols, const T* src, std::ptrdiff_t rsS, std::ptrdiff_t csS, T* dst, std::ptrdiff_t rsD, std::ptrdiff_t csD)
+{
+    constexpr size_t Tile = CopyBlocking<T>::Tile;
+
+    if(rows <= Tile && cols <= Tile){
+        copyTile(rows, cols, src, rsS, csS, dst, rsD, csD);
+    }
+    else if(rows >= cols){
+        const size_t half = rows/2;
+        copyRecursive(half, cols, src, rsS, csS, dst, rsD, csD);
+        copyRecursive(rows - half, cols, src + std::ptrdiff_t(half)*rsS, rsS, csS, dst + std::ptrdiff_t(half)*rsD, rsD, csD);
+    }
+    else{
+        const size_t half = cols/2;
+        copyRecursive(rows, half, src, rsS, csS, dst, rsD, csD);
+        copyRecursive(rows, cols - half, src + std::ptrdiff_t(half)*csS, rsS, csS, dst + std::ptrdiff_t(half)*csD, rsD, csD);
+    }
+}
+
+}
+
+/*! \brief Copies a rows x cols matrix from src to dst on the host.
+  *
+  * Both matrices are described by a pointer and the distance between two consecutive
+  * rows (rs) and columns (cs) like the operands of utl::gemm. If the contiguous dimensions
+  * of src and dst differ, this is a transposition, which is carried out cache-obliviously
+  * with SIMD loops over L1 sized tiles. Large matrices are split into panels distributed
+  * among the OpenMP threads. The matrices must not overlap.
+  */
+template<class T>
+void copyStrided(size_t rows, size_t cols, const T* src, std::ptrdiff_t rsS, std::ptrdiff_t csS, T* dst, std::ptrdiff_t rsD, std::ptrdiff_t csD)
+{
+    constexpr size_t Panel = CopyBlocking<T>::Panel;
+
+    const std::ptrdiff_t rowPanels = std::ptrdiff_t((rows + Panel - 1)/Panel);
+    const std::ptrdiff_t colPanels = std::ptrdiff_t((cols + Panel - 1)/Panel);
+    const std::ptrdiff_t panels = rowPanels*colPanels;
+
+#pragma omp parallel for schedule(static) if(panels > 1)
+    for(std::ptrdiff_t p = 0; p < panels; ++p)
+    {
+        const size_t i = size_t(p % rowPanels)*Panel, j = size_t(p / rowPanels)*Panel;
+        detail::copyRecursive(std::min(Panel, rows - i), std::min(Panel, cols - j),
+                              src + std::ptrdiff_t(i)*rsS + std::ptrdiff_t(j)*csS, rsS, csS,
+                              dst + std::ptrdiff_t(i)*rsD + std::ptrdiff_t(j)*csD, rsD, csD);
+    }
+}
+
+/*! \brief Copies the transpose of the rows x cols column-major matrix src with leading dimension lds into the column-major matrix dst with leading dimension ldd. */
+template<class T>
+void transpose(size_t rows, size_t cols, const T* src, size_t lds, T* dst, size_t ldd)
+{
+    copyStrided(rows, cols, src, 1, std::ptrdiff_t(lds), dst, std::ptrdiff_t(ldd), 1);
+}
+
+}
+#endif
@@ -24,15 +24,24 @@
 */
 
 
+#include <utl_allocator.h>
 #include <utl_args.h>
 #include <utl_dim.h>
 #include <utl_flags.h>
+#include <utl_gemm.h>
 #include <utl_profile_pass.h>
 #include <utl_profile_pass_manager.h>
+#include <utl_perf_counters.h>
+#include <utl_profile_report.h>
+#include <utl_random.h>
+#include <utl_statistics.h>
 #include <utl_storage.h>
 #include <utl_stream.h>
 #include <utl_timer.h>
+#include <utl_transpose.h>
 #include <utl_type.h>
 #include <utl_matrix.h>
+#include <utl_matrix_expression.h>
+#include <utl_matrix_storage.h>
 
 #endif
@@ -50,7 +50,15 @@ SOURCES += \
 	src/utl_storage.cpp \
 	src/utl_args.cpp \
 	src/utl_dim.cpp \
-	src/utl_timer.cpp
+	src/utl_allocator.cpp \
+	src/utl_timer.cpp \
+	src/utl_statistics.cpp \
+	src/utl_perf_counters.cpp \
+	src/utl_profile_report.cpp \
+	src/utl_random.cpp \
+	src/ocl_random.cpp \
+	src/ocl_blas.cpp \
+	src/ocl_reduce.cpp
 
 HEADERS += \
 	inc/utl_utils.h \
@@ -63,5 +71,17 @@ HEADERS += \
 	inc/utl_profile_pass_manager.h \
 	inc/utl_profile_pass.h \
 	inc/utl_flags.h \
+	inc/utl_allocator.h \
+	inc/utl_gemm.h \
 	inc/utl_matrix.h \
-	inc/utl_timer.h
+	inc/utl_matrix_expression.h \
+	inc/utl_matrix_storage.h \
+	inc/utl_timer.h \
+	inc/utl_transpose.h \
+	inc/utl_statistics.h \
+	inc/utl_perf_counters.h \
+	inc/utl_profile_report.h \
+	inc/utl_random.h \
+	inc/ocl_random.h \
+	inc/ocl_blas.h \
+	inc/ocl_reduce.h
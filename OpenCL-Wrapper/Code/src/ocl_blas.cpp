@@ -0,0 +1,894 @@
+//Copyright (C) 2013 Cem Bassoy.
+//
+//This file is part of the OpenCL Utility Toolkit.
+//
+//OpenCL Utility Toolkit is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+//
+//OpenCL Utility Toolkit is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License
+//along with OpenCL Utility Toolkit.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <ocl_blas.h>
+#include <ocl_context.h>
+#include <ocl_device.h>
+#include <ocl_image.h>
+#include <ocl_query.h>
+#include <ocl_queue.h>
+#include <ocl_kernel.h>
+
+#include <utl_assert.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+namespace {
+
+// gemm_naive computes one element of C per work-item.
+// Each matrix of gemm_batched is computed by lanes consecutive work-items of a work-group,
+// the work-items of a matrix step through the elements of C in column-major order,
+// so that neighbouring work-items access neighbouring rows of A and C.
+// op(X) is addressed with the row and column strides of X.
+// strassen_sum forms a linear combination of the four quadrants of an operand, strassen_update
+// adds a product of the recursion to the quadrants of C, both skip quadrants with a zero coefficient.
+const std::string kernels = R"(
+template<class T>
+__kernel void gemm_naive(__global T const* restrict a, __global T const* restrict b, __global T* restrict c,
+                         uint m, uint n, uint k, T alpha, T beta, uint transA, uint transB,
+                         ulong offsetA, uint lda, ulong offsetB, uint ldb, ulong offsetC, uint ldc)
+{
+  uint const i = get_global_id(0), j = get_global_id(1);
+  if(i >= m || j >= n) return;
+
+  a += offsetA; b += offsetB; c += offsetC;
+  uint const rowA = transA ? lda : 1u, colA = transA ? 1u : lda;
+  uint const rowB = transB ? ldb : 1u, colB = transB ? 1u : ldb;
+
+  T sum = 0;
+  for(uint l = 0; l < k; ++l)
+    sum = mad(a[i*rowA + l*colA], b[l*rowB + j*colB], sum);
+  uint const r = i + j*ldc;
+  c[r] = beta == (T)0 ? alpha*sum : mad(beta, c[r], alpha*sum);
+}
+
+template<class T>
+__kernel void gemm_batched_strided(__global T const* restrict a, __global T const* restrict b, __global T* restrict c,
+                                   uint m, uint n, uint k, T alpha, T beta, uint transA, uint transB,
+                                   uint lda, uint ldb, uint ldc, ulong strideA, ulong strideB, ulong strideC,
+                                   uint count, uint lanes)
+{
+  uint const matrix = get_group_id(0)*(get_local_size(0)/lanes) + get_local_id(0)/lanes;
+  uint const lane   = get_local_id(0)%lanes;
+  if(matrix >= count) return;
+
+  __global T const* A = a + matrix*strideA;
+  __global T const* B = b + matrix*strideB;
+  __global T* C       = c + matrix*strideC;
+
+  uint const rowA = transA ? lda : 1u, colA = transA ? 1u : lda;
+  uint const rowB = transB ? ldb : 1u, colB = transB ? 1u : ldb;
+
+  for(uint e = lane; e < m*n; e += lanes){
+    uint const i = e%m, j = e/m;
+    T sum = 0;
+    for(uint l = 0; l < k; ++l)
+      sum = mad(A[i*rowA + l*colA], B[l*rowB + j*colB], sum);
+    uint const r = i + j*ldc;
+    C[r] = beta == (T)0 ? alpha*sum : mad(beta, C[r], alpha*sum);
+  }
+}
+
+template<class T>
+__kernel void gemm_batched(__global T const* restrict a, __global T const* restrict b, __global T* restrict c,
+                           __global uint const* restrict batch, T alpha, T beta, uint transA, uint transB,
+                           uint count, uint lanes)
+{
+  uint const matrix = get_group_id(0)*(get_local_size(0)/lanes) + get_local_id(0)/lanes;
+  uint const lane   = get_local_id(0)%lanes;
+  if(matrix >= count) return;
+
+  __global uint const* entry = batch + 9*matrix;
+  uint const m = entry[0], n = entry[1], k = entry[2];
+  uint const lda = entry[4], ldb = entry[6], ldc = entry[8];
+
+  __global T const* A = a + entry[3];
+  __global T const* B = b + entry[5];
+  __global T* C       = c + entry[7];
+
+  uint const rowA = transA ? lda : 1u, colA = transA ? 1u : lda;
+  uint const rowB = transB ? ldb : 1u, colB = transB ? 1u : ldb;
+
+  for(uint e = lane; e < m*n; e += lanes){
+    uint const i = e%m, j = e/m;
+    T sum = 0;
+    for(uint l = 0; l < k; ++l)
+      sum = mad(A[i*rowA + l*colA], B[l*rowB + j*colB], sum);
+    uint const r = i + j*ldc;
+    C[r] = beta == (T)0 ? alpha*sum : mad(beta, C[r], alpha*sum);
+  }
+}
+
+template<class T>
+__kernel void strassen_sum(__global T const* restrict a, ulong offset, uint ld, uint rows, uint cols,
+                           T c11, T c12, T c21, T c22, __global T* restrict z, uint ldz)
+{
+  uint const i = get_global_id(0), j = get_global_id(1);
+  if(i >= rows || j >= cols) return;
+
+  __global T const* x = a + offset + i + (ulong)j*ld;
+  ulong const down = rows, right = (ulong)cols*ld;
+
+  T sum = 0;
+  if(c11 != (T)0) sum += c11*x[0];
+  if(c12 != (T)0) sum += c12*x[right];
+  if(c21 != (T)0) sum += c21*x[down];
+  if(c22 != (T)0) sum += c22*x[down + right];
+  z[i + j*ldz] = sum;
+}
+
+template<class T>
+__kernel void strassen_update(__global T const* restrict p, uint ldp, __global T* restrict c, ulong offset, uint ldc,
+                              uint rows, uint cols, T alpha, T beta, T c11, T c12, T c21, T c22)
+{
+  uint const i = get_global_id(0), j = get_global_id(1);
+  if(i >= rows || j >= cols) return;
+
+  T const x = alpha*p[i + j*ldp];
+  __global T* y = c + offset + i + (ulong)j*ldc;
+  ulong const down = rows, right = (ulong)cols*ldc;
+
+  if(c11 != (T)0) y[0]            = beta == (T)0 ? c11*x : mad(beta, y[0], c11*x);
+  if(c12 != (T)0) y[right]        = beta == (T)0 ? c12*x : mad(beta, y[right], c12*x);
+  if(c21 != (T)0) y[down]         = beta == (T)0 ? c21*x : mad(beta, y[down], c21*x);
+  if(c22 != (T)0) y[down + right] = beta == (T)0 ? c22*x : mad(beta, y[down + right], c22*x);
+}
+)";
+
+// Work-items per work-group, a work-group computes LocalSize/lanes matrices.
+const size_t LocalSize = 64;
+
+// Work-items per dimension of the work-groups of gemm_naive, strassen_sum, strassen_update and gemm_vec.
+const size_t GroupSize2D = 8;
+
+// Work-items per dimension of a work-group and rows and columns of C per work-group of
+// gemm_basic_algorithm and gemm_img_basic_algorithm, depth of the tiles of gemm_basic_algorithm.
+const size_t GemmGroup = 16, GemmTile = 64, GemmTileK = 16;
+
+// Kernels of gemm.cl which read images.
+const char *const imageKernels[] = {"gemm_img", "gemm_img_basic_algorithm", "gemm_img_double_buffering", "gemm_img_pipelining"};
+
+// Largest width and height of images which every device supports.
+const size_t MaxImageSize = 8192;
+
+// Smallest power of two not below the elements of C, at most LocalSize.
+unsigned int lanes(size_t elements)
+{
+	unsigned int l = 1;
+	while(l < elements && l < LocalSize) l <<= 1;
+	return l;
+}
+
+// Elements spanned by a column-major rows x cols matrix with leading dimension ld.
+size_t span(size_t rows, size_t cols, size_t ld)
+{
+	return rows == 0 || cols == 0 ? 0 : (cols - 1)*ld + rows;
+}
+
+size_t roundUp(size_t x, size_t multiple)
+{
+	return (x + multiple - 1)/multiple*multiple;
+}
+
+// Coefficients of the quadrants 11, 12, 21 and 22 of A and B which form the operands of a
+// product of the Strassen-Winograd recursion and with which the product is added to C.
+struct StrassenProduct
+{
+	int a[4], b[4], c[4];
+};
+
+const StrassenProduct strassenProducts[7] = {
+	{{ 1, 0, 0, 0}, { 1, 0, 0, 0}, {1, 1,  1, 1}},
+	{{ 0, 1, 0, 0}, { 0, 0, 1, 0}, {1, 0,  0, 0}},
+	{{ 1, 1,-1,-1}, { 0, 0, 0, 1}, {0, 1,  0, 0}},
+	{{ 0, 0, 0, 1}, { 1,-1,-1, 1}, {0, 0, -1, 0}},
+	{{ 0, 0, 1, 1}, {-1, 1, 0, 0}, {0, 1,  0, 1}},
+	{{-1, 0, 1, 1}, { 1,-1, 0, 1}, {0, 1,  1, 1}},
+	{{ 1, 0,-1, 0}, { 0,-1, 0, 1}, {0, 0,  1, 1}}
+};
+
+// Index of the only quadrant with coefficient one, -1 if the operand is a sum of quadrants.
+int singleQuadrant(const int (&c)[4])
+{
+	int q = -1;
+	for(int i = 0; i < 4; ++i){
+		if(c[i] == 0) continue;
+		if(c[i] != 1 || q >= 0) return -1;
+		q = i;
+	}
+	return q;
+}
+
+// Offset of quadrant q of a matrix with rows x cols quadrants and leading dimension ld.
+size_t quadrant(int q, size_t rows, size_t cols, size_t ld)
+{
+	return (q/2)*rows + (q%2)*cols*ld;
+}
+
+ocl::Event copyToImage(const ocl::Queue& queue, const ocl::Buffer& buffer, size_t offset, const ocl::Image& image,
+                       size_t width, size_t height, const ocl::EventList& list)
+{
+	const size_t origin[3] = {0, 0, 0}, region[3] = {width, height, 1};
+	cl_event event;
+	OPENCL_SAFE_CALL( clEnqueueCopyBufferToImage(queue.id(), buffer.id(), image.id(), offset, origin, region, list.size(), list.events().data(), &event) );
+	return ocl::Event(event, buffer.context());
+}
+
+ocl::Event copyFromImage(const ocl::Queue& queue, const ocl::Image& image, size_t width, size_t height,
+                         const ocl::Buffer& buffer, size_t offset, const ocl::EventList& list)
+{
+	const size_t origin[3] = {0, 0, 0}, region[3] = {width, height, 1};
+	cl_event event;
+	OPENCL_SAFE_CALL( clEnqueueCopyImageToBuffer(queue.id(), image.id(), buffer.id(), origin, region, offset, list.size(), list.events().data(), &event) );
+	return ocl::Event(event, buffer.context());
+}
+
+
+// Copies the rows x cols matrix at host with leading dimension ld into the packed tile.
+ocl::Event writeTile(const ocl::Queue& queue, const ocl::Buffer& tile, const void *host, size_t rows, size_t cols, size_t ld,
+                     size_t elementSize, const ocl::EventList& list)
+{
+	const size_t origin[3] = {0, 0, 0}, region[3] = {rows*elementSize, cols, 1};
+	cl_event event;
+	OPENCL_SAFE_CALL( clEnqueueWriteBufferRect(queue.id(), tile.id(), CL_FALSE, origin, origin, region, rows*elementSize, 0,
+	                                           ld*elementSize, 0, host, list.size(), list.events().data(), &event) );
+	return ocl::Event(event, tile.context());
+}
+
+// Copies the packed tile into the rows x cols matrix at host with leading dimension ld.
+ocl::Event readTile(const ocl::Queue& queue, const ocl::Buffer& tile, void *host, size_t rows, size_t cols, size_t ld,
+                    size_t elementSize, const ocl::EventList& list)
+{
+	const size_t origin[3] = {0, 0, 0}, region[3] = {rows*elementSize, cols, 1};
+	cl_event event;
+	OPENCL_SAFE_CALL( clEnqueueReadBufferRect(queue.id(), tile.id(), CL_FALSE, origin, origin, region, rows*elementSize, 0,
+	                                          ld*elementSize, 0, host, list.size(), list.events().data(), &event) );
+	return ocl::Event(event, tile.context());
+}
+
+// Edge t of the tiles of C and inner dimension tk of the tiles of A and B, so that two tiles
+// of A, B and C each fit into budget elements and every tile into maxAlloc elements.
+void tileSizes(size_t m, size_t n, size_t k, size_t budget, size_t maxAlloc, size_t& t, size_t& tk)
+{
+	const double square = std::floor(std::sqrt(std::min(budget/6.0, double(maxAlloc))));
+	tk = std::max<size_t>(1, std::min<size_t>(k, size_t(square)));
+
+	// With a short inner dimension the remaining memory enlarges the tiles of C: 2t^2 + 4t*tk <= budget.
+	const double edge = std::sqrt(double(tk)*tk + budget/2.0) - tk;
+	t = size_t(std::min(std::min(edge, std::floor(std::sqrt(double(maxAlloc)))), double(maxAlloc/tk)));
+	t = std::max<size_t>(1, t >= 64 ? t/64*64 : t);
+	t = std::min(t, std::max(m, n));
+}
+
+enum DeviceKind { AnyDevice, GpuDevice, CpuDevice };
+
+struct Tuning
+{
+	DeviceKind kind;
+	const char *vendor, *name; /*!< Substrings of the vendor and the name of the device, empty for any */
+	ocl::blas::GemmConfig config;
+};
+
+// Matched in this order. The image kernel is preferred on VLIW GPUs whose texture cache
+// outperforms their local memory, CPUs run the vector kernel without local memory.
+// Strassen pays off from a few thousand rows on, where the saved products outweigh the additions.
+const Tuning tunings[] = {
+	{GpuDevice, "Advanced Micro Devices", "Cypress", {ocl::blas::Image,   0, 64.0*64*64, 4096}},
+	{GpuDevice, "Advanced Micro Devices", "Cayman",  {ocl::blas::Image,   0, 64.0*64*64, 4096}},
+	{GpuDevice, "Intel",                  "",        {ocl::blas::Blocked, 0, 32.0*32*32, 2048}},
+	{GpuDevice, "",                       "",        {ocl::blas::Blocked, 0, 64.0*64*64, 4096}},
+	{CpuDevice, "",                       "",        {ocl::blas::Vector,  0, 16.0*16*16, 1024}},
+	{AnyDevice, "",                       "",        {ocl::blas::Blocked, 0, 32.0*32*32, 2048}}
+};
+
+std::map<std::string, ocl::blas::GemmConfig>& overrides()
+{
+	static std::map<std::string, ocl::blas::GemmConfig> configs;
+	return configs;
+}
+
+std::string& gemmSource()
+{
+	static std::string source;
+	return source;
+}
+
+std::string deviceKey(const ocl::Device& device)
+{
+	return device.vendor() + "/" + device.name();
+}
+
+}
+
+
+/*! \brief Returns the GemmConfig of the Device.
+  *
+  * A configuration set with setGemmConfig is returned first, otherwise
+  * the first entry of the built-in table which matches the type,
+  * the vendor and the name of the Device.
+  */
+ocl::blas::GemmConfig ocl::blas::gemmConfig(const Device& device)
+{
+	const auto it = overrides().find(deviceKey(device));
+	if(it != overrides().end()) return it->second;
+
+	const std::string vendor = device.vendor(), name = device.name();
+	for(const Tuning& t : tunings){
+		if(t.kind == GpuDevice && !device.isGpu()) continue;
+		if(t.kind == CpuDevice && !device.isCpu()) continue;
+		if(vendor.find(t.vendor) == std::string::npos || name.find(t.name) == std::string::npos) continue;
+		return t.config;
+	}
+	return tunings[sizeof(tunings)/sizeof(Tuning) - 1].config;
+}
+
+/*! \brief Sets the GemmConfig of all devices with the vendor and name of the Device, e.g. after tuning. */
+void ocl::blas::setGemmConfig(const Device& device, const GemmConfig& config)
+{
+	TRUE_ASSERT(config.vectorWidth == 0 || config.vectorWidth == 4 || config.vectorWidth == 8, "Invalid vector width " << config.vectorWidth);
+	overrides()[deviceKey(device)] = config;
+}
+
+/*! \brief Sets the source of gemm.cl, whose kernels Blocked, Vector and Image run.
+  *
+  * Only Blas objects which library creates afterwards build the kernels.
+  */
+void ocl::blas::setKernelSource(const std::string& source)
+{
+	gemmSource() = source;
+}
+
+/*! \brief Returns the source set with setKernelSource, which is empty by default. */
+const std::string& ocl::blas::kernelSource()
+{
+	return gemmSource();
+}
+
+
+/*! \brief Uploads the entries to a new Buffer with the Queue. */
+ocl::Blas::Batch::Batch(Context& ctxt, const Queue& queue, const std::vector<BatchEntry>& entries) :
+	_buffer(ctxt, std::max<size_t>(entries.size(), 1)*sizeof(BatchEntry), Buffer::ReadOnly), _entries(entries), _maxElements(0)
+{
+	static_assert(sizeof(BatchEntry) == 9*sizeof(unsigned int), "BatchEntry must be packed");
+
+	for(const BatchEntry& e : entries){
+		TRUE_ASSERT(e.ldc >= e.m, "Leading dimension of C " << e.ldc << " smaller than m = " << e.m);
+		_maxElements = std::max(_maxElements, e.m*e.n);
+	}
+	if(!entries.empty()) _buffer.write(queue, entries.data(), entries.size()*sizeof(BatchEntry));
+}
+
+/*! \brief Checks the leading dimensions of A and B for the transpositions and that all matrices lie within their Buffers.
+  *
+  * op(A_i) is m x k, so A_i has m rows without and k rows with transposition, and op(B_i) is k x n.
+  */
+void ocl::Blas::Batch::check(blas::Transpose transA, blas::Transpose transB, const Buffer& A, const Buffer& B, const Buffer& C,
+                             size_t elementSize) const
+{
+	for(size_t i = 0; i < _entries.size(); ++i){
+		const BatchEntry& e = _entries[i];
+		const size_t rowsA = transA == blas::NoTrans ? e.m : e.k, colsA = transA == blas::NoTrans ? e.k : e.m;
+		const size_t rowsB = transB == blas::NoTrans ? e.k : e.n, colsB = transB == blas::NoTrans ? e.n : e.k;
+
+		TRUE_ASSERT(e.lda >= rowsA, "Leading dimension of A " << e.lda << " of product " << i << " smaller than " << rowsA);
+		TRUE_ASSERT(e.ldb >= rowsB, "Leading dimension of B " << e.ldb << " of product " << i << " smaller than " << rowsB);
+		TRUE_ASSERT(A.size_bytes() >= (e.offsetA + span(rowsA, colsA, e.lda))*elementSize, "Buffer A too small for product " << i);
+		TRUE_ASSERT(B.size_bytes() >= (e.offsetB + span(rowsB, colsB, e.ldb))*elementSize, "Buffer B too small for product " << i);
+		TRUE_ASSERT(C.size_bytes() >= (e.offsetC + span(e.m, e.n, e.ldc))*elementSize, "Buffer C too small for product " << i);
+	}
+}
+
+
+/*! \brief Builds the kernels for the Types within the Context.
+  *
+  * If gemmSource holds gemm.cl, its kernels are built as well and gemm runs them,
+  * otherwise every product runs Naive. The kernels which read images are left out
+  * unless all devices support images.
+  */
+ocl::Blas::Blas(Context& ctxt, const utl::Types& types, const std::string& gemmSource) :
+	_program(ctxt, types), _gemm(), _workspace(), _images(true)
+{
+	for(const Device& device : ctxt.devices())
+		_images = _images && device.imageSupport();
+
+	_program << kernels;
+	_program.build();
+
+	if(gemmSource.empty()) return;
+
+	_gemm.reset(new Program(ctxt, types));
+	*_gemm << gemmSource;
+	for(const char *name : imageKernels)
+		if(!_images && _gemm->exists(name)) _gemm->deleteKernel(name);
+	_gemm->build();
+}
+
+/*! \brief Returns the OpenCL source of the templated kernels gemm_naive, gemm_batched_strided, gemm_batched,
+  * strassen_sum and strassen_update.
+  */
+const std::string& ocl::Blas::source()
+{
+	return kernels;
+}
+
+/*! \brief Computes C = alpha*op(A)*op(B) + beta*C.
+  *
+  * op(A) is m x k, op(B) is k x n and C is m x n. The matrices start at the
+  * elements offsetA, offsetB and offsetC of their Buffers. The kernel of the
+  * GemmConfig of the device is replaced by Naive for small products, by Blocked
+  * if the Vector kernel would need double or a transposed A or if the matrices
+  * do not fit into images, and by Naive if the device cannot run the work-groups
+  * of gemm.cl or the matrices exceed its 32-bit indices.
+  *
+  * The kernels of gemm.cl compute op(A)*op(B) only. Unless alpha is one and beta
+  * is zero, they write the product into a packed matrix, which strassen_update
+  * scales by alpha and adds to beta*C.
+  */
+template<class T>
+ocl::Event ocl::Blas::gemm(const Queue& queue, blas::Transpose transA, blas::Transpose transB, size_t m, size_t n, size_t k,
+                           T alpha, const Buffer& A, size_t offsetA, size_t lda,
+                                    const Buffer& B, size_t offsetB, size_t ldb,
+                           T beta,  const Buffer& C, size_t offsetC, size_t ldc, const EventList& list)
+{
+	TRUE_ASSERT(m > 0 && n > 0, "Nothing to compute");
+
+	const size_t rowsA = transA == blas::NoTrans ? m : k, colsA = transA == blas::NoTrans ? k : m;
+	const size_t rowsB = transB == blas::NoTrans ? k : n, colsB = transB == blas::NoTrans ? n : k;
+	TRUE_ASSERT(lda >= std::max<size_t>(rowsA, 1), "Leading dimension of A too small");
+	TRUE_ASSERT(ldb >= std::max<size_t>(rowsB, 1), "Leading dimension of B too small");
+	TRUE_ASSERT(ldc >= m, "Leading dimension of C too small");
+	TRUE_ASSERT(A.size_bytes() >= (offsetA + span(rowsA, colsA, lda))*sizeof(T), "Buffer A too small");
+	TRUE_ASSERT(B.size_bytes() >= (offsetB + span(rowsB, colsB, ldb))*sizeof(T), "Buffer B too small");
+	TRUE_ASSERT(C.size_bytes() >= (offsetC + span(m, n, ldc))*sizeof(T), "Buffer C too small");
+
+	const Device& device = queue.device();
+	const blas::GemmConfig config = blas::gemmConfig(device);
+	const size_t limit = std::numeric_limits<unsigned int>::max();
+
+	blas::GemmKernel kernel = _gemm ? config.kernel : blas::Naive;
+	if(double(m)*double(n)*double(k) < config.naiveBelow) kernel = blas::Naive;
+	if(kernel == blas::Vector && (sizeof(T) != sizeof(float) || transA != blas::NoTrans)) kernel = blas::Blocked;
+	if(kernel == blas::Image){
+		const bool fits = sizeof(T) == sizeof(float) && _images && m <= MaxImageSize && n <= MaxImageSize
+		               && lda <= MaxImageSize && colsA <= MaxImageSize && ldb <= MaxImageSize && colsB <= MaxImageSize
+		               && A.size_bytes() >= (offsetA + lda*colsA)*sizeof(T) && B.size_bytes() >= (offsetB + ldb*colsB)*sizeof(T);
+		if(!fits) kernel = blas::Blocked;
+	}
+	if(kernel == blas::Blocked || kernel == blas::Image){
+		const size_t local = kernel == blas::Blocked ? GemmTileK*(2*GemmTile + 1)*sizeof(T) : 0;
+		if(GemmGroup*GemmGroup > device.maxWorkGroupSize() || local > device.localMemSize()) kernel = blas::Naive;
+	}
+	if(kernel != blas::Image && offsetA + span(rowsA, colsA, lda) > limit) kernel = blas::Naive;
+	if(kernel != blas::Image && offsetB + span(rowsB, colsB, ldb) > limit) kernel = blas::Naive;
+	if(offsetC + span(m, n, ldc) > limit) kernel = blas::Naive;
+
+	const unsigned int um = (unsigned int)(m), un = (unsigned int)(n), uk = (unsigned int)(k);
+	const unsigned int ta = (unsigned int)(transA), tb = (unsigned int)(transB);
+
+	if(kernel == blas::Naive){
+		Kernel& naive = _program.kernel<T>("gemm_naive");
+		naive.setWorkSize(GroupSize2D, GroupSize2D, roundUp(m, GroupSize2D), roundUp(n, GroupSize2D));
+		return naive(queue, list, A.id(), B.id(), C.id(), um, un, uk, alpha, beta, ta, tb,
+		             offsetA, (unsigned int)(lda), offsetB, (unsigned int)(ldb), offsetC, (unsigned int)(ldc));
+	}
+
+	// The image of the product is copied as a whole, so it goes into C only without gaps between the columns.
+	const bool direct = alpha == T(1) && beta == T(0) && (kernel != blas::Image || ldc == m);
+	std::unique_ptr<Buffer> packed;
+	if(!direct) packed.reset(new Buffer(_program.context(), m*n*sizeof(T)));
+	const Buffer& P = direct ? C : *packed;
+	const unsigned int offsetP = direct ? (unsigned int)(offsetC) : 0u, ldp = direct ? (unsigned int)(ldc) : um;
+
+	// Distances between the rows and between the columns of op(A) and op(B) in the naming of gemm.cl,
+	// where StrideY steps down a column and StrideX along a row.
+	const unsigned int strideYA = transA ? (unsigned int)(lda) : 1u, strideXA = transA ? 1u : (unsigned int)(lda);
+	const unsigned int strideYB = transB ? (unsigned int)(ldb) : 1u, strideXB = transB ? 1u : (unsigned int)(ldb);
+
+	Event product;
+	if(kernel == blas::Vector){
+		const size_t preferred = device.preferredVectorWidthFloat();
+		const size_t width = config.vectorWidth > 0 ? config.vectorWidth : (preferred >= 8 ? 8 : 4);
+
+		Kernel& vector = _gemm->kernel(width == 8 ? "gemm_vec8" : "gemm_vec4");
+		vector.setWorkSize(GroupSize2D, GroupSize2D, roundUp((n + width - 1)/width, GroupSize2D), roundUp((m + width - 1)/width, GroupSize2D));
+		product = vector(queue, list, A.id(), B.id(), P.id(), uk, (unsigned int)(offsetA), (unsigned int)(offsetB), offsetP,
+		                 strideXA, strideXB, ldp, strideYA, strideYB, 1u, um, un);
+	}
+	else if(kernel == blas::Image){
+		// The images span the leading dimensions, so the columns are copied as a whole.
+		Image imageA(_program.context(), lda, colsA, Image::Float, Image::A, Image::ReadOnly);
+		Image imageB(_program.context(), ldb, colsB, Image::Float, Image::A, Image::ReadOnly);
+		Image imageC(_program.context(), m, n, Image::Float, Image::A, Image::WriteOnly);
+		EventList copies;
+		copies << copyToImage(queue, A, offsetA*sizeof(T), imageA, lda, colsA, list);
+		copies << copyToImage(queue, B, offsetB*sizeof(T), imageB, ldb, colsB, list);
+
+		Kernel& img = _gemm->kernel("gemm_img_basic_algorithm");
+		img.setWorkSize(GemmGroup, GemmGroup, roundUp(n, GemmTile)/GemmTile*GemmGroup, roundUp(m, GemmTile)/GemmTile*GemmGroup);
+		const Event multiplied = img(queue, copies, imageA.id(), imageB.id(), imageC.id(), int(k), 0, 0, 0, 0, 0, 0, int(ta), int(tb), 0);
+		product = copyFromImage(queue, imageC, m, n, P, offsetP*sizeof(T), EventList(multiplied));
+	}
+	else{
+		Kernel& block = _gemm->kernel<T>("gemm_basic_algorithm");
+		block.setWorkSize(GemmGroup, GemmGroup, roundUp(n, GemmTile)/GemmTile*GemmGroup, roundUp(m, GemmTile)/GemmTile*GemmGroup);
+		product = block(queue, list, A.id(), B.id(), P.id(), uk, (unsigned int)(offsetA), (unsigned int)(offsetB), offsetP,
+		                strideXA, strideXB, ldp, strideYA, strideYB, 1u, um, un);
+	}
+	if(direct) return product;
+
+	Kernel& update = _program.kernel<T>("strassen_update");
+	update.setWorkSize(GroupSize2D, GroupSize2D, roundUp(m, GroupSize2D), roundUp(n, GroupSize2D));
+	return update(queue, EventList(product), P.id(), um, C.id(), offsetC, (unsigned int)(ldc), um, un,
+	              alpha, beta, T(1), T(0), T(0), T(0));
+}
+
+/*! \brief Returns the workspace Buffer with the index, which is enlarged to at least bytes.
+  *
+  * Kernels which still use a replaced Buffer keep it alive until they are finished.
+  */
+const ocl::Buffer& ocl::Blas::workspace(size_t index, size_t bytes)
+{
+	if(_workspace.size() <= index) _workspace.resize(index + 1);
+
+	std::unique_ptr<Buffer>& buffer = _workspace[index];
+	if(!buffer || buffer->size_bytes() < bytes)
+		buffer.reset(new Buffer(_program.context(), std::max<size_t>(bytes, 1)));
+	return *buffer;
+}
+
+/*! \brief Computes C = alpha*A*B + beta*C with one level of the Strassen-Winograd recursion.
+  *
+  * The even-sized leading parts of the matrices are split into quadrants. Each of
+  * the seven products multiplies sums of quadrants of A and B, which strassen_sum
+  * forms in the workspace of the level unless the operand is a single quadrant, and
+  * strassen_update adds the product to all quadrants of C it contributes to. The last
+  * row and column of odd-sized matrices are computed with gemm afterwards. Below the
+  * crossover, gemm multiplies classically. All kernels run in order on the Queue.
+  */
+template<class T>
+ocl::Event ocl::Blas::strassen(const Queue& queue, size_t m, size_t n, size_t k, T alpha, const Buffer& A, size_t offsetA, size_t lda,
+                               const Buffer& B, size_t offsetB, size_t ldb, T beta, const Buffer& C, size_t offsetC, size_t ldc,
+                               size_t crossover, size_t level, const EventList& list)
+{
+	if(std::min(m, std::min(n, k)) < std::max<size_t>(crossover, 2))
+		return gemm<T>(queue, blas::NoTrans, blas::NoTrans, m, n, k, alpha, A, offsetA, lda, B, offsetB, ldb, beta, C, offsetC, ldc, list);
+
+	const size_t hm = m/2, hn = n/2, hk = k/2;
+	const Buffer& S = workspace(3*level,     hm*hk*sizeof(T));
+	const Buffer& U = workspace(3*level + 1, hk*hn*sizeof(T));
+	const Buffer& P = workspace(3*level + 2, hm*hn*sizeof(T));
+
+	Kernel& sum = _program.kernel<T>("strassen_sum");
+	Kernel& update = _program.kernel<T>("strassen_update");
+	Event last;
+	EventList deps(list);
+
+	for(size_t p = 0; p < 7; ++p){
+		const StrassenProduct& product = strassenProducts[p];
+		const int qa = singleQuadrant(product.a), qb = singleQuadrant(product.b);
+
+		const Buffer& a = qa < 0 ? S : A;
+		const size_t offA = qa < 0 ? 0 : offsetA + quadrant(qa, hm, hk, lda), ldA = qa < 0 ? hm : lda;
+		if(qa < 0){
+			sum.setWorkSize(GroupSize2D, GroupSize2D, roundUp(hm, GroupSize2D), roundUp(hk, GroupSize2D));
+			deps = EventList(sum(queue, deps, A.id(), offsetA, (unsigned int)(lda), (unsigned int)(hm), (unsigned int)(hk),
+			                     T(product.a[0]), T(product.a[1]), T(product.a[2]), T(product.a[3]), S.id(), (unsigned int)(hm)));
+		}
+
+		const Buffer& b = qb < 0 ? U : B;
+		const size_t offB = qb < 0 ? 0 : offsetB + quadrant(qb, hk, hn, ldb), ldB = qb < 0 ? hk : ldb;
+		if(qb < 0){
+			sum.setWorkSize(GroupSize2D, GroupSize2D, roundUp(hk, GroupSize2D), roundUp(hn, GroupSize2D));
+			deps = EventList(sum(queue, deps, B.id(), offsetB, (unsigned int)(ldb), (unsigned int)(hk), (unsigned int)(hn),
+			                     T(product.b[0]), T(product.b[1]), T(product.b[2]), T(product.b[3]), U.id(), (unsigned int)(hk)));
+		}
+
+		deps = EventList(strassen<T>(queue, hm, hn, hk, T(1), a, offA, ldA, b, offB, ldB, T(0), P, 0, hm, crossover, level + 1, deps));
+
+		// The first product covers all quadrants of C and applies beta.
+		update.setWorkSize(GroupSize2D, GroupSize2D, roundUp(hm, GroupSize2D), roundUp(hn, GroupSize2D));
+		last = update(queue, deps, P.id(), (unsigned int)(hm), C.id(), offsetC, (unsigned int)(ldc), (unsigned int)(hm), (unsigned int)(hn),
+		              alpha, p == 0 ? beta : T(1), T(product.c[0]), T(product.c[1]), T(product.c[2]), T(product.c[3]));
+		deps = EventList(last);
+	}
+
+	if(k%2 == 1)
+		last = gemm<T>(queue, blas::NoTrans, blas::NoTrans, 2*hm, 2*hn, 1, alpha, A, offsetA + (k - 1)*lda, lda,
+		               B, offsetB + k - 1, ldb, T(1), C, offsetC, ldc, EventList(last));
+	if(m%2 == 1)
+		last = gemm<T>(queue, blas::NoTrans, blas::NoTrans, 1, n, k, alpha, A, offsetA + m - 1, lda,
+		               B, offsetB, ldb, beta, C, offsetC + m - 1, ldc, EventList(last));
+	if(n%2 == 1)
+		last = gemm<T>(queue, blas::NoTrans, blas::NoTrans, 2*hm, 1, k, alpha, A, offsetA, lda,
+		               B, offsetB + (n - 1)*ldb, ldb, beta, C, offsetC + (n - 1)*ldc, ldc, EventList(last));
+	return last;
+}
+
+/*! \brief Computes C = alpha*A*B + beta*C with the Strassen-Winograd algorithm.
+  *
+  * A is m x k, B is k x n and C is m x n, none of them transposed. The recursion halves
+  * the dimensions as long as all of them are at least the crossover of the GemmConfig of
+  * the device and multiplies the remaining products with gemm. It performs 7 instead of 8
+  * products per level at the cost of 15 additions of quadrants, which slightly weakens the
+  * error bound, see blas::strassenErrorBound. The workspace needs about a third of the
+  * elements of A, B and C.
+  */
+template<class T>
+ocl::Event ocl::Blas::gemmStrassen(const Queue& queue, size_t m, size_t n, size_t k,
+                                   T alpha, const Buffer& A, size_t offsetA, size_t lda,
+                                            const Buffer& B, size_t offsetB, size_t ldb,
+                                   T beta,  const Buffer& C, size_t offsetC, size_t ldc, const EventList& list)
+{
+	TRUE_ASSERT(m > 0 && n > 0, "Nothing to compute");
+	TRUE_ASSERT(lda >= std::max<size_t>(m, 1), "Leading dimension of A too small");
+	TRUE_ASSERT(ldb >= std::max<size_t>(k, 1), "Leading dimension of B too small");
+	TRUE_ASSERT(ldc >= m, "Leading dimension of C too small");
+	TRUE_ASSERT(A.size_bytes() >= (offsetA + span(m, k, lda))*sizeof(T), "Buffer A too small");
+	TRUE_ASSERT(B.size_bytes() >= (offsetB + span(k, n, ldb))*sizeof(T), "Buffer B too small");
+	TRUE_ASSERT(C.size_bytes() >= (offsetC + span(m, n, ldc))*sizeof(T), "Buffer C too small");
+
+	const size_t crossover = blas::gemmConfig(queue.device()).crossover;
+	return strassen<T>(queue, m, n, k, alpha, A, offsetA, lda, B, offsetB, ldb, beta, C, offsetC, ldc, crossover, 0, list);
+}
+
+/*! \brief Computes C = alpha*op(A)*op(B) + beta*C for matrices in host memory.
+  *
+  * The matrices are split into tiles of C and tiles of A and B along the inner
+  * dimension, which are sized so that two tiles of each fit into deviceBytes and
+  * every tile into the largest allocation of the device. deviceBytes defaults to
+  * half the global memory. A tile of C stays on the device until all products
+  * of the inner dimension are accumulated into it. Tiles are uploaded and C is
+  * downloaded on two additional queues, so the transfers of the next tiles
+  * overlap with the multiplication of the current ones.
+  *
+  * A, B and C can be memory-mapped, e.g. by utl::MappedMatrix. The function
+  * returns when C is written back.
+  */
+template<class T>
+void ocl::Blas::gemmStreamed(const Queue& queue, blas::Transpose transA, blas::Transpose transB, size_t m, size_t n, size_t k,
+                             T alpha, const T *A, size_t lda, const T *B, size_t ldb, T beta, T *C, size_t ldc, size_t deviceBytes)
+{
+	TRUE_ASSERT(m > 0 && n > 0, "Nothing to compute");
+	TRUE_ASSERT(lda >= std::max<size_t>(transA == blas::NoTrans ? m : k, 1), "Leading dimension of A too small");
+	TRUE_ASSERT(ldb >= std::max<size_t>(transB == blas::NoTrans ? k : n, 1), "Leading dimension of B too small");
+	TRUE_ASSERT(ldc >= m, "Leading dimension of C too small");
+
+	const Device& device = queue.device();
+	const size_t budget = (deviceBytes > 0 ? deviceBytes : device.globalMemSize()/2)/sizeof(T);
+	size_t t, tk;
+	tileSizes(m, n, k, budget, device.maxMemAllocSize()/sizeof(T), t, tk);
+
+	const size_t tm = std::min(m, t), tn = std::min(n, t);
+	Context& ctxt = _program.context();
+	Queue upload(ctxt, device), download(ctxt, device);
+
+	const Buffer tileA[2] = {Buffer(ctxt, tm*tk*sizeof(T), Buffer::ReadOnly), Buffer(ctxt, tm*tk*sizeof(T), Buffer::ReadOnly)};
+	const Buffer tileB[2] = {Buffer(ctxt, tk*tn*sizeof(T), Buffer::ReadOnly), Buffer(ctxt, tk*tn*sizeof(T), Buffer::ReadOnly)};
+	const Buffer tileC[2] = {Buffer(ctxt, tm*tn*sizeof(T)), Buffer(ctxt, tm*tn*sizeof(T))};
+
+	EventList usedAB[2], usedC[2]; // last kernel which read a tile of A and B, last download of a tile of C
+	size_t step = 0, tile = 0;
+
+	for(size_t j0 = 0; j0 < n; j0 += tn){
+		for(size_t i0 = 0; i0 < m; i0 += tm, ++tile){
+			const size_t mi = std::min(tm, m - i0), nj = std::min(tn, n - j0);
+			const Buffer& c = tileC[tile%2];
+			T *hostC = C + i0 + j0*ldc;
+
+			EventList ready(usedC[tile%2]);
+			if(beta != T(0)) ready = EventList(writeTile(upload, c, hostC, mi, nj, ldc, sizeof(T), usedC[tile%2]));
+
+			// The inner dimension is split into at least one product, so C = beta*C for k = 0.
+			for(size_t p0 = 0; p0 < std::max<size_t>(k, 1); p0 += tk, ++step){
+				const size_t kp = std::min(tk, k - std::min(k, p0));
+				const Buffer& a = tileA[step%2];
+				const Buffer& b = tileB[step%2];
+				const size_t rowsA = transA == blas::NoTrans ? mi : kp, colsA = transA == blas::NoTrans ? kp : mi;
+				const size_t rowsB = transB == blas::NoTrans ? kp : nj, colsB = transB == blas::NoTrans ? nj : kp;
+
+				EventList deps(ready);
+				if(kp > 0){
+					const T *hostA = transA == blas::NoTrans ? A + i0 + p0*lda : A + p0 + i0*lda;
+					const T *hostB = transB == blas::NoTrans ? B + p0 + j0*ldb : B + j0 + p0*ldb;
+					deps << writeTile(upload, a, hostA, rowsA, colsA, lda, sizeof(T), usedAB[step%2])
+					     << writeTile(upload, b, hostB, rowsB, colsB, ldb, sizeof(T), usedAB[step%2]);
+					upload.flush();
+				}
+
+				const Event product = gemm<T>(queue, transA, transB, mi, nj, kp, alpha, a, 0, std::max<size_t>(rowsA, 1),
+				                              b, 0, std::max<size_t>(rowsB, 1), p0 == 0 ? beta : T(1), c, 0, mi, deps);
+				queue.flush();
+				usedAB[step%2] = EventList(product);
+				ready = EventList(product);
+			}
+
+			usedC[tile%2] = EventList(readTile(download, c, hostC, mi, nj, ldc, sizeof(T), ready));
+			download.flush();
+		}
+	}
+
+	queue.finish();
+	upload.finish();
+	download.finish();
+}
+
+/*! \brief Computes C_i = alpha*op(A_i)*op(B_i) + beta*C_i for count products of the same size.
+  *
+  * op(A_i) is m x k, op(B_i) is k x n and C_i is m x n. The matrices A_i, B_i and C_i
+  * start at the elements i*strideA, i*strideB and i*strideC of their Buffers.
+  */
+template<class T>
+ocl::Event ocl::Blas::gemmBatched(const Queue& queue, blas::Transpose transA, blas::Transpose transB, size_t m, size_t n, size_t k,
+                                  T alpha, const Buffer& A, size_t lda, size_t strideA,
+                                           const Buffer& B, size_t ldb, size_t strideB,
+                                  T beta,  const Buffer& C, size_t ldc, size_t strideC,
+                                  size_t count, const EventList& list)
+{
+	TRUE_ASSERT(count > 0 && m > 0 && n > 0, "Nothing to compute");
+	TRUE_ASSERT(lda >= (transA == blas::NoTrans ? m : k), "Leading dimension of A too small");
+	TRUE_ASSERT(ldb >= (transB == blas::NoTrans ? k : n), "Leading dimension of B too small");
+	TRUE_ASSERT(ldc >= m, "Leading dimension of C too small");
+
+	const size_t sizeA = transA == blas::NoTrans ? span(m, k, lda) : span(k, m, lda);
+	const size_t sizeB = transB == blas::NoTrans ? span(k, n, ldb) : span(n, k, ldb);
+	TRUE_ASSERT(A.size_bytes() >= ((count - 1)*strideA + sizeA)*sizeof(T), "Buffer A too small for " << count << " matrices");
+	TRUE_ASSERT(B.size_bytes() >= ((count - 1)*strideB + sizeB)*sizeof(T), "Buffer B too small for " << count << " matrices");
+	TRUE_ASSERT(C.size_bytes() >= ((count - 1)*strideC + span(m, n, ldc))*sizeof(T), "Buffer C too small for " << count << " matrices");
+
+	const unsigned int l = lanes(m*n);
+	const size_t groups = (count + LocalSize/l - 1)/(LocalSize/l);
+	Kernel& kernel = _program.kernel<T>("gemm_batched_strided");
+	kernel.setWorkSize(LocalSize, groups*LocalSize);
+
+	return kernel(queue, list, A.id(), B.id(), C.id(), (unsigned int)(m), (unsigned int)(n), (unsigned int)(k), alpha, beta,
+	              (unsigned int)(transA), (unsigned int)(transB), (unsigned int)(lda), (unsigned int)(ldb), (unsigned int)(ldc),
+	              strideA, strideB, strideC, (unsigned int)(count), l);
+}
+
+/*! \brief Computes C_i = alpha*op(A_i)*op(B_i) + beta*C_i for all products of the Batch.
+  *
+  * The offsets of an entry are given in elements of the Buffers A, B and C.
+  * The entries are checked against the transpositions and the Buffers, see Batch::check.
+  */
+template<class T>
+ocl::Event ocl::Blas::gemmBatched(const Queue& queue, blas::Transpose transA, blas::Transpose transB, T alpha, const Buffer& A, const Buffer& B,
+                                  T beta, const Buffer& C, const Batch& batch, const EventList& list)
+{
+	TRUE_ASSERT(batch.size() > 0, "Nothing to compute");
+	batch.check(transA, transB, A, B, C, sizeof(T));
+
+	const unsigned int l = lanes(batch.maxElements());
+	const size_t groups = (batch.size() + LocalSize/l - 1)/(LocalSize/l);
+	Kernel& kernel = _program.kernel<T>("gemm_batched");
+	kernel.setWorkSize(LocalSize, groups*LocalSize);
+
+	return kernel(queue, list, A.id(), B.id(), C.id(), batch.buffer().id(), alpha, beta,
+	              (unsigned int)(transA), (unsigned int)(transB), (unsigned int)(batch.size()), l);
+}
+
+/*! \brief Returns the Blas object of the Context, which is created on the first call.
+  *
+  * The kernels are built for double too if all devices of the Context support it,
+  * the kernels of gemm.cl if setKernelSource was called before.
+  */
+ocl::Blas& ocl::blas::library(Context& ctxt)
+{
+	static std::map<const Context*, std::unique_ptr<Blas> > libraries;
+
+	std::unique_ptr<Blas>& instance = libraries[&ctxt];
+	if(!instance || !instance->program().isBuilt()){ // released with a former Context at the same address
+		bool fp64 = true;
+		for(const Device& device : ctxt.devices())
+			fp64 = fp64 && device.preferredVectorWidthDouble() > 0;
+		instance.reset(new Blas(ctxt, fp64 ? utl::type::Single | utl::type::Double : utl::Types(utl::type::Single), blas::kernelSource()));
+	}
+	return *instance;
+}
+
+template<class T>
+ocl::Event ocl::blas::gemm(Transpose transA, Transpose transB, size_t M, size_t N, size_t K,
+                           T alpha, const Buffer& A, size_t lda, const Buffer& B, size_t ldb,
+                           T beta, const Buffer& C, size_t ldc, const EventList& list)
+{
+	Context *ctxt = C.context();
+	TRUE_ASSERT(ctxt != 0, "Buffer C has no Context");
+	return library(*ctxt).gemm<T>(ctxt->activeQueue(), transA, transB, M, N, K, alpha, A, 0, lda, B, 0, ldb, beta, C, 0, ldc, list);
+}
+
+/*! \brief Computes C = alpha*A*B + beta*C with the Strassen-Winograd algorithm and the active Queue of the Context of C.
+  *
+  * See Blas::gemmStrassen.
+  */
+template<class T>
+ocl::Event ocl::blas::gemmStrassen(size_t M, size_t N, size_t K, T alpha, const Buffer& A, size_t lda, const Buffer& B, size_t ldb,
+                                   T beta, const Buffer& C, size_t ldc, const EventList& list)
+{
+	Context *ctxt = C.context();
+	TRUE_ASSERT(ctxt != 0, "Buffer C has no Context");
+	return library(*ctxt).gemmStrassen<T>(ctxt->activeQueue(), M, N, K, alpha, A, 0, lda, B, 0, ldb, beta, C, 0, ldc, list);
+}
+
+/*! \brief Returns the factor f of the error bound max|C - fl(C)| <= f*max|A|*max|B| of gemmStrassen.
+  *
+  * The bound of the Winograd variant, f = ((n/n0)^log2(18)*(n0^2 + 6*n0) - 6*n)*u, holds
+  * to first order in the unit roundoff u for n x n matrices which are halved down to
+  * dimension n0 below the crossover. Classic gemm has f = n^2*u in the same norm.
+  */
+template<class T>
+double ocl::blas::strassenErrorBound(size_t n, size_t crossover)
+{
+	const double u = std::numeric_limits<T>::epsilon()/2;
+	size_t n0 = n;
+	while(n0 >= std::max<size_t>(crossover, 2)) n0 /= 2;
+
+	const double levels = std::pow(double(n)/double(n0), std::log2(18.0));
+	return (levels*(double(n0)*n0 + 6.0*n0) - 6.0*n)*u;
+}
+
+/*! \brief Computes C = alpha*op(A)*op(B) + beta*C for matrices in host memory with the active Queue of the Context.
+  *
+  * See Blas::gemmStreamed.
+  */
+template<class T>
+void ocl::blas::gemmStreamed(Context& ctxt, Transpose transA, Transpose transB, size_t M, size_t N, size_t K,
+                             T alpha, const T *A, size_t lda, const T *B, size_t ldb, T beta, T *C, size_t ldc)
+{
+	library(ctxt).gemmStreamed<T>(ctxt.activeQueue(), transA, transB, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+template ocl::Event ocl::Blas::gemm<float> (const Queue&, blas::Transpose, blas::Transpose, size_t, size_t, size_t,
+                                            float, const Buffer&, size_t, size_t, const Buffer&, size_t, size_t,
+                                            float, const Buffer&, size_t, size_t, const EventList&);
+template ocl::Event ocl::Blas::gemm<double>(const Queue&, blas::Transpose, blas::Transpose, size_t, size_t, size_t,
+                                            double, const Buffer&, size_t, size_t, const Buffer&, size_t, size_t,
+                                            double, const Buffer&, size_t, size_t, const EventList&);
+template ocl::Event ocl::Blas::gemmStrassen<float> (const Queue&, size_t, size_t, size_t, float, const Buffer&, size_t, size_t,
+                                                    const Buffer&, size_t, size_t, float, const Buffer&, size_t, size_t, const EventList&);
+template ocl::Event ocl::Blas::gemmStrassen<double>(const Queue&, size_t, size_t, size_t, double, const Buffer&, size_t, size_t,
+                                                    const Buffer&, size_t, size_t, double, const Buffer&, size_t, size_t, const EventList&);
+template void ocl::Blas::gemmStreamed<float> (const Queue&, blas::Transpose, blas::Transpose, size_t, size_t, size_t,
+                                              float, const float*, size_t, const float*, size_t, float, float*, size_t, size_t);
+template void ocl::Blas::gemmStreamed<double>(const Queue&, blas::Transpose, blas::Transpose, size_t, size_t, size_t,
+                                              double, const double*, size_t, const double*, size_t, double, double*, size_t, size_t);
+template ocl::Event ocl::Blas::gemmBatched<float> (const Queue&, blas::Transpose, blas::Transpose, size_t, size_t, size_t,
+                                                   float, const Buffer&, size_t, size_t, const Buffer&, size_t, size_t,
+                                                   float, const Buffer&, size_t, size_t, size_t, const EventList&);
+template ocl::Event ocl::Blas::gemmBatched<double>(const Queue&, blas::Transpose, blas::Transpose, size_t, size_t, size_t,
+                                                   double, const Buffer&, size_t, size_t, const Buffer&, size_t, size_t,
+                                                   double, const Buffer&, size_t, size_t, size_t, const EventList&);
+template ocl::Event ocl::Blas::gemmBatched<float> (const Queue&, blas::Transpose, blas::Transpose, float, const Buffer&, const Buffer&,
+                                                   float, const Buffer&, const Batch&, const EventList&);
+template ocl::Event ocl::Blas::gemmBatched<double>(const Queue&, blas::Transpose, blas::Transpose, double, const Buffer&, const Buffer&,
+                                                   double, const Buffer&, const Batch&, const EventList&);
+template ocl::Event ocl::blas::gemm<float> (Transpose, Transpose, size_t, size_t, size_t, float, const Buffer&, size_t, const Buffer&, size_t,
+                                            float, const Buffer&, size_t, const EventList&);
+template ocl::Event ocl::blas::gemm<double>(Transpose, Transpose, size_t, size_t, size_t, double, const Buffer&, size_t, const Buffer&, size_t,
+                                            double, const Buffer&, size_t, const EventList&);
+template ocl::Event ocl::blas::gemmStrassen<float> (size_t, size_t, size_t, float, const Buffer&, size_t, const Buffer&, size_t,
+                                                    float, const Buffer&, size_t, const EventList&);
+template ocl::Event ocl::blas::gemmStrassen<double>(size_t, size_t, size_t, double, const Buffer&, size_t, const Buffer&, size_t,
+                                                    double, const Buffer&, size_t, const EventList&);
+template double ocl::blas::strassenErrorBound<float> (size_t, size_t);
+template double ocl::blas::strassenErrorBound<double>(size_t, size_t);
+template void ocl::blas::gemmStreamed<float> (Context&, Transpose, Transpose, size_t, size_t, size_t,
+                                              float, const float*, size_t, const float*, size_t, float, float*, size_t);
+template void ocl::blas::gemmStreamed<double>(Context&, Transpose, Transpose, size_t, size_t, size_t,
+                                              double, const double*, size_t, const double*, size_t, double, double*, size_t);
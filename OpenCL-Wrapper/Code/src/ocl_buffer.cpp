@@ -41,6 +41,21 @@ ocl::Buffer::Buffer (Context& ctxt, size_t size_bytes, Access access ) :
     create(size_bytes,access);
 }
 
+/*! \brief Instantiates this Buffer within a context on top of host memory.
+  *
+  * The Buffer is created with UseHost, i.e. the implementation may use the host memory
+  * directly without copying (zero-copy) as long as host_ptr stays valid. Implementations
+  * usually require host_ptr to be page aligned, see utl::PageAlignedAllocator.
+  *
+  * \param host_ptr is the host memory which backs this Buffer.
+  * \param size_bytes is the size in bytes of the host memory.
+  */
+ocl::Buffer::Buffer (Context& ctxt, void *host_ptr, size_t size_bytes, Access access ) :
+    Memory(ctxt)
+{
+    create(host_ptr, size_bytes, access);
+}
+
 /*! \brief Instantiates this Buffer within a context with size_bytes.
   *
   * No Memory is allocated but only an object created which can be used within
@@ -142,6 +157,27 @@ void ocl::Buffer::create(size_t size_bytes, Access access )
     TRUE_ASSERT(_id != 0, "could not create buffer");
 }
 
+/*! \brief Creates cl_mem for this Buffer which uses the host memory host_ptr.
+  *
+  * Note that no Memory is allocated and AllocHost is never added.
+  *
+  * \param host_ptr is the host memory which backs this Buffer.
+  * \param size_bytes Number of bytes of host_ptr.
+  */
+void ocl::Buffer::create(void *host_ptr, size_t size_bytes, Access access )
+{
+    TRUE_ASSERT(this->_context != 0, "Context not valid - cannot create buffer");
+    TRUE_ASSERT(this->id() == nullptr, "Cannot create buffer twice. Please release buffer.");
+    TRUE_ASSERT(host_ptr != nullptr, "Host pointer must not be null");
+
+    cl_mem_flags flags = access | ocl::Buffer::UseHost;
+
+    cl_int status;
+    _id = clCreateBuffer(this->_context->id(), flags,  size_bytes, host_ptr, &status);
+    OPENCL_SAFE_CALL( status );
+    TRUE_ASSERT(_id != 0, "could not create buffer");
+}
+
 /*! \brief Creates cl_mem for this Buffer.
   *
   * Note that no Memory is allocated. Allocation takes place when data is transfered.
@@ -237,6 +237,30 @@ size_t ocl::Device::globalMemSize() const
     return size_t(a);
 }
 
+/*! \brief Returns the size in bytes of the global memory cache for *this, 0 without a cache. */
+size_t ocl::Device::globalMemCacheSize() const
+{
+    cl_ulong a;
+    OPENCL_SAFE_CALL(  clGetDeviceInfo (_id, CL_DEVICE_GLOBAL_MEM_CACHE_SIZE , sizeof(a), &a, NULL) );
+    return size_t(a);
+}
+
+/*! \brief Returns the size in bytes of a line of the global memory cache for *this . */
+size_t ocl::Device::globalMemCachelineSize() const
+{
+    cl_uint a;
+    OPENCL_SAFE_CALL(  clGetDeviceInfo (_id, CL_DEVICE_GLOBAL_MEM_CACHELINE_SIZE , sizeof(a), &a, NULL) );
+    return size_t(a);
+}
+
+/*! \brief Returns the type of the global memory cache for *this, i.e. CL_NONE, CL_READ_ONLY_CACHE or CL_READ_WRITE_CACHE. */
+cl_device_mem_cache_type ocl::Device::globalMemCacheType() const
+{
+    cl_device_mem_cache_type a;
+    OPENCL_SAFE_CALL(  clGetDeviceInfo (_id, CL_DEVICE_GLOBAL_MEM_CACHE_TYPE , sizeof(a), &a, NULL) );
+    return a;
+}
+
 /*! \brief Returns the local memory size in bytes for *this . */
 size_t ocl::Device::localMemSize() const
 {
@@ -245,6 +269,22 @@ size_t ocl::Device::localMemSize() const
     return size_t(a);
 }
 
+/*! \brief Returns the preferred number of floats in a vector for *this, e.g. 8 for CPUs with AVX. */
+size_t ocl::Device::preferredVectorWidthFloat() const
+{
+    cl_uint a;
+    OPENCL_SAFE_CALL(  clGetDeviceInfo (_id, CL_DEVICE_PREFERRED_VECTOR_WIDTH_FLOAT , sizeof(a), &a, NULL) );
+    return size_t(a);
+}
+
+/*! \brief Returns the preferred number of doubles in a vector for *this, 0 without double precision support. */
+size_t ocl::Device::preferredVectorWidthDouble() const
+{
+    cl_uint a;
+    OPENCL_SAFE_CALL(  clGetDeviceInfo (_id, CL_DEVICE_PREFERRED_VECTOR_WIDTH_DOUBLE , sizeof(a), &a, NULL) );
+    return size_t(a);
+}
+
 /*! \brief Returns the OpenCL platform on which this Device is located.*/
 cl_platform_id ocl::Device::platform() const
 {
@@ -264,6 +304,15 @@ std::string ocl::Device::version() const
 	return buffer;
 }
 
+/*! \brief Returns the version of the OpenCL driver of this Device .*/
+std::string ocl::Device::driverVersion() const
+{
+  char buffer[100];
+  
+	OPENCL_SAFE_CALL( clGetDeviceInfo(this->id(), CL_DRIVER_VERSION,  sizeof buffer, buffer, NULL));
+	return buffer;
+}
+
 /*! \brief Returns the name of this Device .*/
 std::string ocl::Device::name() const
 {
@@ -0,0 +1,145 @@
+//Copyright (C) 2013 Cem Bassoy.
+//
+//This file is part of the OpenCL Utility Toolkit.
+//
+//OpenCL Utility Toolkit is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+//
+//OpenCL Utility Toolkit is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License
+//along with OpenCL Utility Toolkit.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <ocl_random.h>
+#include <ocl_context.h>
+#include <ocl_queue.h>
+#include <ocl_buffer.h>
+#include <ocl_kernel.h>
+
+#include <utl_assert.h>
+
+
+namespace {
+
+// Element i is word i%4 of block i/4. The counter of a block is (block, stream, 0)
+// and the key is the seed, see utl::Philox. Floats use the upper 24 bits of a word.
+const std::string kernels = R"(
+template<class T>
+__kernel void philox_uniform(__global T* data, ulong offset, ulong n, uint key0, uint key1, T low, T high)
+{
+  ulong const block = offset/4 + get_global_id(0);
+  ulong const end   = offset + n;
+  if(4*block >= end) return;
+
+  uint c0 = (uint)block, c1 = (uint)(block >> 32), c2 = 0u, c3 = 0u;
+  uint k0 = key0, k1 = key1;
+  for(int r = 0; r < 10; ++r){
+    uint const h0 = mul_hi(0xD2511F53u, c0), l0 = 0xD2511F53u*c0;
+    uint const h1 = mul_hi(0xCD9E8D57u, c2), l1 = 0xCD9E8D57u*c2;
+    c0 = h1 ^ c1 ^ k0; c2 = h0 ^ c3 ^ k1; c1 = l1; c3 = l0;
+    k0 += 0x9E3779B9u; k1 += 0xBB67AE85u;
+  }
+
+  uint const words[4] = {c0, c1, c2, c3};
+  uint const shift = sizeof(T) == 4 ? 8u : 0u;
+  for(uint l = 0; l < 4; ++l){
+    ulong const e = 4*block + l;
+    if(e < offset || e >= end) continue;
+    T const u = (T)(words[l] >> shift) / (T)(1UL << (32u - shift));
+    data[e - offset] = fma(u, high - low, low);
+  }
+}
+
+template<class T>
+__kernel void philox_normal(__global T* data, ulong offset, ulong n, uint key0, uint key1, T mean, T dev)
+{
+  ulong const block = offset/4 + get_global_id(0);
+  ulong const end   = offset + n;
+  if(4*block >= end) return;
+
+  uint c0 = (uint)block, c1 = (uint)(block >> 32), c2 = 1u, c3 = 0u;
+  uint k0 = key0, k1 = key1;
+  for(int r = 0; r < 10; ++r){
+    uint const h0 = mul_hi(0xD2511F53u, c0), l0 = 0xD2511F53u*c0;
+    uint const h1 = mul_hi(0xCD9E8D57u, c2), l1 = 0xCD9E8D57u*c2;
+    c0 = h1 ^ c1 ^ k0; c2 = h0 ^ c3 ^ k1; c1 = l1; c3 = l0;
+    k0 += 0x9E3779B9u; k1 += 0xBB67AE85u;
+  }
+
+  uint const words[4] = {c0, c1, c2, c3};
+  uint const shift = sizeof(T) == 4 ? 8u : 0u;
+  for(uint l = 0; l < 4; l += 2){
+    T const u1 = ((T)(words[l] >> shift) + (T)1) / (T)(1UL << (32u - shift));
+    T const u2 = (T)(words[l+1] >> shift) / (T)(1UL << (32u - shift));
+    T const r  = sqrt((T)-2*log(u1));
+    T const z[2] = {r*cospi((T)2*u2), r*sinpi((T)2*u2)};
+    for(uint i = 0; i < 2; ++i){
+      ulong const e = 4*block + l + i;
+      if(e >= offset && e < end) data[e - offset] = mean + dev*z[i];
+    }
+  }
+}
+)";
+
+// Work-items per work-group, the global size is rounded up to a multiple.
+const size_t LocalSize = 64;
+
+}
+
+
+/*! \brief Builds the kernels for the Types within the Context. */
+ocl::Random::Random(Context& ctxt, const utl::Types& types) :
+	_program(ctxt, types)
+{
+	_program << kernels;
+	_program.build();
+}
+
+/*! \brief Returns the OpenCL source of the templated kernels philox_uniform and philox_normal. */
+const std::string& ocl::Random::source()
+{
+	return kernels;
+}
+
+/*! \brief Fills the first n elements of the Buffer with uniform numbers in [min, max).
+  *
+  * \param offset index of the first element within the sequence of the seed.
+  */
+template<class T>
+ocl::Event ocl::Random::uniform(const Queue& queue, const Buffer& buffer, size_t n, T min, T max, std::uint64_t seed, size_t offset, const EventList& list)
+{
+	return launch<T>("philox_uniform", queue, buffer, n, min, max, seed, offset, list);
+}
+
+/*! \brief Fills the first n elements of the Buffer with normal numbers.
+  *
+  * \param offset index of the first element within the sequence of the seed.
+  */
+template<class T>
+ocl::Event ocl::Random::normal(const Queue& queue, const Buffer& buffer, size_t n, T mean, T dev, std::uint64_t seed, size_t offset, const EventList& list)
+{
+	return launch<T>("philox_normal", queue, buffer, n, mean, dev, seed, offset, list);
+}
+
+template<class T>
+ocl::Event ocl::Random::launch(const std::string& name, const Queue& queue, const Buffer& buffer, size_t n, T a, T b, std::uint64_t seed, size_t offset, const EventList& list)
+{
+	TRUE_ASSERT(n > 0, "Nothing to generate");
+	TRUE_ASSERT(buffer.size_bytes() >= n*sizeof(T), "Buffer too small for " << n << " elements");
+
+	const size_t blocks = (offset + n + 3)/4 - offset/4;
+	Kernel& kernel = _program.kernel<T>(name);
+	kernel.setWorkSize(LocalSize, (blocks + LocalSize - 1)/LocalSize*LocalSize);
+
+	return kernel(queue, list, buffer.id(), offset, n, (unsigned int)(seed), (unsigned int)(seed >> 32), a, b);
+}
+
+template ocl::Event ocl::Random::uniform<float> (const Queue&, const Buffer&, size_t, float, float, std::uint64_t, size_t, const EventList&);
+template ocl::Event ocl::Random::uniform<double>(const Queue&, const Buffer&, size_t, double, double, std::uint64_t, size_t, const EventList&);
+template ocl::Event ocl::Random::normal<float>  (const Queue&, const Buffer&, size_t, float, float, std::uint64_t, size_t, const EventList&);
+template ocl::Event ocl::Random::normal<double> (const Queue&, const Buffer&, size_t, double, double, std::uint64_t, size_t, const EventList&);
@@ -0,0 +1,571 @@
+//Copyright (C) 2013 Cem Bassoy.
+//
+//This file is part of the OpenCL Utility Toolkit.
+//
+//OpenCL Utility Toolkit is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+//
+//OpenCL Utility Toolkit is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License
+//along with OpenCL Utility Toolkit.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <ocl_reduce.h>
+#include <ocl_context.h>
+#include <ocl_device.h>
+#include <ocl_query.h>
+#include <ocl_queue.h>
+#include <ocl_kernel.h>
+
+#include <utl_assert.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <limits>
+
+
+namespace {
+
+// Every work-item reduces a strided share of vectors of four elements and the rest,
+// a work-group folds the values above the largest power of two below its size onto
+// the lower ones and then halves them, so any local size works and all work-items
+// reach the barriers. OP is the operator and VEC4 the vector type, see operatorOptions.
+const std::string valueSource = R"(
+template<class T>
+__kernel void reduce(__global T const* restrict x, ulong offset, ulong n, T const identity, __local T* s, __global T* restrict y)
+{
+  uint const lid = get_local_id(0), size = get_local_size(0);
+  ulong const gid = get_global_id(0), workers = get_global_size(0);
+  __global T const* z = x + offset;
+
+  T c = identity;
+  for(ulong i = gid; i < n/4; i += workers){
+    VEC4(T) const v = vload4(i, z);
+    c = OP(c, v.s0);
+    c = OP(c, v.s1);
+    c = OP(c, v.s2);
+    c = OP(c, v.s3);
+  }
+  for(ulong i = n/4*4 + gid; i < n; i += workers)
+    c = OP(c, z[i]);
+  s[lid] = c;
+  barrier(CLK_LOCAL_MEM_FENCE);
+
+  uint p = 1;
+  while(2*p < size) p *= 2;
+  for(uint j = p; j > 0; j /= 2){
+    if(lid < j && lid + j < size) s[lid] = OP(s[lid], s[lid + j]);
+    barrier(CLK_LOCAL_MEM_FENCE);
+  }
+  if(lid == 0) y[get_group_id(0)] = s[0];
+}
+)";
+
+// Reduces pairs of values and indices, an element replaces the current one if it is smaller,
+// or larger if largest is set, or if it is equal and has a lower index. The first stage takes
+// the indices from the positions, later stages read them from index. An index of none marks
+// no element. Values and indices are read as vectors of four with the same strided share as reduce.
+const std::string argSource = R"(
+template<class T>
+__kernel void argreduce(__global T const* restrict x, __global ulong const* restrict index, uint indexed, uint largest, ulong offset, ulong n,
+                        __local T* s, __local ulong* t, __global T* restrict y, __global ulong* restrict z)
+{
+  uint const lid = get_local_id(0), size = get_local_size(0);
+  ulong const gid = get_global_id(0), workers = get_global_size(0), none = ~(ulong)0;
+  __global T const* u = x + offset;
+
+  T c = 0;
+  ulong at = none;
+  for(ulong i = gid; i < n/4; i += workers){
+    VEC4(T) const v = vload4(i, u);
+    ulong4 const k = indexed ? vload4(i, index) : (ulong4)(4*i, 4*i + 1, 4*i + 2, 4*i + 3);
+    T const w[4] = {v.s0, v.s1, v.s2, v.s3};
+    ulong const l[4] = {k.s0, k.s1, k.s2, k.s3};
+    for(uint j = 0; j < 4; ++j)
+      if(l[j] != none && (at == none || (largest ? w[j] > c : w[j] < c) || (w[j] == c && l[j] < at))){ c = w[j]; at = l[j]; }
+  }
+  for(ulong i = n/4*4 + gid; i < n; i += workers){
+    T const v = u[i];
+    ulong const k = indexed ? index[i] : i;
+    if(k != none && (at == none || (largest ? v > c : v < c) || (v == c && k < at))){ c = v; at = k; }
+  }
+  s[lid] = c;
+  t[lid] = at;
+  barrier(CLK_LOCAL_MEM_FENCE);
+
+  uint p = 1;
+  while(2*p < size) p *= 2;
+  for(uint j = p; j > 0; j /= 2){
+    if(lid < j && lid + j < size){
+      T const v = s[lid + j];
+      ulong const k = t[lid + j];
+      if(k != none && (t[lid] == none || (largest ? v > s[lid] : v < s[lid]) || (v == s[lid] && k < t[lid]))){ s[lid] = v; t[lid] = k; }
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+  }
+  if(lid == 0){
+    y[get_group_id(0)] = s[0];
+    z[get_group_id(0)] = t[0];
+  }
+}
+)";
+
+// Every work-item scans a vector of four elements, a work-group scans the totals of its
+// work-items with the up- and down-sweep of Blelloch, which needs a power-of-two local size,
+// and stores its total in sums. scan_add combines each element with the scanned total of the
+// preceding work-groups. Input and output may be the same Buffer.
+const std::string scanSource = R"(
+template<class T>
+__kernel void scan(__global T const* x, ulong xoffset, __global T* y, ulong yoffset, ulong n, uint inclusive, T const identity,
+                   __local T* s, __global T* restrict sums)
+{
+  uint const lid = get_local_id(0), size = get_local_size(0);
+  ulong const i = get_global_id(0);
+  __global T const* u = x + xoffset;
+  __global T* v = y + yoffset;
+
+  VEC4(T) e = (VEC4(T))(identity);
+  if(4*i + 3 < n) e = vload4(i, u);
+  else{
+    if(4*i < n)     e.s0 = u[4*i];
+    if(4*i + 1 < n) e.s1 = u[4*i + 1];
+    if(4*i + 2 < n) e.s2 = u[4*i + 2];
+  }
+  e.s1 = OP(e.s0, e.s1);
+  e.s2 = OP(e.s1, e.s2);
+  e.s3 = OP(e.s2, e.s3);
+
+  s[lid] = e.s3;
+  barrier(CLK_LOCAL_MEM_FENCE);
+  for(uint d = 1; d < size; d *= 2){
+    uint const k = (lid + 1)*2*d - 1;
+    if(k < size) s[k] = OP(s[k - d], s[k]);
+    barrier(CLK_LOCAL_MEM_FENCE);
+  }
+  if(lid == 0){
+    sums[get_group_id(0)] = s[size - 1];
+    s[size - 1] = identity;
+  }
+  barrier(CLK_LOCAL_MEM_FENCE);
+  for(uint d = size/2; d > 0; d /= 2){
+    uint const k = (lid + 1)*2*d - 1;
+    if(k < size){
+      T const a = s[k], b = s[k - d];
+      s[k - d] = a;
+      s[k] = OP(a, b);
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+  }
+
+  T const p = s[lid];
+  VEC4(T) r;
+  if(inclusive){
+    r.s0 = OP(p, e.s0);
+    r.s1 = OP(p, e.s1);
+    r.s2 = OP(p, e.s2);
+    r.s3 = OP(p, e.s3);
+  }
+  else{
+    r.s0 = p;
+    r.s1 = OP(p, e.s0);
+    r.s2 = OP(p, e.s1);
+    r.s3 = OP(p, e.s2);
+  }
+  if(4*i + 3 < n) vstore4(r, i, v);
+  else{
+    if(4*i < n)     v[4*i]     = r.s0;
+    if(4*i + 1 < n) v[4*i + 1] = r.s1;
+    if(4*i + 2 < n) v[4*i + 2] = r.s2;
+  }
+}
+
+template<class T>
+__kernel void scan_add(__global T* y, ulong yoffset, ulong n, __global T const* restrict sums)
+{
+  ulong const i = get_global_id(0);
+  T const p = sums[get_group_id(0)];
+  __global T* v = y + yoffset;
+
+  if(4*i + 3 < n){
+    VEC4(T) e = vload4(i, v);
+    e.s0 = OP(p, e.s0);
+    e.s1 = OP(p, e.s1);
+    e.s2 = OP(p, e.s2);
+    e.s3 = OP(p, e.s3);
+    vstore4(e, i, v);
+  }
+  else{
+    for(ulong j = 4*i; j < n; ++j) v[j] = OP(p, v[j]);
+  }
+}
+)";
+
+// Largest local size of the reduction kernels.
+const size_t MaxLocalSize = 256;
+
+// Elements which a work-item reduces at least before a further work-group is started.
+const size_t ElementsPerItem = 16;
+
+// Work-groups per compute unit of a stage.
+const size_t GroupsPerUnit = 4;
+
+// Option which defines VEC4(t) as the vector of four elements of type t.
+const std::string vectorOption = "-DVEC4(t)=t##4";
+
+// Options which define the operator as the macro OP(a, b) as well.
+// Blanks separate the options, so blanks of the expression become comments.
+std::string operatorOptions(const std::string& expression)
+{
+	std::string op;
+	for(const char c : expression)
+		op += std::isspace(static_cast<unsigned char>(c)) ? std::string("/**/") : std::string(1, c);
+	return vectorOption + " -DOP(a,b)=(" + op + ")";
+}
+
+// Returns the Kernel with the name of the Program, which is specialised for T.
+template<class T>
+ocl::Kernel& specialised(const ocl::Program& program, const std::string& name)
+{
+	const utl::Type& type = utl::Type::type<T>();
+	TRUE_ASSERT(program.types().contains(type), "Not all devices of the Context support " << type.name());
+	return program.kernel(name, type);
+}
+
+// Largest local size which the device supports for the kernel, at most MaxLocalSize.
+size_t localSize(const ocl::Kernel& kernel, const ocl::Device& device)
+{
+	size_t size = 0;
+	OPENCL_SAFE_CALL( clGetKernelWorkGroupInfo(kernel.id(), device.id(), CL_KERNEL_WORK_GROUP_SIZE, sizeof(size), &size, NULL) );
+	return std::max<size_t>(std::min(size, MaxLocalSize), 1);
+}
+
+// Largest power of two not above the local sizes of both scan kernels.
+size_t scanLocalSize(const ocl::Kernel& block, const ocl::Kernel& add, const ocl::Device& device)
+{
+	const size_t limit = std::min(localSize(block, device), localSize(add, device));
+	size_t size = 1;
+	while(2*size <= limit) size *= 2;
+	return size;
+}
+
+// Work-groups of a stage which reduces count elements.
+size_t groups(size_t count, size_t local, const ocl::Device& device)
+{
+	const size_t needed = (count + local*ElementsPerItem - 1)/(local*ElementsPerItem);
+	return std::max<size_t>(std::min(needed, GroupsPerUnit*device.maxComputeUnits()), 1);
+}
+
+}
+
+
+/*! \brief Creates a built-in operator. */
+ocl::ReduceOp::ReduceOp(Kind kind) :
+	_name(kind == Sum ? "sum" : kind == Min ? "min" : "max"),
+	_expression(kind == Sum ? "a + b" : kind == Min ? "min(a, b)" : "max(a, b)"), _identity(0)
+{
+}
+
+/*! \brief Creates an operator from an OpenCL expression of a and b and its neutral element.
+  *
+  * The name must differ from the names of other operators,
+  * e.g. ReduceOp("absmax", "max(fabs(a), fabs(b))", 0) for the largest magnitude.
+  */
+ocl::ReduceOp::ReduceOp(const std::string& name, const std::string& expression, double identity) :
+	_name(name), _expression(expression), _identity(identity)
+{
+	TRUE_ASSERT(!name.empty() && name != "sum" && name != "min" && name != "max", "Invalid name " << name << " of a custom operator");
+	TRUE_ASSERT(!expression.empty(), "Operator " << name << " needs an expression");
+}
+
+/*! \brief Returns the neutral element of the operator for the element type. */
+template<class T>
+T ocl::ReduceOp::identity() const
+{
+	typedef std::numeric_limits<T> limits;
+	if(_name == "min") return limits::has_infinity ? limits::infinity() : limits::max();
+	if(_name == "max") return limits::has_infinity ? -limits::infinity() : limits::lowest();
+
+	TRUE_ASSERT(limits::has_infinity || std::isfinite(_identity), "Neutral element of " << _name << " is no " << utl::Type::type<T>().name());
+	return static_cast<T>(_identity);
+}
+
+
+ocl::Reduction::Reduction(Context& ctxt) :
+	_ctxt(ctxt), _programs(), _workspace()
+{
+}
+
+/*! \brief Returns true if all generated Programs are still built, i.e. the Context was not released. */
+bool ocl::Reduction::isBuilt() const
+{
+	for(const auto& p : _programs)
+		if(!p.second->isBuilt()) return false;
+	return true;
+}
+
+/*! \brief Returns the Program with the key, which is built from the templated source on the first call.
+  *
+  * The kernels are specialised for float, int and unsigned int, and for double
+  * if all devices of the Context support the cl_khr_fp64 extension.
+  */
+ocl::Program& ocl::Reduction::program(const std::string& key, const std::string& source, const CompileOption& options)
+{
+	std::unique_ptr<Program>& program = _programs[key];
+	if(program) return *program;
+
+	utl::Types types = utl::type::Single | utl::type::Int | utl::type::UInt;
+	bool fp64 = true;
+	for(const Device& device : _ctxt.devices())
+		fp64 = fp64 && device.preferredVectorWidthDouble() > 0;
+	if(fp64) types << utl::type::Double;
+
+	program.reset(new Program(_ctxt, types, options));
+	*program << source;
+	program->build();
+	return *program;
+}
+
+/*! \brief Returns the workspace Buffer with the index, which is enlarged to at least bytes. */
+const ocl::Buffer& ocl::Reduction::workspace(size_t index, size_t bytes)
+{
+	if(_workspace.size() <= index) _workspace.resize(index + 1);
+
+	std::unique_ptr<Buffer>& buffer = _workspace[index];
+	if(!buffer || buffer->size_bytes() < bytes)
+		buffer.reset(new Buffer(_ctxt, std::max<size_t>(bytes, 1)));
+	return *buffer;
+}
+
+/*! \brief Returns the n elements from offset on of the Buffer combined with the operator.
+  *
+  * The function waits for the list and returns when the result is read.
+  */
+template<class T>
+T ocl::Reduction::reduce(const Queue& queue, const Buffer& buffer, const ReduceOp& op, size_t n, size_t offset, const EventList& list)
+{
+	TRUE_ASSERT(n > 0, "Nothing to reduce");
+	TRUE_ASSERT(buffer.size_bytes() >= (offset + n)*sizeof(T), "Buffer too small for " << n << " elements");
+
+	Kernel& kernel = specialised<T>(program("reduce/" + op.name(), valueSource + scanSource, operatorOptions(op.expression())), "reduce");
+	const Device& device = queue.device();
+	const size_t local = localSize(kernel, device);
+
+	const Buffer *input = &buffer;
+	EventList deps(list);
+	for(size_t count = n, stage = 0; count > 1 || stage == 0; ++stage){
+		const size_t g = groups(count, local, device);
+		const Buffer& output = workspace(stage%2, g*sizeof(T));
+
+		kernel.setWorkSize(local, g*local);
+		deps = EventList(kernel(queue, deps, input->id(), stage == 0 ? offset : size_t(0), count, op.identity<T>(), local*sizeof(T), output.id()));
+		input = &output;
+		count = g;
+	}
+
+	T result;
+	input->read(queue, 0, &result, sizeof(T), deps);
+	return result;
+}
+
+/*! \brief Returns the index of the smallest element, or of the largest one if largest is set. */
+template<class T>
+size_t ocl::Reduction::argreduce(bool largest, const Queue& queue, const Buffer& buffer, size_t n, size_t offset, const EventList& list)
+{
+	TRUE_ASSERT(n > 0, "Nothing to reduce");
+	TRUE_ASSERT(buffer.size_bytes() >= (offset + n)*sizeof(T), "Buffer too small for " << n << " elements");
+
+	Kernel& kernel = specialised<T>(program("argreduce", argSource, vectorOption), "argreduce");
+	const Device& device = queue.device();
+	const size_t local = localSize(kernel, device);
+
+	const Buffer *values = &buffer, *indices = &buffer;
+	EventList deps(list);
+	for(size_t count = n, stage = 0; count > 1 || stage == 0; ++stage){
+		const size_t g = groups(count, local, device);
+		const Buffer& y = workspace(stage%2, g*sizeof(T));
+		const Buffer& z = workspace(2 + stage%2, g*sizeof(cl_ulong));
+
+		kernel.setWorkSize(local, g*local);
+		deps = EventList(kernel(queue, deps, values->id(), indices->id(), (unsigned int)(stage > 0), (unsigned int)(largest),
+		                        stage == 0 ? offset : size_t(0), count, local*sizeof(T), local*sizeof(cl_ulong), y.id(), z.id()));
+		values = &y;
+		indices = &z;
+		count = g;
+	}
+
+	cl_ulong index;
+	indices->read(queue, 0, &index, sizeof(index), deps);
+	return size_t(index);
+}
+
+/*! \brief Returns the index of the smallest of the n elements from offset on, relative to offset. */
+template<class T>
+size_t ocl::Reduction::argmin(const Queue& queue, const Buffer& buffer, size_t n, size_t offset, const EventList& list)
+{
+	return argreduce<T>(false, queue, buffer, n, offset, list);
+}
+
+/*! \brief Returns the index of the largest of the n elements from offset on, relative to offset. */
+template<class T>
+size_t ocl::Reduction::argmax(const Queue& queue, const Buffer& buffer, size_t n, size_t offset, const EventList& list)
+{
+	return argreduce<T>(true, queue, buffer, n, offset, list);
+}
+
+/*! \brief Writes the prefixes of one level of the scan and scans the totals of its work-groups on the next level. */
+template<class T>
+ocl::Event ocl::Reduction::scan(const Queue& queue, const Buffer& input, size_t inputOffset, const Buffer& output, size_t outputOffset,
+                                size_t n, const ReduceOp& op, bool inclusive, const EventList& list)
+{
+	const Program& scans = program("reduce/" + op.name(), valueSource + scanSource, operatorOptions(op.expression()));
+	Kernel& block = specialised<T>(scans, "scan");
+	Kernel& add = specialised<T>(scans, "scan_add");
+	const size_t local = scanLocalSize(block, add, queue.device());
+
+	// The totals belong to this call, as scans on other queues may still use those of an earlier one.
+	// The Buffer is released once the kernels which use it are finished.
+	const size_t groups = (n + 4*local - 1)/(4*local);
+	const Buffer sums(_ctxt, groups*sizeof(T));
+
+	block.setWorkSize(local, groups*local);
+	const Event scanned = block(queue, list, input.id(), inputOffset, output.id(), outputOffset, n, (unsigned int)(inclusive),
+	                            op.identity<T>(), local*sizeof(T), sums.id());
+	if(groups == 1) return scanned;
+
+	const Event offsets = scan<T>(queue, sums, 0, sums, 0, groups, op, false, EventList(scanned));
+	add.setWorkSize(local, groups*local);
+	return add(queue, EventList(offsets), output.id(), outputOffset, n, sums.id());
+}
+
+/*! \brief Writes the exclusive prefixes of the n elements of input from inputOffset on to output from outputOffset on.
+  *
+  * Element i of the output combines the elements 0 to i-1 with the operator, the first one is its neutral element.
+  */
+template<class T>
+ocl::Event ocl::Reduction::exclusiveScan(const Queue& queue, const Buffer& input, const Buffer& output, size_t n, const ReduceOp& op,
+                                         size_t inputOffset, size_t outputOffset, const EventList& list)
+{
+	TRUE_ASSERT(n > 0, "Nothing to scan");
+	TRUE_ASSERT(input.size_bytes() >= (inputOffset + n)*sizeof(T), "Input Buffer too small for " << n << " elements");
+	TRUE_ASSERT(output.size_bytes() >= (outputOffset + n)*sizeof(T), "Output Buffer too small for " << n << " elements");
+	return scan<T>(queue, input, inputOffset, output, outputOffset, n, op, false, list);
+}
+
+/*! \brief Writes the inclusive prefixes of the n elements of input from inputOffset on to output from outputOffset on.
+  *
+  * Element i of the output combines the elements 0 to i with the operator.
+  */
+template<class T>
+ocl::Event ocl::Reduction::inclusiveScan(const Queue& queue, const Buffer& input, const Buffer& output, size_t n, const ReduceOp& op,
+                                         size_t inputOffset, size_t outputOffset, const EventList& list)
+{
+	TRUE_ASSERT(n > 0, "Nothing to scan");
+	TRUE_ASSERT(input.size_bytes() >= (inputOffset + n)*sizeof(T), "Input Buffer too small for " << n << " elements");
+	TRUE_ASSERT(output.size_bytes() >= (outputOffset + n)*sizeof(T), "Output Buffer too small for " << n << " elements");
+	return scan<T>(queue, input, inputOffset, output, outputOffset, n, op, true, list);
+}
+
+/*! \brief Returns the Reduction object of the Context, which is created on the first call. */
+ocl::Reduction& ocl::reduction(Context& ctxt)
+{
+	static std::map<const Context*, std::unique_ptr<Reduction> > reductions;
+
+	std::unique_ptr<Reduction>& instance = reductions[&ctxt];
+	if(!instance || !instance->isBuilt()) // released with a former Context at the same address
+		instance.reset(new Reduction(ctxt));
+	return *instance;
+}
+
+template<class T>
+T ocl::reduce(const Queue& queue, const Buffer& buffer, const ReduceOp& op)
+{
+	Context *ctxt = buffer.context();
+	TRUE_ASSERT(ctxt != 0, "Buffer has no Context");
+	return reduction(*ctxt).reduce<T>(queue, buffer, op, buffer.size_bytes()/sizeof(T));
+}
+
+/*! \brief Writes the exclusive prefixes of all elements of input to output, see Reduction::exclusiveScan. */
+template<class T>
+ocl::Event ocl::exclusiveScan(const Queue& queue, const Buffer& input, const Buffer& output, const ReduceOp& op)
+{
+	Context *ctxt = input.context();
+	TRUE_ASSERT(ctxt != 0, "Buffer has no Context");
+	return reduction(*ctxt).exclusiveScan<T>(queue, input, output, input.size_bytes()/sizeof(T), op);
+}
+
+/*! \brief Writes the inclusive prefixes of all elements of input to output, see Reduction::inclusiveScan. */
+template<class T>
+ocl::Event ocl::inclusiveScan(const Queue& queue, const Buffer& input, const Buffer& output, const ReduceOp& op)
+{
+	Context *ctxt = input.context();
+	TRUE_ASSERT(ctxt != 0, "Buffer has no Context");
+	return reduction(*ctxt).inclusiveScan<T>(queue, input, output, input.size_bytes()/sizeof(T), op);
+}
+
+template<class T>
+size_t ocl::argmin(const Queue& queue, const Buffer& buffer)
+{
+	Context *ctxt = buffer.context();
+	TRUE_ASSERT(ctxt != 0, "Buffer has no Context");
+	return reduction(*ctxt).argmin<T>(queue, buffer, buffer.size_bytes()/sizeof(T));
+}
+
+template<class T>
+size_t ocl::argmax(const Queue& queue, const Buffer& buffer)
+{
+	Context *ctxt = buffer.context();
+	TRUE_ASSERT(ctxt != 0, "Buffer has no Context");
+	return reduction(*ctxt).argmax<T>(queue, buffer, buffer.size_bytes()/sizeof(T));
+}
+
+template float ocl::ReduceOp::identity<float>       () const;
+template double ocl::ReduceOp::identity<double>      () const;
+template int ocl::ReduceOp::identity<int>         () const;
+template unsigned int ocl::ReduceOp::identity<unsigned int>() const;
+template float ocl::Reduction::reduce<float>       (const Queue&, const Buffer&, const ReduceOp&, size_t, size_t, const EventList&);
+template double ocl::Reduction::reduce<double>      (const Queue&, const Buffer&, const ReduceOp&, size_t, size_t, const EventList&);
+template int ocl::Reduction::reduce<int>         (const Queue&, const Buffer&, const ReduceOp&, size_t, size_t, const EventList&);
+template unsigned int ocl::Reduction::reduce<unsigned int>(const Queue&, const Buffer&, const ReduceOp&, size_t, size_t, const EventList&);
+template size_t ocl::Reduction::argmin<float>       (const Queue&, const Buffer&, size_t, size_t, const EventList&);
+template size_t ocl::Reduction::argmin<double>      (const Queue&, const Buffer&, size_t, size_t, const EventList&);
+template size_t ocl::Reduction::argmin<int>         (const Queue&, const Buffer&, size_t, size_t, const EventList&);
+template size_t ocl::Reduction::argmin<unsigned int>(const Queue&, const Buffer&, size_t, size_t, const EventList&);
+template size_t ocl::Reduction::argmax<float>       (const Queue&, const Buffer&, size_t, size_t, const EventList&);
+template size_t ocl::Reduction::argmax<double>      (const Queue&, const Buffer&, size_t, size_t, const EventList&);
+template size_t ocl::Reduction::argmax<int>         (const Queue&, const Buffer&, size_t, size_t, const EventList&);
+template size_t ocl::Reduction::argmax<unsigned int>(const Queue&, const Buffer&, size_t, size_t, const EventList&);
+template ocl::Event ocl::Reduction::exclusiveScan<float>       (const Queue&, const Buffer&, const Buffer&, size_t, const ReduceOp&, size_t, size_t, const EventList&);
+template ocl::Event ocl::Reduction::exclusiveScan<double>      (const Queue&, const Buffer&, const Buffer&, size_t, const ReduceOp&, size_t, size_t, const EventList&);
+template ocl::Event ocl::Reduction::exclusiveScan<int>         (const Queue&, const Buffer&, const Buffer&, size_t, const ReduceOp&, size_t, size_t, const EventList&);
+template ocl::Event ocl::Reduction::exclusiveScan<unsigned int>(const Queue&, const Buffer&, const Buffer&, size_t, const ReduceOp&, size_t, size_t, const EventList&);
+template ocl::Event ocl::Reduction::inclusiveScan<float>       (const Queue&, const Buffer&, const Buffer&, size_t, const ReduceOp&, size_t, size_t, const EventList&);
+template ocl::Event ocl::Reduction::inclusiveScan<double>      (const Queue&, const Buffer&, const Buffer&, size_t, const ReduceOp&, size_t, size_t, const EventList&);
+template ocl::Event ocl::Reduction::inclusiveScan<int>         (const Queue&, const Buffer&, const Buffer&, size_t, const ReduceOp&, size_t, size_t, const EventList&);
+template ocl::Event ocl::Reduction::inclusiveScan<unsigned int>(const Queue&, const Buffer&, const Buffer&, size_t, const ReduceOp&, size_t, size_t, const EventList&);
+template float ocl::reduce<float>       (const Queue&, const Buffer&, const ReduceOp&);
+template double ocl::reduce<double>      (const Queue&, const Buffer&, const ReduceOp&);
+template int ocl::reduce<int>         (const Queue&, const Buffer&, const ReduceOp&);
+template unsigned int ocl::reduce<unsigned int>(const Queue&, const Buffer&, const ReduceOp&);
+template size_t ocl::argmin<float>       (const Queue&, const Buffer&);
+template size_t ocl::argmin<double>      (const Queue&, const Buffer&);
+template size_t ocl::argmin<int>         (const Queue&, const Buffer&);
+template size_t ocl::argmin<unsigned int>(const Queue&, const Buffer&);
+template size_t ocl::argmax<float>       (const Queue&, const Buffer&);
+template size_t ocl::argmax<double>      (const Queue&, const Buffer&);
+template size_t ocl::argmax<int>         (const Queue&, const Buffer&);
+template size_t ocl::argmax<unsigned int>(const Queue&, const Buffer&);
+template ocl::Event ocl::exclusiveScan<float>       (const Queue&, const Buffer&, const Buffer&, const ReduceOp&);
+template ocl::Event ocl::exclusiveScan<double>      (const Queue&, const Buffer&, const Buffer&, const ReduceOp&);
+template ocl::Event ocl::exclusiveScan<int>         (const Queue&, const Buffer&, const Buffer&, const ReduceOp&);
+template ocl::Event ocl::exclusiveScan<unsigned int>(const Queue&, const Buffer&, const Buffer&, const ReduceOp&);
+template ocl::Event ocl::inclusiveScan<float>       (const Queue&, const Buffer&, const Buffer&, const ReduceOp&);
+template ocl::Event ocl::inclusiveScan<double>      (const Queue&, const Buffer&, const Buffer&, const ReduceOp&);
+template ocl::Event ocl::inclusiveScan<int>         (const Queue&, const Buffer&, const Buffer&, const ReduceOp&);
+template ocl::Event ocl::inclusiveScan<unsigned int>(const Queue&, const Buffer&, const Buffer&, const ReduceOp&);
@@ -0,0 +1,109 @@
+//Copyright (C) 2013 Cem Bassoy.
+//
+//This file is part of the OpenCL Utility Toolkit.
+//
+//OpenCL Utility Toolkit is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+//
+//OpenCL Utility Toolkit is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License
+//along with OpenCL Utility Toolkit.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <utl_allocator.h>
+
+#include <new>
+#include <fstream>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <unistd.h>
+#include <sys/mman.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+
+/*! \brief Returns the size of a memory page in bytes. */
+size_t utl::pageSize()
+{
+	static const size_t size = []() -> size_t {
+#if defined(__linux__) || defined(__APPLE__)
+		const long s = sysconf(_SC_PAGESIZE);
+		return s > 0 ? size_t(s) : 4096;
+#elif defined(_WIN32)
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return info.dwPageSize;
+#else
+		return 4096;
+#endif
+	}();
+	return size;
+}
+
+/*! \brief Returns the size of a transparent huge page in bytes.
+  *
+  * On Linux the size is read from sysfs, otherwise 2 MiB is assumed.
+  */
+size_t utl::hugePageSize()
+{
+	static const size_t size = []() -> size_t {
+		size_t s = 0;
+#ifdef __linux__
+		std::ifstream file("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size");
+		file >> s;
+#endif
+		return s >= pageSize() ? s : size_t(2) << 20;
+	}();
+	return size;
+}
+
+/*! \brief Allocates size_bytes of memory aligned to alignment bytes. Throws std::bad_alloc on failure. */
+void* utl::alignedAllocate(size_t size_bytes, size_t alignment)
+{
+	if(size_bytes == 0) return nullptr;
+	return ::operator new(size_bytes, std::align_val_t(alignment));
+}
+
+/*! \brief Releases memory allocated with alignedAllocate using the same alignment. */
+void utl::alignedDeallocate(void *ptr, size_t alignment)
+{
+	if(ptr == nullptr) return;
+	::operator delete(ptr, std::align_val_t(alignment));
+}
+
+/*! \brief Advises the kernel to back the memory with transparent huge pages.
+  *
+  * The advice is only a hint and silently ignored if not supported.
+  */
+void utl::adviseHugePages(void *ptr, size_t size_bytes)
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+	if(ptr != nullptr && size_bytes > 0) madvise(ptr, size_bytes, MADV_HUGEPAGE);
+#else
+	(void)ptr; (void)size_bytes;
+#endif
+}
+
+/*! \brief Writes to every page of the memory from the OpenMP threads.
+  *
+  * The pages are distributed with a static schedule, so that each page is first touched
+  * and thus placed by the thread that processes it in a parallel loop with a static schedule.
+  */
+void utl::touchPages(void *ptr, size_t size_bytes)
+{
+	if(ptr == nullptr || size_bytes == 0) return;
+
+	char *bytes = static_cast<char*>(ptr);
+	const std::ptrdiff_t page  = std::ptrdiff_t(pageSize());
+	const std::ptrdiff_t pages = std::ptrdiff_t((size_bytes + pageSize() - 1)/pageSize());
+
+#pragma omp parallel for schedule(static)
+	for(std::ptrdiff_t i = 0; i < pages; ++i)
+		bytes[i*page] = 0;
+}
@@ -0,0 +1,164 @@
+//Copyright (C) 2013 Cem Bassoy.
+//
+//This file is part of the OpenCL Utility Toolkit.
+//
+//OpenCL Utility Toolkit is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+//
+//OpenCL Utility Toolkit is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License
+//along with OpenCL Utility Toolkit.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <utl_perf_counters.h>
+
+#if defined(__linux__)
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+
+#if defined(__linux__)
+
+namespace {
+
+int openEvent(std::uint32_t type, std::uint64_t config, int tid)
+{
+	perf_event_attr attr;
+	std::memset(&attr, 0, sizeof attr);
+	attr.size           = sizeof attr;
+	attr.type           = type;
+	attr.config         = config;
+	attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv     = 1;
+	// inherit stays 0, threads created later get their own events in attach and would be counted twice.
+
+	return int(syscall(__NR_perf_event_open, &attr, tid, -1, -1, 0));
+}
+
+std::uint64_t cacheMiss(std::uint64_t cache)
+{
+	return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+bool isIntel()
+{
+	std::ifstream cpuinfo("/proc/cpuinfo");
+	std::string line;
+	while(std::getline(cpuinfo, line))
+		if(line.compare(0, 9, "vendor_id") == 0) return line.find("GenuineIntel") != std::string::npos;
+	return false;
+}
+
+/*! \brief Adds the scaled counts of the events fds to counts. */
+void accumulate(const std::vector<int>& fds, std::vector<double>& counts)
+{
+	for(size_t e = 0; e < fds.size(); ++e){
+		std::uint64_t value[3]; // count, time enabled, time running
+		if(fds[e] < 0 || ::read(fds[e], value, sizeof value) != ssize_t(sizeof value)) continue;
+		if(value[2] > 0) counts[e] += double(value[0])*double(value[1])/double(value[2]);
+	}
+}
+
+std::vector<int> threads()
+{
+	std::vector<int> tids;
+	if(DIR* dir = opendir("/proc/self/task")){
+		while(dirent* entry = readdir(dir))
+			if(entry->d_name[0] != '.') tids.push_back(std::atoi(entry->d_name));
+		closedir(dir);
+	}
+	return tids;
+}
+
+}
+
+
+/*! \brief Determines the events which can be counted for the calling thread. */
+utl::PerfCounters::PerfCounters()
+{
+	std::vector<std::pair<std::string, Event> > candidates = {
+		{"cycles",       {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES}},
+		{"instructions", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS}},
+		{"llc_misses",   {PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_LL)}},
+		{"dtlb_misses",  {PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_DTLB)}}
+	};
+
+	// FP_ARITH_INST_RETIRED with all packed 128, 256 and 512 bit single and double precision umasks.
+	if(isIntel()) candidates.push_back({"fp_vector_ops", {PERF_TYPE_RAW, 0xfcc7}});
+
+	const int self = int(syscall(SYS_gettid));
+	for(const auto& c : candidates){
+		const int fd = openEvent(c.second.type, c.second.config, self);
+		if(fd < 0) continue;
+		close(fd);
+		_names.push_back(c.first);
+		_events.push_back(c.second);
+	}
+	_exited.assign(_events.size(), 0.0);
+}
+
+utl::PerfCounters::~PerfCounters()
+{
+	for(const auto& t : _fds)
+		for(int fd : t.second)
+			if(fd >= 0) close(fd);
+}
+
+/*! \brief Opens the events for threads which are not counted yet and closes them for exited threads.
+  *
+  * The final counts of exited threads are kept, so the counts never decrease.
+  */
+void utl::PerfCounters::attach()
+{
+	const std::vector<int> tids = threads();
+	const std::set<int> alive(tids.begin(), tids.end());
+
+	for(auto t = _fds.begin(); t != _fds.end(); ){
+		if(alive.count(t->first)){ ++t; continue; }
+		accumulate(t->second, _exited);
+		for(int fd : t->second)
+			if(fd >= 0) close(fd);
+		t = _fds.erase(t);
+	}
+
+	for(int tid : tids){
+		if(_fds.count(tid)) continue;
+		std::vector<int>& fds = _fds[tid];
+		for(const Event& e : _events)
+			fds.push_back(openEvent(e.type, e.config, tid));
+	}
+}
+
+/*! \brief Returns the counts of all threads since they were attached, in the order of names. */
+std::vector<double> utl::PerfCounters::read()
+{
+	if(_events.empty()) return std::vector<double>();
+
+	attach();
+	std::vector<double> counts = _exited;
+	for(const auto& t : _fds)
+		accumulate(t.second, counts);
+	return counts;
+}
+
+#else
+
+utl::PerfCounters::PerfCounters() {}
+utl::PerfCounters::~PerfCounters() {}
+void utl::PerfCounters::attach() {}
+std::vector<double> utl::PerfCounters::read() { return std::vector<double>(); }
+
+#endif
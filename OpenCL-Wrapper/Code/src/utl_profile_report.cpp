@@ -0,0 +1,317 @@
+//Copyright (C) 2013 Cem Bassoy.
+//
+//This file is part of the OpenCL Utility Toolkit.
+//
+//OpenCL Utility Toolkit is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+//
+//OpenCL Utility Toolkit is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License
+//along with OpenCL Utility Toolkit.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <utl_profile_report.h>
+#include <utl_statistics.h>
+
+#include <cmath>
+#include <ctime>
+#include <limits>
+#include <ostream>
+#include <istream>
+#include <sstream>
+#include <set>
+#include <stdexcept>
+
+// The build system defines the revision of the checked out sources.
+#ifndef UTL_GIT_REVISION
+#define UTL_GIT_REVISION ""
+#endif
+
+namespace {
+
+const char* const CsvHeader = "pass,dim,elements,ops,min_s,median_s,p95_s,mean_s,stddev_s,ci_low_s,ci_high_s,samples,outliers,perf_ops_per_s";
+
+std::string jsonString(const std::string& s)
+{
+	std::ostringstream oss;
+	oss << '"';
+	for(char c : s){
+		switch(c){
+			case '"':  oss << "\\\""; break;
+			case '\\': oss << "\\\\"; break;
+			case '\n': oss << "\\n";  break;
+			case '\t': oss << "\\t";  break;
+			default:
+				if(static_cast<unsigned char>(c) < 0x20) oss << "\\u00" << "0123456789abcdef"[(c >> 4) & 0xf] << "0123456789abcdef"[c & 0xf];
+				else oss << c;
+		}
+	}
+	oss << '"';
+	return oss.str();
+}
+
+// JSON has no representation of inf and nan.
+std::string jsonNumber(double v)
+{
+	if(!std::isfinite(v)) return "null";
+	std::ostringstream oss;
+	oss.precision(std::numeric_limits<double>::max_digits10);
+	oss << v;
+	return oss.str();
+}
+
+void writeJsonObject(std::ostream& out, const utl::Metadata& m)
+{
+	out << '{';
+	for(auto it = m.begin(); it != m.end(); ++it)
+		out << (it == m.begin() ? "" : ", ") << jsonString(it->first) << ": " << jsonString(it->second);
+	out << '}';
+}
+
+std::string csvField(const std::string& s)
+{
+	if(s.find_first_of(",\"\n") == std::string::npos) return s;
+	std::string quoted("\"");
+	for(char c : s){
+		if(c == '"') quoted += '"';
+		quoted += c;
+	}
+	return quoted + '"';
+}
+
+std::vector<std::string> csvSplit(const std::string& line)
+{
+	std::vector<std::string> fields(1);
+	bool quoted = false;
+	for(size_t i = 0; i < line.size(); ++i){
+		const char c = line[i];
+		if(quoted){
+			if(c == '"' && i + 1 < line.size() && line[i+1] == '"') { fields.back() += '"'; ++i; }
+			else if(c == '"') quoted = false;
+			else fields.back() += c;
+		}
+		else if(c == '"') quoted = true;
+		else if(c == ',') fields.emplace_back();
+		else if(c != '\r') fields.back() += c;
+	}
+	return fields;
+}
+
+}
+
+
+utl::ProfileRecord::ProfileRecord() :
+	elements(0), ops(0),
+	min(0), median(0), p95(0), mean(0), stddev(0), ciLow(0), ciHigh(0),
+	samples(0), outliers(0)
+{}
+
+
+/*! \brief Creates an empty report with the metadata of the current build. */
+utl::ProfileReport::ProfileReport() : _metadata(buildMetadata())
+{}
+
+/*! \brief Adds the records of a pass together with its metadata, e.g. the device it ran on. */
+void utl::ProfileReport::add(const std::string& pass, const Metadata& metadata, const std::vector<ProfileRecord>& records)
+{
+	_passes.emplace_back(pass, metadata);
+	_records.insert(_records.end(), records.begin(), records.end());
+}
+
+void utl::ProfileReport::writeJson(std::ostream& out) const
+{
+	out << "{\n  \"metadata\": ";
+	writeJsonObject(out, _metadata);
+	out << ",\n  \"units\": {\"time\": \"s\", \"ops\": \"operations\", \"perf\": \"operations/s\"},\n  \"passes\": [";
+
+	for(size_t p = 0; p < _passes.size(); ++p){
+		const std::string& name = _passes[p].first;
+		out << (p == 0 ? "" : ",") << "\n    {\n      \"name\": " << jsonString(name) << ",\n      \"metadata\": ";
+		writeJsonObject(out, _passes[p].second);
+		out << ",\n      \"results\": [";
+
+		bool first = true;
+		for(const ProfileRecord& r : _records){
+			if(r.pass != name) continue;
+			out << (first ? "" : ",") << "\n        {\"dim\": " << jsonString(r.dim)
+			    << ", \"elements\": " << jsonNumber(r.elements) << ", \"ops\": " << jsonNumber(r.ops)
+			    << ", \"min_s\": " << jsonNumber(r.min) << ", \"median_s\": " << jsonNumber(r.median)
+			    << ", \"p95_s\": " << jsonNumber(r.p95) << ", \"mean_s\": " << jsonNumber(r.mean)
+			    << ", \"stddev_s\": " << jsonNumber(r.stddev) << ", \"ci_low_s\": " << jsonNumber(r.ciLow)
+			    << ", \"ci_high_s\": " << jsonNumber(r.ciHigh) << ", \"samples\": " << r.samples
+			    << ", \"outliers\": " << r.outliers << ", \"perf_ops_per_s\": " << jsonNumber(r.perf())
+			    << ", \"times_s\": [";
+			for(size_t i = 0; i < r.times.size(); ++i) out << (i == 0 ? "" : ", ") << jsonNumber(r.times[i]);
+			out << "]";
+			if(!r.counters.empty()){
+				out << ", \"counters\": {";
+				for(auto it = r.counters.begin(); it != r.counters.end(); ++it)
+					out << (it == r.counters.begin() ? "" : ", ") << jsonString(it->first) << ": " << jsonNumber(it->second);
+				out << '}';
+			}
+			out << '}';
+			first = false;
+		}
+		out << "\n      ]\n    }";
+	}
+	out << "\n  ]\n}" << std::endl;
+}
+
+/*! \brief Writes one line per pass and problem size. The metadata precede the header as comments. */
+void utl::ProfileReport::writeCsv(std::ostream& out) const
+{
+	for(const auto& m : _metadata)
+		out << "# " << m.first << ": " << m.second << '\n';
+	for(const auto& p : _passes)
+		for(const auto& m : p.second)
+			out << "# " << p.first << '/' << m.first << ": " << m.second << '\n';
+
+	// The hardware counters of all passes follow the fixed columns.
+	std::set<std::string> counters;
+	for(const ProfileRecord& r : _records)
+		for(const auto& c : r.counters) counters.insert(c.first);
+
+	out << CsvHeader;
+	for(const std::string& c : counters) out << ',' << csvField(c);
+	out << '\n';
+
+	out.precision(std::numeric_limits<double>::max_digits10);
+	for(const ProfileRecord& r : _records){
+		out << csvField(r.pass) << ',' << csvField(r.dim) << ',' << r.elements << ',' << r.ops << ','
+		    << r.min << ',' << r.median << ',' << r.p95 << ',' << r.mean << ',' << r.stddev << ','
+		    << r.ciLow << ',' << r.ciHigh << ',' << r.samples << ',' << r.outliers << ',' << r.perf();
+		for(const std::string& c : counters){
+			auto it = r.counters.find(c);
+			out << ',';
+			if(it != r.counters.end()) out << it->second;
+		}
+		out << '\n';
+	}
+	out.flush();
+}
+
+/*! \brief Reads the records of a CSV file written by writeCsv. Columns are identified by the header. */
+std::vector<utl::ProfileRecord> utl::ProfileReport::readCsv(std::istream& in)
+{
+	std::vector<ProfileRecord> records;
+	std::map<std::string, size_t> column;
+	const std::vector<std::string> header = csvSplit(CsvHeader);
+	const std::set<std::string> fixed(header.begin(), header.end());
+
+	std::string line;
+	while(std::getline(in, line)){
+		if(line.empty() || line[0] == '#') continue;
+		const std::vector<std::string> fields = csvSplit(line);
+
+		if(column.empty()){
+			for(size_t i = 0; i < fields.size(); ++i) column[fields[i]] = i;
+			for(const char* c : {"pass", "dim", "median_s", "mean_s", "stddev_s", "samples", "outliers"})
+				if(column.count(c) == 0) throw std::runtime_error(std::string("Column ") + c + " is missing in the CSV header");
+			continue;
+		}
+
+		auto text = [&](const char* c) -> std::string {
+			auto it = column.find(c);
+			return it != column.end() && it->second < fields.size() ? fields[it->second] : std::string();
+		};
+		auto number = [&](const char* c) -> double {
+			const std::string s = text(c);
+			return s.empty() ? 0.0 : std::stod(s);
+		};
+
+		ProfileRecord r;
+		r.pass     = text("pass");
+		r.dim      = text("dim");
+		r.elements = number("elements");
+		r.ops      = number("ops");
+		r.min      = number("min_s");
+		r.median   = number("median_s");
+		r.p95      = number("p95_s");
+		r.mean     = number("mean_s");
+		r.stddev   = number("stddev_s");
+		r.ciLow    = number("ci_low_s");
+		r.ciHigh   = number("ci_high_s");
+		r.samples  = size_t(number("samples"));
+		r.outliers = size_t(number("outliers"));
+
+		// Columns which are not part of the header written by writeCsv hold counters.
+		for(const auto& c : column){
+			if(fixed.count(c.first) || c.second >= fields.size() || fields[c.second].empty()) continue;
+			r.counters[c.first] = std::stod(fields[c.second]);
+		}
+		records.push_back(r);
+	}
+	return records;
+}
+
+
+utl::Metadata utl::buildMetadata()
+{
+	Metadata m;
+
+	const std::string revision(UTL_GIT_REVISION);
+	m["git_revision"] = revision.empty() ? "unknown" : revision;
+
+#if defined(__VERSION__)
+	m["compiler"] = __VERSION__;
+#elif defined(_MSC_VER)
+	m["compiler"] = "MSVC " + std::to_string(_MSC_VER);
+#endif
+
+	char date[32];
+	const std::time_t now = std::time(nullptr);
+	if(std::strftime(date, sizeof date, "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now)))
+		m["date"] = date;
+
+	return m;
+}
+
+/*! \brief Compares the records of the same pass and problem size.
+  *
+  * A record is a regression if its median runtime is more than threshold slower than
+  * the baseline and the one-sided Welch t-test rejects equal mean runtimes at the
+  * significance level alpha. Improvements are flagged symmetrically. Records without
+  * a baseline are skipped.
+  */
+std::vector<utl::ProfileComparison> utl::compare(const std::vector<ProfileRecord>& baseline, const std::vector<ProfileRecord>& current, double alpha, double threshold)
+{
+	std::vector<ProfileComparison> result;
+
+	for(const ProfileRecord& c : current){
+		const ProfileRecord* b = nullptr;
+		for(const ProfileRecord& r : baseline)
+			if(r.pass == c.pass && r.dim == c.dim) { b = &r; break; }
+		if(b == nullptr || b->median <= 0) continue;
+
+		const double nb = double(b->samples - b->outliers), nc = double(c.samples - c.outliers);
+		const double vb = nb > 0 ? b->stddev*b->stddev/nb : 0.0, vc = nc > 0 ? c.stddev*c.stddev/nc : 0.0;
+
+		ProfileComparison cmp;
+		cmp.pass     = c.pass;
+		cmp.dim      = c.dim;
+		cmp.baseline = b->median;
+		cmp.current  = c.median;
+		cmp.change   = (c.median - b->median)/b->median;
+
+		// Without spread only the threshold decides.
+		bool significant = true;
+		if(vb + vc > 0){
+			cmp.t = (c.mean - b->mean)/std::sqrt(vb + vc);
+			const double dof = (vb + vc)*(vb + vc)/((nb > 1 ? vb*vb/(nb - 1) : 0.0) + (nc > 1 ? vc*vc/(nc - 1) : 0.0));
+			significant = std::fabs(cmp.t) > studentQuantile(1 - alpha, std::isfinite(dof) ? dof : 1.0);
+		}
+		else{
+			cmp.t = c.mean == b->mean ? 0.0 : std::copysign(std::numeric_limits<double>::infinity(), c.mean - b->mean);
+		}
+
+		cmp.regression  = significant && cmp.t > 0 && cmp.change >  threshold;
+		cmp.improvement = significant && cmp.t < 0 && cmp.change < -threshold;
+		result.push_back(cmp);
+	}
+	return result;
+}
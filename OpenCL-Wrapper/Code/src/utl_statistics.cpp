@@ -0,0 +1,139 @@
+//Copyright (C) 2013 Cem Bassoy.
+//
+//This file is part of the OpenCL Utility Toolkit.
+//
+//OpenCL Utility Toolkit is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+//
+//OpenCL Utility Toolkit is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License
+//along with OpenCL Utility Toolkit.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <utl_statistics.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+utl::Statistics::Statistics() :
+	_samples(0), _outliers(0),
+	_min(0), _max(0), _mean(0), _median(0), _p95(0), _stddev(0),
+	_confidence(0), _ciLow(0), _ciHigh(0)
+{}
+
+/*! \brief Computes the statistics of the samples.
+  *
+  * \param samples measured values, e.g. runtimes in seconds.
+  * \param confidence level of the confidence interval of the mean, e.g. 0.95.
+  */
+utl::Statistics::Statistics(const std::vector<double>& samples, double confidence) : Statistics()
+{
+	_confidence = confidence;
+	if(samples.empty()) return;
+
+	std::vector<double> sorted(samples);
+	std::sort(sorted.begin(), sorted.end());
+
+	const double q1 = quantile(sorted, 0.25), q3 = quantile(sorted, 0.75);
+	const double lower = q1 - 3.0*(q3 - q1), upper = q3 + 3.0*(q3 - q1);
+
+	auto first = std::lower_bound(sorted.begin(), sorted.end(), lower);
+	auto last  = std::upper_bound(first, sorted.end(), upper);
+	const std::vector<double> inliers(first, last);
+
+	_samples  = samples.size();
+	_outliers = samples.size() - inliers.size();
+
+	const double n = double(inliers.size());
+	_min    = inliers.front();
+	_max    = inliers.back();
+	_median = quantile(inliers, 0.5);
+	_p95    = quantile(inliers, 0.95);
+
+	double sum = 0;
+	for(double s : inliers) sum += s;
+	_mean = sum/n;
+
+	double squares = 0;
+	for(double s : inliers) squares += (s - _mean)*(s - _mean);
+	_stddev = inliers.size() > 1 ? std::sqrt(squares/(n - 1)) : 0.0;
+
+	const double halfWidth = inliers.size() > 1 ? studentQuantile(0.5 + confidence/2, n - 1)*_stddev/std::sqrt(n) : 0.0;
+	_ciLow  = _mean - halfWidth;
+	_ciHigh = _mean + halfWidth;
+}
+
+double utl::Statistics::ciRelativeWidth() const
+{
+	if(_samples < 2) return std::numeric_limits<double>::infinity();
+	return _mean != 0 ? (_ciHigh - _ciLow)/std::fabs(_mean) : 0.0;
+}
+
+/*! \brief Returns the p-quantile of sorted samples with linear interpolation between the closest ranks. */
+double utl::quantile(const std::vector<double>& sorted, double p)
+{
+	if(sorted.empty()) return std::numeric_limits<double>::quiet_NaN();
+	const double pos = p*double(sorted.size() - 1);
+	const size_t i = size_t(pos);
+	if(i + 1 >= sorted.size()) return sorted.back();
+	return sorted[i] + (pos - double(i))*(sorted[i+1] - sorted[i]);
+}
+
+/*! \brief Returns the p-quantile of the standard normal distribution.
+  *
+  * Uses the rational approximation of Acklam with a relative error below 1.2e-9.
+  */
+double utl::normalQuantile(double p)
+{
+	static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02, 1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+	static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02, 6.680131188771972e+01, -1.328068155288572e+01};
+	static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00, -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+	static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00, 3.754408661907416e+00};
+
+	if(p <= 0) return -std::numeric_limits<double>::infinity();
+	if(p >= 1) return  std::numeric_limits<double>::infinity();
+
+	if(p < 0.02425){
+		const double q = std::sqrt(-2*std::log(p));
+		return (((((c[0]*q+c[1])*q+c[2])*q+c[3])*q+c[4])*q+c[5]) / ((((d[0]*q+d[1])*q+d[2])*q+d[3])*q+1);
+	}
+	if(p > 1 - 0.02425){
+		const double q = std::sqrt(-2*std::log(1-p));
+		return -(((((c[0]*q+c[1])*q+c[2])*q+c[3])*q+c[4])*q+c[5]) / ((((d[0]*q+d[1])*q+d[2])*q+d[3])*q+1);
+	}
+	const double q = p - 0.5, r = q*q;
+	return (((((a[0]*r+a[1])*r+a[2])*r+a[3])*r+a[4])*r+a[5])*q / (((((b[0]*r+b[1])*r+b[2])*r+b[3])*r+b[4])*r+1);
+}
+
+/*! \brief Returns the p-quantile of Student's t-distribution with dof degrees of freedom.
+  *
+  * Uses the Cornish-Fisher expansion around the normal quantile, which is accurate to
+  * about 1% for three and more degrees of freedom. The exact values are used below.
+  */
+double utl::studentQuantile(double p, double dof)
+{
+	if(dof < 1) return std::numeric_limits<double>::infinity();
+
+	const bool upper = p >= 0.5;
+	const double pu = upper ? p : 1 - p;
+
+	double t;
+	if(dof < 1.5)      t = std::tan(3.14159265358979323846*(pu - 0.5));
+	else if(dof < 2.5) t = (2*pu - 1)*std::sqrt(2/(4*pu*(1 - pu)));
+	else{
+		const double z = normalQuantile(pu), z2 = z*z;
+		const double g1 = (z2 + 1)*z/4;
+		const double g2 = ((5*z2 + 16)*z2 + 3)*z/96;
+		const double g3 = (((3*z2 + 19)*z2 + 17)*z2 - 15)*z/384;
+		const double g4 = ((((79*z2 + 776)*z2 + 1482)*z2 - 1920)*z2 - 945)*z/92160;
+		t = z + g1/dof + g2/(dof*dof) + g3/(dof*dof*dof) + g4/(dof*dof*dof*dof);
+	}
+	return upper ? t : -t;
+}
@@ -21,12 +21,23 @@
 #include <fstream>
 #include <cstdlib>
 #include <cmath>
-#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define UTL_HAVE_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 #include <utl_assert.h>
 #include <utl_stream.h>
 #include <utl_storage.h>
 #include <utl_dim.h>
+#include <utl_random.h>
 
 /** \file util.cpp
  * \brief Implementierung der Schnittstelle zur Benutzung von Hilfsfunktionen wie z.B. zur Ein-/Ausgabe von Matrizen.
@@ -87,28 +98,387 @@ template void utl::read<size_t> (const std::string &name, size_t *matrix, size_t
 template void utl::read<float> (const std::string &name, float *matrix, size_t size, std::ios::openmode mode);
 template void utl::read<double> (const std::string &name, double *matrix, size_t size, std::ios::openmode mode);
 
+
+namespace {
+
+/*! \brief Kopf einer Matrixdatei, wie er auf der Platte steht. */
+struct RawMatrixHeader
+{
+	char          magic[8];
+	std::uint32_t version;
+	std::uint32_t endian;
+	std::uint64_t dataOffset;
+	std::uint64_t rows, cols;
+	std::uint64_t innerRows, innerCols;
+	std::uint64_t elementSize;
+	char          type[16];
+	char          storage[16];
+	char          innerStorage[16];
+};
+
+const char          Magic[8] = {'U','T','L','M','A','T','R','X'};
+const std::uint32_t Version  = 1;
+const std::uint32_t Endian   = 0x01020304;
+
+std::string fromName(const char (&name)[16])
+{
+	return std::string(name, std::find(name, name + sizeof name, '\0'));
+}
+
+const utl::Storage* toStorage(const char (&name)[16])
+{
+	const std::string n = fromName(name);
+	if(n == utl::RowMajor.name()) return &utl::RowMajor;
+	if(n == utl::ColMajor.name()) return &utl::ColMajor;
+	TRUE_ASSERT(false, "Unknown storage in matrix file: " << n);
+	return 0;
+}
+
+void copyName(char (&to)[16], const std::string &from)
+{
+	std::memset(to, 0, sizeof to);
+	std::strncpy(to, from.c_str(), sizeof to - 1);
+}
+
+RawMatrixHeader toRaw(const utl::MatrixHeader &h)
+{
+	RawMatrixHeader r;
+	std::memset(&r, 0, sizeof r);
+	std::memcpy(r.magic, Magic, sizeof Magic);
+	r.version     = Version;
+	r.endian      = Endian;
+	r.dataOffset  = utl::MatrixHeader::dataOffset;
+	r.rows        = h.rows;
+	r.cols        = h.cols;
+	r.innerRows   = h.innerRows;
+	r.innerCols   = h.innerCols;
+	r.elementSize = h.elementSize;
+	copyName(r.type, h.type);
+	copyName(r.storage, h.storage->name());
+	copyName(r.innerStorage, h.innerStorage->name());
+	return r;
+}
+
+utl::MatrixHeader fromRaw(const RawMatrixHeader &r, const std::string &name)
+{
+	TRUE_ASSERT(std::memcmp(r.magic, Magic, sizeof Magic) == 0, "No matrix file: " << name);
+	TRUE_ASSERT(r.endian == Endian, "Matrix file " << name << " has a different byte order");
+	TRUE_ASSERT(r.version == Version, "Matrix file " << name << " has version " << r.version);
+	TRUE_ASSERT(r.dataOffset == utl::MatrixHeader::dataOffset, "Matrix file " << name << " has data offset " << r.dataOffset);
+	TRUE_ASSERT((r.innerRows == 0) == (r.innerCols == 0) && (r.innerRows == 0 || (r.rows % r.innerRows == 0 && r.cols % r.innerCols == 0)),
+	            "Matrix file " << name << " has partial blocks " << r.innerRows << "x" << r.innerCols);
+
+	utl::MatrixHeader h;
+	h.type         = fromName(r.type);
+	h.elementSize  = size_t(r.elementSize);
+	h.rows         = size_t(r.rows);
+	h.cols         = size_t(r.cols);
+	h.storage      = toStorage(r.storage);
+	h.innerRows    = size_t(r.innerRows);
+	h.innerCols    = size_t(r.innerCols);
+	h.innerStorage = toStorage(r.innerStorage);
+	return h;
+}
+
+void writeRaw(std::ofstream &os, const utl::MatrixHeader &h, const std::string &name)
+{
+	const RawMatrixHeader r = toRaw(h);
+	const std::vector<char> padding(utl::MatrixHeader::dataOffset - sizeof r, 0);
+	os.write((const char*)&r, sizeof r);
+	os.write(padding.data(), padding.size());
+	TRUE_ASSERT(!os.bad(), "Error writing file: " << name);
+}
+
+utl::MatrixHeader readRaw(std::ifstream &is, const std::string &name)
+{
+	RawMatrixHeader r;
+	is.read((char*)&r, sizeof r);
+	TRUE_ASSERT(is.gcount() == std::streamsize(sizeof r), "No matrix file: " << name);
+	return fromRaw(r, name);
+}
+
+}
+
+
+utl::MatrixHeader::MatrixHeader() :
+	type(), elementSize(0), rows(0), cols(0), storage(&utl::ColMajor),
+	innerRows(0), innerCols(0), innerStorage(&utl::ColMajor)
+{}
+
+/*! \brief Erzeugt den Kopf einer Matrix mit Elementen vom Typ T
+  *
+	* \param innerRows  Anzahl der Zeilen eines Blocks einer Matrix2, 0 falls nicht geblockt
+	* \param innerCols  Anzahl der Spalten eines Blocks einer Matrix2, 0 falls nicht geblockt
+  *
+  * rows und cols muessen Vielfache der Blockgroesse sein, da Randbloecke nicht unterstuetzt werden.
+  */
+template<class T>
+utl::MatrixHeader utl::MatrixHeader::create(size_t rows, size_t cols, const utl::Storage& storage,
+                                            size_t innerRows, size_t innerCols, const utl::Storage& innerStorage)
+{
+	TRUE_ASSERT((innerRows == 0) == (innerCols == 0), "Block size " << innerRows << "x" << innerCols);
+	TRUE_ASSERT(innerRows == 0 || (rows % innerRows == 0 && cols % innerCols == 0),
+	            "Matrix " << rows << "x" << cols << " is no multiple of block " << innerRows << "x" << innerCols);
+	MatrixHeader h;
+	h.type         = utl::typeToString<T>();
+	h.elementSize  = sizeof(T);
+	h.rows         = rows;
+	h.cols         = cols;
+	h.storage      = &storage;
+	h.innerRows    = innerRows;
+	h.innerCols    = innerCols;
+	h.innerStorage = &innerStorage;
+	return h;
+}
+
+/*! \brief Prueft, ob die Elemente der Datei vom Typ T sind. */
+template<class T>
+void utl::MatrixHeader::check() const
+{
+	TRUE_ASSERT(type == utl::typeToString<T>() && elementSize == sizeof(T),
+	            "Matrix file contains " << type << " instead of " << utl::typeToString<T>());
+}
+
+/*! \brief Liest den Kopf einer Matrixdatei */
+utl::MatrixHeader utl::readMatrixHeader(const std::string &name)
+{
+	std::ifstream is(name.c_str(), std::ios::in | std::ios::binary);
+	TRUE_ASSERT(!is.fail(), "Error opening file: " << name);
+	return readRaw(is, name);
+}
+
+/*! \brief Schreibt eine Matrix mit Kopf in eine Datei
+  *
+	* \param A       Elemente der Matrix in der Reihenfolge, die der Kopf beschreibt
+	* \param header  Kopf, z.B. von MatrixHeader::create<T>
+  */
+template<class T>
+void utl::writeMatrix(const std::string &name, const T *A, const utl::MatrixHeader &header)
+{
+	utl::MatrixWriter writer(name, header);
+	writer.write(A, header.elements());
+	writer.close();
+}
+
+/*! \brief Liest eine Matrix mit Kopf von einer Datei
+  *
+	* \param A     Feld mit Platz fuer size Elemente
+	* \param size  Anzahl der Elemente, muss mit dem Kopf uebereinstimmen
+  */
+template<class T>
+utl::MatrixHeader utl::readMatrix(const std::string &name, T *A, size_t size)
+{
+	utl::MatrixReader reader(name);
+	TRUE_ASSERT(size == reader.header().elements(), size << " != " << reader.header().elements());
+	reader.read(A, size);
+	return reader.header();
+}
+
+
+/*! \brief Oeffnet eine Matrixdatei zum abschnittsweisen Schreiben und schreibt den Kopf. */
+utl::MatrixWriter::MatrixWriter(const std::string &name, const utl::MatrixHeader &header) :
+	_name(name), _os(name.c_str(), std::ios::out | std::ios::binary | std::ios::trunc), _header(header), _written(0)
+{
+	TRUE_ASSERT(!_os.fail(), "Error opening file: " << name);
+	writeRaw(_os, _header, _name);
+}
+
+utl::MatrixWriter::~MatrixWriter()
+{
+	if(!_os.is_open()) return;
+	TRUE_WARNING(_written == _header.elements(), "Matrix file " << _name << " is incomplete: " << _written << " of " << _header.elements());
+	_os.close();
+}
+
+/*! \brief Haengt die naechsten size Elemente an die Datei an */
+template<class T>
+void utl::MatrixWriter::write(const T *A, size_t size)
+{
+	_header.check<T>();
+	TRUE_ASSERT(_written + size <= _header.elements(), "Too many elements for matrix file " << _name);
+	_os.write((const char*)A, size*sizeof(T));
+	TRUE_ASSERT(!_os.bad(), "Error writing file: " << _name);
+	_written += size;
+}
+
+/*! \brief Schliesst die Datei, nachdem alle Elemente geschrieben wurden */
+void utl::MatrixWriter::close()
+{
+	TRUE_ASSERT(_written == _header.elements(), "Matrix file " << _name << " is incomplete: " << _written << " of " << _header.elements());
+	_os.close();
+	TRUE_ASSERT(!_os.fail(), "Error writing file: " << _name);
+}
+
+
+/*! \brief Oeffnet eine Matrixdatei zum abschnittsweisen Lesen und liest den Kopf. */
+utl::MatrixReader::MatrixReader(const std::string &name) :
+	_name(name), _is(name.c_str(), std::ios::in | std::ios::binary), _header(), _position(0)
+{
+	TRUE_ASSERT(!_is.fail(), "Error opening file: " << name);
+	_header = readRaw(_is, _name);
+	_is.seekg(0, std::ios::end);
+	const size_t length = size_t(_is.tellg());
+	TRUE_ASSERT(length == utl::MatrixHeader::dataOffset + _header.bytes(),
+	            "Matrix file " << _name << " has " << length << " bytes instead of " << utl::MatrixHeader::dataOffset + _header.bytes());
+	seek(0);
+}
+
+/*! \brief Liest bis zu size der naechsten Elemente
+  *
+	* \return Anzahl der gelesenen Elemente, 0 am Ende der Datei
+  */
+template<class T>
+size_t utl::MatrixReader::read(T *A, size_t size)
+{
+	_header.check<T>();
+	const size_t n = std::min(size, remaining());
+	_is.read((char*)A, n*sizeof(T));
+	TRUE_ASSERT(!_is.bad() && _is.gcount() == std::streamsize(n*sizeof(T)), "Error reading file: " << _name);
+	_position += n;
+	return n;
+}
+
+/*! \brief Setzt die Leseposition auf das Element mit dem linearen Index element */
+void utl::MatrixReader::seek(size_t element)
+{
+	TRUE_ASSERT(element <= _header.elements(), element << " > " << _header.elements());
+	_is.clear();
+	_is.seekg(std::streamoff(utl::MatrixHeader::dataOffset + element*_header.elementSize), std::ios::beg);
+	_position = element;
+}
+
+
+utl::MappedMatrix::MappedMatrix() : _base(0), _length(0), _header() {}
+
+/*! \brief Bildet eine vorhandene Matrixdatei in den Speicher ab
+  *
+	* \param writable  Wenn true, werden Aenderungen in die Datei geschrieben
+  */
+utl::MappedMatrix::MappedMatrix(const std::string &name, bool writable) : _base(0), _length(0), _header()
+{
+#if defined(UTL_HAVE_MMAP)
+	const int fd = ::open(name.c_str(), writable ? O_RDWR : O_RDONLY);
+	TRUE_ASSERT(fd >= 0, "Error opening file: " << name);
+	struct stat st;
+	TRUE_ASSERT(fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(RawMatrixHeader), "No matrix file: " << name);
+	_length = size_t(st.st_size);
+	void *base = mmap(0, _length, PROT_READ | PROT_WRITE, writable ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+	::close(fd);
+	TRUE_ASSERT(base != MAP_FAILED, "Error mapping file: " << name);
+	_base = (char*)base;
+	_header = fromRaw(*(const RawMatrixHeader*)_base, name);
+	TRUE_ASSERT(_length == utl::MatrixHeader::dataOffset + _header.bytes(),
+	            "Matrix file " << name << " has " << _length << " bytes instead of " << utl::MatrixHeader::dataOffset + _header.bytes());
+#else
+	(void)writable;
+	TRUE_ASSERT(false, "Memory-mapped matrix files are not supported on this system: " << name);
+#endif
+}
+
+utl::MappedMatrix::MappedMatrix(utl::MappedMatrix&& other) :
+	_base(other._base), _length(other._length), _header(other._header)
+{
+	other._base = 0;
+	other._length = 0;
+}
+
+utl::MappedMatrix::~MappedMatrix()
+{
+#if defined(UTL_HAVE_MMAP)
+	if(_base) munmap(_base, _length);
+#endif
+}
+
+/*! \brief Legt eine neue Matrixdatei mit dem Kopf header an und bildet sie beschreibbar ab
+  *
+  * Die Elemente sind mit 0 initialisiert und werden direkt ueber data in die Datei geschrieben.
+  */
+utl::MappedMatrix utl::MappedMatrix::create(const std::string &name, const utl::MatrixHeader &header)
+{
+	{
+		std::ofstream os(name.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+		TRUE_ASSERT(!os.fail(), "Error opening file: " << name);
+		writeRaw(os, header, name);
+	}
+#if defined(UTL_HAVE_MMAP)
+	TRUE_ASSERT(truncate(name.c_str(), off_t(utl::MatrixHeader::dataOffset + header.bytes())) == 0, "Error resizing file: " << name);
+#endif
+	return MappedMatrix(name, true);
+}
+
+/*! \brief Zeiger auf das erste Element, das an einer Seitengrenze liegt */
+template<class T>
+T* utl::MappedMatrix::data() const
+{
+	_header.check<T>();
+	return _base ? (T*)(_base + utl::MatrixHeader::dataOffset) : 0;
+}
+
+/*! \brief Schreibt die Aenderungen einer beschreibbaren Abbildung in die Datei */
+void utl::MappedMatrix::sync()
+{
+#if defined(UTL_HAVE_MMAP)
+	if(_base){
+		TRUE_ASSERT(msync(_base, _length, MS_SYNC) == 0, "Error syncing mapped matrix file");
+	}
+#endif
+}
+
+
+template utl::MatrixHeader utl::MatrixHeader::create<char>(size_t rows, size_t cols, const utl::Storage& storage, size_t innerRows, size_t innerCols, const utl::Storage& innerStorage);
+template utl::MatrixHeader utl::MatrixHeader::create<int>(size_t rows, size_t cols, const utl::Storage& storage, size_t innerRows, size_t innerCols, const utl::Storage& innerStorage);
+template utl::MatrixHeader utl::MatrixHeader::create<size_t>(size_t rows, size_t cols, const utl::Storage& storage, size_t innerRows, size_t innerCols, const utl::Storage& innerStorage);
+template utl::MatrixHeader utl::MatrixHeader::create<float>(size_t rows, size_t cols, const utl::Storage& storage, size_t innerRows, size_t innerCols, const utl::Storage& innerStorage);
+template utl::MatrixHeader utl::MatrixHeader::create<double>(size_t rows, size_t cols, const utl::Storage& storage, size_t innerRows, size_t innerCols, const utl::Storage& innerStorage);
+
+template void utl::MatrixHeader::check<char>() const;
+template void utl::MatrixHeader::check<int>() const;
+template void utl::MatrixHeader::check<size_t>() const;
+template void utl::MatrixHeader::check<float>() const;
+template void utl::MatrixHeader::check<double>() const;
+
+template void utl::writeMatrix<char>(const std::string &name, const char *A, const utl::MatrixHeader &header);
+template void utl::writeMatrix<int>(const std::string &name, const int *A, const utl::MatrixHeader &header);
+template void utl::writeMatrix<size_t>(const std::string &name, const size_t *A, const utl::MatrixHeader &header);
+template void utl::writeMatrix<float>(const std::string &name, const float *A, const utl::MatrixHeader &header);
+template void utl::writeMatrix<double>(const std::string &name, const double *A, const utl::MatrixHeader &header);
+
+template utl::MatrixHeader utl::readMatrix<char>(const std::string &name, char *A, size_t size);
+template utl::MatrixHeader utl::readMatrix<int>(const std::string &name, int *A, size_t size);
+template utl::MatrixHeader utl::readMatrix<size_t>(const std::string &name, size_t *A, size_t size);
+template utl::MatrixHeader utl::readMatrix<float>(const std::string &name, float *A, size_t size);
+template utl::MatrixHeader utl::readMatrix<double>(const std::string &name, double *A, size_t size);
+
+template void utl::MatrixWriter::write<char>(const char *A, size_t size);
+template void utl::MatrixWriter::write<int>(const int *A, size_t size);
+template void utl::MatrixWriter::write<size_t>(const size_t *A, size_t size);
+template void utl::MatrixWriter::write<float>(const float *A, size_t size);
+template void utl::MatrixWriter::write<double>(const double *A, size_t size);
+
+template size_t utl::MatrixReader::read<char>(char *A, size_t size);
+template size_t utl::MatrixReader::read<int>(int *A, size_t size);
+template size_t utl::MatrixReader::read<size_t>(size_t *A, size_t size);
+template size_t utl::MatrixReader::read<float>(float *A, size_t size);
+template size_t utl::MatrixReader::read<double>(double *A, size_t size);
+
+template char* utl::MappedMatrix::data<char>() const;
+template int* utl::MappedMatrix::data<int>() const;
+template size_t* utl::MappedMatrix::data<size_t>() const;
+template float* utl::MappedMatrix::data<float>() const;
+template double* utl::MappedMatrix::data<double>() const;
+
 /*! \brief Initialisierung eines Feldes mit Pseudo-Zufallszahlen
   * 
 	* \param data     Zeiger eine N-dimensionale Matrix
 	* \param maxData  Bezeichnet das Maximum Element mit dem data initialisiert wird.
+	*
+	* Die Zahlen werden mit utl::Philox parallel erzeugt.
   */ 
 
 template<class T>
 void utl::randn(T *data, size_t num, T maxData)
 {
-	using namespace std::chrono;
-	srand(duration_cast<microseconds>(system_clock::now().time_since_epoch()).count());
-
-
-	if(maxData == (T)RAND_MAX){
-		for (size_t i = 0; i < num; ++i){
-				data[i] = (T)rand();
-		}
-		return;
-	}
-	for (size_t i = 0; i < num; ++i){
-			data[i] = (T)( ( (double)rand() / (double)RAND_MAX ) * (double)maxData);
-	}
+	utl::Philox(utl::Philox::randomSeed()).uniform(data, num, T(0), maxData);
 }
 
 
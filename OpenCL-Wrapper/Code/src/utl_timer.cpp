@@ -17,6 +17,25 @@
 
 #include <utl_timer.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define UTL_TIMER_TSC
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#include <cpuid.h>
+#endif
+#endif
+
 
 utl::Seconds::Seconds (long double m) : _m(m){}
 utl::Seconds::Seconds (const Seconds &s) : _m(s._m){}
@@ -40,8 +59,207 @@ utl::MicroSeconds::MicroSeconds (const MicroSeconds &s) : _m(s._m){}
 
 
 
-utl::Timer::point utl::Timer::_start;
-utl::Timer::point utl::Timer::_stop;
+namespace {
+
+struct ClockState
+{
+	std::atomic<int> source;
+	bool tsc;
+	double secondsPerTick; // of the time stamp counter
+
+	ClockState() : source(utl::Clock::Steady), tsc(false), secondsPerTick(0)
+	{
+#ifdef UTL_TIMER_TSC
+		// CPUID 0x80000007 reports an invariant time stamp counter in bit 8 of EDX.
+		unsigned int regs[4] = {0, 0, 0, 0};
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0x80000000);
+		if(unsigned(info[0]) >= 0x80000007u){ __cpuid(info, 0x80000007); regs[3] = unsigned(info[3]); }
+#else
+		if(__get_cpuid_max(0x80000000u, nullptr) >= 0x80000007u)
+			__get_cpuid(0x80000007u, &regs[0], &regs[1], &regs[2], &regs[3]);
+#endif
+		tsc = (regs[3] & (1u << 8)) != 0;
+		if(!tsc) return;
+
+		// Count the ticks during 20 ms of the steady clock.
+		typedef std::chrono::steady_clock steady;
+		const steady::time_point t0 = steady::now();
+		const unsigned long long c0 = __rdtsc();
+		steady::time_point t1;
+		do { t1 = steady::now(); } while(t1 - t0 < std::chrono::milliseconds(20));
+		const unsigned long long c1 = __rdtsc();
+
+		secondsPerTick = std::chrono::duration<double>(t1 - t0).count()/double(c1 - c0);
+		source = utl::Clock::Tsc;
+#endif
+	}
+};
+
+ClockState& clockState()
+{
+	static ClockState state;
+	return state;
+}
+
+struct Region
+{
+	std::string name;
+	size_t parent;
+	size_t calls;
+	utl::Clock::ticks total, min, max;
+	std::vector<size_t> children;
+};
+
+struct MergedRegion
+{
+	std::string name;
+	size_t calls;
+	double total, min, max;
+	std::vector<MergedRegion> children;
+};
+
+}
+
+namespace utl { namespace detail {
+
+/*! \brief Region tree of one thread. Region 0 is the root which is never timed. */
+struct TimerBuffer
+{
+	TimerBuffer() : current(0) { reset(); }
+
+	void reset()
+	{
+		regions.assign(1, Region{std::string(), 0, 0, 0, 0, 0, std::vector<size_t>()});
+		current = 0;
+	}
+
+	size_t enter(const char* name)
+	{
+		for(size_t child : regions[current].children){
+			if(regions[child].name == name) return current = child;
+		}
+		regions.push_back(Region{name, current, 0, 0, ~Clock::ticks(0), 0, std::vector<size_t>()});
+		regions[current].children.push_back(regions.size() - 1);
+		return current = regions.size() - 1;
+	}
+
+	void leave(size_t region, Clock::ticks elapsed)
+	{
+		Region& r = regions[region];
+		r.calls += 1;
+		r.total += elapsed;
+		r.min = std::min(r.min, elapsed);
+		r.max = std::max(r.max, elapsed);
+		current = r.parent;
+	}
+
+	std::vector<Region> regions;
+	size_t current;
+};
+
+}}
+
+namespace {
+
+struct Registry
+{
+	std::mutex mutex;
+	std::vector<std::shared_ptr<utl::detail::TimerBuffer> > buffers;
+};
+
+Registry& registry()
+{
+	static Registry r;
+	return r;
+}
+
+// The registry keeps the buffers of finished threads alive until the report.
+utl::detail::TimerBuffer* threadBuffer()
+{
+	thread_local utl::detail::TimerBuffer* buffer = nullptr;
+	if(buffer == nullptr){
+		std::shared_ptr<utl::detail::TimerBuffer> b = std::make_shared<utl::detail::TimerBuffer>();
+		std::lock_guard<std::mutex> lock(registry().mutex);
+		registry().buffers.push_back(b);
+		buffer = b.get();
+	}
+	return buffer;
+}
+
+void merge(MergedRegion& into, const std::vector<Region>& regions, size_t region)
+{
+	for(size_t c : regions[region].children){
+		const Region& r = regions[c];
+		auto it = std::find_if(into.children.begin(), into.children.end(), [&r](const MergedRegion& m){ return m.name == r.name; });
+		if(it == into.children.end()){
+			into.children.push_back(MergedRegion{r.name, 0, 0.0, 1e300, 0.0, std::vector<MergedRegion>()});
+			it = into.children.end() - 1;
+		}
+		if(r.calls > 0){
+			it->calls += r.calls;
+			it->total += utl::Clock::seconds(r.total);
+			it->min = std::min(it->min, utl::Clock::seconds(r.min));
+			it->max = std::max(it->max, utl::Clock::seconds(r.max));
+		}
+		merge(*it, regions, c);
+	}
+}
+
+void print(std::ostream& out, const MergedRegion& region, double parentTotal, int depth)
+{
+	out << std::left << std::setw(32) << (std::string(2*depth, ' ') + region.name) << std::right
+	    << std::setw(10) << region.calls
+	    << std::setw(14) << region.total
+	    << std::setw(14) << (region.calls > 0 ? region.total/double(region.calls) : 0.0)
+	    << std::setw(14) << (region.calls > 0 ? region.min : 0.0)
+	    << std::setw(14) << region.max
+	    << std::setw(12) << std::fixed << std::setprecision(1) << (parentTotal > 0 ? 100*region.total/parentTotal : 100.0)
+	    << std::scientific << std::setprecision(3) << '\n';
+	for(const MergedRegion& child : region.children)
+		print(out, child, region.total, depth + 1);
+}
+
+}
+
+
+utl::Clock::ticks utl::Clock::now()
+{
+#ifdef UTL_TIMER_TSC
+	if(clockState().source == Tsc) return __rdtsc();
+#endif
+	return ticks(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/*! \brief Converts a difference of ticks into seconds. */
+double utl::Clock::seconds(ticks t)
+{
+	return clockState().source == Tsc ? double(t)*clockState().secondsPerTick : double(t)*1e-9;
+}
+
+utl::Clock::Source utl::Clock::source()
+{
+	return Source(clockState().source.load());
+}
+
+/*! \brief Selects the source of the clock. The time stamp counter is only selected if it is invariant.
+  *
+  * Ticks taken from different sources must not be mixed.
+  */
+void utl::Clock::setSource(Source s)
+{
+	clockState().source = s == Tsc && !tscAvailable() ? Steady : s;
+}
+
+bool utl::Clock::tscAvailable()
+{
+	return clockState().tsc;
+}
+
+
+utl::Timer::Timer() : _start(), _stop()
+{}
 
 void utl::Timer::tic()
 {
@@ -53,14 +271,14 @@ void utl::Timer::toc()
     _stop = clock::now();
 }
 
-utl::MicroSeconds utl::Timer::elapsed()
+utl::MicroSeconds utl::Timer::elapsed() const
 {
     const duration &dur = std::chrono::duration_cast<resolution>(_stop - _start);
     MicroSeconds s = double(dur.count());
     return s;
 }
 
-utl::MicroSeconds utl::Timer::elapsed(size_t run)
+utl::MicroSeconds utl::Timer::elapsed(size_t run) const
 {
     const duration &dur = std::chrono::duration_cast<resolution>(_stop - _start);
     // duration in seconds
@@ -69,12 +287,57 @@ utl::MicroSeconds utl::Timer::elapsed(size_t run)
 }
 
 
-utl::Timer::point utl::Timer::start()
+utl::Timer::point utl::Timer::start() const
 {
     return _start;
 }
 
-utl::Timer::point utl::Timer::stop()
+utl::Timer::point utl::Timer::stop() const
 {
     return _stop;
 }
+
+
+/*! \brief Enters the region name below the innermost region of this thread and starts the clock. */
+utl::ScopedTimer::ScopedTimer(const char* name) :
+	_buffer(threadBuffer()), _region(_buffer->enter(name)), _start(Clock::now())
+{}
+
+utl::ScopedTimer::~ScopedTimer()
+{
+	const Clock::ticks stop = Clock::now();
+	_buffer->leave(_region, stop - _start);
+}
+
+/*! \brief Writes the regions of all threads merged by their path with the share of the parent's time. */
+void utl::ScopedTimer::report(std::ostream& out)
+{
+	MergedRegion root{std::string(), 0, 0.0, 0.0, 0.0, std::vector<MergedRegion>()};
+	{
+		std::lock_guard<std::mutex> lock(registry().mutex);
+		for(const auto& b : registry().buffers)
+			merge(root, b->regions, 0);
+	}
+
+	const std::ios::fmtflags flags = out.flags();
+	const std::streamsize precision = out.precision();
+
+	out << std::left << std::setw(32) << "region" << std::right << std::setw(10) << "calls"
+	    << std::setw(14) << "total [s]" << std::setw(14) << "mean [s]" << std::setw(14) << "min [s]"
+	    << std::setw(14) << "max [s]" << std::setw(12) << "parent [%]" << '\n';
+	out << std::scientific << std::setprecision(3);
+	for(const MergedRegion& r : root.children)
+		print(out, r, 0.0, 0);
+
+	out.flags(flags);
+	out.precision(precision);
+	out.flush();
+}
+
+/*! \brief Discards all regions. No ScopedTimer may be alive. */
+void utl::ScopedTimer::reset()
+{
+	std::lock_guard<std::mutex> lock(registry().mutex);
+	for(const auto& b : registry().buffers)
+		b->reset();
+}
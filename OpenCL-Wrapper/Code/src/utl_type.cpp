@@ -87,7 +87,7 @@ namespace type{
     Type Single  ("float",         typeid(float));
     //Type Single4 ("float4",        typeid(float));
     Type Int     ("int",           typeid(int));
-    Type UInt    ("unsigned int",  typeid(unsigned int));
+    Type UInt    ("uint",          typeid(unsigned int));
     Type SChar    ("signed char",   typeid(signed char));
     Type UChar   ("unsigned char", typeid(unsigned char));
     Type Bool    ("bool",          typeid(bool));
@@ -9,11 +9,15 @@ __kernel void minimum(int num, __global T *x, int offset, int step, __global T *
 
 	barrier(CLK_LOCAL_MEM_FENCE);
 
-	// do reduction in shared mem
-	for(int j=get_local_size(0)>>1; j>0; j>>=1)
+	// do reduction in shared mem, all work-items have to reach every barrier.
+	// the elements above the largest power of two below the local size are folded first.
+	int size = get_local_size(0);
+	int p = 1;
+	while(2*p < size) p <<= 1;
+	for(int j=p; j>0; j>>=1)
 	{
-			if (lid >= j) continue;			
-			s[lid] = s[lid] < s[lid+j] ? s[lid] : s[lid+j];			
+			if (lid < j && lid+j < size)
+				s[lid] = s[lid] < s[lid+j] ? s[lid] : s[lid+j];
 			barrier(CLK_LOCAL_MEM_FENCE);
 	}
 
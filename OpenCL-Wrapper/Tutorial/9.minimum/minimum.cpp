@@ -24,7 +24,8 @@ int main(int argc, char* argv[])
     const size_t elements_in = args.size() > 1 ? args.toSizet(1) : 1 << 22;
     const size_t size_bytes_in  = elements_in * sizeof(Type);
     const size_t local_size = 256;
-    const size_t elements_out = std::max(elements_in/local_size, 1ull);
+    // one minimum per work-group, the last work-group may be partial.
+    const size_t elements_out = std::max<size_t>((elements_in + local_size - 1)/local_size, 1);
 		const size_t size_bytes_out = elements_out * sizeof(Type);
 		const size_t execute = 100;
 			
@@ -49,7 +50,7 @@ int main(int argc, char* argv[])
     // get the kernels.
     ocl::Kernel &kernel = program.kernel("minimum", utl::type::Single);
     // set the index space for the kernels
-    kernel.setWorkSize(local_size, elements_in);
+    kernel.setWorkSize(local_size, elements_out * local_size);
     
 
     // create host matrices
@@ -67,7 +68,8 @@ int main(int argc, char* argv[])
 
     // execute both kernels only if the event_write is completed.
     // note that kernel executions are always asynchronous.
-    utl::Timer::tic();
+    utl::Timer timer;
+    timer.tic();
     for(size_t i = 0; i < execute; ++i){
 	    kernel(queue, int(elements_in), d_matrix_in.id(), 0, 1, d_matrix_out.id(), local_size * sizeof(Type));
     	queue.finish();
@@ -75,20 +77,29 @@ int main(int argc, char* argv[])
     // copy data from device buffers to host buffers
     d_matrix_out.read(queue, h_matrix_out.data(), size_bytes_out);       
     float min_gpu = std::min_element(h_matrix_out.begin(), h_matrix_out.end())[0];
-    utl::Timer::toc();
-    std::cout << "Minimum[GPU]: " << min_gpu << ", Time[GPU] = " << utl::Seconds(utl::Timer::elapsed(execute)) << std::endl;
+    timer.toc();
+    std::cout << "Minimum[GPU]: " << min_gpu << ", Time[GPU] = " << utl::Seconds(timer.elapsed(execute)) << std::endl;
+
+    // the reduction of the library reduces the minima of the work-groups on the device too.
+    float min_reduce = ocl::reduce<Type>(queue, d_matrix_in, ocl::ReduceOp::Min);
+    timer.tic();
+    for(size_t i = 0; i < execute; ++i){
+        min_reduce = ocl::reduce<Type>(queue, d_matrix_in, ocl::ReduceOp::Min);
+    }
+    timer.toc();
+    std::cout << "Minimum[reduce]: " << min_reduce << ", Time[reduce] = " << utl::Seconds(timer.elapsed(execute)) << std::endl;
 	
 		
 		float min_cpu;
 		min_cpu = std::min_element(h_matrix_in.begin(), h_matrix_in.end())[0];
 		min_cpu = std::min_element(h_matrix_in.begin(), h_matrix_in.end())[0];
 		
-		utl::Timer::tic();		
+		timer.tic();		
 		for(size_t i = 0; i < execute; ++i){
 	    min_cpu = std::min_element(h_matrix_in.begin(), h_matrix_in.end())[0];
 	  }
-    utl::Timer::toc();
-    std::cout << "Minimum[CPU]: " << min_cpu << ", Time[CPU] = " << utl::Seconds(utl::Timer::elapsed(execute)) << std::endl;
+    timer.toc();
+    std::cout << "Minimum[CPU]: " << min_cpu << ", Time[CPU] = " << utl::Seconds(timer.elapsed(execute)) << std::endl;
     
 
 	return 0;